@@ -0,0 +1,130 @@
+
+#include "AllocationCounter.h"
+#include "RealtimeSafetyChecker.h"
+#include <cstdlib>
+#include <new>
+
+//==============================================================================
+
+/// Number of counters in existence, allocations are only counted while it is above zero
+static std::atomic<int> activeCounters{ 0 };
+
+/// Allocations made by every thread while a counter existed
+static std::atomic<juce::int64> totalAllocations{ 0 };
+
+/**
+ * Implementation of a constructor for AllocationCounter
+ *
+ * Starts counting from the current total
+ *
+ */
+AllocationCounter::AllocationCounter()
+{
+	activeCounters.fetch_add(1);
+	start = totalAllocations.load();
+}
+
+/**
+ * Implementation of a destructor for AllocationCounter
+ *
+ * Stops counting once the last counter is gone
+ *
+ */
+AllocationCounter::~AllocationCounter()
+{
+	activeCounters.fetch_sub(1);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getCount method for AllocationCounter
+ *
+ * Returns the allocations made since the count started
+ *
+ */
+juce::int64 AllocationCounter::getCount() const {
+	return totalAllocations.load() - start;
+}
+
+/**
+ * Implementation of reset method for AllocationCounter
+ *
+ * Starts the count again from the current total
+ *
+ */
+void AllocationCounter::reset() {
+	start = totalAllocations.load();
+}
+
+/**
+ * Implementation of isAvailable method for AllocationCounter
+ *
+ * Returns true if the replaced allocation functions are compiled in
+ *
+ */
+bool AllocationCounter::isAvailable() {
+	return OTODECKS_COUNT_ALLOCATIONS || OTODECKS_RT_CHECKS;
+}
+
+/**
+ * Implementation of allocationMade method for AllocationCounter
+ *
+ * Adds the allocation to the total while any counter exists
+ *
+ */
+void AllocationCounter::allocationMade() {
+	if (activeCounters.load(std::memory_order_relaxed) > 0) {
+		totalAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+//==============================================================================
+
+#if (OTODECKS_COUNT_ALLOCATIONS || OTODECKS_RT_CHECKS) && ! JUCE_LINUX
+
+/*
+	Replacements of the global operator new and delete, only built where the C
+	allocation functions are not replaced. The nothrow forms of the standard library
+	call these, so only the plain forms are replaced. On Linux the malloc and free
+	calls underneath are counted and checked instead.
+*/
+void* operator new(std::size_t size) {
+	AllocationCounter::allocationMade();
+#if OTODECKS_RT_CHECKS
+	RealtimeSafetyChecker::check(RealtimeSafetyChecker::allocation, size);
+#endif
+	if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+#if OTODECKS_RT_CHECKS
+	if (ptr != nullptr) {
+		RealtimeSafetyChecker::check(RealtimeSafetyChecker::deallocation, 0);
+	}
+#endif
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	operator delete(ptr);
+}
+
+#endif
+
+//==============================================================================
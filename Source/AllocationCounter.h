@@ -0,0 +1,71 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/// Compiles allocation counting in, on by default in debug builds; set it for benchmark builds
+#ifndef OTODECKS_COUNT_ALLOCATIONS
+ #define OTODECKS_COUNT_ALLOCATIONS JUCE_DEBUG
+#endif
+
+//==============================================================================
+
+/**
+ * Definition of an AllocationCounter
+ *
+ * Counts the heap allocations made by every thread of the process for as long as it
+ * exists, so the work a callback hands to worker and background threads is counted
+ * too. On Linux malloc, calloc and realloc are replaced and count every allocation,
+ * including those of operator new and of C code; elsewhere the global operator new is
+ * replaced instead. Each allocation costs one load while no counter exists. Counters
+ * can be nested, each counting everything since it was created. Nothing is counted
+ * unless OTODECKS_COUNT_ALLOCATIONS or OTODECKS_RT_CHECKS is set.
+ *
+ */
+class AllocationCounter {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for AllocationCounter, starts counting.
+	*/
+	AllocationCounter();
+
+	/**
+		* Class destructor for AllocationCounter, stops counting.
+	*/
+	~AllocationCounter();
+
+	//==============================================================================
+
+	/**
+		* @return Number of allocations counted so far
+	*/
+	juce::int64 getCount() const;
+
+	/**
+		* Sets the count back to zero
+	*/
+	void reset();
+
+	/**
+		* @return True if allocations are counted in this build
+	*/
+	static bool isAvailable();
+
+	/**
+		* Called by the replaced allocation functions for every allocation
+	*/
+	static void allocationMade();
+
+	//==============================================================================
+
+private:
+
+	/// Process-wide allocation total when the count was last started or reset
+	juce::int64 start;
+
+	JUCE_DECLARE_NON_COPYABLE(AllocationCounter)
+};
@@ -0,0 +1,794 @@
+
+#include "AudioBenchmark.h"
+#include "AllocationCounter.h"
+#include "ParameterMailbox.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for AudioBenchmark
+ *
+ * Registers the basic formats and picks the audio rendered per measurement
+ *
+ */
+AudioBenchmark::AudioBenchmark(const juce::Array<juce::File>& _files, bool quick)
+	: files(_files), secondsPerMeasurement(quick ? 1.0 : 5.0)
+{
+	formatManager.registerBasicFormats();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of run method for AudioBenchmark
+ *
+ * Writes the synthetic files, runs the player benchmark on every file, the resampler,
+ * filter, engine, keylock and mapping benchmarks on the synthetic WAV file and the cue
+ * benchmark on every compressed file, then runs the mailbox and controls stress tests and
+ * deletes the synthetic files.
+ *
+ */
+int AudioBenchmark::run() {
+	std::cout << "OtoDecks audio benchmark: " << juce::SystemStats::getNumCpus() << " cpus, "
+		<< sampleRate << " Hz, " << secondsPerMeasurement << " s per measurement, times in ns per block" << std::endl;
+
+	const juce::File syntheticWav = writeSyntheticFile(".wav");
+	const juce::File syntheticFlac = writeSyntheticFile(".flac");
+	bool ok = syntheticWav.existsAsFile() && syntheticFlac.existsAsFile();
+
+	juce::Array<juce::File> allFiles{ syntheticWav, syntheticFlac };
+	allFiles.addArray(files);
+
+	for (const auto& file : allFiles) {
+		if (file.existsAsFile()) {
+			ok = benchmarkPlayer(file) && ok;
+		}
+	}
+	if (syntheticWav.existsAsFile()) {
+		ok = benchmarkResampler(syntheticWav) && ok;
+		benchmarkFilters();
+		ok = benchmarkEngine(syntheticWav) && ok;
+		ok = benchmarkKeylockBudget(syntheticWav) && ok;
+		ok = benchmarkMapping(syntheticWav) && ok;
+	}
+	for (const auto& file : allFiles) {
+		if (file.existsAsFile() && !file.hasFileExtension("wav;aif;aiff")) {
+			ok = benchmarkCueSeeks(file) && ok;
+		}
+	}
+
+	ok = benchmarkMailbox() && ok;
+	if (syntheticWav.existsAsFile()) {
+		ok = benchmarkControls(syntheticWav) && ok;
+	}
+	for (const auto& file : syntheticFiles) {
+		file.deleteFile();
+	}
+	return ok ? 0 : 1;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of measure method for AudioBenchmark
+ *
+ * Renders a few blocks first so parameter changes and lazily filled buffers settle,
+ * carrying on at a real time pace while the source is still silent, as a seek only
+ * produces audio once a background thread has picked it up. Then times every block on
+ * its own, sleeping until the next block is due when paced, outside the timed part.
+ * The block times are sorted for the percentiles after counting stops, so sorting is
+ * not counted as an allocation of the audio path.
+ *
+ */
+AudioBenchmark::Stats AudioBenchmark::measure(juce::AudioSource& source, int blockSize, int numBlocks, int numChannels, bool paced) {
+	numBlocks = juce::jmax(1, numBlocks);
+	blockTimes.resize((size_t)numBlocks);
+	buffer.setSize(numChannels, blockSize, false, false, true);
+	juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+
+	const int blockMs = juce::jmax(1, juce::roundToInt(1000.0 * blockSize / sampleRate));
+	for (auto i = 0; i < 16 || (i < 200 && buffer.getMagnitude(0, blockSize) == 0.0f); ++i) {
+		source.getNextAudioBlock(info);
+		if (i >= 16) {
+			juce::Thread::sleep(blockMs);
+		}
+	}
+
+	juce::int64 allocations = 0;
+	{
+		AllocationCounter counter;
+		const auto firstTicks = juce::Time::getHighResolutionTicks();
+		for (auto i = 0; i < numBlocks; ++i) {
+			const auto startTicks = juce::Time::getHighResolutionTicks();
+			source.getNextAudioBlock(info);
+			const auto endTicks = juce::Time::getHighResolutionTicks();
+			blockTimes[(size_t)i] = juce::Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1.0e9;
+			if (paced) {
+				const auto dueTicks = firstTicks + juce::Time::secondsToHighResolutionTicks((i + 1) * blockSize / sampleRate);
+				if (dueTicks > endTicks) {
+					juce::Thread::sleep(juce::roundToInt(juce::Time::highResolutionTicksToSeconds(dueTicks - endTicks) * 1000.0));
+				}
+			}
+		}
+		allocations = counter.getCount();
+	}
+
+	Stats stats;
+	double total = 0;
+	for (auto time : blockTimes) {
+		total += time;
+	}
+	std::sort(blockTimes.begin(), blockTimes.end());
+	const auto percentile = [this](double p) { return blockTimes[(size_t)(p * (double)(blockTimes.size() - 1))]; };
+	stats.mean = total / numBlocks;
+	stats.p50 = percentile(0.5);
+	stats.p90 = percentile(0.9);
+	stats.p99 = percentile(0.99);
+	stats.max = blockTimes.back();
+	stats.allocationsPerBlock = AllocationCounter::isAvailable() ? (double)allocations / numBlocks : -1.0;
+	stats.realtimeFactor = total > 0 ? numBlocks * blockSize / sampleRate / (total * 1.0e-9) : 0.0;
+	return stats;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of benchmarkPlayer method for AudioBenchmark
+ *
+ * For both load modes and every power of two block size from 32 to 2048, plays the
+ * file from the start at unity speed, at 1.13x through the resampler and through the
+ * time stretcher, each with the filters bypassed and with the filter and EQ engaged.
+ * Then streams the file through a reader and the default read-ahead buffer, as the
+ * application does for a compressed file, at 1.13x with the EQ engaged and blocks
+ * pulled in real time, and reports how full the buffer was left and how many blocks it
+ * could not serve in time.
+ *
+ */
+bool AudioBenchmark::benchmarkPlayer(const juce::File& file) {
+	struct Setting {
+		double speed;
+		bool keylock;
+		bool filters;
+	};
+	const Setting settings[] = { { 1.0, false, false }, { 1.0, false, true }, { 1.13, false, false }, { 1.13, false, true }, { 1.13, true, false }, { 1.13, true, true } };
+	const DJAudioPlayer::LoadMode modes[] = { DJAudioPlayer::streaming, DJAudioPlayer::ramResident };
+
+	for (auto mode : modes) {
+		DJAudioPlayer player(formatManager);
+		player.setReadAheadTime(0);
+		if (!load(player, file, mode)) {
+			return false;
+		}
+		const juce::String modeName = mode == DJAudioPlayer::ramResident ? "ram" : (player.isMemoryMapped() ? "mapped" : "stream");
+
+		for (auto blockSize = 32; blockSize <= 2048; blockSize *= 2) {
+			player.prepareToPlay(blockSize, sampleRate);
+			for (const auto& setting : settings) {
+				player.setSpeed(setting.speed);
+				player.setKeylock(setting.keylock);
+				player.setFilter(setting.filters ? 2000.0 : 0.0);
+				player.setLBFilter(setting.filters ? 1.5 : 1.0);
+				player.setMBFilter(setting.filters ? 0.7 : 1.0);
+				player.setHBFilter(setting.filters ? 1.2 : 1.0);
+				player.setPosition(0);
+				player.start();
+
+				const auto stats = measure(player, blockSize, (int)(secondsPerMeasurement * sampleRate / blockSize));
+				print("player " + file.getFileName() + " " + modeName + " block=" + juce::String(blockSize) + " speed=" + juce::String(setting.speed, 2)
+					+ (setting.keylock ? " keylock" : "") + (setting.filters ? " eq" : ""), stats);
+				player.stop();
+			}
+			player.releaseResources();
+		}
+	}
+
+	const int blockSize = 512;
+	DJAudioPlayer player(formatManager);
+	player.setMemoryMapping(false);
+	if (!load(player, file, DJAudioPlayer::streaming)) {
+		return false;
+	}
+	player.prepareToPlay(blockSize, sampleRate);
+	player.setSpeed(1.13);
+	player.setFilter(2000.0);
+	player.setLBFilter(1.5);
+	player.setMBFilter(0.7);
+	player.setHBFilter(1.2);
+	player.setPosition(0);
+	player.start();
+	const auto stats = measure(player, blockSize, (int)(secondsPerMeasurement * sampleRate / blockSize), 2, true);
+	print("player " + file.getFileName() + " stream read-ahead block=" + juce::String(blockSize) + " speed=1.13 eq", stats);
+	std::cout << "    read-ahead " << juce::String(player.getReadAheadLength(), 1) << " s, " << juce::roundToInt(player.getReadAheadFillLevel() * 100.0f)
+		<< "% decoded, " << player.getUnderrunCount() << " underruns" << std::endl;
+	player.stop();
+	player.releaseResources();
+	return true;
+}
+
+/**
+ * Implementation of benchmarkResampler method for AudioBenchmark
+ *
+ * Plays the file at 1.13x with 512 sample blocks in every quality tier
+ *
+ */
+bool AudioBenchmark::benchmarkResampler(const juce::File& file) {
+	DJAudioPlayer player(formatManager);
+	if (!load(player, file, DJAudioPlayer::ramResident)) {
+		return false;
+	}
+	player.prepareToPlay(512, sampleRate);
+	player.setSpeed(1.13);
+
+	const juce::String names[] = { "draft", "normal", "mastering" };
+	const PolyphaseResamplingAudioSource::Quality tiers[] = { PolyphaseResamplingAudioSource::draft, PolyphaseResamplingAudioSource::normal, PolyphaseResamplingAudioSource::mastering };
+	for (auto i = 0; i < 3; ++i) {
+		player.setResamplerQuality(tiers[i]);
+		player.setPosition(0);
+		player.start();
+		print("resampler " + names[i] + " block=512 speed=1.13", measure(player, 512, (int)(secondsPerMeasurement * sampleRate / 512)));
+	}
+	player.releaseResources();
+	return true;
+}
+
+/**
+ * Implementation of benchmarkFilters method for AudioBenchmark
+ *
+ * Loops a second of noise through the five filters of a deck, all engaged: the filter
+ * knob's high pass and low pass stages, and the three EQ shelves and peak. The old
+ * path chains a juce::IIRFilterAudioSource per filter, each a pass over the block with
+ * per channel filter objects; the new one runs the same coefficients through a
+ * BiquadCascade in a single pass. Both read the noise the same way, so the difference
+ * is the filtering. Results are in ns per sample of every channel.
+ *
+ */
+void AudioBenchmark::benchmarkFilters() {
+	struct CascadeSource : public juce::AudioSource {
+		CascadeSource(juce::AudioSource& _input) : input(_input) {}
+		void prepareToPlay(int samplesPerBlockExpected, double rate) override { input.prepareToPlay(samplesPerBlockExpected, rate); }
+		void releaseResources() override { input.releaseResources(); }
+		void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override {
+			input.getNextAudioBlock(info);
+			cascade.process(info.buffer->getWritePointer(0, info.startSample),
+				info.buffer->getNumChannels() > 1 ? info.buffer->getWritePointer(1, info.startSample) : nullptr, info.numSamples);
+		}
+		juce::AudioSource& input;
+		BiquadCascade<5> cascade;
+	};
+
+	const double q = 1.0 / juce::MathConstants<double>::sqrt2;
+	const juce::IIRCoefficients coefficients[] = {
+		juce::IIRCoefficients::makeHighPass(sampleRate, 2000),
+		juce::IIRCoefficients::makeLowShelf(sampleRate, 500, q, 1.5f),
+		juce::IIRCoefficients::makePeakFilter(sampleRate, 3250, q, 0.7f),
+		juce::IIRCoefficients::makeHighShelf(sampleRate, 5000, q, 1.2f),
+		juce::IIRCoefficients::makeLowPass(sampleRate, 18000)
+	};
+	const int blockSize = 512;
+	const int numBlocks = (int)(secondsPerMeasurement * sampleRate / blockSize);
+
+	for (auto numChannels = 2; numChannels >= 1; --numChannels) {
+		juce::AudioBuffer<float> noise(numChannels, (int)sampleRate);
+		juce::Random random(numChannels);
+		for (auto chan = 0; chan < numChannels; ++chan) {
+			for (auto i = 0; i < noise.getNumSamples(); ++i) {
+				noise.setSample(chan, i, random.nextFloat() * 0.5f - 0.25f);
+			}
+		}
+		const juce::String channels = numChannels == 2 ? "stereo" : "mono";
+
+		juce::MemoryAudioSource oldInput(noise, true, true);
+		juce::OwnedArray<juce::IIRFilterAudioSource> oldFilters;
+		for (const auto& coefficient : coefficients) {
+			oldFilters.add(new juce::IIRFilterAudioSource(oldFilters.isEmpty() ? static_cast<juce::AudioSource*>(&oldInput) : oldFilters.getLast(), false));
+			oldFilters.getLast()->setCoefficients(coefficient);
+		}
+		oldFilters.getLast()->prepareToPlay(blockSize, sampleRate);
+		const auto oldStats = measure(*oldFilters.getLast(), blockSize, numBlocks, numChannels);
+		oldFilters.getLast()->releaseResources();
+
+		juce::MemoryAudioSource newInput(noise, true, true);
+		CascadeSource cascadeSource(newInput);
+		for (auto stage = 0; stage < 5; ++stage) {
+			cascadeSource.cascade.setCoefficients(stage, coefficients[stage]);
+		}
+		cascadeSource.prepareToPlay(blockSize, sampleRate);
+		const auto newStats = measure(cascadeSource, blockSize, numBlocks, numChannels);
+		cascadeSource.releaseResources();
+
+		print("filters IIRFilterAudioSource x5 " + channels + " block=512", oldStats);
+		print("filters BiquadCascade<5> " + channels + " block=512", newStats);
+		const double samples = (double)blockSize * numChannels;
+		std::cout << "    " << channels << " ns/sample old " << juce::String(oldStats.mean / samples, 2) << " new "
+			<< juce::String(newStats.mean / samples, 2) << ", " << juce::String(oldStats.mean / juce::jmax(1.0, newStats.mean), 2) << "x faster" << std::endl;
+	}
+}
+
+/**
+ * Implementation of benchmarkEngine method for AudioBenchmark
+ *
+ * Plays the file on 1, 2, 4 and 8 decks at 1.13x with the EQ engaged, once with every
+ * deck rendered on the calling thread and once with the worker pool, and prints the
+ * measured speedup of the pool along with the slowest deck's smoothed render time, the
+ * least a parallel callback can take.
+ *
+ */
+bool AudioBenchmark::benchmarkEngine(const juce::File& file) {
+	for (auto numDecks = 1; numDecks <= 8; numDecks *= 2) {
+		Stats serialStats;
+		for (auto parallel = 0; parallel < 2; ++parallel) {
+			DeckEngine engine(formatManager, numDecks, parallel == 1 ? -1 : 0);
+			engine.prepareToPlay(512, sampleRate);
+			for (auto i = 0; i < numDecks; ++i) {
+				auto* deck = engine.getDeck(i);
+				if (!load(*deck, file, DJAudioPlayer::ramResident)) {
+					return false;
+				}
+				deck->setSpeed(1.13);
+				deck->setLBFilter(1.5);
+				deck->setHBFilter(1.2);
+				deck->setPosition(0.5 * i);
+				deck->start();
+			}
+
+			const auto stats = measure(engine, 512, (int)(secondsPerMeasurement * sampleRate / 512));
+			print("engine decks=" + juce::String(numDecks) + " block=512 speed=1.13 eq " + (parallel == 1 ? "pool" : "serial"), stats);
+			if (parallel == 0) {
+				serialStats = stats;
+			}
+			else {
+				double slowest = 0;
+				for (auto i = 0; i < numDecks; ++i) {
+					slowest = juce::jmax(slowest, engine.getDeck(i)->getRenderTime() * 1.0e6);
+				}
+				std::cout << "    pool speedup " << juce::String(serialStats.mean / juce::jmax(1.0, stats.mean), 2)
+					<< "x, slowest deck " << juce::roundToInt(slowest) << " ns" << std::endl;
+			}
+			engine.releaseResources();
+		}
+	}
+	return true;
+}
+
+/**
+ * Implementation of benchmarkKeylockBudget method for AudioBenchmark
+ *
+ * Plays the file on 2 and 4 decks of a DeckEngine, every deck keylocked at 0.8x and then
+ * at 1.2x, the ends of the tempo fader, with 128 sample blocks. A device calls back every
+ * 2.9 ms at that size, so the mean and 99th percentile callback are printed as a share of
+ * that budget; a p99 above 100% would be heard as dropouts.
+ *
+ */
+bool AudioBenchmark::benchmarkKeylockBudget(const juce::File& file) {
+	const int blockSize = 128;
+	const double budget = blockSize / sampleRate * 1.0e9;
+	for (auto numDecks = 2; numDecks <= 4; numDecks *= 2) {
+		for (const double speed : { 0.8, 1.2 }) {
+			DeckEngine engine(formatManager, numDecks);
+			engine.prepareToPlay(blockSize, sampleRate);
+			for (auto i = 0; i < numDecks; ++i) {
+				auto* deck = engine.getDeck(i);
+				if (!load(*deck, file, DJAudioPlayer::ramResident)) {
+					return false;
+				}
+				deck->setKeylock(true);
+				deck->setSpeed(speed);
+				deck->setPosition(0.5 * i);
+				deck->start();
+			}
+
+			const auto stats = measure(engine, blockSize, (int)(secondsPerMeasurement * sampleRate / blockSize));
+			print("keylock decks=" + juce::String(numDecks) + " block=128 speed=" + juce::String(speed, 2), stats);
+			std::cout << "    budget " << juce::roundToInt(budget) << " ns, mean " << juce::String(100.0 * stats.mean / budget, 1)
+				<< "%, p99 " << juce::String(100.0 * stats.p99 / budget, 1) << "%" << std::endl;
+			engine.releaseResources();
+		}
+	}
+	return true;
+}
+
+/**
+ * Implementation of benchmarkMailbox method for AudioBenchmark
+ *
+ * Every field of a snapshot holds the number it was published with, so a snapshot
+ * copied while the writer was filling it shows up as fields that differ. The writer
+ * publishes as fast as it can, yielding now and then, while the calling thread plays
+ * a callback that fetches and checks the latest snapshot in a tight loop, so the two
+ * sides overlap as often as possible, for as long as a measurement lasts.
+ *
+ */
+bool AudioBenchmark::benchmarkMailbox() {
+	struct Snapshot {
+		juce::int64 fields[32];
+	};
+
+	struct Writer : public juce::Thread {
+		Writer(ParameterMailbox<Snapshot>& _mailbox) : juce::Thread("Mailbox writer"), mailbox(_mailbox) {}
+
+		void run() override {
+			Snapshot snapshot;
+			while (!threadShouldExit()) {
+				++published;
+				std::fill(std::begin(snapshot.fields), std::end(snapshot.fields), published.load());
+				mailbox.publish(snapshot);
+				if (published % 64 == 0) {
+					juce::Thread::yield();
+				}
+			}
+		}
+
+		ParameterMailbox<Snapshot>& mailbox;
+		std::atomic<juce::int64> published{ 0 };
+	};
+
+	ParameterMailbox<Snapshot> mailbox;
+	Writer writer(mailbox);
+	Snapshot snapshot;
+	std::fill(std::begin(snapshot.fields), std::end(snapshot.fields), 0);
+
+	juce::int64 fetches = 0, torn = 0, backwards = 0, last = 0;
+	writer.startThread();
+	const auto endTicks = juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks(secondsPerMeasurement);
+	while (juce::Time::getHighResolutionTicks() < endTicks) {
+		if (mailbox.fetch(snapshot)) {
+			++fetches;
+			const juce::int64 first = snapshot.fields[0];
+			if (std::any_of(std::begin(snapshot.fields), std::end(snapshot.fields), [first](juce::int64 field) { return field != first; })) {
+				++torn;
+			}
+			if (first < last) {
+				++backwards;
+			}
+			last = first;
+		}
+	}
+	writer.stopThread(1000);
+
+	std::cout << "mailbox published=" << writer.published.load() << " fetched=" << fetches << " torn=" << torn
+		<< " backwards=" << backwards << std::endl;
+	if (torn > 0 || backwards > 0) {
+		std::cout << "    FAILED: the mailbox handed over a torn or stale snapshot" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Implementation of benchmarkControls method for AudioBenchmark
+ *
+ * The controls start at step zero, then the mover thread sets the six of them in a fixed
+ * order, each to a value that encodes the step it belongs to, as a slider being dragged
+ * would, and each setter publishes the whole parameter set. Any set the deck can be handed therefore has its first controls
+ * at some step and the rest at the step before, so a block rendered with any other mix
+ * of steps was rendered with a torn set. The calling thread plays blocks back to back
+ * for as long as a measurement lasts, rewinding before the end of the file, reads the
+ * parameters the deck applied, which only the audio thread touches, and checks the
+ * output for samples that are not finite.
+ *
+ */
+bool AudioBenchmark::benchmarkControls(const juce::File& file) {
+	static constexpr int numSteps = 400;
+	static constexpr int numControls = 6;
+
+	struct Mover : public juce::Thread {
+		Mover(DJAudioPlayer& _player) : juce::Thread("Control mover"), player(_player) {}
+
+		void run() override {
+			while (!threadShouldExit()) {
+				move((int)(++moves % numSteps));
+				if (moves % 16 == 0) {
+					juce::Thread::yield();
+				}
+			}
+		}
+
+		void move(int step) {
+			player.setSpeed(0.8 + step * 0.001);
+			player.setFilter((step - numSteps / 2) * 50.0);
+			player.setLBFilter(0.5 + step * 0.0025);
+			player.setMBFilter(0.5 + step * 0.0025);
+			player.setHBFilter(0.5 + step * 0.0025);
+			player.setGain((double)step / numSteps, true);
+		}
+
+		DJAudioPlayer& player;
+		std::atomic<juce::int64> moves{ 0 };
+	};
+
+	const int blockSize = 256;
+	DJAudioPlayer player(formatManager);
+	player.prepareToPlay(blockSize, sampleRate);
+	if (!load(player, file, DJAudioPlayer::ramResident)) {
+		return false;
+	}
+	player.start();
+	buffer.setSize(2, blockSize);
+	juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+
+	Mover mover(player);
+	mover.move(0);
+	juce::int64 blocks = 0, torn = 0, nonFinite = 0;
+	float peak = 0;
+	mover.startThread();
+	const auto endTicks = juce::Time::getHighResolutionTicks() + juce::Time::secondsToHighResolutionTicks(secondsPerMeasurement);
+	while (juce::Time::getHighResolutionTicks() < endTicks) {
+		if (player.getPositionRelative() > 0.9) {
+			player.setPosition(0);
+		}
+		player.getNextAudioBlock(info);
+		++blocks;
+
+		const auto& parameters = player.activeParameters;
+		const int steps[numControls] = {
+			juce::roundToInt((parameters.speed - 0.8) / 0.001),
+			juce::roundToInt(parameters.filterFrequency / 50.0) + numSteps / 2,
+			juce::roundToInt((parameters.lowBandGain - 0.5) / 0.0025),
+			juce::roundToInt((parameters.midBandGain - 0.5) / 0.0025),
+			juce::roundToInt((parameters.highBandGain - 0.5) / 0.0025),
+			juce::roundToInt(parameters.gain * numSteps)
+		};
+		const int previous = (steps[0] + numSteps - 1) % numSteps;
+		bool behind = false;
+		for (auto control = 1; control < numControls; ++control) {
+			behind = behind || steps[control] != steps[0];
+			if (steps[control] != (behind ? previous : steps[0])) {
+				++torn;
+				break;
+			}
+		}
+
+		for (auto chan = 0; chan < buffer.getNumChannels(); ++chan) {
+			const float* samples = buffer.getReadPointer(chan);
+			nonFinite += std::count_if(samples, samples + blockSize, [](float sample) { return !std::isfinite(sample); });
+		}
+		peak = juce::jmax(peak, buffer.getMagnitude(0, blockSize));
+	}
+	mover.stopThread(1000);
+	player.releaseResources();
+
+	std::cout << "controls " << file.getFileName() << " blocks=" << blocks << " control moves=" << mover.moves.load()
+		<< " torn=" << torn << " non-finite samples=" << nonFinite << " peak=" << juce::String(peak, 3) << std::endl;
+	if (torn > 0 || nonFinite > 0) {
+		std::cout << "    FAILED: a block was rendered with a torn parameter set or produced non-finite samples" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Implementation of benchmarkMapping method for AudioBenchmark
+ *
+ * Loads the file once with memory mapping and once without, which streams it through a
+ * reader. Blocks are first timed without a read-ahead thread, so the streamed blocks
+ * include reading and converting the file and the mapped ones reading from the page
+ * cache. Each is then loaded again with the default read-ahead, as the application
+ * plays it, and blocks are paced in real time while it jumps to the same random
+ * positions, recording the time until the first block with audio and the underruns of
+ * the streamed one's read-ahead buffer. The file was just written, so both read from a
+ * warm page cache.
+ *
+ */
+bool AudioBenchmark::benchmarkMapping(const juce::File& file) {
+	const int blockSize = 512;
+	const int blockMs = juce::roundToInt(1000.0 * blockSize / sampleRate);
+	const int numSeeks = 16;
+
+	for (auto mapping : { true, false }) {
+		const juce::String name = mapping ? "mapped" : "stream";
+		DJAudioPlayer player(formatManager);
+		player.setMemoryMapping(mapping);
+		player.setReadAheadTime(0);
+		if (!load(player, file, DJAudioPlayer::streaming)) {
+			return false;
+		}
+		if (player.isMemoryMapped() != mapping) {
+			std::cout << "mapping " << file.getFileName() << " could not be " << name << std::endl;
+			return false;
+		}
+		player.prepareToPlay(blockSize, sampleRate);
+		player.setPosition(0);
+		player.start();
+		print("mapping " + file.getFileName() + " " + name + " block=" + juce::String(blockSize),
+			measure(player, blockSize, (int)(secondsPerMeasurement * sampleRate / blockSize)));
+		player.stop();
+		player.releaseResources();
+
+		buffer.setSize(2, blockSize);
+		juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+		DJAudioPlayer pacedPlayer(formatManager);
+		pacedPlayer.setMemoryMapping(mapping);
+		pacedPlayer.prepareToPlay(blockSize, sampleRate);
+		if (!load(pacedPlayer, file, DJAudioPlayer::streaming)) {
+			return false;
+		}
+		const double length = pacedPlayer.getLengthInSeconds();
+		pacedPlayer.start();
+		for (auto i = 0; i < 50; ++i) {
+			pacedPlayer.getNextAudioBlock(info);
+			juce::Thread::sleep(blockMs);
+		}
+
+		juce::Random random(2);
+		double total = 0, maximum = 0;
+		for (auto seek = 0; seek < numSeeks; ++seek) {
+			pacedPlayer.setPosition(random.nextDouble() * (length - 2));
+			const auto startTicks = juce::Time::getHighResolutionTicks();
+			for (auto i = 0; i < 200; ++i) {
+				pacedPlayer.getNextAudioBlock(info);
+				if (buffer.getMagnitude(0, blockSize) > 0.0f) {
+					break;
+				}
+				juce::Thread::sleep(blockMs);
+			}
+			const double latency = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+			total += latency;
+			maximum = juce::jmax(maximum, latency);
+			for (auto i = 0; i < 20; ++i) {
+				pacedPlayer.getNextAudioBlock(info);
+				juce::Thread::sleep(blockMs);
+			}
+		}
+		const int underruns = pacedPlayer.getUnderrunCount();
+		pacedPlayer.releaseResources();
+		std::cout << "mapping " << file.getFileName() << " " << name << " seek to audio: mean " << juce::String(total / numSeeks, 3)
+			<< " ms max " << juce::String(maximum, 3) << " ms" << (mapping ? juce::String() : ", read-ahead underruns " + juce::String(underruns)) << std::endl;
+	}
+	return true;
+}
+
+/**
+ * Implementation of benchmarkCueSeeks method for AudioBenchmark
+ *
+ * Streams the file with the read-ahead thread, as the application does, and sets eight
+ * hot cues. Blocks are paced in real time so the background threads run as they would
+ * behind a device. Every cue is jumped to, then a position a second after it, and the
+ * time until the first block with audio is recorded for both. The latency the deck
+ * measured itself is recorded alongside, with how many cue jumps it served from a cue
+ * window, so a jump that missed its window shows up even when the disk was fast.
+ *
+ */
+bool AudioBenchmark::benchmarkCueSeeks(const juce::File& file) {
+	const int blockSize = 512;
+	const int blockMs = juce::roundToInt(1000.0 * blockSize / sampleRate);
+	buffer.setSize(2, blockSize);
+	juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+
+	DJAudioPlayer player(formatManager);
+	player.prepareToPlay(blockSize, sampleRate);
+	if (!load(player, file, DJAudioPlayer::streaming)) {
+		return false;
+	}
+	const double length = player.getLengthInSeconds();
+	if (length < 20) {
+		std::cout << "cue " << file.getFileName() << " skipped, shorter than 20 s" << std::endl;
+		return true;
+	}
+
+	const int numCues = 8;
+	for (auto i = 0; i < numCues; ++i) {
+		player.setCuePoint(i, (0.1 + 0.1 * i) * (length - 2) / length);
+	}
+	player.start();
+	for (auto i = 0; i < 50; ++i) {
+		player.getNextAudioBlock(info);
+		juce::Thread::sleep(blockMs);
+	}
+
+	const auto seekLatency = [&](double seconds) {
+		player.setPosition(seconds);
+		const auto startTicks = juce::Time::getHighResolutionTicks();
+		for (auto i = 0; i < 200; ++i) {
+			player.getNextAudioBlock(info);
+			if (buffer.getMagnitude(0, blockSize) > 0.0f) {
+				break;
+			}
+			juce::Thread::sleep(blockMs);
+		}
+		const double latency = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+		for (auto i = 0; i < 20; ++i) {
+			player.getNextAudioBlock(info);
+			juce::Thread::sleep(blockMs);
+		}
+		return latency;
+	};
+
+	double cueTotal = 0, cueMax = 0, streamTotal = 0, streamMax = 0;
+	double cueMeasuredTotal = 0, streamMeasuredTotal = 0;
+	int cueHits = 0, streamHits = 0;
+	for (auto i = 0; i < numCues; ++i) {
+		const double cueSeconds = (0.1 + 0.1 * i) * (length - 2);
+		const double cue = seekLatency(cueSeconds);
+		cueMeasuredTotal += juce::jmax(0.0, player.getSeekLatency());
+		cueHits += player.wasSeekFromCue() ? 1 : 0;
+		const double stream = seekLatency(cueSeconds + 1.0);
+		streamMeasuredTotal += juce::jmax(0.0, player.getSeekLatency());
+		streamHits += player.wasSeekFromCue() ? 1 : 0;
+		cueTotal += cue;
+		cueMax = juce::jmax(cueMax, cue);
+		streamTotal += stream;
+		streamMax = juce::jmax(streamMax, stream);
+	}
+	player.releaseResources();
+
+	std::cout << "cue " << file.getFileName() << " seek to audio: hot cue mean " << juce::String(cueTotal / numCues, 3) << " ms max " << juce::String(cueMax, 3)
+		<< " ms, other position mean " << juce::String(streamTotal / numCues, 3) << " ms max " << juce::String(streamMax, 3) << " ms" << std::endl;
+	std::cout << "cue " << file.getFileName() << " deck measured: hot cue mean " << juce::String(cueMeasuredTotal / numCues, 3) << " ms, "
+		<< cueHits << "/" << numCues << " from a cue window, other position mean " << juce::String(streamMeasuredTotal / numCues, 3) << " ms, "
+		<< streamHits << "/" << numCues << " from a cue window" << std::endl;
+	return true;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of writeSyntheticFile method for AudioBenchmark
+ *
+ * Writes 30 seconds of two sines, a slow sweep and a little noise, different on each
+ * channel, so no block is silent and every filter band has something to work on.
+ *
+ */
+juce::File AudioBenchmark::writeSyntheticFile(const juce::String& extension) {
+	const juce::File file = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("OtoDecksBenchmark" + extension);
+	auto* format = formatManager.findFormatForFileExtension(extension);
+	file.deleteFile();
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (format == nullptr || stream == nullptr) {
+		return {};
+	}
+	std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+	if (writer == nullptr) {
+		return {};
+	}
+	stream.release();
+	syntheticFiles.add(file);
+
+	juce::Random random(1);
+	juce::AudioBuffer<float> block(2, 4096);
+	const int length = (int)(30 * sampleRate);
+	double sweepPhase = 0;
+	for (auto start = 0; start < length; start += block.getNumSamples()) {
+		for (auto i = 0; i < block.getNumSamples(); ++i) {
+			const double t = (start + i) / sampleRate;
+			sweepPhase += juce::MathConstants<double>::twoPi * (100.0 + 9900.0 * t / 30.0) / sampleRate;
+			const float noise = 0.05f * (random.nextFloat() * 2.0f - 1.0f);
+			block.getWritePointer(0)[i] = (float)(0.3 * std::sin(juce::MathConstants<double>::twoPi * 220.0 * t) + 0.2 * std::sin(sweepPhase)) + noise;
+			block.getWritePointer(1)[i] = (float)(0.3 * std::sin(juce::MathConstants<double>::twoPi * 330.0 * t) + 0.2 * std::cos(sweepPhase)) + noise;
+		}
+		writer->writeFromAudioSampleBuffer(block, 0, juce::jmin(block.getNumSamples(), length - start));
+	}
+	return file;
+}
+
+/**
+ * Implementation of load method for AudioBenchmark
+ *
+ * Loads synchronously with the load mode and reports a failure
+ *
+ */
+bool AudioBenchmark::load(DJAudioPlayer& player, const juce::File& file, DJAudioPlayer::LoadMode mode) {
+	player.setLoadMode(mode);
+	player.loadURL(juce::URL{ file });
+	if (!player.isLoaded()) {
+		std::cout << "could not load " << file.getFullPathName() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Implementation of print method for AudioBenchmark
+ *
+ * Prints the label followed by the times, allocations and realtime factor on one line,
+ * with n/a for the allocations when the build does not count them
+ *
+ */
+void AudioBenchmark::print(const juce::String& label, const Stats& stats) {
+	std::cout << label.paddedRight(' ', 56) << " mean " << juce::roundToInt(stats.mean) << " p50 " << juce::roundToInt(stats.p50)
+		<< " p90 " << juce::roundToInt(stats.p90) << " p99 " << juce::roundToInt(stats.p99) << " max " << juce::roundToInt(stats.max)
+		<< " allocs/block " << (stats.allocationsPerBlock < 0 ? juce::String("n/a") : juce::String(stats.allocationsPerBlock, 2)) << " " << juce::roundToInt(stats.realtimeFactor) << "x realtime" << std::endl;
+}
+
+//==============================================================================
@@ -0,0 +1,232 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "DJAudioPlayer.h"
+#include "DeckEngine.h"
+#include "BiquadCascade.h"
+
+//==============================================================================
+
+/**
+ * Definition of an AudioBenchmark
+ *
+ * Runs the audio path without a device and prints how long it takes. Every benchmark
+ * calls getNextAudioBlock in a tight loop after a short warm-up, times each block and
+ * counts the heap allocations made meanwhile by every thread, when the build counts
+ * them. The suite covers:
+ *
+ *	player   - one deck across buffer sizes 32 to 2048, speeds, keylock and filter settings,
+ *	           streamed and RAM resident, then streamed with the read-ahead thread in real
+ *	           time with its buffer fill and underruns
+ *	resampler - the speed resampler quality tiers
+ *	filters  - the five band BiquadCascade against the five juce::IIRFilterAudioSource
+ *	           it replaced, in ns per sample, stereo and mono
+ *	engine   - a DeckEngine with 1 to 8 decks, rendered serially and on the worker pool
+ *	keylock  - 2 and 4 keylocked decks at -20% and +20% tempo against the budget of a
+ *	           128 sample callback
+ *	mapping  - the same WAV file memory mapped and streamed through a reader, in time per
+ *	           block and seek latency
+ *	cue      - seek latency to a hot cue against a seek to an arbitrary position
+ *	           and the latency the deck measured, with its cue window hits
+ *	mailbox  - a ParameterMailbox stress test, failing the run if a snapshot is torn
+ *	controls - a deck played while another thread moves its speed, filter, EQ and gain
+ *	           controls, failing the run on a torn parameter set or a non-finite sample
+ *
+ * Synthetic WAV and FLAC files are generated in the temp folder; files passed on the
+ * command line are benchmarked the same way. Streamed decks mostly read without a
+ * read-ahead thread, since a faster than real time loop would only ever see underruns,
+ * so their blocks include decoding. The read-ahead player run and the seek latency
+ * benchmarks run in real time.
+ *
+ */
+class AudioBenchmark {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for AudioBenchmark, initializes member variables.
+		*
+		* @param Audio files benchmarked on top of the synthetic ones
+		* @param True to render less audio per measurement
+	*/
+	AudioBenchmark(const juce::Array<juce::File>& files, bool quick);
+
+	//==============================================================================
+
+	/**
+		* Runs every benchmark and prints the results to standard output
+		*
+		* @return Exit code, 0 if every file could be benchmarked and every stress test passed
+	*/
+	int run();
+
+	//==============================================================================
+
+private:
+
+	/// Timing of a series of blocks
+	struct Stats {
+		/// Mean time per block in nanoseconds
+		double mean = 0;
+
+		/// Median time per block in nanoseconds
+		double p50 = 0;
+
+		/// 90th percentile time per block in nanoseconds
+		double p90 = 0;
+
+		/// 99th percentile time per block in nanoseconds
+		double p99 = 0;
+
+		/// Slowest block in nanoseconds
+		double max = 0;
+
+		/// Heap allocations per block on every thread, -1 if the build does not count them
+		double allocationsPerBlock = 0;
+
+		/// Seconds of audio rendered per second of wall time
+		double realtimeFactor = 0;
+	};
+
+	//==============================================================================
+
+	/**
+		* Times blocks of an audio source after a warm-up
+		*
+		* @param Source to pull blocks from, already prepared for the block size
+		* @param Samples per block
+		* @param Number of blocks to time
+		* @param Number of channels of the blocks
+		* @param True to pull the timed blocks at a real time pace, as a device would
+		* @return Stats of the timed blocks
+	*/
+	Stats measure(juce::AudioSource& source, int blockSize, int numBlocks, int numChannels = 2, bool paced = false);
+
+	/**
+		* Benchmarks one deck with a file across buffer sizes, speeds, keylock and filter settings
+		*
+		* @param File to load
+		* @return True if the file could be loaded
+	*/
+	bool benchmarkPlayer(const juce::File& file);
+
+	/**
+		* Benchmarks the resampler quality tiers with a file
+		*
+		* @param File to load
+		* @return True if the file could be loaded
+	*/
+	bool benchmarkResampler(const juce::File& file);
+
+	/**
+		* Benchmarks the deck EQ and filter as a BiquadCascade against a chain of juce::IIRFilterAudioSource
+	*/
+	void benchmarkFilters();
+
+	/**
+		* Benchmarks a DeckEngine playing a file on a growing number of decks
+		*
+		* @param File to load on every deck
+		* @return True if the file could be loaded
+	*/
+	bool benchmarkEngine(const juce::File& file);
+
+	/**
+		* Benchmarks keylocked decks at the extremes of the tempo range with a small buffer
+		* and prints the callback time as a share of the time the buffer lasts
+		*
+		* @param File to load on every deck
+		* @return True if the file could be loaded
+	*/
+	bool benchmarkKeylockBudget(const juce::File& file);
+
+	/**
+		* Plays the same file memory mapped and streamed through a reader, timing blocks
+		* without a read-ahead thread and measuring in real time how long random seeks take
+		* to produce audio with one
+		*
+		* @param Uncompressed WAV or AIFF file to load
+		* @return True if the file could be loaded both ways
+	*/
+	bool benchmarkMapping(const juce::File& file);
+
+	/**
+		* Measures in real time how long seeks to hot cues and to arbitrary positions take to produce audio
+		*
+		* @param File to load
+		* @return True if the file could be loaded
+	*/
+	bool benchmarkCueSeeks(const juce::File& file);
+
+	/**
+		* Publishes numbered snapshots into a ParameterMailbox from one thread while a simulated
+		* callback fetches them on another, checking each one is whole and none goes backwards
+		*
+		* @return True if every fetched snapshot was whole and in order
+	*/
+	bool benchmarkMailbox();
+
+	/**
+		* Plays a file on a deck while another thread keeps moving its speed, filter, EQ and
+		* volume controls, checking after every block that the parameters it was rendered
+		* with form a set the controls were really in and that every sample is finite
+		*
+		* @param File to load
+		* @return True if the file could be loaded and every block passed
+	*/
+	bool benchmarkControls(const juce::File& file);
+
+	/**
+		* Writes a stereo test signal of sines, a sweep and noise to the temp folder
+		*
+		* @param Extension picking the format, .wav or .flac
+		* @return The written file, or a nonexistent file if it could not be written
+	*/
+	juce::File writeSyntheticFile(const juce::String& extension);
+
+	/**
+		* Loads a file into a player
+		*
+		* @param Player to load
+		* @param File to load
+		* @param Load mode
+		* @return True if the file was loaded
+	*/
+	static bool load(DJAudioPlayer& player, const juce::File& file, DJAudioPlayer::LoadMode mode);
+
+	/**
+		* Prints one result line
+		*
+		* @param Benchmark name and settings
+		* @param Stats to print
+	*/
+	static void print(const juce::String& label, const Stats& stats);
+
+	//==============================================================================
+
+	/// Formats used to read and write files
+	juce::AudioFormatManager formatManager;
+
+	/// Files benchmarked on top of the synthetic ones
+	juce::Array<juce::File> files;
+
+	/// Synthetic files written by run, deleted when it finishes
+	juce::Array<juce::File> syntheticFiles;
+
+	/// Seconds of audio rendered per measurement
+	double secondsPerMeasurement;
+
+	/// Sample rate of every benchmark
+	double sampleRate = 44100;
+
+	/// Block times of the current measurement, allocated before timing starts
+	std::vector<double> blockTimes;
+
+	/// Buffer blocks are rendered into
+	juce::AudioBuffer<float> buffer;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioBenchmark)
+};
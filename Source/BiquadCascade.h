@@ -0,0 +1,302 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <utility>
+
+/**
+ * Definition of a BiquadCascade class template
+ *
+ * A fixed number of biquad filter stages, set with juce::IIRCoefficients, that are
+ * processed together in a single pass over a stereo block. Every sample of both
+ * channels runs through all active stages before the next sample is read. The left
+ * and right filter states are held as an interleaved pair, so each stage updates both
+ * channels in one go with the same instructions. The stages are unrolled at compile
+ * time: there is a block loop for every combination of active stages, and the cascade
+ * runs the one matching its current combination, so bypassed stages are compiled out
+ * and cost nothing. A mono block takes a single channel path through the left states
+ * only, rather than filtering the same samples twice. The cascade is not thread safe,
+ * coefficients are set from the thread that processes it.
+ *
+ */
+template <int NumStages>
+class BiquadCascade {
+	static_assert(NumStages > 0 && NumStages <= 6, "A block loop is compiled for every combination of active stages");
+
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for BiquadCascade, all stages start bypassed.
+	*/
+	BiquadCascade() {
+		updateActiveStages();
+	}
+
+	//==============================================================================
+
+	/**
+		* Sets the coefficients of a stage and makes it active
+		*
+		* @param Index of the stage
+		* @param juce::IIRCoefficients for the stage
+	*/
+	void setCoefficients(int stage, const juce::IIRCoefficients& newCoefficients) {
+		jassert(juce::isPositiveAndBelow(stage, NumStages));
+		for (auto i = 0; i < 5; ++i) {
+			stages[stage].coefficients[i] = newCoefficients.coefficients[i];
+		}
+		stages[stage].active = true;
+		updateActiveStages();
+	}
+
+	/**
+		* Bypasses a stage, removing it from the block loop
+		*
+		* @param Index of the stage
+	*/
+	void setBypassed(int stage) {
+		jassert(juce::isPositiveAndBelow(stage, NumStages));
+		stages[stage].active = false;
+		updateActiveStages();
+	}
+
+	/**
+		* @param Index of the stage
+		* @return If the stage is bypassed
+	*/
+	bool isBypassed(int stage) const {
+		return !stages[stage].active;
+	}
+
+	/**
+		* Clears the filter state of every stage
+	*/
+	void reset() {
+		for (auto& stage : stages) {
+			resetState(stage);
+		}
+	}
+
+	//==============================================================================
+
+	/**
+		* Filters a block in place through every active stage in a single pass
+		*
+		* @param Samples of the left channel
+		* @param Samples of the right channel, nullptr for a mono block
+		* @param Number of samples to process
+	*/
+	void process(float* left, float* right, int numSamples) {
+		if (activeStages == 0) {
+			return;
+		}
+		if (right == nullptr) {
+			monoBlock(stages, left, numSamples);
+		}
+		else {
+			stereoBlock(stages, left, right, numSamples);
+		}
+
+		for (auto& stage : stages) {
+			snapToZero(stage);
+		}
+	}
+
+	//==============================================================================
+
+private:
+
+	/// Left and right value of a state variable, interleaved
+	struct Pair {
+		/// Value of the left channel
+		float left = 0;
+
+		/// Value of the right channel
+		float right = 0;
+	};
+
+	/// Coefficients and interleaved left/right state of a single stage
+	struct Stage {
+		/// Normalised b0, b1, b2, a1, a2 coefficients
+		float coefficients[5] = { 1, 0, 0, 0, 0 };
+
+		/// First state variable of the left and right channel
+		Pair z1;
+
+		/// Second state variable of the left and right channel
+		Pair z2;
+
+		/// Flags if the stage is processed
+		bool active = false;
+	};
+
+	/// Block loop over a stereo block for one combination of active stages
+	using StereoBlock = void (*)(Stage*, float*, float*, int);
+
+	/// Block loop over a mono block for one combination of active stages
+	using MonoBlock = void (*)(Stage*, float*, int);
+
+	//==============================================================================
+
+	/**
+		* Filters a stereo block in place through the stages set in ActiveStages
+		*
+		* @param Stages of the cascade
+		* @param Samples of the left channel
+		* @param Samples of the right channel
+		* @param Number of samples to process
+	*/
+	template <unsigned ActiveStages>
+	static void processStereoBlock(Stage* stages, float* left, float* right, int numSamples) noexcept {
+		for (auto i = 0; i < numSamples; ++i) {
+			Pair x{ left[i], right[i] };
+			processStages<ActiveStages>(stages, x, std::integral_constant<int, 0>());
+			left[i] = x.left;
+			right[i] = x.right;
+		}
+	}
+
+	/**
+		* Filters a mono block in place through the stages set in ActiveStages, using the left states
+		*
+		* @param Stages of the cascade
+		* @param Samples of the channel
+		* @param Number of samples to process
+	*/
+	template <unsigned ActiveStages>
+	static void processMonoBlock(Stage* stages, float* samples, int numSamples) noexcept {
+		for (auto i = 0; i < numSamples; ++i) {
+			float x = samples[i];
+			processStages<ActiveStages>(stages, x, std::integral_constant<int, 0>());
+			samples[i] = x;
+		}
+	}
+
+	/**
+		* Runs a sample from stage Index onwards through the stages set in ActiveStages.
+		* The test of ActiveStages is a constant, so every bypassed stage is compiled out.
+		*
+		* @param Stages of the cascade
+		* @param Stereo pair or mono sample, replaced by the filtered value
+	*/
+	template <unsigned ActiveStages, typename Sample, int Index>
+	static inline void processStages(Stage* stages, Sample& x, std::integral_constant<int, Index>) noexcept {
+		if ((ActiveStages >> Index) & 1u) {
+			processStage(stages[Index], x);
+		}
+		processStages<ActiveStages>(stages, x, std::integral_constant<int, Index + 1>());
+	}
+
+	/**
+		* Ends the unrolled stages after the last one
+	*/
+	template <unsigned ActiveStages, typename Sample>
+	static inline void processStages(Stage*, Sample&, std::integral_constant<int, NumStages>) noexcept {}
+
+	/**
+		* Runs a stereo sample pair through a stage in transposed direct form II
+		*
+		* @param Stage to process
+		* @param Left and right sample, replaced by the filtered pair
+	*/
+	static inline void processStage(Stage& stage, Pair& x) noexcept {
+		const float* c = stage.coefficients;
+		const Pair out{ c[0] * x.left + stage.z1.left, c[0] * x.right + stage.z1.right };
+		stage.z1 = Pair{ c[1] * x.left - c[3] * out.left + stage.z2.left, c[1] * x.right - c[3] * out.right + stage.z2.right };
+		stage.z2 = Pair{ c[2] * x.left - c[4] * out.left, c[2] * x.right - c[4] * out.right };
+		x = out;
+	}
+
+	/**
+		* Runs a single sample through a stage in transposed direct form II, using the left state
+		*
+		* @param Stage to process
+		* @param Sample, replaced by the filtered sample
+	*/
+	static inline void processStage(Stage& stage, float& x) noexcept {
+		const float* c = stage.coefficients;
+		const float out = c[0] * x + stage.z1.left;
+		stage.z1.left = c[1] * x - c[3] * out + stage.z2.left;
+		stage.z2.left = c[2] * x - c[4] * out;
+		x = out;
+	}
+
+	/**
+		* Flushes denormal state values of a stage to zero
+		*
+		* @param Stage to flush
+	*/
+	static void snapToZero(Stage& stage) noexcept {
+		JUCE_SNAP_TO_ZERO(stage.z1.left);
+		JUCE_SNAP_TO_ZERO(stage.z1.right);
+		JUCE_SNAP_TO_ZERO(stage.z2.left);
+		JUCE_SNAP_TO_ZERO(stage.z2.right);
+	}
+
+	/**
+		* Clears the state variables of a stage
+		*
+		* @param Stage to clear
+	*/
+	static void resetState(Stage& stage) noexcept {
+		stage.z1 = Pair();
+		stage.z2 = Pair();
+	}
+
+	/**
+		* Looks up the stereo block loop for a combination of active stages
+		*
+		* @param Bit per stage, set if the stage is active
+		* @return Block loop compiled for the combination
+	*/
+	template <unsigned... Combinations>
+	static StereoBlock getStereoBlock(unsigned combination, std::integer_sequence<unsigned, Combinations...>) noexcept {
+		static const StereoBlock blocks[] = { &processStereoBlock<Combinations>... };
+		return blocks[combination];
+	}
+
+	/**
+		* Looks up the mono block loop for a combination of active stages
+		*
+		* @param Bit per stage, set if the stage is active
+		* @return Block loop compiled for the combination
+	*/
+	template <unsigned... Combinations>
+	static MonoBlock getMonoBlock(unsigned combination, std::integer_sequence<unsigned, Combinations...>) noexcept {
+		static const MonoBlock blocks[] = { &processMonoBlock<Combinations>... };
+		return blocks[combination];
+	}
+
+	/**
+		* Rebuilds the combination of active stages and picks its block loops, clearing the bypassed stages
+	*/
+	void updateActiveStages() {
+		activeStages = 0;
+		for (auto i = 0; i < NumStages; ++i) {
+			if (stages[i].active) {
+				activeStages |= 1u << i;
+			}
+			else {
+				resetState(stages[i]);
+			}
+		}
+		const auto combinations = std::make_integer_sequence<unsigned, 1u << NumStages>();
+		stereoBlock = getStereoBlock(activeStages, combinations);
+		monoBlock = getMonoBlock(activeStages, combinations);
+	}
+
+	//==============================================================================
+
+	/// Filter stages in index order
+	Stage stages[NumStages];
+
+	/// Bit per stage, set if the stage is active
+	unsigned activeStages = 0;
+
+	/// Block loop for stereo blocks through the active stages
+	StereoBlock stereoBlock = nullptr;
+
+	/// Block loop for mono blocks through the active stages
+	MonoBlock monoBlock = nullptr;
+};
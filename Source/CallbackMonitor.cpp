@@ -0,0 +1,320 @@
+
+#include "CallbackMonitor.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for CallbackMonitor
+ *
+ * Zeroes the histogram bins written by the audio thread
+ *
+ */
+CallbackMonitor::CallbackMonitor()
+{
+	for (auto& bin : loadBins) {
+		bin.store(0);
+	}
+	for (auto& bin : jitterBins) {
+		bin.store(0);
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepare method for CallbackMonitor
+ *
+ * Stores the sample rate and forgets the previous callback, so the gap across a
+ * device restart is not counted as jitter.
+ *
+ */
+void CallbackMonitor::prepare(double newSampleRate) {
+	sampleRate = newSampleRate;
+	previousStartTicks = 0;
+	previousDeadline = 0;
+}
+
+/**
+ * Implementation of callbackStarted method for CallbackMonitor
+ *
+ * Returns the high resolution tick count
+ *
+ */
+juce::int64 CallbackMonitor::callbackStarted() const {
+	return juce::Time::getHighResolutionTicks();
+}
+
+/**
+ * Implementation of callbackFinished method for CallbackMonitor
+ *
+ * The deadline of a callback is the duration of the block it produced. The load is
+ * the time taken over the deadline, and the jitter how far the gap since the previous
+ * callback is from the previous deadline.
+ *
+ */
+void CallbackMonitor::callbackFinished(juce::int64 startTicks, int numSamples) {
+	if (numSamples <= 0) {
+		return;
+	}
+	const double duration = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+	const double deadline = numSamples / sampleRate;
+	const double callbackLoad = duration / deadline;
+
+	increment(loadBins[(size_t)juce::jlimit(0, numLoadBins - 1, (int)(callbackLoad * 100.0))]);
+	if (callbackLoad > 1.0) {
+		increment(overruns);
+	}
+
+	if (previousStartTicks != 0) {
+		const double gap = juce::Time::highResolutionTicksToSeconds(startTicks - previousStartTicks);
+		const double jitter = std::abs(gap - previousDeadline);
+		increment(jitterBins[(size_t)juce::jlimit(0, numJitterBins - 1, (int)(jitter * 10000.0))]);
+		if (gap > 2.0 * previousDeadline) {
+			increment(lateCallbacks);
+		}
+	}
+	previousStartTicks = startTicks;
+	previousDeadline = deadline;
+
+	busyNanos.store(busyNanos.load(std::memory_order_relaxed) + (juce::int64)(duration * 1.0e9), std::memory_order_relaxed);
+	blockNanos.store(blockNanos.load(std::memory_order_relaxed) + (juce::int64)(deadline * 1.0e9), std::memory_order_relaxed);
+	lastBlockSize.store(numSamples, std::memory_order_relaxed);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of update method for CallbackMonitor
+ *
+ * Adds what every counter gained since the previous update to the histograms and
+ * counts. The counters wrap, which the unsigned differences take care of. The load
+ * is the busy time over the audio time in between, and the peak the upper edge of
+ * the highest load bin that gained a callback.
+ *
+ */
+void CallbackMonitor::update() {
+	peakLoad = 0;
+	for (auto i = 0; i < numLoadBins; ++i) {
+		const juce::uint32 count = loadBins[(size_t)i].load(std::memory_order_relaxed);
+		const juce::uint32 added = count - previousLoadBins[(size_t)i];
+		previousLoadBins[(size_t)i] = count;
+		loadHistogram[(size_t)i] += added;
+		if (added > 0) {
+			peakLoad = (float)(i + 1);
+		}
+	}
+	for (auto i = 0; i < numJitterBins; ++i) {
+		const juce::uint32 count = jitterBins[(size_t)i].load(std::memory_order_relaxed);
+		jitterHistogram[(size_t)i] += count - previousJitterBins[(size_t)i];
+		previousJitterBins[(size_t)i] = count;
+	}
+
+	const juce::int64 busy = busyNanos.load(std::memory_order_relaxed);
+	const juce::int64 block = blockNanos.load(std::memory_order_relaxed);
+	if (block > previousBlockNanos) {
+		load = (float)(100.0 * (double)(busy - previousBusyNanos) / (double)(block - previousBlockNanos));
+	}
+	previousBusyNanos = busy;
+	previousBlockNanos = block;
+
+	const juce::uint32 newOverruns = overruns.load(std::memory_order_relaxed);
+	overrunCount += newOverruns - previousOverruns;
+	previousOverruns = newOverruns;
+
+	const juce::uint32 newLateCallbacks = lateCallbacks.load(std::memory_order_relaxed);
+	lateCallbackCount += newLateCallbacks - previousLateCallbacks;
+	previousLateCallbacks = newLateCallbacks;
+}
+
+/**
+ * Implementation of reset method for CallbackMonitor
+ *
+ * Clears the histograms and counts kept by the message thread. The audio thread
+ * counters carry on, update only ever looks at what they gained.
+ *
+ */
+void CallbackMonitor::reset() {
+	loadHistogram.fill(0);
+	jitterHistogram.fill(0);
+	overrunCount = 0;
+	lateCallbackCount = 0;
+	deviceXRunsAtReset = juce::jmax(0, deviceXRuns);
+}
+
+/**
+ * Implementation of setDeviceXRunCount method for CallbackMonitor
+ *
+ * Stores the count. A count lower than the last one means the device was reopened,
+ * so the baseline is dropped.
+ *
+ */
+void CallbackMonitor::setDeviceXRunCount(int count) {
+	if (count < deviceXRuns) {
+		deviceXRunsAtReset = 0;
+	}
+	deviceXRuns = count;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getLoad method for CallbackMonitor
+ *
+ * Returns the load data member
+ *
+ */
+float CallbackMonitor::getLoad() const {
+	return load;
+}
+
+/**
+ * Implementation of getPeakLoad method for CallbackMonitor
+ *
+ * Returns the peakLoad data member
+ *
+ */
+float CallbackMonitor::getPeakLoad() const {
+	return peakLoad;
+}
+
+/**
+ * Implementation of getLoadPercentile method for CallbackMonitor
+ *
+ * Returns the upper edge of the load bin the fraction falls in
+ *
+ */
+float CallbackMonitor::getLoadPercentile(double fraction) const {
+	return (float)(findPercentileBin(loadHistogram, fraction) + 1);
+}
+
+/**
+ * Implementation of getJitterPercentile method for CallbackMonitor
+ *
+ * Returns the upper edge of the jitter bin the fraction falls in, in milliseconds
+ *
+ */
+float CallbackMonitor::getJitterPercentile(double fraction) const {
+	return (float)(findPercentileBin(jitterHistogram, fraction) + 1) * 0.1f;
+}
+
+/**
+ * Implementation of getLoadHistogram method for CallbackMonitor
+ *
+ * Returns the loadHistogram data member
+ *
+ */
+const std::array<juce::uint64, CallbackMonitor::numLoadBins>& CallbackMonitor::getLoadHistogram() const {
+	return loadHistogram;
+}
+
+/**
+ * Implementation of getOverrunCount method for CallbackMonitor
+ *
+ * Returns the overrunCount data member
+ *
+ */
+juce::int64 CallbackMonitor::getOverrunCount() const {
+	return overrunCount;
+}
+
+/**
+ * Implementation of getLateCallbackCount method for CallbackMonitor
+ *
+ * Returns the lateCallbackCount data member
+ *
+ */
+juce::int64 CallbackMonitor::getLateCallbackCount() const {
+	return lateCallbackCount;
+}
+
+/**
+ * Implementation of getDeviceXRunCount method for CallbackMonitor
+ *
+ * Returns the device count since the last reset, or -1 if the device does not report one
+ *
+ */
+int CallbackMonitor::getDeviceXRunCount() const {
+	return deviceXRuns < 0 ? -1 : deviceXRuns - deviceXRunsAtReset;
+}
+
+/**
+ * Implementation of getXRunCount method for CallbackMonitor
+ *
+ * Prefers the device count, which also sees dropouts the callback cannot
+ *
+ */
+juce::int64 CallbackMonitor::getXRunCount() const {
+	return deviceXRuns >= 0 ? getDeviceXRunCount() : overrunCount + lateCallbackCount;
+}
+
+/**
+ * Implementation of getBlockDuration method for CallbackMonitor
+ *
+ * Returns the last block size over the sample rate in milliseconds
+ *
+ */
+double CallbackMonitor::getBlockDuration() const {
+	return 1000.0 * lastBlockSize.load(std::memory_order_relaxed) / sampleRate;
+}
+
+/**
+ * Implementation of getBlockSize method for CallbackMonitor
+ *
+ * Returns the lastBlockSize counter
+ *
+ */
+int CallbackMonitor::getBlockSize() const {
+	return lastBlockSize.load(std::memory_order_relaxed);
+}
+
+/**
+ * Implementation of getSampleRate method for CallbackMonitor
+ *
+ * Returns the sampleRate data member
+ *
+ */
+double CallbackMonitor::getSampleRate() const {
+	return sampleRate;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of increment method for CallbackMonitor
+ *
+ * A load and a store rather than fetch_add, as only the audio thread writes the counter
+ *
+ */
+template <typename Counter>
+void CallbackMonitor::increment(Counter& counter) {
+	counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/**
+ * Implementation of findPercentileBin method for CallbackMonitor
+ *
+ * Walks the bins until the running total reaches the fraction of all entries
+ *
+ */
+template <size_t numBins>
+int CallbackMonitor::findPercentileBin(const std::array<juce::uint64, numBins>& histogram, double fraction) {
+	juce::uint64 total = 0;
+	for (auto count : histogram) {
+		total += count;
+	}
+	if (total == 0) {
+		return -1;
+	}
+
+	const juce::uint64 target = juce::jmax((juce::uint64)1, (juce::uint64)std::ceil(fraction * (double)total));
+	juce::uint64 runningTotal = 0;
+	for (size_t i = 0; i < numBins; ++i) {
+		runningTotal += histogram[i];
+		if (runningTotal >= target) {
+			return (int)i;
+		}
+	}
+	return (int)numBins - 1;
+}
+
+//==============================================================================
@@ -0,0 +1,243 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+//==============================================================================
+
+/**
+ * Definition of a CallbackMonitor
+ *
+ * Measures how close the audio callback comes to its deadline. The audio thread times
+ * every callback and the gap since the previous one and counts them into fixed
+ * histograms of DSP load (time taken over time available) and jitter (gap minus the
+ * expected period). Every counter has a single writer, so the audio thread only does
+ * plain atomic loads and stores. A callback slower than its deadline is counted as an
+ * overrun, and a gap of more than two periods as a late callback; either is heard as a
+ * dropout unless the device has buffering to spare. The message thread drains the
+ * counters with update and works out the load and percentiles from them.
+ *
+ */
+class CallbackMonitor {
+public:
+
+	/// Number of 1% DSP load bins, the last one counting every callback at 200% and above
+	static constexpr int numLoadBins = 201;
+
+	/// Number of 0.1 ms jitter bins, the last one counting every gap 10 ms or more off
+	static constexpr int numJitterBins = 101;
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for CallbackMonitor, initializes member variables.
+	*/
+	CallbackMonitor();
+
+	//==============================================================================
+
+	/**
+		* Sets the sample rate the deadlines are worked out from. Called before audio processing starts.
+		*
+		* @param Number of samples per second
+	*/
+	void prepare(double sampleRate);
+
+	/**
+		* Called from the audio thread at the start of the callback
+		*
+		* @return Tick count to pass to callbackFinished
+	*/
+	juce::int64 callbackStarted() const;
+
+	/**
+		* Called from the audio thread at the end of the callback to record it
+		*
+		* @param Tick count returned by callbackStarted
+		* @param Number of samples the callback produced
+	*/
+	void callbackFinished(juce::int64 startTicks, int numSamples);
+
+	//==============================================================================
+
+	/**
+		* Drains the counters written by the audio thread. Called from the message thread.
+	*/
+	void update();
+
+	/**
+		* Forgets everything measured so far. Called from the message thread.
+	*/
+	void reset();
+
+	/**
+		* Sets the xrun count reported by the audio device, -1 if it does not report one
+		*
+		* @param Xruns counted by the device since it was opened
+	*/
+	void setDeviceXRunCount(int count);
+
+	//==============================================================================
+
+	/**
+		* @return Average DSP load since the previous update, in percent
+	*/
+	float getLoad() const;
+
+	/**
+		* @return Highest DSP load of a callback since the previous update, in percent
+	*/
+	float getPeakLoad() const;
+
+	/**
+		* @param Fraction of callbacks, between 0 and 1
+		* @return DSP load in percent that the fraction of callbacks stayed under since the last reset
+	*/
+	float getLoadPercentile(double fraction) const;
+
+	/**
+		* @param Fraction of callbacks, between 0 and 1
+		* @return Jitter in milliseconds that the fraction of callbacks stayed under since the last reset
+	*/
+	float getJitterPercentile(double fraction) const;
+
+	/**
+		* @return Number of callbacks in each DSP load bin since the last reset
+	*/
+	const std::array<juce::uint64, numLoadBins>& getLoadHistogram() const;
+
+	/**
+		* @return Number of callbacks slower than their deadline since the last reset
+	*/
+	juce::int64 getOverrunCount() const;
+
+	/**
+		* @return Number of callbacks more than two periods after the previous one since the last reset
+	*/
+	juce::int64 getLateCallbackCount() const;
+
+	/**
+		* @return Xruns reported by the audio device since the last reset, -1 if the device does not report them
+	*/
+	int getDeviceXRunCount() const;
+
+	/**
+		* @return Xruns reported by the device if it reports them, otherwise overruns and late callbacks
+	*/
+	juce::int64 getXRunCount() const;
+
+	/**
+		* @return Duration of the last callback's block in milliseconds
+	*/
+	double getBlockDuration() const;
+
+	/**
+		* @return Number of samples in the last callback's block
+	*/
+	int getBlockSize() const;
+
+	/**
+		* @return Number of samples per second the deadlines are worked out from
+	*/
+	double getSampleRate() const;
+
+	//==============================================================================
+
+private:
+
+	/**
+		* Adds one to a counter only the audio thread writes, without a locked instruction
+		*
+		* @param Counter to increment
+	*/
+	template <typename Counter>
+	static void increment(Counter& counter);
+
+	/**
+		* @param Histogram to read
+		* @param Fraction of entries
+		* @return Index of the bin the fraction of entries falls in
+	*/
+	template <size_t numBins>
+	static int findPercentileBin(const std::array<juce::uint64, numBins>& histogram, double fraction);
+
+	//==============================================================================
+
+	/// Number of samples per second
+	double sampleRate = 44100;
+
+	/// Tick count at the start of the previous callback, 0 before the first one
+	juce::int64 previousStartTicks = 0;
+
+	/// Block duration of the previous callback in seconds
+	double previousDeadline = 0;
+
+	/// Callbacks per DSP load bin, written by the audio thread
+	std::array<std::atomic<juce::uint32>, numLoadBins> loadBins;
+
+	/// Callbacks per jitter bin, written by the audio thread
+	std::array<std::atomic<juce::uint32>, numJitterBins> jitterBins;
+
+	/// Nanoseconds spent in callbacks, written by the audio thread
+	std::atomic<juce::int64> busyNanos{ 0 };
+
+	/// Nanoseconds of audio produced by callbacks, written by the audio thread
+	std::atomic<juce::int64> blockNanos{ 0 };
+
+	/// Callbacks slower than their deadline, written by the audio thread
+	std::atomic<juce::uint32> overruns{ 0 };
+
+	/// Callbacks more than two periods after the previous one, written by the audio thread
+	std::atomic<juce::uint32> lateCallbacks{ 0 };
+
+	/// Number of samples in the last block, written by the audio thread
+	std::atomic<int> lastBlockSize{ 0 };
+
+	//==============================================================================
+
+	/// Load bins at the previous update
+	std::array<juce::uint32, numLoadBins> previousLoadBins{};
+
+	/// Jitter bins at the previous update
+	std::array<juce::uint32, numJitterBins> previousJitterBins{};
+
+	/// Callbacks per DSP load bin since the last reset
+	std::array<juce::uint64, numLoadBins> loadHistogram{};
+
+	/// Callbacks per jitter bin since the last reset
+	std::array<juce::uint64, numJitterBins> jitterHistogram{};
+
+	/// busyNanos at the previous update
+	juce::int64 previousBusyNanos = 0;
+
+	/// blockNanos at the previous update
+	juce::int64 previousBlockNanos = 0;
+
+	/// overruns at the previous update
+	juce::uint32 previousOverruns = 0;
+
+	/// lateCallbacks at the previous update
+	juce::uint32 previousLateCallbacks = 0;
+
+	/// Average load since the previous update
+	float load = 0;
+
+	/// Peak load since the previous update
+	float peakLoad = 0;
+
+	/// Overruns since the last reset
+	juce::int64 overrunCount = 0;
+
+	/// Late callbacks since the last reset
+	juce::int64 lateCallbackCount = 0;
+
+	/// Latest xrun count reported by the device, -1 if it does not report one
+	int deviceXRuns = -1;
+
+	/// Device xrun count at the last reset
+	int deviceXRunsAtReset = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CallbackMonitor)
+};
@@ -0,0 +1,79 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ * Definition of a CommandQueue class template
+ *
+ * A lock-free ring buffer that passes commands from a single writer thread to a single
+ * reader thread in order. Each side only advances its own index, publishing it with a
+ * release store that the other side reads with an acquire load, so a command is fully
+ * written before the reader can see it. The reader can look at the oldest command
+ * before taking it, so commands meant for later can wait at the front of the queue.
+ * The capacity is fixed and a full queue refuses new commands rather than waiting.
+ *
+ */
+template <typename CommandType, int capacity>
+class CommandQueue {
+public:
+
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+	//==============================================================================
+
+	/**
+		* Adds a command to the back of the queue. Only called from the writer thread.
+		*
+		* @param Command to add
+		* @return False if the queue was full and the command was dropped
+	*/
+	bool push(const CommandType& command) {
+		const juce::uint32 write = writeIndex.load(std::memory_order_relaxed);
+		if (write - readIndex.load(std::memory_order_acquire) >= (juce::uint32)capacity) {
+			return false;
+		}
+		commands[write & mask] = command;
+		writeIndex.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+		* Copies the command at the front of the queue without removing it. Only called from the reader thread.
+		*
+		* @param Command to overwrite with the front of the queue
+		* @return False if the queue is empty
+	*/
+	bool peek(CommandType& command) const {
+		const juce::uint32 read = readIndex.load(std::memory_order_relaxed);
+		if (read == writeIndex.load(std::memory_order_acquire)) {
+			return false;
+		}
+		command = commands[read & mask];
+		return true;
+	}
+
+	/**
+		* Removes the command at the front of the queue. Only called from the reader thread after a successful peek.
+	*/
+	void pop() {
+		readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	//==============================================================================
+
+private:
+
+	/// Mask turning an index into a slot
+	static constexpr juce::uint32 mask = (juce::uint32)capacity - 1;
+
+	/// Command slots, each owned by the writer until published and by the reader until popped
+	CommandType commands[capacity];
+
+	/// Number of commands ever pushed, written by the writer thread
+	std::atomic<juce::uint32> writeIndex{ 0 };
+
+	/// Number of commands ever popped, written by the reader thread
+	std::atomic<juce::uint32> readIndex{ 0 };
+};
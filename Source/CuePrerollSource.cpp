@@ -0,0 +1,322 @@
+
+#include "CuePrerollSource.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for CuePrerollSource
+ *
+ * Allocates a stereo buffer for every window up front, so setting a cue never allocates.
+ * Each window starts a little before its cue so the rounding of a relative seek position
+ * still lands inside it.
+ *
+ */
+CuePrerollSource::CuePrerollSource(juce::PositionableAudioSource* _source, const ReadAheadAudioSource* readAheadSource, juce::AudioFormatReader* cueReader, juce::TimeSliceThread& thread, double windowSeconds)
+	: source(_source), readAhead(readAheadSource), reader(cueReader), backgroundThread(thread),
+	windowLength(juce::jmax(4096, (int)(windowSeconds * cueReader->sampleRate)))
+{
+	jassert(source != nullptr);
+	windowLead = juce::jmin(1024, windowLength / 8);
+	for (auto& cue : cues) {
+		cue.buffer.setSize(2, windowLength);
+	}
+}
+
+/**
+ * Implementation of a destructor for CuePrerollSource
+ *
+ * Detaches from the decode thread before the windows and reader are freed.
+ *
+ */
+CuePrerollSource::~CuePrerollSource()
+{
+	backgroundThread.removeTimeSliceClient(this);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setCue method for CuePrerollSource
+ *
+ * Moves the window to the new position and queues it for decoding. If the window is
+ * being played, the wrapped source takes over at the current position first.
+ *
+ */
+void CuePrerollSource::setCue(int index, juce::int64 position) {
+	if (index < 0 || index >= maxNumCues) {
+		return;
+	}
+
+	juce::int64 resumePosition = -1;
+	{
+		const juce::SpinLock::ScopedLockType sl(cueLock);
+		auto& cue = cues[index];
+		if (activeCue == index) {
+			resumePosition = cue.start + activeOffset;
+			activeCue = -1;
+			windowPlayPos = -1;
+		}
+		cue.start = juce::jmax((juce::int64)0, position - windowLead);
+		cue.length = 0;
+		++cue.generation;
+		cue.pending = true;
+		cue.ready = false;
+	}
+
+	if (resumePosition >= 0) {
+		source->setNextReadPosition(resumePosition);
+	}
+	backgroundThread.moveToFrontOfQueue(this);
+}
+
+/**
+ * Implementation of clearCues method for CuePrerollSource
+ *
+ * Drops every window. If one is being played, the wrapped source takes over at the current position.
+ *
+ */
+void CuePrerollSource::clearCues() {
+	juce::int64 resumePosition = -1;
+	{
+		const juce::SpinLock::ScopedLockType sl(cueLock);
+		if (activeCue >= 0) {
+			resumePosition = cues[activeCue].start + activeOffset;
+			activeCue = -1;
+			windowPlayPos = -1;
+		}
+		for (auto& cue : cues) {
+			++cue.generation;
+			cue.pending = false;
+			cue.ready = false;
+		}
+	}
+
+	if (resumePosition >= 0) {
+		source->setNextReadPosition(resumePosition);
+	}
+}
+
+/**
+ * Implementation of isCueReady method for CuePrerollSource
+ *
+ * Returns the ready flag of the window.
+ *
+ */
+bool CuePrerollSource::isCueReady(int index) const {
+	const juce::SpinLock::ScopedLockType sl(cueLock);
+	return index >= 0 && index < maxNumCues && cues[index].ready;
+}
+
+/**
+ * Implementation of getLastSeekLatency method for CuePrerollSource
+ *
+ * Returns the lastSeekLatency data member.
+ *
+ */
+double CuePrerollSource::getLastSeekLatency() const {
+	return lastSeekLatency;
+}
+
+/**
+ * Implementation of wasLastSeekFromCue method for CuePrerollSource
+ *
+ * Returns the lastSeekFromCue data member.
+ *
+ */
+bool CuePrerollSource::wasLastSeekFromCue() const {
+	return lastSeekFromCue;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for CuePrerollSource
+ *
+ * Prepares the wrapped source and attaches to the decode thread.
+ *
+ */
+void CuePrerollSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+	if (!isPrepared) {
+		backgroundThread.addTimeSliceClient(this);
+		isPrepared = true;
+	}
+}
+
+/**
+ * Implementation of releaseResources method for CuePrerollSource
+ *
+ * Detaches from the decode thread and releases the wrapped source.
+ *
+ */
+void CuePrerollSource::releaseResources() {
+	if (isPrepared) {
+		backgroundThread.removeTimeSliceClient(this);
+		isPrepared = false;
+	}
+	source->releaseResources();
+}
+
+/**
+ * Implementation of getNextAudioBlock method for CuePrerollSource
+ *
+ * Copies what is left of the active window, duplicating a mono window to every channel,
+ * and reads the rest of the block from the wrapped source, which was left at the end of
+ * the window. The first block played from the position of a seek stops the seek timer,
+ * whatever its level: one with samples from a window, or one the wrapped source no longer
+ * holds silent for the seek, which a source without a read-ahead never does.
+ *
+ */
+void CuePrerollSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	int fromWindow = 0;
+	{
+		const juce::SpinLock::ScopedLockType sl(cueLock);
+		if (activeCue >= 0) {
+			const auto& cue = cues[activeCue];
+			fromWindow = juce::jmin(bufferToFill.numSamples, cue.length - activeOffset);
+			for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+				bufferToFill.buffer->copyFrom(chan, bufferToFill.startSample, cue.buffer, juce::jmin(chan, cue.buffer.getNumChannels() - 1), activeOffset, fromWindow);
+			}
+			activeOffset += fromWindow;
+			if (activeOffset >= cue.length) {
+				activeCue = -1;
+				windowPlayPos = -1;
+			}
+			else {
+				windowPlayPos = cue.start + activeOffset;
+			}
+		}
+	}
+
+	if (fromWindow < bufferToFill.numSamples) {
+		juce::AudioSourceChannelInfo info(bufferToFill.buffer, bufferToFill.startSample + fromWindow, bufferToFill.numSamples - fromWindow);
+		source->getNextAudioBlock(info);
+	}
+
+	auto ticks = seekTicks.load();
+	if (ticks != 0 && (fromWindow > 0 || readAhead == nullptr || !readAhead->isSeekPending())
+		&& seekTicks.compare_exchange_strong(ticks, 0)) {
+		lastSeekLatency = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - ticks) * 1000.0;
+		lastSeekFromCue = fromWindow > 0;
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setNextReadPosition method for CuePrerollSource
+ *
+ * Starts the seek timer, then looks for a decoded window whose first half holds the
+ * position. When one is found it becomes the active window and the wrapped source is
+ * moved to the end of it, so its read-ahead starts filling from where the window stops.
+ * Otherwise the wrapped source is moved to the position.
+ *
+ */
+void CuePrerollSource::setNextReadPosition(juce::int64 newPosition) {
+	seekTicks = juce::Time::getHighResolutionTicks();
+
+	juce::int64 sourcePosition = newPosition;
+	{
+		const juce::SpinLock::ScopedLockType sl(cueLock);
+		activeCue = -1;
+		for (auto i = 0; i < maxNumCues; ++i) {
+			const auto& cue = cues[i];
+			if (cue.ready && newPosition >= cue.start && newPosition < cue.start + cue.length / 2) {
+				activeCue = i;
+				activeOffset = (int)(newPosition - cue.start);
+				sourcePosition = cue.start + cue.length;
+				break;
+			}
+		}
+		windowPlayPos = activeCue >= 0 ? newPosition : -1;
+	}
+
+	source->setNextReadPosition(sourcePosition);
+}
+
+/**
+ * Implementation of getNextReadPosition method for CuePrerollSource
+ *
+ * Returns the position in the active window, or the position of the wrapped source.
+ *
+ */
+juce::int64 CuePrerollSource::getNextReadPosition() const {
+	const auto pos = windowPlayPos.load();
+	return pos >= 0 ? pos : source->getNextReadPosition();
+}
+
+/**
+ * Implementation of getTotalLength method for CuePrerollSource
+ *
+ * Returns the length of the wrapped source.
+ *
+ */
+juce::int64 CuePrerollSource::getTotalLength() const {
+	return source->getTotalLength();
+}
+
+/**
+ * Implementation of isLooping method for CuePrerollSource
+ *
+ * Returns the looping state of the wrapped source.
+ *
+ */
+bool CuePrerollSource::isLooping() const {
+	return source->isLooping();
+}
+
+/**
+ * Implementation of setLooping method for CuePrerollSource
+ *
+ * Sets the looping state of the wrapped source.
+ *
+ */
+void CuePrerollSource::setLooping(bool shouldLoop) {
+	source->setLooping(shouldLoop);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of useTimeSlice method for CuePrerollSource
+ *
+ * Takes the first window waiting to be decoded and decodes it outside the lock. The
+ * window is not read by the audio thread until it is ready, and the result is only
+ * marked ready if the cue was not moved while it was decoding.
+ *
+ */
+int CuePrerollSource::useTimeSlice() {
+	int index = -1;
+	juce::int64 start = 0;
+	int generation = 0;
+	{
+		const juce::SpinLock::ScopedLockType sl(cueLock);
+		for (auto i = 0; i < maxNumCues && index < 0; ++i) {
+			if (cues[i].pending) {
+				index = i;
+				start = cues[i].start;
+				generation = cues[i].generation;
+			}
+		}
+	}
+
+	if (index < 0) {
+		return 100;
+	}
+
+	const int length = (int)juce::jlimit((juce::int64)0, (juce::int64)windowLength, reader->lengthInSamples - start);
+	if (length > 0) {
+		reader->read(&cues[index].buffer, 0, length, start, true, true);
+	}
+
+	const juce::SpinLock::ScopedLockType sl(cueLock);
+	auto& cue = cues[index];
+	if (cue.generation == generation) {
+		cue.length = length;
+		cue.pending = false;
+		cue.ready = length > 0;
+	}
+	return 1;
+}
+
+//==============================================================================
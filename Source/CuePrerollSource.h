@@ -0,0 +1,214 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "ReadAheadAudioSource.h"
+
+//==============================================================================
+
+/**
+ * Definition of a CuePrerollSource
+ *
+ * A PositionableAudioSource that keeps a short window of decoded PCM at every hot cue
+ * of a streamed file. The windows are decoded on a background juce::TimeSliceThread with
+ * a reader of their own. A seek that lands in a decoded window is served from memory
+ * straight away, while the wrapped source is moved to the end of the window and has the
+ * length of the window to catch up before playback reaches it. Any other seek is passed
+ * through. Every seek is timed until the first block played from its position, whether
+ * from a window or from the wrapped source, however quiet that block is.
+ *
+ */
+class CuePrerollSource : public juce::PositionableAudioSource,
+	private juce::TimeSliceClient
+{
+public:
+
+	/// Number of cue windows kept
+	static constexpr int maxNumCues = 8;
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for CuePrerollSource, allocates every cue window.
+		*
+		* @param PositionableAudioSource streaming the file, not owned
+		* @param ReadAheadAudioSource that source is or nullptr if it plays a seek straight away, not owned
+		* @param Reader of the same file used only to decode the windows, owned
+		* @param juce::TimeSliceThread that decodes the windows
+		* @param Length of each window in seconds
+	*/
+	CuePrerollSource(juce::PositionableAudioSource* source, const ReadAheadAudioSource* readAheadSource, juce::AudioFormatReader* cueReader, juce::TimeSliceThread& thread, double windowSeconds = 0.5);
+
+	/**
+		* Class destructor for CuePrerollSource, detaches from the decode thread.
+	*/
+	~CuePrerollSource() override;
+
+	//==============================================================================
+
+	/**
+		* Sets a cue and queues its window for decoding. Only called from the message thread.
+		*
+		* @param Index of the cue, from 0 to maxNumCues - 1
+		* @param Position of the cue in samples
+	*/
+	void setCue(int index, juce::int64 position);
+
+	/**
+		* Clears every cue window. Only called from the message thread.
+	*/
+	void clearCues();
+
+	/**
+		* @param Index of the cue
+		* @return If the window of the cue is decoded
+	*/
+	bool isCueReady(int index) const;
+
+	/**
+		* @return Milliseconds from the last seek until the first block with audio was produced, -1 before the first seek
+	*/
+	double getLastSeekLatency() const;
+
+	/**
+		* @return If the last seek was served from a cue window
+	*/
+	bool wasLastSeekFromCue() const;
+
+	//==============================================================================
+
+	/**
+		* Prepares the wrapped source and attaches to the decode thread
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Detaches from the decode thread and releases the wrapped source
+	*/
+	void releaseResources() override;
+
+	/**
+		* Copies what is left of an active cue window, the rest of the block comes from the wrapped source
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Plays from a cue window if the position lies in one, otherwise seeks the wrapped source
+		*
+		* @param Position in samples
+	*/
+	void setNextReadPosition(juce::int64 newPosition) override;
+
+	/**
+		* @return Next playback position in samples
+	*/
+	juce::int64 getNextReadPosition() const override;
+
+	/**
+		* @return Total length of the wrapped source in samples
+	*/
+	juce::int64 getTotalLength() const override;
+
+	/**
+		* @return If the wrapped source is looping
+	*/
+	bool isLooping() const override;
+
+	/**
+		* Sets the looping state of the wrapped source
+		*
+		* @param True to loop the wrapped source
+	*/
+	void setLooping(bool shouldLoop) override;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Called by the decode thread to decode the next queued cue window
+		*
+		* @return Number of milliseconds before the decode thread should call again
+	*/
+	int useTimeSlice() override;
+
+	//==============================================================================
+
+	/// Decoded PCM around one cue
+	struct CueWindow {
+		/// Decoded samples, allocated in the constructor
+		juce::AudioBuffer<float> buffer;
+
+		/// Position of the first sample of the window, a little before the cue
+		juce::int64 start = 0;
+
+		/// Number of decoded samples in the window
+		int length = 0;
+
+		/// Incremented whenever the cue changes, so a decode of an old position is dropped
+		int generation = 0;
+
+		/// Flags if the window is waiting to be decoded
+		bool pending = false;
+
+		/// Flags if the window is decoded and can be played
+		bool ready = false;
+	};
+
+	/// Wrapped source streaming the file
+	juce::PositionableAudioSource* source;
+
+	/// Wrapped source as a read-ahead, which tells when a seek has been played from, or nullptr
+	const ReadAheadAudioSource* readAhead;
+
+	/// Reader decoding the cue windows
+	std::unique_ptr<juce::AudioFormatReader> reader;
+
+	/// Background thread that decodes the windows
+	juce::TimeSliceThread& backgroundThread;
+
+	/// Number of samples held by each window
+	int windowLength;
+
+	/// Number of samples a window starts before its cue, so rounding of the seek position still lands in it
+	int windowLead;
+
+	/// Cue windows
+	CueWindow cues[maxNumCues];
+
+	/// Guards the cue windows and the active window, only held for index updates and block copies
+	mutable juce::SpinLock cueLock;
+
+	/// Index of the window being played, -1 when playing from the wrapped source
+	int activeCue = -1;
+
+	/// Read position in the active window
+	int activeOffset = 0;
+
+	/// Next playback position while a window is active, -1 while playing from the wrapped source
+	std::atomic<juce::int64> windowPlayPos{ -1 };
+
+	/// High resolution ticks of the last seek, 0 once its first block has been played
+	std::atomic<juce::int64> seekTicks{ 0 };
+
+	/// Milliseconds from the last seek to its first block
+	std::atomic<double> lastSeekLatency{ -1.0 };
+
+	/// Flags if the last seek was served from a window
+	std::atomic<bool> lastSeekFromCue{ false };
+
+	/// Flags if the source is prepared and attached to the decode thread
+	bool isPrepared = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CuePrerollSource)
+};
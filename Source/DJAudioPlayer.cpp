@@ -7,59 +7,130 @@
  * Implementation of a constructor for DJAudioPlayer
  *
  * Initializes juce::AudioFormatManager pointer data member
+ * and starts the read-ahead thread
  *
  */
 DJAudioPlayer::DJAudioPlayer(juce::AudioFormatManager& _formatManager)
 	: formatManager(_formatManager)
 {
+	readAheadThread.startThread();
 };
 
 /**
  * Implementation of a destructor for DJAudioPlayer
  *
+ * Cancels and waits for any pending load, then detaches the loaded source
+ * from the DeckTransportSource before the read-ahead thread is stopped
+ *
  */
-DJAudioPlayer::~DJAudioPlayer() {};
+DJAudioPlayer::~DJAudioPlayer() {
+	cancelLoad();
+	loaderPool.removeAllJobs(true, 10000);
+	{
+		const juce::SpinLock::ScopedLockType sl(sourceLock);
+		transportSource.setSource(nullptr, 0);
+		activeScratchSource = nullptr;
+	}
+	readAheadThread.stopThread(2000);
+};
 
 //==============================================================================
 
 /**
  * Implementation of prepareToPlay method for DJAudioPlayer
  *
- * Calls prepareToPlay methods on all AudioSource data members and saves the sample rate
+ * Calls prepareToPlay methods on all AudioSource data members, which reach the
+ * DeckTransportSource through the time stretcher and resampler, clears the
+ * filter state, prepares the level meter and saves the sample rate and block size.
+ * The active parameters are reapplied so the filter coefficients and the resampler
+ * ratio match the new sample rate, and the deck clock restarts from 0.
  *
  */
 void DJAudioPlayer::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
-	transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	resampleSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	audioLPFilter.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	audioHPFilter.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	audioLBFilter.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	audioMBFilter.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	audioHBFilter.prepareToPlay(samplesPerBlockExpected, sampleRate);
+	{
+		const juce::SpinLock::ScopedLockType sl(sourceLock);
+		timeStretchSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+		if (activeScratchSource != nullptr) {
+			activeScratchSource->prepareToPlay(samplesPerBlockExpected, sampleRate);
+		}
+	}
+	filterCascade.reset();
+	levelMeter.prepare(sampleRate, samplesPerBlockExpected);
 	thisSampleRate = sampleRate;
+	thisBlockSize = samplesPerBlockExpected;
+	applyParameters(activeParameters, true);
+	sampleClock.store(0, std::memory_order_relaxed);
 };
 
 /**
  * Implementation of getNextAudioBlock method for DJAudioPlayer
  *
- * Calls getNextAudioBlock methods on the main AudioSource data member and updates the root mean square value
+ * Applies the latest published parameter snapshot, if any, and starts or ends a scratch.
+ * The sources of the loaded file are only used if their lock can be taken, which fails
+ * only while installSource swaps in a new file, and the block is silent then. The resampler
+ * ratio follows the sample rate of a newly swapped in file. Then works through the
+ * queued transport commands due in this block. The block is rendered up to the sample
+ * of each command before it is carried out, so starts, stops and seeks land on the
+ * sample they were given. Commands due in a later block stay queued, and commands
+ * never move back before one already carried out. Runs the block through the filter
+ * cascade, hands it to the level meter and publishes the playhead. The time taken is smoothed into renderTime
  *
  */
 void DJAudioPlayer::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
-	audioLPFilter.getNextAudioBlock(bufferToFill);
-	float rmsLevelLeft = juce::Decibels::gainToDecibels(bufferToFill.buffer->getRMSLevel(0, 0, bufferToFill.buffer->getNumSamples()));
-	float rmsLevelRight = juce::Decibels::gainToDecibels(bufferToFill.buffer->getRMSLevel(1, 0, bufferToFill.buffer->getNumSamples()));
-	level = (rmsLevelLeft + rmsLevelRight) / 2;
+	const auto startTicks = juce::Time::getHighResolutionTicks();
+	Parameters newParameters;
+	if (parameterMailbox.fetch(newParameters)) {
+		applyParameters(newParameters);
+	}
+	const juce::int64 blockStart = sampleClock.load(std::memory_order_relaxed);
+	const juce::SpinLock::ScopedTryLockType sourceGuard(sourceLock);
+	if (!sourceGuard.isLocked()) {
+		bufferToFill.clearActiveBufferRegion();
+		sampleClock.store(blockStart + bufferToFill.numSamples, std::memory_order_relaxed);
+		return;
+	}
+	if (transportSource.getSourceSampleRate() != speedSampleRate) {
+		applySpeed(activeParameters);
+	}
+	blockScratchSource = activeScratchSource;
+	updateScratch();
+
+	int offset = 0;
+	TransportCommand command;
+	while (commandQueue.peek(command) && command.atSample < blockStart + bufferToFill.numSamples) {
+		const int commandOffset = (int)juce::jlimit((juce::int64)offset, (juce::int64)bufferToFill.numSamples, command.atSample - blockStart);
+		renderTransport(bufferToFill, offset, commandOffset - offset);
+		offset = commandOffset;
+		applyCommand(command);
+		commandQueue.pop();
+	}
+	renderTransport(bufferToFill, offset, bufferToFill.numSamples - offset);
+	sampleClock.store(blockStart + bufferToFill.numSamples, std::memory_order_relaxed);
+
+	auto* buffer = bufferToFill.buffer;
+	filterCascade.process(buffer->getWritePointer(0, bufferToFill.startSample),
+		buffer->getNumChannels() > 1 ? buffer->getWritePointer(1, bufferToFill.startSample) : nullptr,
+		bufferToFill.numSamples);
+	levelMeter.process(*buffer, bufferToFill.startSample, bufferToFill.numSamples);
+	publishPlayhead();
+	blockScratchSource = nullptr;
+
+	const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+	renderTime = renderTime + (elapsed - renderTime) * 0.05;
 };
 
 /**
  * Implementation of releaseResources method for DJAudioPlayer
  *
- * Calls releaseResources methods on the main AudioSource data member
+ * Calls releaseResources methods on the main AudioSource data member and the scratch source
  *
  */
 void DJAudioPlayer::releaseResources() {
-	audioLPFilter.releaseResources();
+	const juce::SpinLock::ScopedLockType sl(sourceLock);
+	timeStretchSource.releaseResources();
+	if (activeScratchSource != nullptr) {
+		activeScratchSource->releaseResources();
+	}
 };
 
 //============================================================================== 
@@ -67,31 +138,49 @@ void DJAudioPlayer::releaseResources() {
 /**
  * Implementation of start method for DJAudioPlayer
  *
- *  Calls the start method on the AudioTransportSource data member
+ *  Queues a start command for the audio thread
  *
  */
-void DJAudioPlayer::start() {
-	transportSource.start();
+void DJAudioPlayer::start(juce::int64 atSample) {
+	TransportCommand command;
+	command.type = TransportCommand::startCommand;
+	command.atSample = atSample;
+	queueCommand(command);
 };
 
 /**
  * Implementation of stop method for DJAudioPlayer
  *
- *  Calls the stop method on the AudioTransportSource data member
+ *  Queues a stop command for the audio thread
  *
  */
-void DJAudioPlayer::stop() {
-	transportSource.stop();
+void DJAudioPlayer::stop(juce::int64 atSample) {
+	TransportCommand command;
+	command.type = TransportCommand::stopCommand;
+	command.atSample = atSample;
+	queueCommand(command);
 };
 
 /**
  * Implementation of isPlaying method for DJAudioPlayer
  *
- * Returns if the AudioTransportSource data member is playing
+ * Fetches the latest playhead published by the audio thread and returns its playing flag,
+ * which follows the commands carried out there and the end of the file
  *
  */
 bool DJAudioPlayer::isPlaying() {
-	return transportSource.isPlaying();
+	playheadMailbox.fetch(latestPlayhead);
+	return latestPlayhead.playing;
+}
+
+/**
+ * Implementation of getSampleClock method for DJAudioPlayer
+ *
+ * Returns the sampleClock counter
+ *
+ */
+juce::int64 DJAudioPlayer::getSampleClock() {
+	return sampleClock;
 }
 
 /**
@@ -117,26 +206,343 @@ juce::URL DJAudioPlayer::returnURL() {
 /**
  * Implementation of loadURL method for DJAudioPlayer
  *
- * Creates a reader for the juce::URL and parses it into a juce::AudioFormatReaderSource
- * The AudioTransportSource data member sets it source using the juce::AudioFormatReaderSource
+ * Cancels any pending asynchronous load, opens and prepares the file on the calling
+ * thread and swaps it into the DeckTransportSource
  *
  */
 void DJAudioPlayer::loadURL(juce::URL audioURL) {
-	auto* reader = formatManager.createReaderFor(audioURL.createInputStream(false));
-	if (reader != nullptr) {
-		std::unique_ptr<juce::AudioFormatReaderSource> newSource(new juce::AudioFormatReaderSource(reader, true));
-		transportSource.setSource(newSource.get(), 0, nullptr, reader->sampleRate);
-		readerSource.reset(newSource.release());
-		DBG("real metadata size: " << reader->metadataValues.size());
-		loadedFileName = audioURL.getFileName();
-		loaded = true;
-		currentAudioURL = audioURL;
-	}
-	else
-	{
+	cancelLoad();
+	auto source = openSource(audioURL, loadMode, readAheadTime, memoryMapping, nullptr);
+	if (source == nullptr) {
 		DBG("Something went wrong loading the file ");
 		loaded = false;
+		return;
 	}
+	prepareSource(*source, thisBlockSize, thisSampleRate);
+	installSource(std::move(source), audioURL);
+};
+
+/**
+ * Implementation of loadURLAsync method for DJAudioPlayer
+ *
+ * Takes a new load generation, which makes any earlier job stale, and adds a job to the
+ * loader pool that opens the file with the current settings and prepares it for the
+ * current block size and sample rate, so a read-ahead prefills on the loader thread too.
+ * The job gives up as soon as its generation is stale. Progress and the prepared sources
+ * are posted back to the message thread, where they are dropped if the generation moved
+ * on or the player was deleted in the meantime; otherwise the sources are swapped in and
+ * the callbacks are called.
+ *
+ */
+void DJAudioPlayer::loadURLAsync(juce::URL audioURL, std::function<void(double)> onProgress, std::function<void(bool)> onFinished) {
+	const int generation = ++loadGeneration;
+	const LoadMode mode = loadMode;
+	const double readAheadSeconds = readAheadTime;
+	const bool allowMapping = memoryMapping;
+	const int blockSize = thisBlockSize;
+	const double outputSampleRate = thisSampleRate;
+	juce::WeakReference<DJAudioPlayer> weakThis(this);
+	loading = true;
+
+	loaderPool.addJob([this, weakThis, generation, mode, readAheadSeconds, allowMapping, blockSize, outputSampleRate, audioURL, onProgress, onFinished] {
+		auto isCurrent = [this, generation] { return loadGeneration == generation; };
+		auto reportProgress = [weakThis, generation, isCurrent, onProgress](double progress) {
+			if (onProgress != nullptr) {
+				juce::MessageManager::callAsync([weakThis, generation, onProgress, progress] {
+					if (weakThis != nullptr && weakThis->loadGeneration == generation) {
+						onProgress(progress);
+					}
+				});
+			}
+			return isCurrent();
+		};
+
+		if (!reportProgress(0)) {
+			return;
+		}
+		std::shared_ptr<OpenedSource> source(openSource(audioURL, mode, readAheadSeconds, allowMapping, reportProgress).release());
+		if (!isCurrent()) {
+			return;
+		}
+		if (source != nullptr) {
+			prepareSource(*source, blockSize, outputSampleRate);
+			if (!isCurrent()) {
+				return;
+			}
+		}
+
+		juce::MessageManager::callAsync([weakThis, generation, source, audioURL, onFinished] {
+			if (weakThis == nullptr || weakThis->loadGeneration != generation) {
+				return;
+			}
+			auto* player = weakThis.get();
+			player->loading = false;
+			if (source == nullptr) {
+				DBG("Something went wrong loading the file ");
+				player->loaded = false;
+			}
+			else {
+				player->installSource(std::unique_ptr<OpenedSource>(new OpenedSource(std::move(*source))), audioURL);
+			}
+			if (onFinished != nullptr) {
+				onFinished(source != nullptr);
+			}
+		});
+	});
+};
+
+/**
+ * Implementation of cancelLoad method for DJAudioPlayer
+ *
+ * Takes a new load generation so a pending job stops and its results are dropped
+ *
+ */
+void DJAudioPlayer::cancelLoad() {
+	++loadGeneration;
+	loading = false;
+};
+
+/**
+ * Implementation of isLoading method for DJAudioPlayer
+ *
+ * Returns the loading data member
+ *
+ */
+bool DJAudioPlayer::isLoading() {
+	return loading;
+};
+
+/**
+ * Implementation of openSource method for DJAudioPlayer
+ *
+ * In ramResident mode the whole file is first decoded into memory by the shared TrackDecoder
+ * and played from a DecodedAudioSource. Otherwise uncompressed WAV and AIFF files are played
+ * through a memory mapped MappedAudioSource, unless mapping is turned off. Any other file, or one that fails to load that way,
+ * gets a reader for the juce::URL parsed into a juce::AudioFormatReaderSource.
+ * When a read-ahead time is set, the juce::AudioFormatReaderSource is wrapped in a
+ * ReadAheadAudioSource so decoding happens on the read-ahead thread. Those are then
+ * wrapped in a CuePrerollSource with a second reader, so hot cues play from memory.
+ * Whatever the outermost source is, it is finally wrapped in a LoopAudioSource,
+ * and a ScratchAudioSource is opened next to it.
+ *
+ */
+std::unique_ptr<DJAudioPlayer::OpenedSource> DJAudioPlayer::openSource(const juce::URL& audioURL, LoadMode mode, double readAheadSeconds, bool allowMapping, std::function<bool(double)> progressCallback) {
+	std::unique_ptr<OpenedSource> source(new OpenedSource());
+
+	if (mode == ramResident) {
+		auto decoded = trackDecoder->decode(audioURL, formatManager, progressCallback);
+		if (decoded != nullptr) {
+			source->decodedSource.reset(new DecodedAudioSource(decoded));
+			source->playbackSource = source->decodedSource.get();
+			source->sampleRate = decoded->getSampleRate();
+			addLoopSource(*source, audioURL);
+			addScratchSource(*source, audioURL);
+			return source;
+		}
+		if (progressCallback != nullptr && !progressCallback(0)) {
+			return nullptr;
+		}
+		DBG("DJAudioPlayer::openSource: falling back to streaming " << audioURL.getFileName());
+	}
+
+	if (allowMapping) {
+		source->mappedSource = MappedAudioSource::createFor(audioURL, formatManager, readAheadThread, readAheadSeconds);
+	}
+	if (source->mappedSource != nullptr) {
+		source->playbackSource = source->mappedSource.get();
+		source->sampleRate = source->mappedSource->getSampleRate();
+		addLoopSource(*source, audioURL);
+		addScratchSource(*source, audioURL);
+		return source;
+	}
+
+	auto* reader = formatManager.createReaderFor(audioURL.createInputStream(false));
+	if (reader == nullptr) {
+		return nullptr;
+	}
+	source->readerSource.reset(new juce::AudioFormatReaderSource(reader, true));
+	if (readAheadSeconds > 0) {
+		source->readAheadSource.reset(new ReadAheadAudioSource(source->readerSource.get(), readAheadThread, (int)(readAheadSeconds * reader->sampleRate)));
+	}
+	source->playbackSource = source->readAheadSource != nullptr ? static_cast<juce::PositionableAudioSource*>(source->readAheadSource.get()) : source->readerSource.get();
+	source->sampleRate = reader->sampleRate;
+
+	if (auto* cueReader = formatManager.createReaderFor(audioURL.createInputStream(false))) {
+		source->cuePrerollSource.reset(new CuePrerollSource(source->playbackSource, source->readAheadSource.get(), cueReader, readAheadThread));
+		source->playbackSource = source->cuePrerollSource.get();
+	}
+	DBG("real metadata size: " << reader->metadataValues.size());
+	addLoopSource(*source, audioURL);
+	addScratchSource(*source, audioURL);
+	return source;
+};
+
+/**
+ * Implementation of addLoopSource method for DJAudioPlayer
+ *
+ * Loops are decoded on the read-ahead thread, which already decodes the cue windows.
+ *
+ */
+void DJAudioPlayer::addLoopSource(OpenedSource& source, const juce::URL& audioURL) {
+	if (auto* loopReader = formatManager.createReaderFor(audioURL.createInputStream(false))) {
+		source.loopSource.reset(new LoopAudioSource(source.playbackSource, loopReader, readAheadThread));
+		source.playbackSource = source.loopSource.get();
+	}
+};
+
+/**
+ * Implementation of addScratchSource method for DJAudioPlayer
+ *
+ * The scratch cache is filled on the read-ahead thread along with everything else read ahead.
+ *
+ */
+void DJAudioPlayer::addScratchSource(OpenedSource& source, const juce::URL& audioURL) {
+	if (auto* scratchReader = formatManager.createReaderFor(audioURL.createInputStream(false))) {
+		source.scratchSource.reset(new ScratchAudioSource(scratchReader, readAheadThread));
+	}
+};
+
+/**
+ * Implementation of prepareSource method for DJAudioPlayer
+ *
+ * The playback source is prepared at the sample rate of the file, as the resampler after
+ * the DeckTransportSource converts it, and the scratch source at the output rate.
+ *
+ */
+void DJAudioPlayer::prepareSource(OpenedSource& source, int blockSize, double outputSampleRate) {
+	source.playbackSource->prepareToPlay(blockSize, source.sampleRate);
+	if (source.scratchSource != nullptr) {
+		source.scratchSource->prepareToPlay(blockSize, outputSampleRate);
+	}
+	source.preparedBlockSize = blockSize;
+	source.preparedSampleRate = outputSampleRate;
+};
+
+/**
+ * Implementation of installSource method for DJAudioPlayer
+ *
+ * The new playback and scratch sources arrive prepared and are only prepared again if
+ * the device changed its block size or sample rate while they were loading. They are
+ * swapped into the DeckTransportSource data member and the scratch source slot together
+ * under the source lock, so the audio thread moves from the old file to the new one between two blocks and
+ * never holds on to the old sources. The resampler and time stretcher drop what they
+ * buffered from the old file, and the old sources are released and freed once nothing
+ * references them.
+ *
+ */
+void DJAudioPlayer::installSource(std::unique_ptr<OpenedSource> source, const juce::URL& audioURL) {
+	if (source->preparedBlockSize != thisBlockSize || source->preparedSampleRate != thisSampleRate) {
+		prepareSource(*source, thisBlockSize, thisSampleRate);
+	}
+	auto* scratch = source->scratchSource.get();
+	{
+		const juce::SpinLock::ScopedLockType sl(sourceLock);
+		transportSource.setSource(source->playbackSource, source->sampleRate);
+		activeScratchSource = scratch;
+	}
+	resampleSource.requestReset();
+	timeStretchSource.requestReset();
+	if (openedSource != nullptr) {
+		openedSource->playbackSource->releaseResources();
+	}
+	openedSource = std::move(source);
+	loadedFileName = audioURL.getFileName();
+	loaded = true;
+	currentAudioURL = audioURL;
+};
+
+/**
+ * Implementation of setReadAheadTime method for DJAudioPlayer
+ *
+ * Sets the readAheadTime data member used by the next loadURL call
+ *
+ */
+void DJAudioPlayer::setReadAheadTime(double seconds) {
+	readAheadTime = juce::jmax(0.0, seconds);
+};
+
+/**
+ * Implementation of setLoadMode method for DJAudioPlayer
+ *
+ * Sets the loadMode data member used by the next loadURL call
+ *
+ */
+void DJAudioPlayer::setLoadMode(LoadMode mode) {
+	loadMode = mode;
+};
+
+/**
+ * Implementation of setMemoryMapping method for DJAudioPlayer
+ *
+ * Sets the memoryMapping data member used by the next loadURL call
+ *
+ */
+void DJAudioPlayer::setMemoryMapping(bool shouldMap) {
+	memoryMapping = shouldMap;
+};
+
+/**
+ * Implementation of getLoadMode method for DJAudioPlayer
+ *
+ * Returns the loadMode data member
+ *
+ */
+DJAudioPlayer::LoadMode DJAudioPlayer::getLoadMode() {
+	return loadMode;
+};
+
+/**
+ * Implementation of isRamResident method for DJAudioPlayer
+ *
+ * Returns true if the DecodedAudioSource data member is playing the loaded file
+ *
+ */
+bool DJAudioPlayer::isRamResident() {
+	return openedSource != nullptr && openedSource->decodedSource != nullptr;
+};
+
+/**
+ * Implementation of isMemoryMapped method for DJAudioPlayer
+ *
+ * Returns true if the MappedAudioSource data member is playing the loaded file
+ *
+ */
+bool DJAudioPlayer::isMemoryMapped() {
+	return openedSource != nullptr && openedSource->mappedSource != nullptr;
+};
+
+/**
+ * Implementation of getReadAheadFillLevel method for DJAudioPlayer
+ *
+ * Returns the fill level of the ReadAheadAudioSource data member,
+ * or 1 when the player reads on the audio thread
+ *
+ */
+float DJAudioPlayer::getReadAheadFillLevel() {
+	return openedSource != nullptr && openedSource->readAheadSource != nullptr ? openedSource->readAheadSource->getBufferFillLevel() : 1.0f;
+};
+
+/**
+ * Implementation of getReadAheadLength method for DJAudioPlayer
+ *
+ * Converts the buffer length of the ReadAheadAudioSource data member to seconds of
+ * the file, or returns 0 when the player reads on the audio thread
+ *
+ */
+double DJAudioPlayer::getReadAheadLength() {
+	return openedSource != nullptr && openedSource->readAheadSource != nullptr && openedSource->sampleRate > 0
+		? openedSource->readAheadSource->getBufferLength() / openedSource->sampleRate : 0.0;
+};
+
+/**
+ * Implementation of getUnderrunCount method for DJAudioPlayer
+ *
+ * Returns the underrun count of the ReadAheadAudioSource data member,
+ * or 0 when the player reads on the audio thread
+ *
+ */
+int DJAudioPlayer::getUnderrunCount() {
+	return openedSource != nullptr && openedSource->readAheadSource != nullptr ? openedSource->readAheadSource->getUnderrunCount() : 0;
 };
 
 //==============================================================================
@@ -144,22 +550,44 @@ void DJAudioPlayer::loadURL(juce::URL audioURL) {
 /**
  * Implementation of getRMSLevel method for DJAudioPlayer
  *
- * Returns the level data member
+ * Returns the ballistic RMS level of the LevelMeter data member
  *
  */
 float DJAudioPlayer::getRMSLevel() {
-	return level;
+	return levelMeter.getRMSDecibels();
+};
+
+/**
+ * Implementation of getLevelMeter method for DJAudioPlayer
+ *
+ * Returns the LevelMeter data member
+ *
+ */
+LevelMeter& DJAudioPlayer::getLevelMeter() {
+	return levelMeter;
 };
 
 /**
  * Implementation of getPositionRelative method for DJAudioPlayer
  *
- * Returns the relative position of the AudioTransportSource data member.
+ * Returns the extrapolated position relative to the length of the file in the published playhead.
  * Value returned is between 0 and 1.
  *
  */
 double DJAudioPlayer::getPositionRelative() {
-	return (transportSource.getLengthInSeconds() == 0 ? 0 : transportSource.getCurrentPosition() / transportSource.getLengthInSeconds());
+	const double position = getCurrentPosition();
+	return (latestPlayhead.length == 0 ? 0 : position / latestPlayhead.length);
+}
+
+/**
+ * Implementation of getLengthInSeconds method for DJAudioPlayer
+ *
+ * Returns the length of the loaded playback source, which the message thread owns, so the
+ * DeckTransportSource data member is left to the audio thread.
+ *
+ */
+double DJAudioPlayer::getLengthInSeconds() {
+	return openedSource != nullptr && openedSource->sampleRate > 0 ? (double)openedSource->playbackSource->getTotalLength() / openedSource->sampleRate : 0.0;
 }
 
 //==============================================================================
@@ -171,8 +599,8 @@ double DJAudioPlayer::getPositionRelative() {
  * functionality before setting the playerVolume.
  * Non volume functionality would impact the cross fader
  * volume.
- * Calls the setGain method on the AudioTransportSource data member,
- * passing in the multiplication of the player volume and cross fader volume.
+ * Publishes the multiplication of the player volume, cross fader volume and
+ * normalising gain for the audio thread to apply to the DeckTransportSource data member.
  *
  */
 void DJAudioPlayer::setGain(double gain, bool isVol) {
@@ -186,38 +614,269 @@ void DJAudioPlayer::setGain(double gain, bool isVol) {
 		DBG("DJAudioPlayer:: setGain Gain should be between 0 and 1");
 	}
 	else {
-		transportSource.setGain(playerVol * crossFadeVol);
+		pendingParameters.gain = playerVol * crossFadeVol * juce::Decibels::decibelsToGain(normalisationDb);
+		parameterMailbox.publish(pendingParameters);
 	}
 
 };
 
+/**
+ * Implementation of setNormalisation method for DJAudioPlayer
+ *
+ * The gain takes the track to the target loudness, lowered if that would push its true
+ * peak over the ceiling and capped at the largest boost, so a quiet track with sharp
+ * transients is not raised into clipping. Unanalysed tracks play at unity gain.
+ * Publishes the gain with the volume and cross fader gain, so the audio thread does
+ * no more work than for a volume change.
+ *
+ */
+void DJAudioPlayer::setNormalisation(double loudness, double truePeak) {
+	if (loudness == 0 || loudness <= TrackAnalyser::minLevel) {
+		normalisationDb = 0;
+	}
+	else {
+		normalisationDb = juce::jmin(targetLoudness - loudness, truePeakCeiling - truePeak, maxNormalisationBoost);
+	}
+	pendingParameters.gain = playerVol * crossFadeVol * juce::Decibels::decibelsToGain(normalisationDb);
+	parameterMailbox.publish(pendingParameters);
+};
+
+/**
+ * Implementation of getNormalisationDecibels method for DJAudioPlayer
+ *
+ * Returns the normalisationDb data member
+ *
+ */
+double DJAudioPlayer::getNormalisationDecibels() {
+	return normalisationDb;
+};
+
 /**
  * Implementation of setSpeed method for DJAudioPlayer
  *
- * If conditional acting as guard clause, ensuring resampling
- * ratio isnt set below 0 or above 100.
- * Sets ResamplingAudioSource data member's resampling ratio with
- * passed in value
+ * If conditional acting as guard clause, ensuring the speed
+ * isnt set below 0 or above 100.
+ * Publishes the passed in value for the audio thread, which multiplies it with the
+ * ratio of the file and output sample rates for the PolyphaseResamplingAudioSource
+ * data member, or hands it to the time stretcher when keylock is on. The resampler
+ * holds its ratio between 0.05 and 4, the speed slider covers 0.8 to 1.2.
  *
  */
 void DJAudioPlayer::setSpeed(double ratio) {
 	if (ratio < 0 || ratio > 100.0) {
-		DBG("DJAudioPlayer:: setGain Gain should be between 0 and 100");
+		DBG("DJAudioPlayer:: setSpeed Speed should be between 0 and 100");
 	}
 	else {
-		resampleSource.setResamplingRatio(ratio);
+		pendingParameters.speed = ratio;
+		parameterMailbox.publish(pendingParameters);
+	}
+};
+
+/**
+ * Implementation of setKeylock method for DJAudioPlayer
+ *
+ * Publishes the keylock state for the audio thread to apply
+ *
+ */
+void DJAudioPlayer::setKeylock(bool shouldLock) {
+	pendingParameters.keylock = shouldLock;
+	parameterMailbox.publish(pendingParameters);
+};
+
+/**
+ * Implementation of isKeylockEnabled method for DJAudioPlayer
+ *
+ * Returns the keylock state last set from the message thread
+ *
+ */
+bool DJAudioPlayer::isKeylockEnabled() {
+	return pendingParameters.keylock;
+};
+
+/**
+ * Implementation of setResamplerQuality method for DJAudioPlayer
+ *
+ * Publishes the resampler quality tier for the audio thread to apply
+ *
+ */
+void DJAudioPlayer::setResamplerQuality(PolyphaseResamplingAudioSource::Quality quality) {
+	pendingParameters.resamplerQuality = quality;
+	parameterMailbox.publish(pendingParameters);
+};
+
+/**
+ * Implementation of getResamplerQuality method for DJAudioPlayer
+ *
+ * Returns the resampler quality tier last set from the message thread
+ *
+ */
+PolyphaseResamplingAudioSource::Quality DJAudioPlayer::getResamplerQuality() {
+	return pendingParameters.resamplerQuality;
+};
+
+/**
+ * Implementation of setCuePoint method for DJAudioPlayer
+ *
+ * Converts the relative position into samples of the loaded file and hands it
+ * to the CuePrerollSource, if the file has one
+ *
+ */
+void DJAudioPlayer::setCuePoint(int index, double pos) {
+	if (openedSource != nullptr && openedSource->cuePrerollSource != nullptr) {
+		openedSource->cuePrerollSource->setCue(index, (juce::int64)(pos * openedSource->cuePrerollSource->getTotalLength()));
+	}
+};
+
+/**
+ * Implementation of clearCuePoints method for DJAudioPlayer
+ *
+ * Clears the cue windows of the CuePrerollSource, if the file has one
+ *
+ */
+void DJAudioPlayer::clearCuePoints() {
+	if (openedSource != nullptr && openedSource->cuePrerollSource != nullptr) {
+		openedSource->cuePrerollSource->clearCues();
+	}
+};
+
+/**
+ * Implementation of setLoopIn method for DJAudioPlayer
+ *
+ * Converts the start into samples of the loaded file and hands it to the LoopAudioSource
+ *
+ */
+void DJAudioPlayer::setLoopIn(double startSecs) {
+	if (openedSource != nullptr && openedSource->loopSource != nullptr) {
+		openedSource->loopSource->setLoopStart((juce::int64)(startSecs * openedSource->sampleRate));
+	}
+};
+
+/**
+ * Implementation of setLoop method for DJAudioPlayer
+ *
+ * Converts the loop into samples of the loaded file and hands it to the LoopAudioSource
+ *
+ */
+void DJAudioPlayer::setLoop(double startSecs, double endSecs, bool roll) {
+	if (openedSource != nullptr && openedSource->loopSource != nullptr) {
+		openedSource->loopSource->setLoop((juce::int64)(startSecs * openedSource->sampleRate), (juce::int64)(endSecs * openedSource->sampleRate), roll);
+	}
+};
+
+/**
+ * Implementation of exitLoop method for DJAudioPlayer
+ *
+ * Exits the loop of the LoopAudioSource, if the file has one
+ *
+ */
+void DJAudioPlayer::exitLoop() {
+	if (openedSource != nullptr && openedSource->loopSource != nullptr) {
+		openedSource->loopSource->exitLoop();
 	}
 };
 
+/**
+ * Implementation of isLoopActive method for DJAudioPlayer
+ *
+ * Returns if the LoopAudioSource has a loop set
+ *
+ */
+bool DJAudioPlayer::isLoopActive() {
+	return openedSource != nullptr && openedSource->loopSource != nullptr && openedSource->loopSource->isLoopActive();
+};
+
+/**
+ * Implementation of getCurrentPosition method for DJAudioPlayer
+ *
+ * Fetches the latest playhead published by the audio thread and moves it on at its rate
+ * for the time since it was taken, so the position keeps moving smoothly between audio
+ * blocks. The transport itself is never touched.
+ *
+ */
+double DJAudioPlayer::getCurrentPosition() {
+	playheadMailbox.fetch(latestPlayhead);
+	const double elapsed = juce::jlimit(0.0, maxExtrapolation, (juce::Time::getMillisecondCounterHiRes() - latestPlayhead.timestamp) / 1000.0);
+	return juce::jlimit(0.0, latestPlayhead.length, latestPlayhead.position + latestPlayhead.rate * elapsed);
+};
+
+/**
+ * Implementation of setScratch method for DJAudioPlayer
+ *
+ * Publishes the scratch state and velocity for the audio thread to apply,
+ * only when they changed as the jog wheel reports them on every timer tick
+ *
+ */
+void DJAudioPlayer::setScratch(bool isScratching, double velocity) {
+	if (pendingParameters.scratching != isScratching || pendingParameters.scratchVelocity != velocity) {
+		pendingParameters.scratching = isScratching;
+		pendingParameters.scratchVelocity = velocity;
+		parameterMailbox.publish(pendingParameters);
+	}
+};
+
+/**
+ * Implementation of setSlip method for DJAudioPlayer
+ *
+ * Publishes the slip state for the audio thread to apply
+ *
+ */
+void DJAudioPlayer::setSlip(bool shouldSlip) {
+	pendingParameters.slip = shouldSlip;
+	parameterMailbox.publish(pendingParameters);
+};
+
+/**
+ * Implementation of isSlipEnabled method for DJAudioPlayer
+ *
+ * Returns the slip state last set from the message thread
+ *
+ */
+bool DJAudioPlayer::isSlipEnabled() {
+	return pendingParameters.slip;
+};
+
+/**
+ * Implementation of getSeekLatency method for DJAudioPlayer
+ *
+ * Returns the seek latency measured by the CuePrerollSource, if the file has one
+ *
+ */
+double DJAudioPlayer::getSeekLatency() {
+	return openedSource != nullptr && openedSource->cuePrerollSource != nullptr ? openedSource->cuePrerollSource->getLastSeekLatency() : -1.0;
+};
+
+/**
+ * Implementation of getRenderTime method for DJAudioPlayer
+ *
+ * Returns the renderTime data member
+ *
+ */
+double DJAudioPlayer::getRenderTime() {
+	return renderTime;
+};
+
+/**
+ * Implementation of wasSeekFromCue method for DJAudioPlayer
+ *
+ * Returns if the CuePrerollSource served the last seek from a cue window
+ *
+ */
+bool DJAudioPlayer::wasSeekFromCue() {
+	return openedSource != nullptr && openedSource->cuePrerollSource != nullptr && openedSource->cuePrerollSource->wasLastSeekFromCue();
+};
+
 /**
  * Implementation of setPosition method for DJAudioPlayer
  *
- * Sets the playback position by calling setPosition method
- * in the AudioTransportSource data member
+ * Queues a seek command for the audio thread
  *
  */
-void DJAudioPlayer::setPosition(double posInSecs) {
-	transportSource.setPosition(posInSecs);
+void DJAudioPlayer::setPosition(double posInSecs, juce::int64 atSample) {
+	TransportCommand command;
+	command.type = TransportCommand::seekCommand;
+	command.seconds = posInSecs;
+	command.atSample = atSample;
+	queueCommand(command);
 };
 
 /**
@@ -227,70 +886,316 @@ void DJAudioPlayer::setPosition(double posInSecs) {
  * Converts value into a length in seconds and calls setPosition with converted value.
  *
  */
-void DJAudioPlayer::setPositionRelative(double pos) {
+void DJAudioPlayer::setPositionRelative(double pos, juce::int64 atSample) {
 	if (pos < 0 || pos > 1) {
 		DBG("DJAudioPlayer:: setPositionRelative pos should be between 0 and 1");
 	}
 	else {
-		double posInSecs = transportSource.getLengthInSeconds() * pos;
-		setPosition(posInSecs);
+		double posInSecs = getLengthInSeconds() * pos;
+		setPosition(posInSecs, atSample);
 	}
 }
 
 /**
  * Implementation of setFilter method for DJAudioPlayer
  *
- * Sets the high pass IIRCoefficients or low pass IIRCoefficients
- * on the IIRFilterAudioSource data members depending on the freq
- * value passed in
+ * Publishes the low pass or high pass frequency for the audio thread to apply
  *
  */
 void DJAudioPlayer::setFilter(double freq) {
-	if (freq > 0 && freq < 20000) {
-		audioLPFilter.makeInactive();
-		audioHPFilter.setCoefficients(juce::IIRCoefficients::makeHighPass(thisSampleRate, freq));
-	}
-	else if (freq < 0 && freq > -20000) {
-		audioHPFilter.makeInactive();
-		audioLPFilter.setCoefficients(juce::IIRCoefficients::makeLowPass(thisSampleRate, 20000 + freq));
-	}
-	else if (freq == 0) {
-		audioHPFilter.makeInactive();
-		audioLPFilter.makeInactive();
-	}
+	pendingParameters.filterFrequency = freq;
+	parameterMailbox.publish(pendingParameters);
 }
 
 /**
  * Implementation of setLBFilter method for DJAudioPlayer
  *
- * Sets the low shelf IIRCoefficients on the IIRFilterAudioSource
- * data member depending on the gain value passed in
+ * Publishes the low band gain for the audio thread to apply
  *
  */
 void DJAudioPlayer::setLBFilter(double gain) {
-	audioLBFilter.setCoefficients(juce::IIRCoefficients::makeLowShelf(thisSampleRate, 500, 1.0 / juce::MathConstants<double>::sqrt2, gain));
+	pendingParameters.lowBandGain = gain;
+	parameterMailbox.publish(pendingParameters);
 };
 
 /**
  * Implementation of setMBFilter method for DJAudioPlayer
  *
- * Sets the peak filter IIRCoefficients on the IIRFilterAudioSource
- * data member depending on the gain value passed in
+ * Publishes the mid band gain for the audio thread to apply
  *
  */
 void DJAudioPlayer::setMBFilter(double gain) {
-	audioMBFilter.setCoefficients(juce::IIRCoefficients::makePeakFilter(thisSampleRate, 3250, 1.0 / juce::MathConstants<double>::sqrt2, gain));
+	pendingParameters.midBandGain = gain;
+	parameterMailbox.publish(pendingParameters);
 };
 
 /**
  * Implementation of setHBFilter method for DJAudioPlayer
  *
- * Sets the high shelf IIRCoefficients on the IIRFilterAudioSource
- * data member depending on the gain value passed in
+ * Publishes the high band gain for the audio thread to apply
  *
  */
 void DJAudioPlayer::setHBFilter(double gain) {
-	audioHBFilter.setCoefficients(juce::IIRCoefficients::makeHighShelf(thisSampleRate, 5000, 1.0 / juce::MathConstants<double>::sqrt2, gain));
+	pendingParameters.highBandGain = gain;
+	parameterMailbox.publish(pendingParameters);
+};
+
+//==============================================================================
+
+/**
+ * Implementation of queueCommand method for DJAudioPlayer
+ *
+ * Pushes the command onto the CommandQueue data member. The queue only fills up if the
+ * audio thread stops taking commands, in which case the command is dropped.
+ *
+ */
+void DJAudioPlayer::queueCommand(const TransportCommand& command) {
+	if (!commandQueue.push(command)) {
+		DBG("DJAudioPlayer::queueCommand: transport command queue is full");
+	}
+}
+
+/**
+ * Implementation of applyCommand method for DJAudioPlayer
+ *
+ * Starting only starts pulling audio from the DeckTransportSource data member, if a file is
+ * loaded, and stopping stops pulling it after a short fade out; the new state reaches the
+ * message thread with the next playhead. A seek hands the position down the chain of
+ * sources, none of which block on it, drops the input the resampler and time stretcher
+ * buffered from the old position, and cuts the fade out of a stop short.
+ *
+ */
+void DJAudioPlayer::applyCommand(const TransportCommand& command) {
+	switch (command.type) {
+	case TransportCommand::startCommand:
+		playing = transportSource.getSourceSampleRate() > 0;
+		stopFadeRemaining = 0;
+		break;
+	case TransportCommand::stopCommand:
+		if (playing) {
+			playing = false;
+			stopFadeRemaining = stopFadeLength;
+		}
+		break;
+	case TransportCommand::seekCommand:
+		transportSource.setPosition(command.seconds);
+		resampleSource.requestReset();
+		timeStretchSource.requestReset();
+		stopFadeRemaining = 0;
+		break;
+	}
+}
+
+/**
+ * Implementation of renderTransport method for DJAudioPlayer
+ *
+ * While scratching, renders from the scratch source with the deck gain, which the
+ * DeckTransportSource would otherwise apply, and moves the slip position on as far as
+ * the transport would have played. With slip on, the slip position is handed to the
+ * transport every block; that only tells its background reader where to fill from, so
+ * the audio is already read when the scratch ends there. While playing, renders from the main AudioSource
+ * data member and stops once the DeckTransportSource has played past the end of
+ * the file. After a stop, renders what is left of the fade out and clears the rest.
+ *
+ */
+void DJAudioPlayer::renderTransport(const juce::AudioSourceChannelInfo& bufferToFill, int offset, int numSamples) {
+	if (numSamples <= 0) {
+		return;
+	}
+	auto* buffer = bufferToFill.buffer;
+	const int startSample = bufferToFill.startSample + offset;
+
+	if (scratchActive) {
+		auto* scratch = blockScratchSource;
+		scratch->getNextAudioBlock(juce::AudioSourceChannelInfo(buffer, startSample, numSamples));
+		buffer->applyGain(startSample, numSamples, (float)activeParameters.gain);
+		if (playing) {
+			slipPosition += numSamples * activeParameters.speed * scratch->getFileSampleRate() / thisSampleRate;
+			if (activeParameters.slip) {
+				transportSource.setPosition(slipPosition / scratch->getFileSampleRate());
+			}
+		}
+		return;
+	}
+
+	if (playing) {
+		timeStretchSource.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer, startSample, numSamples));
+		if (transportSource.hasStreamFinished()) {
+			playing = false;
+		}
+		return;
+	}
+
+	const int fadeSamples = juce::jmin(stopFadeRemaining, numSamples);
+	if (fadeSamples > 0) {
+		timeStretchSource.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer, startSample, fadeSamples));
+		for (auto chan = 0; chan < buffer->getNumChannels(); ++chan) {
+			buffer->applyGainRamp(chan, startSample, fadeSamples, (float)stopFadeRemaining / stopFadeLength, (float)(stopFadeRemaining - fadeSamples) / stopFadeLength);
+		}
+		stopFadeRemaining -= fadeSamples;
+	}
+	buffer->clear(startSample + fadeSamples, numSamples - fadeSamples);
+}
+
+/**
+ * Implementation of updateScratch method for DJAudioPlayer
+ *
+ * A scratch starts where the transport is, at the speed the deck was playing, and the
+ * scratch source eases from there to the jog velocity. The slip position starts there
+ * too. When the scratch ends with slip on, the transport is already at the slip position,
+ * which renderTransport kept handing it; otherwise it is moved to the scratch position.
+ * Either way the resampler and time stretcher drop what they buffered. A scratch whose source went away with a new file just ends. Outside a
+ * scratch the scratch source is kept centred on the transport position.
+ *
+ */
+void DJAudioPlayer::updateScratch() {
+	auto* scratch = blockScratchSource;
+	const bool wantScratch = activeParameters.scratching && scratch != nullptr;
+	if (wantScratch && !scratchActive) {
+		slipPosition = transportSource.getCurrentPosition() * scratch->getFileSampleRate();
+		scratch->begin(slipPosition, playing ? activeParameters.speed : 0.0);
+		scratchActive = true;
+		stopFadeRemaining = 0;
+	}
+	else if (!wantScratch && scratchActive) {
+		scratchActive = false;
+		if (scratch != nullptr) {
+			if (!activeParameters.slip || !playing) {
+				const double target = activeParameters.slip ? slipPosition : scratch->getPosition();
+				transportSource.setPosition(target / scratch->getFileSampleRate());
+			}
+			resampleSource.requestReset();
+			timeStretchSource.requestReset();
+		}
+	}
+
+	if (scratchActive) {
+		scratch->setVelocity(activeParameters.scratchVelocity);
+	}
+	else if (scratch != nullptr) {
+		scratch->setPlayhead((juce::int64)(transportSource.getCurrentPosition() * scratch->getFileSampleRate()));
+	}
+}
+
+/**
+ * Implementation of publishPlayhead method for DJAudioPlayer
+ *
+ * Takes the position from the scratch source while scratching and from the
+ * DeckTransportSource data member otherwise, with the rate it is moving at and
+ * whether the deck is playing.
+ *
+ */
+void DJAudioPlayer::publishPlayhead() {
+	Playhead playhead;
+	playhead.length = transportSource.getLengthInSeconds();
+	playhead.playing = playing;
+	if (scratchActive) {
+		playhead.position = blockScratchSource->getPosition() / blockScratchSource->getFileSampleRate();
+		playhead.rate = activeParameters.scratchVelocity;
+	}
+	else {
+		playhead.position = transportSource.getCurrentPosition();
+		playhead.rate = playing ? activeParameters.speed : 0.0;
+	}
+	playhead.timestamp = juce::Time::getMillisecondCounterHiRes();
+	playheadMailbox.publish(playhead);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of applyParameters method for DJAudioPlayer
+ *
+ * Compares the snapshot with the last applied one and only updates the
+ * DeckTransportSource gain, resampler ratio and quality, time stretch and filter stages
+ * whose settings changed, so coefficients are not recomputed every block.
+ *
+ */
+void DJAudioPlayer::applyParameters(const Parameters& newParameters, bool applyAll) {
+	if (applyAll || newParameters.gain != activeParameters.gain) {
+		transportSource.setGain((float)newParameters.gain);
+	}
+	if (applyAll || newParameters.speed != activeParameters.speed || newParameters.keylock != activeParameters.keylock) {
+		applySpeed(newParameters);
+	}
+	if (applyAll || newParameters.resamplerQuality != activeParameters.resamplerQuality) {
+		resampleSource.setQuality(newParameters.resamplerQuality);
+	}
+	if (applyAll || newParameters.filterFrequency != activeParameters.filterFrequency) {
+		applyFilter(newParameters.filterFrequency);
+	}
+	if (applyAll || newParameters.lowBandGain != activeParameters.lowBandGain) {
+		applyBandFilter(lowBandStage, newParameters.lowBandGain);
+	}
+	if (applyAll || newParameters.midBandGain != activeParameters.midBandGain) {
+		applyBandFilter(midBandStage, newParameters.midBandGain);
+	}
+	if (applyAll || newParameters.highBandGain != activeParameters.highBandGain) {
+		applyBandFilter(highBandStage, newParameters.highBandGain);
+	}
+	activeParameters = newParameters;
+}
+
+/**
+ * Implementation of applySpeed method for DJAudioPlayer
+ *
+ * The DeckTransportSource does not resample, so the resampler also converts the file to
+ * the device sample rate. With keylock it only does that and the speed goes to the time
+ * stretcher instead.
+ *
+ */
+void DJAudioPlayer::applySpeed(const Parameters& newParameters) {
+	speedSampleRate = transportSource.getSourceSampleRate();
+	const double fileRatio = speedSampleRate > 0 ? speedSampleRate / thisSampleRate : 1.0;
+	resampleSource.setResamplingRatio(newParameters.keylock ? fileRatio : newParameters.speed * fileRatio);
+	timeStretchSource.setTempo(newParameters.speed);
+	timeStretchSource.setEnabled(newParameters.keylock);
+}
+
+/**
+ * Implementation of applyFilter method for DJAudioPlayer
+ *
+ * Sets the high pass IIRCoefficients or low pass IIRCoefficients
+ * on the filter cascade depending on the freq value passed in,
+ * bypassing the other stage
+ *
+ */
+void DJAudioPlayer::applyFilter(double freq) {
+	if (freq > 0 && freq < 20000) {
+		filterCascade.setBypassed(lowPassStage);
+		filterCascade.setCoefficients(highPassStage, juce::IIRCoefficients::makeHighPass(thisSampleRate, freq));
+	}
+	else if (freq < 0 && freq > -20000) {
+		filterCascade.setBypassed(highPassStage);
+		filterCascade.setCoefficients(lowPassStage, juce::IIRCoefficients::makeLowPass(thisSampleRate, 20000 + freq));
+	}
+	else if (freq == 0) {
+		filterCascade.setBypassed(highPassStage);
+		filterCascade.setBypassed(lowPassStage);
+	}
+}
+
+/**
+ * Implementation of applyBandFilter method for DJAudioPlayer
+ *
+ * Sets the low shelf, peak filter or high shelf IIRCoefficients on the
+ * filter cascade depending on the stage and gain value passed in.
+ * A unity gain bypasses the stage
+ *
+ */
+void DJAudioPlayer::applyBandFilter(int stage, double gain) {
+	if (gain == 1) {
+		filterCascade.setBypassed(stage);
+	}
+	else if (stage == lowBandStage) {
+		filterCascade.setCoefficients(stage, juce::IIRCoefficients::makeLowShelf(thisSampleRate, 500, 1.0 / juce::MathConstants<double>::sqrt2, gain));
+	}
+	else if (stage == midBandStage) {
+		filterCascade.setCoefficients(stage, juce::IIRCoefficients::makePeakFilter(thisSampleRate, 3250, 1.0 / juce::MathConstants<double>::sqrt2, gain));
+	}
+	else if (stage == highBandStage) {
+		filterCascade.setCoefficients(stage, juce::IIRCoefficients::makeHighShelf(thisSampleRate, 5000, 1.0 / juce::MathConstants<double>::sqrt2, gain));
+	}
 };
 
 //==============================================================================
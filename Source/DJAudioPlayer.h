@@ -1,18 +1,52 @@
 
 #pragma once
 #include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include "ReadAheadAudioSource.h"
+#include "DeckTransportSource.h"
+#include "BiquadCascade.h"
+#include "ParameterMailbox.h"
+#include "CommandQueue.h"
+#include "LevelMeter.h"
+#include "TrackDecoder.h"
+#include "DecodedAudioSource.h"
+#include "MappedAudioSource.h"
+#include "TimeStretchAudioSource.h"
+#include "PolyphaseResamplingAudioSource.h"
+#include "CuePrerollSource.h"
+#include "LoopAudioSource.h"
+#include "ScratchAudioSource.h"
+#include "TrackAnalyser.h"
 
 /**
  * Definition of a DJAudioplayer
  *
  * An AudioSource class that contains general player functionality.
  * Acts as an AudioSource interface that contains load, gain, playback
- * and filter functionality
+ * and filter functionality.
+ * Gain, speed and filter settings are published from the message thread as a
+ * snapshot that the audio thread picks up once at the start of each block.
+ * Starts, stops and seeks are queued as commands for the audio thread, which
+ * carries them out at the sample of the deck clock they were given.
+ * While the jog wheel is held, the deck plays from a ScratchAudioSource instead of
+ * the transport, at the velocity of the jog wheel.
+ * After each block the audio thread publishes the playhead and the transport state with
+ * the time they were taken, and the message thread extrapolates the playhead from there
+ * instead of asking the transport.
  *
  */
 class DJAudioPlayer : public juce::AudioSource {
 public:
 
+	/// How loadURL reads the audio file
+	enum LoadMode {
+		/// Read from disk while playing, memory mapped for WAV and AIFF and decoded ahead of the playhead otherwise
+		streaming,
+		/// Decode the whole file into memory before playing, falling back to streaming if it does not fit
+		ramResident
+	};
+
 	//==============================================================================
 
 	/**
@@ -53,19 +87,29 @@ public:
 
 	/**
 		* Start playing the file
+		*
+		* @param Sample of the deck clock to start at, 0 or a past sample starts at the next audio block
 	*/
-	void start();
+	void start(juce::int64 atSample = 0);
 
 	/**
-	   * Stop playing the file
-   */
-	void stop();
+		* Stop playing the file
+		*
+		* @param Sample of the deck clock to stop at, 0 or a past sample stops at the next audio block
+	*/
+	void stop(juce::int64 atSample = 0);
 
 	/**
-	   * Returns true if the DJAudioPlayer is playing on the audio source, and false otherwise
+	   * Returns true if the DJAudioPlayer is playing on the audio source, and false otherwise,
+	   * as last published by the audio thread. Only called from the message thread.
    */
 	bool isPlaying();
 
+	/**
+	   * Returns the number of samples rendered since prepareToPlay, the clock transport commands are timed against
+   */
+	juce::int64 getSampleClock();
+
 	/**
 	   * Returns true if player is loaded with an audio file
    */
@@ -77,28 +121,113 @@ public:
 	juce::URL returnURL();
 
 	/**
-		* Loads URL into the transport source
+		* Loads URL into the transport source, blocking until the file is open. In ramResident
+		* mode that means until the whole file is decoded, so the UI loads with loadURLAsync.
 		*
 		* @param juce::URL of audio file to be loaded
 	*/
 	void loadURL(juce::URL audioURL);
 
+	/**
+		* Opens the URL on the loader thread and swaps it into the transport source once it is ready,
+		* without blocking the message thread. A later load or cancelLoad call cancels this one.
+		* Both callbacks are called on the message thread, and never once the load has been superseded.
+		*
+		* @param juce::URL of audio file to be loaded
+		* @param Called with the loaded portion between 0 and 1 while the file is opened or decoded
+		* @param Called with true once the new file is playing from the transport source, false if it could not be opened
+	*/
+	void loadURLAsync(juce::URL audioURL, std::function<void(double)> onProgress, std::function<void(bool)> onFinished);
+
+	/**
+		* Cancels a pending loadURLAsync call, the currently loaded file is kept
+	*/
+	void cancelLoad();
+
+	/**
+	   * Returns true while a loadURLAsync call is pending
+   */
+	bool isLoading();
+
+	/**
+		* Sets the amount of audio decoded, or for memory mapped files paged in, ahead of the
+		* playhead on the read-ahead thread. Takes effect on the next loaded file.
+		*
+		* @param Read-ahead buffer length in seconds, 0 decodes on the audio thread instead
+	*/
+	void setReadAheadTime(double seconds);
+
+	/**
+		* Sets how the next loaded file is read
+		*
+		* @param streaming or ramResident
+	*/
+	void setLoadMode(LoadMode mode);
+
+	/**
+		* Sets if a streamed WAV or AIFF file is memory mapped. Takes effect on the next loaded file.
+		*
+		* @param True to memory map the file, false to stream it through a reader
+	*/
+	void setMemoryMapping(bool shouldMap);
+
+	/**
+	   * Returns the load mode used for the next loaded file
+   */
+	LoadMode getLoadMode();
+
+	/**
+	   * Returns true if the loaded file plays from memory, false if it is streamed
+   */
+	bool isRamResident();
+
+	/**
+	   * Returns true if the loaded file is played through a memory mapped WAV or AIFF reader
+   */
+	bool isMemoryMapped();
+
+	/**
+	   * Returns the portion of the read-ahead buffer that is decoded ahead of the playhead, between 0 and 1
+   */
+	float getReadAheadFillLevel();
+
+	/**
+	   * Returns the seconds of the loaded file the read-ahead buffer holds when full, 0 when the player reads on the audio thread
+   */
+	double getReadAheadLength();
+
+	/**
+	   * Returns the number of blocks that were not fully decoded in time since the file was loaded
+   */
+	int getUnderrunCount();
+
 	//==============================================================================
 
 	/**
-	   * Returns the rms level of the audio source via the level variable member
+	   * Returns the rms level of the audio source in decibels via the level meter
    */
 	float getRMSLevel();
 
 	/**
-	   * Get the relative position of the playhead
+	   * Returns the level meter fed by the audio thread, read and updated from the message thread
+   */
+	LevelMeter& getLevelMeter();
+
+	/**
+	   * Get the relative position of the playhead, extrapolated from the last published playhead.
+	   * Only called from the message thread.
    */
 	double getPositionRelative();
 
+	/**
+	   * Get the length of the loaded file in seconds, 0 when nothing is loaded
+   */
+	double getLengthInSeconds();
+
 	//==============================================================================
 
 	/**
-		* Set gain of the file
+		* Set gain of the file, applied from the next audio block
 		*
 		*  @param Gain of audio source, between 0 to 1
 		*  @param True if called from volume functionality, false otherwise.
@@ -106,49 +235,174 @@ public:
 	void setGain(double gain, bool isVol = true);
 
 	/**
-		* Set speed of file playing by setting resampling audio source ratio
+		* Sets the gain that brings the loaded track to the target loudness, applied from the next audio block
+		* together with the volume and cross fader gain. Called once a track is loaded.
+		*
+		* @param Integrated loudness of the track in LUFS, 0 if it has not been analysed
+		* @param True peak of the track in dBTP
+	*/
+	void setNormalisation(double loudness, double truePeak);
+
+	/**
+	   * Returns the normalising gain of the loaded track in decibels
+   */
+	double getNormalisationDecibels();
+
+	/**
+		* Set speed of file playing through the polyphase resampler, or the time stretcher with keylock, applied from the next audio block
 		*
-		* @param Ratio of the resampling source
+		* @param Playback speed, 1 for the file's own speed
 	*/
 	void setSpeed(double ratio);
 
+	/**
+		* Sets keylock, applied from the next audio block. With keylock the speed changes
+		* the tempo through the time stretcher and the pitch stays the same.
+		*
+		* @param True to keep the pitch when the speed changes
+	*/
+	void setKeylock(bool shouldLock);
+
+	/**
+	   * Returns true if keylock is on
+   */
+	bool isKeylockEnabled();
+
+	/**
+		* Sets the quality tier of the speed resampler, applied from the next audio block
+		*
+		* @param draft, normal or mastering
+	*/
+	void setResamplerQuality(PolyphaseResamplingAudioSource::Quality quality);
+
+	/**
+	   * Returns the quality tier of the speed resampler
+   */
+	PolyphaseResamplingAudioSource::Quality getResamplerQuality();
+
+	/**
+		* Sets a hot cue so a jump to it can start from pre-decoded audio. Only streamed
+		* compressed files keep cue windows, other files seek without decoding anyway.
+		*
+		* @param Index of the cue, from 0 to CuePrerollSource::maxNumCues - 1
+		* @param Relative position of the cue between 0 and 1
+	*/
+	void setCuePoint(int index, double pos);
+
+	/**
+		* Clears every hot cue of the loaded file
+	*/
+	void clearCuePoints();
+
+	/**
+		* Marks the start of a loop whose end is set later, so the loop is decoded ahead
+		*
+		* @param Start of the loop in seconds
+	*/
+	void setLoopIn(double startSecs);
+
+	/**
+		* Loops a section of the loaded file from a pre-decoded buffer, replacing the current loop once it is decoded
+		*
+		* @param Start of the loop in seconds
+		* @param End of the loop in seconds
+		* @param True for a loop roll, which returns to where the track would have been when it is exited
+	*/
+	void setLoop(double startSecs, double endSecs, bool roll = false);
+
+	/**
+		* Exits the loop, a loop plays on past its end and a loop roll returns to the slipped position
+	*/
+	void exitLoop();
+
+	/**
+	   * Returns true if a loop is set and has not been exited
+   */
+	bool isLoopActive();
+
+	/**
+	   * Returns the playback position in seconds, extrapolated from the last published playhead.
+	   * Only called from the message thread.
+   */
+	double getCurrentPosition();
+
+	/**
+		* Starts, moves or ends a scratch, applied from the next audio block. While scratching the
+		* deck plays at the velocity of the jog wheel instead of the transport, and when the scratch
+		* ends playback carries on from the scratch position, or with slip from where the track
+		* would have been.
+		*
+		* @param True while the jog wheel is held
+		* @param Velocity of the jog wheel relative to normal playback, negative to play backwards
+	*/
+	void setScratch(bool isScratching, double velocity);
+
+	/**
+		* Sets slip mode, applied from the next audio block
+		*
+		* @param True to return to where the track would have been when a scratch ends
+	*/
+	void setSlip(bool shouldSlip);
+
+	/**
+	   * Returns true if slip mode is on
+   */
+	bool isSlipEnabled();
+
+	/**
+	   * Returns the milliseconds from the last seek until its first block was played, -1 if not measured
+   */
+	double getSeekLatency();
+
+	/**
+	   * Returns true if the last seek was served from a pre-decoded cue window
+   */
+	bool wasSeekFromCue();
+
+	/**
+	   * Returns the smoothed time getNextAudioBlock takes in milliseconds
+   */
+	double getRenderTime();
+
 	/**
 		* Set position of the file playback in seconds
 		*
 		* @param Position of the audio source playback in seconds.
+		* @param Sample of the deck clock to seek at, 0 or a past sample seeks at the next audio block
 	*/
-	void setPosition(double posInSecs);
+	void setPosition(double posInSecs, juce::int64 atSample = 0);
 
 	/**
 		* Set relative position of the file playback, calls setPosition
 		*
 		* @param Relative position of the audio source playback between 0 and 1.
+		* @param Sample of the deck clock to seek at, 0 or a past sample seeks at the next audio block
 	*/
-	void setPositionRelative(double pos);
+	void setPositionRelative(double pos, juce::int64 atSample = 0);
 
 	/**
-	   * Sets the IIR coefficients of audioLPFilter and audioHPFilter audio sources
+	   * Sets the IIR coefficients of the low pass and high pass filter stages, applied from the next audio block
 	   *
 	   * @param Frequency to perform low or high pass from -20000 to 20000.
    */
 	void setFilter(double freq);
 
 	/**
-	   * Sets the IIR coefficients of audioLBFilter audio source
+	   * Sets the IIR coefficients of the low band filter stage, applied from the next audio block
 	   *
 	   * @param Gain factor of the audio source in the low band.
    */
 	void setLBFilter(double gain);
 
 	/**
-	   * Sets the IIR coefficients of audioMBFilter audio source
+	   * Sets the IIR coefficients of the mid band filter stage, applied from the next audio block
 	   *
 	   * @param Gain factor of the audio source in the mid band.
    */
 	void setMBFilter(double gain);
 
 	/**
-	   * Sets the IIR coefficients of audioHBFilter audio source
+	   * Sets the IIR coefficients of the high band filter stage, applied from the next audio block
 	   *
 	   * @param Gain factor of the audio source in the high band.
    */
@@ -158,38 +412,356 @@ public:
 
 private:
 
+	/// Reads the parameters each block was rendered with in its stress test
+	friend class AudioBenchmark;
+
+	//==============================================================================
+
+	/// Snapshot of the control settings handed from the message thread to the audio thread
+	struct Parameters {
+		/// Combined player, cross fader and normalising gain
+		double gain = 1;
+
+		/// Playback speed, a resampling ratio or with keylock a tempo ratio
+		double speed = 1;
+
+		/// Keeps the pitch when the speed changes
+		bool keylock = false;
+
+		/// Quality tier of the speed resampler
+		PolyphaseResamplingAudioSource::Quality resamplerQuality = PolyphaseResamplingAudioSource::normal;
+
+		/// Low pass or high pass frequency from -20000 to 20000, 0 when both are off
+		double filterFrequency = 0;
+
+		/// Gain factor of the low band
+		double lowBandGain = 1;
+
+		/// Gain factor of the mid band
+		double midBandGain = 1;
+
+		/// Gain factor of the high band
+		double highBandGain = 1;
+
+		/// Plays from the scratch source at scratchVelocity instead of the transport
+		bool scratching = false;
+
+		/// Velocity of the jog wheel relative to normal playback
+		double scratchVelocity = 0;
+
+		/// Returns to where the track would have been when a scratch ends
+		bool slip = false;
+	};
+
+	//==============================================================================
+
+	/// Playhead published by the audio thread after each block
+	struct Playhead {
+		/// Playback position in seconds, of the scratch while scratching
+		double position = 0;
+
+		/// Length of the loaded file in seconds
+		double length = 0;
+
+		/// Seconds of the file played per second, 0 when stopped
+		double rate = 0;
+
+		/// Flags if the deck is playing, cleared by a stop or the end of the file
+		bool playing = false;
+
+		/// juce::Time::getMillisecondCounterHiRes when the playhead was taken
+		double timestamp = 0;
+	};
+
+	//==============================================================================
+
+	/// Start, stop or seek queued for the audio thread
+	struct TransportCommand {
+		/// Kind of command
+		enum Type {
+			startCommand,
+			stopCommand,
+			seekCommand
+		};
+
+		/// Kind of command
+		Type type = startCommand;
+
+		/// Position to seek to in seconds
+		double seconds = 0;
+
+		/// Sample of the deck clock to act at
+		juce::int64 atSample = 0;
+	};
+
+	//==============================================================================
+
+	/// Sources opened for a file, owned by the player once swapped into the transport source
+	struct OpenedSource {
+		/// Source playing the decoded file from memory, null when streaming
+		std::unique_ptr<DecodedAudioSource> decodedSource;
+
+		/// Source playing a WAV or AIFF file through a memory mapping, null for other files
+		std::unique_ptr<MappedAudioSource> mappedSource;
+
+		/// Reader source for other files
+		std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+
+		/// Read-ahead source buffering the reader source, null when reading on the audio thread
+		std::unique_ptr<ReadAheadAudioSource> readAheadSource;
+
+		/// Cue windows in front of the reader or read-ahead source, freed before them
+		std::unique_ptr<CuePrerollSource> cuePrerollSource;
+
+		/// Loop buffer in front of every other source, freed before them
+		std::unique_ptr<LoopAudioSource> loopSource;
+
+		/// Source played while scratching, next to the playback chain rather than in it
+		std::unique_ptr<ScratchAudioSource> scratchSource;
+
+		/// The outermost of the sources above, handed to the transport source
+		juce::PositionableAudioSource* playbackSource = nullptr;
+
+		/// Sample rate of the file
+		double sampleRate = 0;
+
+		/// Block size the sources were prepared for, 0 before prepareSource
+		int preparedBlockSize = 0;
+
+		/// Output sample rate the scratch source was prepared for
+		double preparedSampleRate = 0;
+	};
+
+	/**
+		* Opens the URL with the same fallbacks as loadURL. Safe to call from the loader thread,
+		* as it only reads the settings it is passed.
+		*
+		* @param juce::URL of audio file to be opened
+		* @param LoadMode to open the file with
+		* @param Read-ahead buffer length in seconds
+		* @param True to memory map a streamed WAV or AIFF file
+		* @param Called with the decoded portion between 0 and 1 for a RAM-resident load, returns false to cancel
+		* @return Opened sources, or nullptr if the file could not be opened or the load was cancelled
+	*/
+	std::unique_ptr<OpenedSource> openSource(const juce::URL& audioURL, LoadMode mode, double readAheadSeconds, bool allowMapping, std::function<bool(double)> progressCallback);
+
+	/**
+		* Wraps the outermost source in a LoopAudioSource with a reader of its own, if the file can be opened again
+		*
+		* @param Sources opened so far
+		* @param juce::URL they were opened from
+	*/
+	void addLoopSource(OpenedSource& source, const juce::URL& audioURL);
+
+	/**
+		* Adds a ScratchAudioSource with a reader of its own, if the file can be opened again
+		*
+		* @param Sources opened so far
+		* @param juce::URL they were opened from
+	*/
+	void addScratchSource(OpenedSource& source, const juce::URL& audioURL);
+
+	/**
+		* Prepares the playback and scratch sources, which waits for a read-ahead to prefill.
+		* Called from the loader thread, before the sources are handed to the audio thread.
+		*
+		* @param Sources returned by openSource
+		* @param Expected samples in a block
+		* @param Number of samples per second of the output
+	*/
+	static void prepareSource(OpenedSource& source, int blockSize, double outputSampleRate);
+
+	/**
+		* Swaps opened sources into the transport source and frees the previous ones. Only called from the message thread.
+		*
+		* @param Sources returned by openSource and prepared by prepareSource
+		* @param juce::URL they were opened from
+	*/
+	void installSource(std::unique_ptr<OpenedSource> source, const juce::URL& audioURL);
+
+	/**
+		* Applies a parameter snapshot to the audio sources, only touching settings that changed.
+		* Only called from the audio thread.
+		*
+		* @param Snapshot to apply
+		* @param True to apply every setting regardless of the previous snapshot
+	*/
+	void applyParameters(const Parameters& newParameters, bool applyAll = false);
+
+	/**
+		* Sets the resampler ratio and time stretch tempo for a speed, correcting for the sample
+		* rate of the loaded file. Only called from the audio thread.
+		*
+		* @param Snapshot holding the speed and keylock state
+	*/
+	void applySpeed(const Parameters& newParameters);
+
+	/**
+		* Queues a transport command, dropping it if the queue is full. Only called from the message thread.
+		*
+		* @param Command to queue
+	*/
+	void queueCommand(const TransportCommand& command);
+
+	/**
+		* Carries out a transport command. Only called from the audio thread.
+		*
+		* @param Command to carry out
+	*/
+	void applyCommand(const TransportCommand& command);
+
+	/**
+		* Fills part of the block from the playing sources, from the tail of a stop, or with silence.
+		* Only called from the audio thread.
+		*
+		* @param Block being filled
+		* @param Offset into the block to start at
+		* @param Number of samples to fill
+	*/
+	void renderTransport(const juce::AudioSourceChannelInfo& bufferToFill, int offset, int numSamples);
+
+	/**
+		* Starts or ends a scratch when the active parameters ask for it, and hands the scratch source
+		* the jog velocity or the playhead. Only called from the audio thread.
+	*/
+	void updateScratch();
+
+	/**
+		* Publishes the playhead at the end of the block for the message thread. Only called from the audio thread.
+	*/
+	void publishPlayhead();
+
+	/**
+		* Sets or bypasses the low pass and high pass filter stages. Only called from the audio thread.
+		*
+		* @param Frequency to perform low or high pass from -20000 to 20000.
+	*/
+	void applyFilter(double freq);
+
+	/**
+		* Sets or bypasses one of the band filter stages. Only called from the audio thread.
+		*
+		* @param lowBandStage, midBandStage or highBandStage
+		* @param Gain factor of the band, a unity gain bypasses the stage
+	*/
+	void applyBandFilter(int stage, double gain);
+
+	//==============================================================================
+
 	/// Reference assigned to the AudioFormatManager passed into the constructor
 	juce::AudioFormatManager& formatManager;
 
-	/// Reader source for the audio url
-	std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+	/// Background thread decoding or paging in the loaded file ahead of the playhead
+	juce::TimeSliceThread readAheadThread{ "DJAudioPlayer read-ahead" };
 
-	/// AudioTransportSource to manage basic gain and playback controls.
-	juce::AudioTransportSource transportSource;
+	/// Sources of the loaded file, null when nothing is loaded
+	std::unique_ptr<OpenedSource> openedSource;
 
-	/// ResamplingAudioSource to manage resampling ratio controls
-	juce::ResamplingAudioSource resampleSource{ &transportSource, false, 2 };
+	/// double to store the read-ahead buffer length in seconds
+	double readAheadTime = 2.0;
 
-	/// IIRFilterAudioSource to manage low band filter controls
-	juce::IIRFilterAudioSource audioLBFilter{ &resampleSource , false };
+	/// Decoder shared by every deck for RAM-resident loading
+	juce::SharedResourcePointer<TrackDecoder> trackDecoder;
 
-	/// IIRFilterAudioSource to manage mid band filter controls
-	juce::IIRFilterAudioSource audioMBFilter{ &audioLBFilter , false };
+	/// Single thread opening files for loadURLAsync
+	juce::ThreadPool loaderPool{ 1 };
 
-	/// IIRFilterAudioSource to manage high band filter controls
-	juce::IIRFilterAudioSource audioHBFilter{ &audioMBFilter , false };
+	/// Incremented by every load, a pending loadURLAsync job is stale once it no longer matches
+	std::atomic<int> loadGeneration{ 0 };
 
-	/// IIRFilterAudioSource to manage high pass filter controls
-	juce::IIRFilterAudioSource audioHPFilter{ &audioHBFilter , false };
+	/// Flags if a loadURLAsync call is pending
+	bool loading = false;
 
-	/// IIRFilterAudioSource to manage low pass filter controls
-	juce::IIRFilterAudioSource audioLPFilter{ &audioHPFilter , false };
+	/// Smoothed time getNextAudioBlock takes in milliseconds, written by the audio thread
+	std::atomic<double> renderTime{ 0 };
+
+	/// LoadMode used by the next loadURL call
+	LoadMode loadMode = streaming;
+
+	/// Flags if the next loadURL call memory maps a streamed WAV or AIFF file
+	bool memoryMapping = true;
+
+	/// DeckTransportSource to manage basic gain and playback controls without locking the audio thread
+	DeckTransportSource transportSource;
+
+	/// PolyphaseResamplingAudioSource to manage resampling ratio controls
+	PolyphaseResamplingAudioSource resampleSource{ &transportSource, false, 2 };
+
+	/// TimeStretchAudioSource to change the tempo without changing the pitch when keylock is on
+	TimeStretchAudioSource timeStretchSource{ &resampleSource, false };
+
+	/// Index of each stage in the filterCascade, in processing order
+	enum FilterStage {
+		lowBandStage,
+		midBandStage,
+		highBandStage,
+		highPassStage,
+		lowPassStage,
+		numFilterStages
+	};
+
+	/// BiquadCascade to manage low, mid and high band as well as high and low pass filter controls in a single pass
+	BiquadCascade<numFilterStages> filterCascade;
 
 	/// juce::String to store the file name of the loaded url
 	juce::String loadedFileName;
 
 	/// double to store the sample rate
-	double thisSampleRate;
+	double thisSampleRate = 44100;
+
+	/// int to store the expected block size
+	int thisBlockSize = 512;
+
+	/// Parameters edited by the message thread and published to parameterMailbox
+	Parameters pendingParameters;
+
+	/// Parameters last applied on the audio thread
+	Parameters activeParameters;
+
+	/// Lock-free handover of parameter snapshots to the audio thread
+	ParameterMailbox<Parameters> parameterMailbox;
+
+	/// Lock-free queue of transport commands for the audio thread
+	CommandQueue<TransportCommand, 256> commandQueue;
+
+	/// Flags if the deck is playing, only used on the audio thread and published with the playhead
+	bool playing = false;
+
+	/// Samples rendered since prepareToPlay, written by the audio thread
+	std::atomic<juce::int64> sampleClock{ 0 };
+
+	/// Samples of the fade out after a stop still to render, only used on the audio thread
+	int stopFadeRemaining = 0;
+
+	/// Length of the fade out after a stop in samples
+	static constexpr int stopFadeLength = 256;
+
+	/// Guards activeScratchSource and the source of transportSource, held by the audio thread for a block and by installSource for the swap
+	juce::SpinLock sourceLock;
+
+	/// Scratch source of the loaded file, null when it has none
+	ScratchAudioSource* activeScratchSource = nullptr;
+
+	/// Scratch source of the loaded file for the block being rendered
+	ScratchAudioSource* blockScratchSource = nullptr;
+
+	/// Flags if the deck is playing from the scratch source, only used on the audio thread
+	bool scratchActive = false;
+
+	/// Where the track would have been without the scratch in samples of the file, only used on the audio thread
+	double slipPosition = 0;
+
+	/// Sample rate of the file the resampler ratio was last set for, only used on the audio thread
+	double speedSampleRate = 0;
+
+	/// Lock-free handover of the playhead from the audio thread to the message thread
+	ParameterMailbox<Playhead> playheadMailbox;
+
+	/// Playhead last fetched on the message thread
+	Playhead latestPlayhead;
+
+	/// Longest time a playhead is extrapolated for in seconds, so it stops when the audio device does
+	static constexpr double maxExtrapolation = 0.1;
 
 	/// boolean to determine if the player is loaded
 	bool loaded = false;
@@ -200,9 +772,23 @@ private:
 	/// double to store the cross fader volume
 	double crossFadeVol = 1;
 
+	/// double to store the normalising gain of the loaded track in decibels
+	double normalisationDb = 0;
+
+	/// Loudness tracks are normalised to in LUFS
+	static constexpr double targetLoudness = -14.0;
+
+	/// Highest true peak a normalised track is allowed to reach in dBTP
+	static constexpr double truePeakCeiling = -1.0;
+
+	/// Largest boost given to a quiet track in decibels
+	static constexpr double maxNormalisationBoost = 12.0;
+
 	/// juce::URL to store the current loaded audio file's URL
 	juce::URL currentAudioURL;
 
-	/// float to store the audio source RMS level
-	float level;
+	/// LevelMeter measuring the output of the player
+	LevelMeter levelMeter;
+
+	JUCE_DECLARE_WEAK_REFERENCEABLE(DJAudioPlayer)
 };
@@ -0,0 +1,328 @@
+
+#include "DeckEngine.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for DeckEngine
+ *
+ * By default starts a worker for every deck but the first, which renders on the audio
+ * thread, leaving one core free. Creates the decks, assigning even decks to the left of
+ * the cross fader and odd decks to the right, and allocates the per deck arrays.
+ *
+ */
+DeckEngine::DeckEngine(juce::AudioFormatManager& formatManager, int numDecks, int numWorkers)
+	: workerPool(numWorkers >= 0 ? numWorkers : juce::jlimit(0, juce::jmax(0, juce::SystemStats::getNumCpus() - 1), numDecks - 1))
+{
+	numDecks = juce::jmax(1, numDecks);
+	targetGains.reset(new std::atomic<float>[(size_t)numDecks]);
+	rendering.reset(new std::atomic<bool>[(size_t)numDecks]);
+	renderedSection.reset(new std::atomic<juce::uint32>[(size_t)numDecks]);
+	appliedGains.allocate((size_t)numDecks, true);
+	blockGains.allocate((size_t)numDecks, true);
+	rampStartGains.allocate((size_t)numDecks, true);
+	rampEndGains.allocate((size_t)numDecks, true);
+	channelPointers.allocate((size_t)numDecks, true);
+	deckRendered.allocate((size_t)numDecks, true);
+
+	for (auto i = 0; i < numDecks; ++i) {
+		decks.add(new DJAudioPlayer(formatManager));
+		sides.add(i % 2 == 0 ? left : right);
+		targetGains[i] = 1.0f;
+		appliedGains[i] = 1.0f;
+		rendering[i] = false;
+		renderedSection[i] = 0;
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getNumDecks method for DeckEngine
+ *
+ * Returns the size of the decks array
+ *
+ */
+int DeckEngine::getNumDecks() const {
+	return decks.size();
+}
+
+/**
+ * Implementation of getDeck method for DeckEngine
+ *
+ * Returns the deck at the index
+ *
+ */
+DJAudioPlayer* DeckEngine::getDeck(int index) const {
+	return decks[index];
+}
+
+/**
+ * Implementation of setCrossfaderSide method for DeckEngine
+ *
+ * Stores the side and recomputes the deck gains
+ *
+ */
+void DeckEngine::setCrossfaderSide(int index, CrossfaderSide side) {
+	if (juce::isPositiveAndBelow(index, sides.size())) {
+		sides.set(index, side);
+		updateCrossfaderGains();
+	}
+}
+
+/**
+ * Implementation of getCrossfaderSide method for DeckEngine
+ *
+ * Returns the side of the deck
+ *
+ */
+DeckEngine::CrossfaderSide DeckEngine::getCrossfaderSide(int index) const {
+	return sides[index];
+}
+
+/**
+ * Implementation of setCrossfader method for DeckEngine
+ *
+ * Stores the position and recomputes the deck gains
+ *
+ */
+void DeckEngine::setCrossfader(double position) {
+	crossfaderPosition = juce::jlimit(-1.0, 1.0, position);
+	updateCrossfaderGains();
+}
+
+/**
+ * Implementation of getCallbackTime method for DeckEngine
+ *
+ * Returns the callbackTime data member
+ *
+ */
+double DeckEngine::getCallbackTime() const {
+	return callbackTime;
+}
+
+/**
+ * Implementation of getLateRenderCount method for DeckEngine
+ *
+ * Returns the lateRenders data member
+ *
+ */
+int DeckEngine::getLateRenderCount() const {
+	return lateRenders;
+}
+
+/**
+ * Implementation of setDeadlineEnabled method for DeckEngine
+ *
+ * Sets the deadlineEnabled data member
+ *
+ */
+void DeckEngine::setDeadlineEnabled(bool shouldEnforceDeadline) {
+	deadlineEnabled = shouldEnforceDeadline;
+}
+
+/**
+ * Implementation of updateCrossfaderGains method for DeckEngine
+ *
+ * The gain of a side is inversely proportional to the distance of the knob from it:
+ * moving right fades the left decks out and moving left fades the right decks out.
+ * Decks set to thru always play at unity.
+ *
+ */
+void DeckEngine::updateCrossfaderGains() {
+	const float leftGain = (float)(crossfaderPosition > 0 ? 1 - crossfaderPosition : 1);
+	const float rightGain = (float)(crossfaderPosition < 0 ? 1 + crossfaderPosition : 1);
+	for (auto i = 0; i < decks.size(); ++i) {
+		targetGains[i] = sides[i] == left ? leftGain : (sides[i] == right ? rightGain : 1.0f);
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for DeckEngine
+ *
+ * Waits for decks left rendering by the last callback, then prepares every deck and
+ * sizes two render channels per deck and the silent channel for the block size.
+ *
+ */
+void DeckEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	waitForRenders();
+	engineSampleRate = sampleRate;
+	deckBuffers.setSize(decks.size() * 2, juce::jmax(1, samplesPerBlockExpected));
+	silence.setSize(1, juce::jmax(1, samplesPerBlockExpected));
+	silence.clear();
+	for (auto* deck : decks) {
+		deck->prepareToPlay(samplesPerBlockExpected, sampleRate);
+	}
+}
+
+/**
+ * Implementation of releaseResources method for DeckEngine
+ *
+ * Waits for decks left rendering by the last callback, then releases every deck and
+ * frees the render channels.
+ *
+ */
+void DeckEngine::releaseResources() {
+	waitForRenders();
+	for (auto* deck : decks) {
+		deck->releaseResources();
+	}
+	deckBuffers.setSize(decks.size() * 2, 0);
+}
+
+/**
+ * Implementation of waitForRenders method for DeckEngine
+ *
+ * A deck the audio thread gave up on finishes on its worker within about a block, so
+ * this sleeps in short steps rather than synchronising with the workers.
+ *
+ */
+void DeckEngine::waitForRenders() {
+	for (auto i = 0; i < decks.size(); ++i) {
+		while (rendering[i].load()) {
+			juce::Thread::sleep(1);
+		}
+	}
+}
+
+/**
+ * Implementation of getNextAudioBlock method for DeckEngine
+ *
+ * Works through the block in sections no longer than the render channels. The worker pool
+ * renders every deck's section into its own pair of channels in parallel and returns once
+ * all are done. With the deadline on it also returns once deadlineFraction of the time
+ * the block has played up to the end of the section has passed since the callback
+ * started; a deck that has not finished the section by then is mixed from the silent
+ * channel and counted as late. Whether each deck rendered is read once per section, so
+ * both channels of a deck agree. Both output channels are then mixed by mixDecks. Across the whole block every deck
+ * ramps from the gain it ended the last block on to the current cross fader gain, each section
+ * taking its part of that ramp. Extra output channels are cleared. The wall time of the
+ * whole callback is smoothed into callbackTime.
+ *
+ */
+void DeckEngine::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	const auto startTicks = juce::Time::getHighResolutionTicks();
+	const int maxSection = deckBuffers.getNumSamples();
+	if (maxSection == 0) {
+		bufferToFill.clearActiveBufferRegion();
+		return;
+	}
+
+	const int numDecks = decks.size();
+	for (auto i = 0; i < numDecks; ++i) {
+		blockGains[i] = targetGains[i].load();
+	}
+
+	int done = 0;
+	while (done < bufferToFill.numSamples) {
+		const int numSamples = juce::jmin(maxSection, bufferToFill.numSamples - done);
+		const float sectionStart = (float)done / bufferToFill.numSamples;
+		const float sectionEnd = (float)(done + numSamples) / bufferToFill.numSamples;
+		for (auto i = 0; i < numDecks; ++i) {
+			rampStartGains[i] = appliedGains[i] + (blockGains[i] - appliedGains[i]) * sectionStart;
+			rampEndGains[i] = appliedGains[i] + (blockGains[i] - appliedGains[i]) * sectionEnd;
+		}
+
+		sectionLength = numSamples;
+		const juce::uint32 section = ++sectionNumber;
+		juce::int64 deadlineTicks = 0;
+		if (deadlineEnabled && engineSampleRate > 0) {
+			const double seconds = deadlineFraction * (done + numSamples) / engineSampleRate;
+			deadlineTicks = startTicks + juce::jmax((juce::int64)1, juce::Time::secondsToHighResolutionTicks(seconds));
+		}
+		workerPool.run(&DeckEngine::renderDeck, this, numDecks, deadlineTicks);
+		for (auto i = 0; i < numDecks; ++i) {
+			deckRendered[i] = renderedSection[i].load() == section;
+			if (!deckRendered[i]) {
+				++lateRenders;
+			}
+		}
+
+		for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+			float* dest = bufferToFill.buffer->getWritePointer(chan, bufferToFill.startSample + done);
+			if (chan >= 2) {
+				juce::FloatVectorOperations::clear(dest, numSamples);
+				continue;
+			}
+			for (auto i = 0; i < numDecks; ++i) {
+				channelPointers[i] = deckRendered[i] ? deckBuffers.getReadPointer(i * 2 + chan) : silence.getReadPointer(0);
+			}
+			mixDecks(dest, channelPointers.get(), rampStartGains.get(), rampEndGains.get(), numDecks, numSamples);
+		}
+		done += numSamples;
+	}
+
+	for (auto i = 0; i < numDecks; ++i) {
+		appliedGains[i] = blockGains[i];
+	}
+
+	const double elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+	callbackTime = callbackTime + (elapsed - callbackTime) * 0.05;
+}
+
+/**
+ * Implementation of renderDeck method for DeckEngine
+ *
+ * Claims the deck first, so a deck still rendering a section the audio thread gave up on
+ * skips this one instead of being rendered by two threads. Wraps the deck's two channels
+ * in a buffer referring to them, which does not allocate, renders the current section
+ * into it and marks the section as rendered before letting go of the deck.
+ *
+ */
+void DeckEngine::renderDeck(void* context, int index) {
+	auto* engine = static_cast<DeckEngine*>(context);
+	if (engine->rendering[index].exchange(true)) {
+		return;
+	}
+	const juce::uint32 section = engine->sectionNumber.load();
+	const int numSamples = engine->sectionLength.load();
+	juce::AudioBuffer<float> deckBuffer(engine->deckBuffers.getArrayOfWritePointers() + index * 2, 2, numSamples);
+	juce::AudioSourceChannelInfo info(&deckBuffer, 0, numSamples);
+	engine->decks.getUnchecked(index)->getNextAudioBlock(info);
+	engine->renderedSection[index] = section;
+	engine->rendering[index] = false;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of mixDecks method for DeckEngine
+ *
+ * Every source adds gain times sample into eight lane accumulators, with the gain
+ * stepping linearly from its start to its end value. The tail is mixed a sample at a time.
+ *
+ */
+void DeckEngine::mixDecks(float* dest, const float* const* sources, const float* startGains, const float* endGains, int numSources, int numSamples) {
+	if (numSamples <= 0) {
+		return;
+	}
+	const float step = 1.0f / numSamples;
+
+	int i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		float sums[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+		for (auto s = 0; s < numSources; ++s) {
+			const float* source = sources[s] + i;
+			const float gain = startGains[s];
+			const float slope = (endGains[s] - gain) * step;
+			for (auto lane = 0; lane < 8; ++lane) {
+				sums[lane] += source[lane] * (gain + slope * (float)(i + lane));
+			}
+		}
+		for (auto lane = 0; lane < 8; ++lane) {
+			dest[i + lane] = sums[lane];
+		}
+	}
+
+	for (; i < numSamples; ++i) {
+		float sum = 0;
+		for (auto s = 0; s < numSources; ++s) {
+			sum += sources[s][i] * (startGains[s] + (endGains[s] - startGains[s]) * step * (float)i);
+		}
+		dest[i] = sum;
+	}
+}
+
+//==============================================================================
@@ -0,0 +1,237 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include "DJAudioPlayer.h"
+#include "RealtimeWorkerPool.h"
+
+//==============================================================================
+
+/**
+ * Definition of a DeckEngine
+ *
+ * An AudioSource that owns a fixed number of DJAudioPlayer decks and mixes them
+ * into its output. Every deck renders into its own preallocated channels, the decks
+ * running concurrently on a RealtimeWorkerPool so the callback takes about as long as
+ * the slowest deck rather than all of them together. The audio thread joins the workers
+ * before mixing. A render deadline can be turned on, after which a deck still rendering
+ * once most of the block's time is used up is mixed as silence for that section and left
+ * to finish, trading a gap in one deck for the whole output missing the device deadline.
+ * Once all are rendered one
+ * kernel sums all decks into each output channel in a single pass, applying each
+ * deck's cross fader gain as a ramp across the block so fader moves do not click.
+ * Each deck is assigned to the left or right side of the cross fader, or bypasses it.
+ *
+ */
+class DeckEngine : public juce::AudioSource {
+public:
+
+	/// Side of the cross fader a deck is assigned to
+	enum CrossfaderSide {
+		/// Faded out as the cross fader moves right
+		left,
+		/// Faded out as the cross fader moves left
+		right,
+		/// Not affected by the cross fader
+		thru
+	};
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for DeckEngine, creates the decks and assigns them to alternate sides.
+		*
+		* @param juce::AudioFormatManager reference passed to every deck
+		* @param Number of decks, at least 1
+		* @param Number of workers rendering decks alongside the audio thread, -1 to pick one per deck but the first
+	*/
+	DeckEngine(juce::AudioFormatManager& formatManager, int numDecks, int numWorkers = -1);
+
+	//==============================================================================
+
+	/**
+		* @return Number of decks
+	*/
+	int getNumDecks() const;
+
+	/**
+		* @param Index of the deck
+		* @return Deck at the index, owned by the engine
+	*/
+	DJAudioPlayer* getDeck(int index) const;
+
+	/**
+		* Assigns a deck to a side of the cross fader. Only called from the message thread.
+		*
+		* @param Index of the deck
+		* @param left, right or thru
+	*/
+	void setCrossfaderSide(int index, CrossfaderSide side);
+
+	/**
+		* @param Index of the deck
+		* @return Side of the cross fader the deck is assigned to
+	*/
+	CrossfaderSide getCrossfaderSide(int index) const;
+
+	/**
+		* Moves the cross fader, applied from the next audio block. Only called from the message thread.
+		*
+		* @param Position from -1 (left) to 1 (right)
+	*/
+	void setCrossfader(double position);
+
+	/**
+		* @return Smoothed wall time of getNextAudioBlock in milliseconds
+	*/
+	double getCallbackTime() const;
+
+	/**
+		* @return Number of deck sections mixed as silence because the deck missed the deadline
+	*/
+	int getLateRenderCount() const;
+
+	/**
+		* Turns the render deadline on or off. Off, the default, every section waits for every
+		* deck. On, a deck that is late is mixed as silence for the section and loses the audio
+		* its worker goes on to render. Only called while the engine is not playing.
+		*
+		* @param True to give up on late decks
+	*/
+	void setDeadlineEnabled(bool shouldEnforceDeadline);
+
+	//==============================================================================
+
+	/**
+		* Prepares every deck and allocates their render channels
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Releases every deck
+	*/
+	void releaseResources() override;
+
+	/**
+		* Renders every deck and mixes them into the block
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Sums sources into a destination with a gain per source ramped linearly across the block.
+		* Works through the destination eight samples at a time so every source is read once and
+		* the destination written once, with the eight lanes independent so the loop vectorises.
+		*
+		* @param Destination, overwritten
+		* @param Source pointers
+		* @param Gain of each source at the first sample
+		* @param Gain of each source after the last sample
+		* @param Number of sources
+		* @param Number of samples
+	*/
+	static void mixDecks(float* dest, const float* const* sources, const float* startGains, const float* endGains, int numSources, int numSamples);
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Works out the gain of every deck from the cross fader position and its side
+	*/
+	void updateCrossfaderGains();
+
+	/**
+		* Renders one deck into its channels for the current section, run by the worker pool.
+		* Does nothing if the deck is still rendering an earlier section.
+		*
+		* @param DeckEngine rendering the section
+		* @param Index of the deck
+	*/
+	static void renderDeck(void* engine, int index);
+
+	/**
+		* Waits until no deck is still rendering a section the audio thread gave up on
+	*/
+	void waitForRenders();
+
+	//==============================================================================
+
+	/// Decks mixed by the engine
+	juce::OwnedArray<DJAudioPlayer> decks;
+
+	/// Side of the cross fader of each deck
+	juce::Array<CrossfaderSide> sides;
+
+	/// Cross fader position from -1 to 1
+	double crossfaderPosition = 0;
+
+	/// Cross fader gain of each deck set by the message thread
+	std::unique_ptr<std::atomic<float>[]> targetGains;
+
+	/// Cross fader gain of each deck at the end of the last block
+	juce::HeapBlock<float> appliedGains;
+
+	/// Gains at the end of the block being mixed
+	juce::HeapBlock<float> blockGains;
+
+	/// Gains at the start of the section being mixed
+	juce::HeapBlock<float> rampStartGains;
+
+	/// Gains at the end of the section being mixed
+	juce::HeapBlock<float> rampEndGains;
+
+	/// Two channels per deck the decks render into
+	juce::AudioBuffer<float> deckBuffers;
+
+	/// Pointers to one channel of every deck, handed to mixDecks
+	juce::HeapBlock<const float*> channelPointers;
+
+	/// Flags of the decks that rendered the section being mixed, read once per section
+	juce::HeapBlock<bool> deckRendered;
+
+	/// Silent channel mixed in place of a deck that missed the deadline
+	juce::AudioBuffer<float> silence;
+
+	/// Number of samples in the section being rendered
+	std::atomic<int> sectionLength{ 0 };
+
+	/// Number of the section being rendered, counting up from 1
+	std::atomic<juce::uint32> sectionNumber{ 0 };
+
+	/// Flags of the decks a task is rendering right now
+	std::unique_ptr<std::atomic<bool>[]> rendering;
+
+	/// Number of the section each deck last finished rendering
+	std::unique_ptr<std::atomic<juce::uint32>[]> renderedSection;
+
+	/// Share of a section's duration the audio thread waits for the decks
+	static constexpr double deadlineFraction = 0.8;
+
+	/// Flags if late decks are given up on
+	bool deadlineEnabled = false;
+
+	/// Number of samples per second the engine is prepared for
+	double engineSampleRate = 0;
+
+	/// Number of deck sections mixed as silence because the deck missed the deadline
+	std::atomic<int> lateRenders{ 0 };
+
+	/// Workers rendering the decks alongside the audio thread
+	RealtimeWorkerPool workerPool;
+
+	/// Smoothed wall time of getNextAudioBlock in milliseconds
+	std::atomic<double> callbackTime{ 0 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckEngine)
+};
@@ -13,7 +13,7 @@
  * well
  *
  */
-DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& cacheToUse, ZoomedWaveform* _zoomedDisplay, Library& _library, juce::Colour _colour) : player(_player), waveformDisplay(formatManagerToUse, cacheToUse, _colour), zoomedDisplay(_zoomedDisplay), jogWheel(formatManagerToUse, cacheToUse, _colour), library(&_library), theme(_colour)
+DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& cacheToUse, ZoomedWaveform* _zoomedDisplay, Library& _library, juce::Colour _colour, bool _isRightDeck) : player(_player), waveformDisplay(formatManagerToUse, cacheToUse, _colour), zoomedDisplay(_zoomedDisplay), jogWheel(formatManagerToUse, cacheToUse, _colour), library(&_library), theme(_colour), isRightDeck(_isRightDeck)
 {
 	std::vector<juce::Label*> labels{ &volLabel, &speedLabel, &filterLabel, &lbLabel, &mbLabel, &hbLabel };
 	for (auto& label : labels) {
@@ -32,6 +32,20 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& formatManager
 	addAndMakeVisible(lowBandFilter);
 	addAndMakeVisible(midBandFilter);
 	addAndMakeVisible(highBandFilter);
+	addAndMakeVisible(ramButton);
+	addAndMakeVisible(keylockButton);
+	addAndMakeVisible(qualityButton);
+	for (auto& loopButton : { &loopInButton, &loopOutButton, &loopHalveButton, &loopDoubleButton, &autoLoopButton, &rollButton, &slipButton }) {
+		loopButton->setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colour::fromRGBA(25, 25, 25, 255));
+		loopButton->setColour(juce::TextButton::ColourIds::buttonOnColourId, theme);
+		loopButton->setColour(juce::TextButton::ColourIds::textColourOnId, juce::Colours::black);
+		loopButton->addListener(this);
+		addAndMakeVisible(loopButton);
+	}
+	autoLoopButton.setClickingTogglesState(true);
+	slipButton.setClickingTogglesState(true);
+	loopSizeLabel.setJustificationType(juce::Justification::centred);
+	addAndMakeVisible(loopSizeLabel);
 
 	volSlider.setRange(0, 1);
 	speedSlider.setRange(0.8, 1.2);
@@ -42,6 +56,7 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& formatManager
 	waveformDisplay.setRange(0, 1);
 	zoomedDisplay->setRange(0, 1);
 	jogWheel.setRange(0, 1);
+	jogWheel.onScratch = [this](bool isScratching, double velocity) { player->setScratch(isScratching, velocity); };
 
 	filter.setValue(0);
 	lowBandFilter.setValue(1);
@@ -52,6 +67,9 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& formatManager
 
 	playButton.addListener(this);
 	loadButton.addListener(this);
+	ramButton.addListener(this);
+	keylockButton.addListener(this);
+	qualityButton.addListener(this);
 	volSlider.addListener(this);
 	speedSlider.addListener(this);
 
@@ -93,6 +111,13 @@ DeckGUI::DeckGUI(DJAudioPlayer* _player, juce::AudioFormatManager& formatManager
 		nullptr);
 	loadButton.setImages(loadButtonImage.get(), loadButtonHoverImage.get());
 	playButton.setClickingTogglesState(true);
+	for (auto& toggle : { &ramButton, &keylockButton }) {
+		toggle->setClickingTogglesState(true);
+		toggle->setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colour::fromRGBA(25, 25, 25, 255));
+		toggle->setColour(juce::TextButton::ColourIds::buttonOnColourId, theme);
+		toggle->setColour(juce::TextButton::ColourIds::textColourOnId, juce::Colours::black);
+	}
+	qualityButton.setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colour::fromRGBA(25, 25, 25, 255));
 	playButton.setEdgeIndent(0);
 	loadButton.setEdgeIndent(0);
 
@@ -124,6 +149,7 @@ DeckGUI::~DeckGUI()
  * Implementation of paint method for DeckGUI
  *
  * Cue button colours are being set and the volume meter is drawn based on the volRMS value.
+ * The render time of the deck is drawn under the quality button.
  *
  */
 void DeckGUI::paint(juce::Graphics& g)
@@ -149,7 +175,7 @@ void DeckGUI::paint(juce::Graphics& g)
 			g.setColour(juce::Colour::fromRGBA(25, 25, 25, 255));
 		}
 
-		double volXOffset = theme == juce::Colours::hotpink ? 62.5 : getWidth() - (double)75;
+		double volXOffset = isRightDeck ? 62.5 : getWidth() - (double)75;
 
 		juce::Rectangle<float> rect(volXOffset, pos, 12.5, (volMeterHeight / 10) - 2);
 		g.fillRect(rect);
@@ -165,9 +191,20 @@ void DeckGUI::paint(juce::Graphics& g)
 		}
 	}
 
-	double mainXOffset = theme == juce::Colours::hotpink ? getWidth() * 7 / 32 : getWidth() * 25 / 32;
+	double mainXOffset = isRightDeck ? getWidth() * 7 / 32 : getWidth() * 25 / 32;
 	g.setColour(juce::Colour::fromRGBA(25, 25, 25, 255));
 	g.drawLine(mainXOffset, 0, mainXOffset, getHeight());
+
+	if (renderTime >= 0) {
+		g.setColour(juce::Colours::grey);
+		g.setFont(11.0f);
+		g.drawText(juce::String(renderTime / 100.0, 2) + " ms", qualityButton.getBounds().translated(0, 24).withHeight(14), juce::Justification::centred);
+	}
+
+	if (loadProgress >= 0) {
+		g.setColour(theme);
+		g.fillRect(0.0f, 0.0f, (float)(getWidth() * juce::jmax(0.02, loadProgress)), 3.0f);
+	}
 }
 
 /**
@@ -179,12 +216,12 @@ void DeckGUI::paint(juce::Graphics& g)
 void DeckGUI::resized()
 {
 	double rowH = getHeight() / 9;
-	double volXOffset = theme == juce::Colours::hotpink ? 5.5 : getWidth() - (double)55;
+	double volXOffset = isRightDeck ? 5.5 : getWidth() - (double)55;
 	volSlider.setBounds(volXOffset, rowH * 2, 50, rowH * 3);
 	volLabel.setBounds(volXOffset, rowH * 5 + 5, 50, rowH * 0.5);
 	filter.setBounds(volXOffset, rowH * 5.8, 50, 50);
 	filterLabel.setBounds(volXOffset, rowH * 6.9, 50, 50);
-	double mainXOffset = theme == juce::Colours::hotpink ? getWidth() * 7 / 32 : 0;
+	double mainXOffset = isRightDeck ? getWidth() * 7 / 32 : 0;
 	speedSlider.setBounds(mainXOffset, rowH * 2, getWidth() / 8, rowH * 3);
 	speedLabel.setBounds(mainXOffset, rowH * 5 + 5, getWidth() / 8, rowH * 0.5);
 	jogWheel.setBounds(mainXOffset + getWidth() * 22.5 / 32 - 98.9, 5 + rowH * 2, (rowH * 3.3) - 10, (rowH * 3.3) - 10);
@@ -210,6 +247,17 @@ void DeckGUI::resized()
 	lbLabel.setBounds(xOffset, rowH * 6.9, 50, 50);
 	mbLabel.setBounds(xOffset + getWidth() / 5, rowH * 6.9, 50, 50);
 	hbLabel.setBounds(xOffset + getWidth() * 2 / 5, rowH * 6.9, 50, 50);
+
+	double toggleXOffset = isRightDeck ? 65 : getWidth() - (double)125;
+	ramButton.setBounds(toggleXOffset, rowH * 5.8, 60, 20);
+	keylockButton.setBounds(toggleXOffset, rowH * 5.8 + 24, 60, 20);
+	qualityButton.setBounds(toggleXOffset, rowH * 5.8 + 48, 60, 20);
+
+	std::vector<juce::Component*> loopControls{ &loopInButton, &loopOutButton, &loopHalveButton, &loopSizeLabel, &loopDoubleButton, &autoLoopButton, &rollButton, &slipButton };
+	double loopCellLength = cellLength * 3 / loopControls.size();
+	for (auto i = 0; i < loopControls.size(); ++i) {
+		loopControls[i]->setBounds(i * loopCellLength + xOffset, rowH * 8, loopCellLength - 4, rowH * 0.7);
+	}
 }
 
 //============================================================================== 
@@ -231,13 +279,67 @@ void DeckGUI::buttonClicked(juce::Button* button) {
 	}
 
 
+	if (button == &ramButton) {
+		player->setLoadMode(ramButton.getToggleState() ? DJAudioPlayer::ramResident : DJAudioPlayer::streaming);
+	}
+
+	if (button == &keylockButton) {
+		player->setKeylock(keylockButton.getToggleState());
+	}
+
+	if (button == &qualityButton) {
+		const auto quality = (PolyphaseResamplingAudioSource::Quality)((player->getResamplerQuality() + 1) % PolyphaseResamplingAudioSource::numQualities);
+		const juce::String names[] = { "DRAFT", "NORMAL", "MASTER" };
+		player->setResamplerQuality(quality);
+		qualityButton.setButtonText(names[quality]);
+	}
+
+	if (button == &slipButton) {
+		player->setSlip(slipButton.getToggleState());
+	}
+
 	if (button == &loadButton && library->selectionIsValid()) {
 		loadDeck(library->getSelectedTrack());
 	}
 
 	if (player->isLoaded()) {
-		for (auto& cue : cues) {
-			juce::TextButton* thisButton = cue;
+		if (button == &loopInButton) {
+			loopIn = player->getCurrentPosition();
+			player->setLoopIn(loopIn);
+		}
+
+		if (button == &loopOutButton) {
+			if (player->isLoopActive()) {
+				player->exitLoop();
+				autoLoopStart = -1;
+			}
+			else if (loopIn >= 0 && player->getCurrentPosition() > loopIn) {
+				player->setLoop(loopIn, player->getCurrentPosition());
+			}
+		}
+
+		if (button == &loopHalveButton || button == &loopDoubleButton) {
+			loopBeats = juce::jlimit(0.25, 32.0, button == &loopHalveButton ? loopBeats / 2 : loopBeats * 2);
+			loopSizeLabel.setText(loopBeats < 1 ? "1/" + juce::String(juce::roundToInt(1 / loopBeats)) : juce::String(juce::roundToInt(loopBeats)), juce::NotificationType::dontSendNotification);
+			if (autoLoopStart >= 0 && player->isLoopActive()) {
+				player->setLoop(autoLoopStart, autoLoopStart + getLoopLength());
+			}
+		}
+
+		if (button == &autoLoopButton) {
+			if (autoLoopButton.getToggleState()) {
+				startBeatLoop(false);
+			}
+			else {
+				player->exitLoop();
+				autoLoopStart = -1;
+			}
+		}
+	}
+
+	if (player->isLoaded()) {
+		for (auto i = 0; i < cues.size(); ++i) {
+			juce::TextButton* thisButton = cues[i];
 			if (button == thisButton) {
 				if (cueTargets.find(thisButton) != cueTargets.end()) {
 					player->setPositionRelative(cueTargets[thisButton].first);
@@ -248,6 +350,7 @@ void DeckGUI::buttonClicked(juce::Button* button) {
 				}
 				else {
 					cueTargets[thisButton] = std::make_pair(player->getPositionRelative(), static_cast <float> (rand()) / static_cast <float> (RAND_MAX));
+					player->setCuePoint(i, cueTargets[thisButton].first);
 					waveformDisplay.setCuePoints(cueTargets);
 					zoomedDisplay->setCuePoints(cueTargets);
 				}
@@ -258,6 +361,27 @@ void DeckGUI::buttonClicked(juce::Button* button) {
 	modeIsPlaying ? player->start() : player->stop();
 };
 
+/**
+ * Implementation of buttonStateChanged method for DeckGUI
+ *
+ * Starts a loop roll while the roll button is held down and exits it,
+ * returning to the slipped position, once it is released.
+ *
+ */
+void DeckGUI::buttonStateChanged(juce::Button* button) {
+	if (button == &rollButton && player->isLoaded()) {
+		if (rollButton.isDown() && !rolling) {
+			rolling = true;
+			startBeatLoop(true);
+		}
+		else if (!rollButton.isDown() && rolling) {
+			rolling = false;
+			player->exitLoop();
+			autoLoopStart = -1;
+		}
+	}
+};
+
 //============================================================================== 
 
 /**
@@ -336,10 +460,13 @@ void DeckGUI::filesDropped(const juce::StringArray& files, int x, int y) {
 /**
  * Implementation of timerCallback method for DeckGUI
  *
- * Continuously update any WaveformDisplay objects from the player's position.
- * Check if any WaveformDisplay objects' playback control is triggered, and setting
- * the DJAudioPlayer instance's playback with the triggered playback control value.
- * This is also where the DJAudioPlayer instance's root mean square value is updated.
+ * While the JogWheel is held its velocity is passed on again, so it drops to 0 once the hand stops.
+ * Dragging a WaveformDisplay scrubs through the scratch engine the same way: every tick
+ * the deck is scratched at the velocity that brings the playhead to the dragged position
+ * by the next tick, capped at maxScrubVelocity, and the scratch ends when the drag does,
+ * leaving the deck playing or stopped as it was. A drag further from the playhead than
+ * the scratch source holds around it jumps there with a seek instead.
+ * This is also where the DJAudioPlayer instance's level meter is updated and its root mean square value read.
  *
  */
 void DeckGUI::timerCallback() {
@@ -349,65 +476,130 @@ void DeckGUI::timerCallback() {
 		repaint();
 	}
 
+	if (jogWheel.isScratching()) {
+		player->setScratch(true, jogWheel.getScratchVelocity());
+	}
+
 	for (auto i = 0; i < displays.size(); ++i) {
 		if (displays[i]->isFileLoaded()) {
-			double pos = displays[i]->getValue();
 			if (displays[i]->isSliderDragged()) {
 				draggedIndex = i;
-				canContinue = false;
-				if (displays[i] == &waveformDisplay) {
-					player->stop();
+				const double distance = (displays[i]->getValue() - player->getPositionRelative()) * player->getLengthInSeconds();
+				if (std::abs(distance) > scrubJumpSeconds) {
+					player->setScratch(false, 0.0);
+					player->setPositionRelative(displays[i]->getValue());
 				}
 				else {
-					if (prevPlayerPos == pos) {
-						player->stop();
-					}
-					else {
-						!player->isPlaying() ? player->start() : NULL;
-					}
+					player->setScratch(true, juce::jlimit(-maxScrubVelocity, maxScrubVelocity, distance * 1000.0 / getTimerInterval()));
 				}
-				player->setPositionRelative(pos);
-				prevPlayerPos = pos;
 			}
-			else if (canContinue == false && !(displays[i]->isSliderDragged()) && draggedIndex == i) {
-				DBG("YESSSS " << (displays[i]->isSliderDragged() ? "true" : "false"));
-				modeIsPlaying ? player->start() : player->stop();
-				canContinue = true;
+			else if (draggedIndex == i) {
+				player->setScratch(false, 0.0);
 				draggedIndex = -1;
 			}
-			else {
-				displays[i]->setPositionRelative(player->getPositionRelative());
-			}
 		}
 	}
 
+	const int newRenderTime = juce::roundToInt(player->getRenderTime() * 100.0);
+	if (renderTime != newRenderTime) {
+		renderTime = newRenderTime;
+		repaint(qualityButton.getBounds().translated(0, 24).withHeight(14));
+	}
+
+	if (autoLoopButton.getToggleState() != player->isLoopActive()) {
+		autoLoopButton.setToggleState(player->isLoopActive(), juce::NotificationType::dontSendNotification);
+	}
+
+	player->getLevelMeter().update();
 	if (volRMS != player->getRMSLevel()) {
 		volRMS = player->getRMSLevel();
 		repaint();
 	}
 }
 
+/**
+ * Implementation of updatePlayhead method for DeckGUI
+ *
+ * Runs at the display refresh rate, so the waveforms move on every frame. The player
+ * extrapolates its playhead from the one the audio thread last published, which is
+ * read once per frame for every WaveformDisplay object not being dragged.
+ *
+ */
+void DeckGUI::updatePlayhead() {
+	const double position = player->getPositionRelative();
+	for (auto i = 0; i < displays.size(); ++i) {
+		if (displays[i]->isFileLoaded() && !displays[i]->isSliderDragged() && draggedIndex != i) {
+			displays[i]->setPositionRelative(position);
+		}
+	}
+}
+
 //============================================================================== 
 
 /**
  * Implementation of loadDeck method for DeckGUI
  *
- * Loads the player with the track object.
- * Loads all WaveformDisplay objects with the track object.
- * Cue point data from previously loaded tracks are cleared.
+ * Starts loading the player with the track object in the background,
+ * showing the load progress along the top of the deck. Once the player
+ * has swapped the new file in, all WaveformDisplay objects are loaded
+ * with the track object and cue point data from previously loaded
+ * tracks are cleared. Loading another track first cancels this one.
  *
  */
 void DeckGUI::loadDeck(track track) {
-	player->loadURL(track.url);
-	if (player->isLoaded()) {
-		for (auto& display : displays) {
+	juce::Component::SafePointer<DeckGUI> safeThis(this);
+	loadProgress = 0;
+	repaint();
+
+	player->loadURLAsync(track.url,
+		[safeThis](double progress) {
+			if (safeThis != nullptr) {
+				safeThis->loadProgress = progress;
+				safeThis->repaint();
+			}
+		},
+		[safeThis, track](bool succeeded) {
+			if (safeThis != nullptr) {
+				safeThis->loadProgress = -1;
+				if (succeeded) {
+					safeThis->deckLoaded(track);
+				}
+				safeThis->repaint();
+			}
+		});
+};
+
+/**
+ * Implementation of deckLoaded method for DeckGUI
+ *
+ * Sets the player's normalising gain from the track's loudness and clears the cue
+ * point and loop data of previously loaded tracks. Loading the WaveformDisplay objects
+ * opens the file for its waveform, so it is posted to run after this message rather
+ * than holding up a deck that starts playing straight away; it is dropped if another
+ * track was loaded or the deck deleted by then.
+ *
+ */
+void DeckGUI::deckLoaded(track track) {
+	const int generation = ++displayLoadGeneration;
+	juce::Component::SafePointer<DeckGUI> safeThis(this);
+	juce::MessageManager::callAsync([safeThis, generation, track] {
+		if (safeThis == nullptr || safeThis->displayLoadGeneration != generation) {
+			return;
+		}
+		for (auto& display : safeThis->displays) {
 			display->loadTrack(track);
-			display->addListener(this);
+			display->addListener(safeThis.getComponent());
 		}
-	}
+	});
 
+	player->setNormalisation(track.loudness, track.truePeak);
 	player->setGain(volSlider.getValue(), true);
 	cueTargets.clear();
+	loadedTrack = track;
+	loopIn = -1;
+	autoLoopStart = -1;
+	rolling = false;
+	autoLoopButton.setToggleState(false, juce::NotificationType::dontSendNotification);
 
 	if (modeIsPlaying) {
 		playButton.setToggleState(true, juce::NotificationType::dontSendNotification);
@@ -418,4 +610,33 @@ void DeckGUI::loadDeck(track track) {
 	}
 };
 
+/**
+ * Implementation of startBeatLoop method for DeckGUI
+ *
+ * The loop starts on the last beat of the grid at or before the playhead, so it stays
+ * in phase with the track, and runs for the set number of beats.
+ *
+ */
+void DeckGUI::startBeatLoop(bool roll) {
+	const double position = player->getCurrentPosition();
+	double start = position;
+	if (loadedTrack.bpm > 0) {
+		const double beatLength = 60.0 / loadedTrack.bpm;
+		const double beatStart = loadedTrack.firstBeat + std::floor((position - loadedTrack.firstBeat) / beatLength) * beatLength;
+		start = beatStart >= 0 ? beatStart : position;
+	}
+	autoLoopStart = start;
+	player->setLoop(start, start + getLoopLength(), roll);
+};
+
+/**
+ * Implementation of getLoopLength method for DeckGUI
+ *
+ * Tracks without a tempo loop at 120 BPM.
+ *
+ */
+double DeckGUI::getLoopLength() {
+	return loopBeats * 60.0 / (loadedTrack.bpm > 0 ? loadedTrack.bpm : 120.0);
+};
+
 //============================================================================== 
@@ -38,8 +38,9 @@ public:
 		* @param ZoomedWaveform pointer
 		* @param Library reference to load track selections
 		* @param juce::Colour that defines the theme colour of the component
+		* @param True to mirror the layout for a deck on the right of the mixer
 	*/
-	DeckGUI(DJAudioPlayer* player, juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& cacheToUse, ZoomedWaveform* _zoomedDisplay, Library& _library, juce::Colour _colour);
+	DeckGUI(DJAudioPlayer* player, juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& cacheToUse, ZoomedWaveform* _zoomedDisplay, Library& _library, juce::Colour _colour, bool _isRightDeck);
 
 	/**
 		* Class Destructor for DeckGUI, clears dynamically allocated variables.
@@ -73,6 +74,13 @@ private:
 	*/
 	void buttonClicked(juce::Button* button) override;
 
+	/**
+		* Called when a button in DeckGUI listener is pressed or released, used for the momentary loop roll.
+		*
+		* @param juce::Button object that has added this component as its listener
+	*/
+	void buttonStateChanged(juce::Button* button) override;
+
 	//==============================================================================
 
 	/**
@@ -108,6 +116,11 @@ private:
 	*/
 	void timerCallback() override;
 
+	/**
+		* Moves the WaveformDisplay objects to the player's playhead, called on every display refresh.
+	*/
+	void updatePlayhead();
+
 	//==============================================================================
 
 	/**
@@ -117,6 +130,26 @@ private:
 	*/
 	void loadDeck(track track);
 
+	/**
+		* Resets the deck once the player has loaded the track and posts the loading of the WaveformDisplay objects.
+		*
+		* @param track object that was loaded into the player
+	*/
+	void deckLoaded(track track);
+
+	/**
+		* Loops the set number of beats from the beat at or before the playhead, snapped to the
+		* loaded track's beatgrid when it has one, otherwise from the playhead at 120 BPM.
+		*
+		* @param True for a loop roll
+	*/
+	void startBeatLoop(bool roll);
+
+	/**
+		* @return Length of the set number of beats in seconds at the loaded track's tempo
+	*/
+	double getLoopLength();
+
 	//==============================================================================
 
 	/// Pointer to Library component.
@@ -155,6 +188,12 @@ private:
 	/// juce::Colour to define the theme of the DeckGUI
 	juce::Colour theme;
 
+	/// Flags if the deck sits on the right of the mixer, mirroring its layout
+	bool isRightDeck;
+
+	/// Portion of the pending track load between 0 and 1, -1 when no load is pending
+	double loadProgress = -1;
+
 	/// juce::Label to label the volume slider
 	juce::Label volLabel{ "VOLUME", "VOLUME" };
 
@@ -191,6 +230,54 @@ private:
 	/// juce::Label to label the high band slider
 	juce::Label hbLabel{ "HIGH", "HIGH" };
 
+	/// juce::TextButton toggling RAM-resident loading for the next loaded track
+	juce::TextButton ramButton{ "RAM" };
+
+	/// juce::TextButton toggling keylock so the BPM slider keeps the pitch
+	juce::TextButton keylockButton{ "KEY" };
+
+	/// juce::TextButton cycling the speed resampler through its quality tiers
+	juce::TextButton qualityButton{ "NORMAL" };
+
+	/// juce::TextButton marking the start of a manual loop
+	juce::TextButton loopInButton{ "IN" };
+
+	/// juce::TextButton closing a manual loop at the playhead, or exiting the active loop
+	juce::TextButton loopOutButton{ "OUT" };
+
+	/// juce::TextButton halving the loop length
+	juce::TextButton loopHalveButton{ "-" };
+
+	/// juce::TextButton doubling the loop length
+	juce::TextButton loopDoubleButton{ "+" };
+
+	/// juce::Label showing the loop length in beats
+	juce::Label loopSizeLabel{ "LOOPSIZE", "4" };
+
+	/// juce::TextButton toggling an auto loop of the set length
+	juce::TextButton autoLoopButton{ "LOOP" };
+
+	/// juce::TextButton held down for a loop roll of the set length
+	juce::TextButton rollButton{ "ROLL" };
+
+	/// juce::TextButton toggling slip mode, so a scratch returns to where the track would have been
+	juce::TextButton slipButton{ "SLIP" };
+
+	/// Track loaded into the player, its tempo and beatgrid set the loop lengths
+	track loadedTrack;
+
+	/// Loop length in beats, from 1/4 to 32
+	double loopBeats = 4;
+
+	/// Start of a manual loop marked with loopInButton in seconds, -1 when unmarked
+	double loopIn = -1;
+
+	/// Start of the auto loop or loop roll in seconds, -1 when none is set
+	double autoLoopStart = -1;
+
+	/// Flags if the roll button is held down
+	bool rolling = false;
+
 	/// Instance of WaveformDisplay class.
 	WaveformDisplay waveformDisplay;
 
@@ -206,20 +293,26 @@ private:
 	/// Vector of juce::TextButton pointers for cue buttons
 	std::vector<juce::TextButton*> cues;
 
+	/// Render time of the deck last drawn, in hundredths of a millisecond, -1 until the timer first reads it
+	int renderTime = -1;
+
 	/// Map of juce::TextButton pointers to std::pair of double and floats. Maps cue buttons to a pair containing double for audio position and float for hue colour of cue button.
 	std::map<juce::TextButton*, std::pair<double, float>> cueTargets;
 
-	/// Previous audio player position used to compare to the current player position.
-	double prevPlayerPos;
-
-	/// Determines if the player can continue playing
-	bool canContinue = true;
-
 	/// Determines if the deck playing mode.
 	bool modeIsPlaying = false;
 
 	/// Determines the WaveformDisplay object being dragged in displays vector.
-	int draggedIndex;
+	int draggedIndex = -1;
+
+	/// Incremented by every loaded track, so a waveform load posted for an earlier one is dropped
+	int displayLoadGeneration = 0;
+
+	/// Fastest a dragged WaveformDisplay scratches the deck, relative to normal playback
+	static constexpr double maxScrubVelocity = 16.0;
+
+	/// Seconds from the playhead beyond which a dragged WaveformDisplay seeks instead, within the audio the scratch source holds around the playhead
+	static constexpr double scrubJumpSeconds = 4.0;
 
 	/// Determines if cue buttons should be lit up with their hue colours in cueTargets map.
 	bool flash;
@@ -230,5 +323,8 @@ private:
 	/// Determines the average root mean square value derived from the DJAudioPlayer
 	float volRMS;
 
+	/// Calls updatePlayhead in time with the display refresh
+	juce::VBlankAttachment vBlankAttachment{ this, [this] { updatePlayhead(); } };
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeckGUI);
 };
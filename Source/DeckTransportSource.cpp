@@ -0,0 +1,137 @@
+
+#include "DeckTransportSource.h"
+
+//==============================================================================
+
+/**
+ * Implementation of setSource method for DeckTransportSource
+ *
+ * Saves the source and its sample rate and clears the end of stream flag
+ *
+ */
+void DeckTransportSource::setSource(juce::PositionableAudioSource* newSource, double newSourceSampleRate) {
+	source = newSource;
+	sourceSampleRate = newSource != nullptr ? newSourceSampleRate : 0.0;
+	inputStreamEOF = false;
+}
+
+/**
+ * Implementation of getSourceSampleRate method for DeckTransportSource
+ *
+ * Returns the sourceSampleRate data member
+ *
+ */
+double DeckTransportSource::getSourceSampleRate() const {
+	return sourceSampleRate;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for DeckTransportSource
+ *
+ * Saves the block size and prepares the source at the sample rate of the file.
+ *
+ */
+void DeckTransportSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	juce::ignoreUnused(sampleRate);
+	blockSize = samplesPerBlockExpected;
+	if (source != nullptr) {
+		source->prepareToPlay(blockSize, sourceSampleRate);
+	}
+	lastGain = gain;
+}
+
+/**
+ * Implementation of releaseResources method for DeckTransportSource
+ *
+ * Calls releaseResources on the source
+ *
+ */
+void DeckTransportSource::releaseResources() {
+	if (source != nullptr) {
+		source->releaseResources();
+	}
+}
+
+/**
+ * Implementation of getNextAudioBlock method for DeckTransportSource
+ *
+ * Reads the block from the source and ramps from the gain of the last block to the
+ * current one. A source that does not loop and has played past its end is flagged
+ * as finished, as juce::AudioTransportSource would, but nobody is sent a message.
+ *
+ */
+void DeckTransportSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	if (source == nullptr) {
+		bufferToFill.clearActiveBufferRegion();
+		return;
+	}
+
+	source->getNextAudioBlock(bufferToFill);
+	if (!source->isLooping() && source->getNextReadPosition() > source->getTotalLength() + 1) {
+		inputStreamEOF = true;
+	}
+
+	for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+		bufferToFill.buffer->applyGainRamp(chan, bufferToFill.startSample, bufferToFill.numSamples, lastGain, gain);
+	}
+	lastGain = gain;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setPosition method for DeckTransportSource
+ *
+ * Converts the position into samples of the source and moves the source there
+ *
+ */
+void DeckTransportSource::setPosition(double newPosition) {
+	if (source != nullptr && sourceSampleRate > 0) {
+		source->setNextReadPosition((juce::int64)(newPosition * sourceSampleRate));
+		inputStreamEOF = false;
+	}
+}
+
+/**
+ * Implementation of getCurrentPosition method for DeckTransportSource
+ *
+ * Converts the position of the source into seconds
+ *
+ */
+double DeckTransportSource::getCurrentPosition() const {
+	return source != nullptr && sourceSampleRate > 0 ? (double)source->getNextReadPosition() / sourceSampleRate : 0.0;
+}
+
+/**
+ * Implementation of getLengthInSeconds method for DeckTransportSource
+ *
+ * Converts the length of the source into seconds
+ *
+ */
+double DeckTransportSource::getLengthInSeconds() const {
+	return source != nullptr && sourceSampleRate > 0 ? (double)source->getTotalLength() / sourceSampleRate : 0.0;
+}
+
+/**
+ * Implementation of hasStreamFinished method for DeckTransportSource
+ *
+ * Returns the inputStreamEOF data member
+ *
+ */
+bool DeckTransportSource::hasStreamFinished() const {
+	return inputStreamEOF;
+}
+
+/**
+ * Implementation of setGain method for DeckTransportSource
+ *
+ * Sets the gain data member
+ *
+ */
+void DeckTransportSource::setGain(float newGain) {
+	gain = newGain;
+}
+
+//==============================================================================
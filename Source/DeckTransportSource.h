@@ -0,0 +1,112 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+
+/**
+ * Definition of a DeckTransportSource
+ *
+ * The AudioSource at the head of a deck's playback chain, in place of a
+ * juce::AudioTransportSource. It reads the positionable source of the loaded file with
+ * a gain ramp and notices when a file that does not loop has run out, but it never takes
+ * a lock, never sends change messages and never resamples: a seek only hands the new
+ * position to the source, which every source of this app takes without blocking, and
+ * the sample rate of the file is corrected for by the deck's resampler. Only used from
+ * the audio thread, apart from setSource, which the owner keeps the audio thread out of.
+ *
+ */
+class DeckTransportSource : public juce::AudioSource {
+public:
+
+	//==============================================================================
+
+	/**
+		* Sets the source to play, which must already be prepared. The audio thread must not
+		* be inside getNextAudioBlock while it is called.
+		*
+		* @param PositionableAudioSource of the loaded file, not owned, or nullptr
+		* @param Number of samples per second of the source
+	*/
+	void setSource(juce::PositionableAudioSource* newSource, double newSourceSampleRate);
+
+	/**
+		* @return Number of samples per second of the source, 0 when there is none
+	*/
+	double getSourceSampleRate() const;
+
+	//==============================================================================
+
+	/**
+		* Prepares the source at its own sample rate
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second, ignored as the source is not resampled here
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Releases the source
+	*/
+	void releaseResources() override;
+
+	/**
+		* Reads the next block from the source with the gain applied, silence when there is no source
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Moves the source to a new position, taking effect on the next block
+		*
+		* @param Position in seconds
+	*/
+	void setPosition(double newPosition);
+
+	/**
+		* @return Next playback position of the source in seconds
+	*/
+	double getCurrentPosition() const;
+
+	/**
+		* @return Length of the source in seconds, 0 when there is none
+	*/
+	double getLengthInSeconds() const;
+
+	/**
+		* @return True once a source that does not loop has played past its end, until the next seek
+	*/
+	bool hasStreamFinished() const;
+
+	/**
+		* Sets the gain, ramped to over the next block
+		*
+		* @param Linear gain
+	*/
+	void setGain(float newGain);
+
+	//==============================================================================
+
+private:
+
+	/// Source of the loaded file, not owned
+	juce::PositionableAudioSource* source = nullptr;
+
+	/// Number of samples per second of the source
+	double sourceSampleRate = 0;
+
+	/// Gain to ramp to
+	float gain = 1.0f;
+
+	/// Gain the last block ended at
+	float lastGain = 1.0f;
+
+	/// Flags if the source has played past its end
+	bool inputStreamEOF = false;
+
+	/// Expected samples in a block, passed on to a new source
+	int blockSize = 512;
+};
@@ -0,0 +1,128 @@
+
+#include "DecodedAudioSource.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for DecodedAudioSource
+ *
+ * Holds a reference to the decoded track
+ *
+ */
+DecodedAudioSource::DecodedAudioSource(DecodedTrack::Ptr _track)
+	: track(_track)
+{
+	jassert(track != nullptr);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for DecodedAudioSource
+ *
+ * The track is already decoded, nothing to prepare
+ *
+ */
+void DecodedAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+}
+
+/**
+ * Implementation of releaseResources method for DecodedAudioSource
+ *
+ * The track is released with the source, nothing to release
+ *
+ */
+void DecodedAudioSource::releaseResources() {
+}
+
+/**
+ * Implementation of getNextAudioBlock method for DecodedAudioSource
+ *
+ * Copies the block from the decoded buffer in sections that end at the end of the track,
+ * wrapping to the start when looping and clearing the rest otherwise.
+ * A mono track is copied to every output channel.
+ *
+ */
+void DecodedAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	const auto& source = track->getBuffer();
+	const juce::int64 length = source.getNumSamples();
+	const bool shouldLoop = looping.load();
+	juce::int64 position = nextPlayPos.load();
+
+	int done = 0;
+	while (done < bufferToFill.numSamples) {
+		if (shouldLoop && length > 0) {
+			position %= length;
+		}
+		if (position < 0 || position >= length) {
+			bufferToFill.buffer->clear(bufferToFill.startSample + done, bufferToFill.numSamples - done);
+			position += bufferToFill.numSamples - done;
+			break;
+		}
+
+		const int sectionLength = (int)juce::jmin((juce::int64)(bufferToFill.numSamples - done), length - position);
+		for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+			bufferToFill.buffer->copyFrom(chan, bufferToFill.startSample + done, source, juce::jmin(chan, source.getNumChannels() - 1), (int)position, sectionLength);
+		}
+		done += sectionLength;
+		position += sectionLength;
+	}
+
+	nextPlayPos = position;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setNextReadPosition method for DecodedAudioSource
+ *
+ * Sets the nextPlayPos data member
+ *
+ */
+void DecodedAudioSource::setNextReadPosition(juce::int64 newPosition) {
+	nextPlayPos = newPosition;
+}
+
+/**
+ * Implementation of getNextReadPosition method for DecodedAudioSource
+ *
+ * Returns the playhead, wrapped to the track length when looping.
+ *
+ */
+juce::int64 DecodedAudioSource::getNextReadPosition() const {
+	const auto pos = nextPlayPos.load();
+	const auto length = getTotalLength();
+	return (looping && length > 0) ? pos % length : pos;
+}
+
+/**
+ * Implementation of getTotalLength method for DecodedAudioSource
+ *
+ * Returns the number of samples in the decoded buffer
+ *
+ */
+juce::int64 DecodedAudioSource::getTotalLength() const {
+	return track->getBuffer().getNumSamples();
+}
+
+/**
+ * Implementation of isLooping method for DecodedAudioSource
+ *
+ * Returns the looping data member
+ *
+ */
+bool DecodedAudioSource::isLooping() const {
+	return looping;
+}
+
+/**
+ * Implementation of setLooping method for DecodedAudioSource
+ *
+ * Sets the looping data member
+ *
+ */
+void DecodedAudioSource::setLooping(bool shouldLoop) {
+	looping = shouldLoop;
+}
+
+//==============================================================================
@@ -0,0 +1,97 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "TrackDecoder.h"
+
+//==============================================================================
+
+/**
+ * Definition of a DecodedAudioSource
+ *
+ * A PositionableAudioSource that plays a DecodedTrack straight from memory.
+ * Seeking only moves the playhead, so cues, scrubbing and waveform clicks take
+ * effect on the next block without any disk access or decoding.
+ *
+ */
+class DecodedAudioSource : public juce::PositionableAudioSource {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for DecodedAudioSource, initializes member variables.
+		*
+		* @param DecodedTrack to play, kept alive by this source
+	*/
+	DecodedAudioSource(DecodedTrack::Ptr track);
+
+	//==============================================================================
+
+	/**
+		* Nothing to prepare, the track is already in memory
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Nothing to release, the track is freed with the source
+	*/
+	void releaseResources() override;
+
+	/**
+		* Copies the next block out of the decoded track
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Sets the next playback position
+		*
+		* @param Position in samples
+	*/
+	void setNextReadPosition(juce::int64 newPosition) override;
+
+	/**
+		* @return Next playback position in samples
+	*/
+	juce::int64 getNextReadPosition() const override;
+
+	/**
+		* @return Length of the decoded track in samples
+	*/
+	juce::int64 getTotalLength() const override;
+
+	/**
+		* @return If the track is looping
+	*/
+	bool isLooping() const override;
+
+	/**
+		* Sets the looping state of the track
+		*
+		* @param True to loop the track
+	*/
+	void setLooping(bool shouldLoop) override;
+
+	//==============================================================================
+
+private:
+
+	/// Decoded track being played
+	DecodedTrack::Ptr track;
+
+	/// Next playback position in samples
+	std::atomic<juce::int64> nextPlayPos{ 0 };
+
+	/// Flags if the track is looping
+	std::atomic<bool> looping{ false };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedAudioSource)
+};
@@ -41,7 +41,7 @@ void JogWheel::paint(juce::Graphics& g)
 	g.fillEllipse(2, 2, getWidth() - 4, getHeight() - 4);
 
 	g.setColour(theme);
-	noRotations = audioThumb.getTotalLength() / 2;
+	noRotations = getLengthInSeconds() / secondsPerTurn;
 	float angle = getPosition() * 360 * noRotations;
 	float piAngle = angle * M_PI / 180;
 
@@ -59,7 +59,7 @@ void JogWheel::paint(juce::Graphics& g)
 	g.drawEllipse(10, 10, getWidth() - 20, getHeight() - 20, 1.5);
 
 	if (isLoaded) {
-		std::string time = track::getLengthString(position * audioThumb.getTotalLength(), true);
+		std::string time = track::getLengthString(position * getLengthInSeconds(), true);
 		juce::Rectangle<float> rect(0, getHeight() / 2 - 10, getWidth(), 10);
 		g.drawText(time, rect, juce::Justification::centred);
 	}
@@ -75,29 +75,102 @@ void JogWheel::resized()
 
 //==============================================================================
 
+/**
+ * Implementation of isScratching method for JogWheel
+ *
+ * Returns the scratching data member
+ *
+ */
+bool JogWheel::isScratching() {
+	return scratching;
+};
+
+/**
+ * Implementation of getScratchVelocity method for JogWheel
+ *
+ * Returns the smoothed velocity, or 0 once no drag event has come in for a moment,
+ * as a hand holding the JogWheel still sends none.
+ *
+ */
+double JogWheel::getScratchVelocity() {
+	if (!scratching || juce::Time::getMillisecondCounterHiRes() - lastDragTime > stillTime) {
+		return 0;
+	}
+	return scratchVelocity;
+};
+
+//==============================================================================
+
+/**
+ * Implementation of mouseDown method for JogWheel
+ *
+ * Grabbing the JogWheel stops the record under the hand, so a scratch starts at
+ * a velocity of 0 from the angle of the mouse.
+ *
+ */
+void JogWheel::mouseDown(const juce::MouseEvent& e) {
+	if (isEnabled() && isLoaded) {
+		juce::Point<double> centre(getWidth() / 2, getHeight() / 2);
+		scratching = true;
+		scratchVelocity = 0;
+		lastAngle = centre.getAngleToPoint(e.position.toDouble());
+		lastDragTime = juce::Time::getMillisecondCounterHiRes();
+		if (onScratch != nullptr) {
+			onScratch(true, 0);
+		}
+	}
+};
+
 /**
  * Implementation of mouseDrag method for JogWheel
  *
- * The current angle of the mouse is compared to the previous recorded angle
- * to determine if the playhead's value should move forward or backwards.
+ * The angle turned since the last drag event, wrapped to half a turn either way, is
+ * turned into seconds of audio and divided by the time between the events to give the
+ * velocity relative to normal playback, clockwise being forwards. Mouse events come in
+ * unevenly, so the velocity is smoothed over a couple of events.
  *
  */
 void JogWheel::mouseDrag(const juce::MouseEvent& e) {
+	if (!scratching) {
+		return;
+	}
 	juce::Point<double> centre(getWidth() / 2, getHeight() / 2);
-	juce::Point<double> currentPoint(e.x, e.y);
-	juce::Point<double> prevPoint(prevX, prevY);
-	if (isEnabled()) {
-		sliderIsDragged = true;
-		DBG("MOUSE DRAGGED :: jog");
-		if (centre.getAngleToPoint(currentPoint) - centre.getAngleToPoint(prevPoint) > 0) {
-			setValue(position + 0.1 / audioThumb.getTotalLength());
+	const double angle = centre.getAngleToPoint(e.position.toDouble());
+	const double now = juce::Time::getMillisecondCounterHiRes();
+	double turned = angle - lastAngle;
+	if (turned > juce::MathConstants<double>::pi) {
+		turned -= juce::MathConstants<double>::twoPi;
+	}
+	else if (turned < -juce::MathConstants<double>::pi) {
+		turned += juce::MathConstants<double>::twoPi;
+	}
+
+	const double elapsed = (now - lastDragTime) / 1000.0;
+	if (elapsed > 0) {
+		const double velocity = turned / juce::MathConstants<double>::twoPi * secondsPerTurn / elapsed;
+		const bool wasStill = now - lastDragTime > stillTime;
+		scratchVelocity = wasStill ? velocity : scratchVelocity + (velocity - scratchVelocity) * 0.5;
+		lastAngle = angle;
+		lastDragTime = now;
+		if (onScratch != nullptr) {
+			onScratch(true, scratchVelocity);
 		}
-		else if (centre.getAngleToPoint(currentPoint) - centre.getAngleToPoint(prevPoint) < 0) {
-			setValue(position - 0.1 / audioThumb.getTotalLength());
+	}
+};
+
+/**
+ * Implementation of mouseUp method for JogWheel
+ *
+ * Letting go of the JogWheel ends the scratch.
+ *
+ */
+void JogWheel::mouseUp(const juce::MouseEvent& e) {
+	if (scratching) {
+		scratching = false;
+		scratchVelocity = 0;
+		if (onScratch != nullptr) {
+			onScratch(false, 0);
 		}
-		prevX = e.x;
-		prevY = e.y;
-		setPositionRelative(getValue());
 	}
 };
 
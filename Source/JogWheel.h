@@ -10,6 +10,8 @@
  *
  * A component that has similar playback control functionality to ZoomedWaveform
  * but a different appearance. Acts as a DJ Deck's JogWheel display with playback functionality.
+ * Holding the JogWheel scratches, turning it reports the velocity of the turn relative
+ * to normal playback, with one turn covering secondsPerTurn of audio.
  * Communicates with DJAudioPlayer via the DeckGUI interface
  *
  */
@@ -35,6 +37,25 @@ public:
 
 	//==============================================================================
 
+	/**
+		* Returns true while the JogWheel is held
+	*/
+	bool isScratching();
+
+	/**
+		* Returns the velocity of the JogWheel relative to normal playback, negative when turned
+		* backwards and 0 when it has been held still for a moment
+	*/
+	double getScratchVelocity();
+
+	/// Called when the JogWheel is grabbed, turned or released, with the held state and velocity
+	std::function<void(bool, double)> onScratch;
+
+	/// Seconds of audio covered by one turn of the JogWheel
+	static constexpr double secondsPerTurn = 2.0;
+
+	//==============================================================================
+
 private:
 
 	//==============================================================================
@@ -53,6 +74,13 @@ private:
 
 	//==============================================================================
 
+	/**
+	   * Called when the mouse is pressed on the JogWheel.
+	   *
+	   * @param juce::MouseEvent triggered by user
+   */
+	void mouseDown(const juce::MouseEvent& e);
+
 	/**
 	   * Called when the mouse is dragged on the JogWheel.
 	   *
@@ -60,6 +88,13 @@ private:
    */
 	void mouseDrag(const juce::MouseEvent& e);
 
+	/**
+	   * Called when the mouse is released from the JogWheel.
+	   *
+	   * @param juce::MouseEvent triggered by user
+   */
+	void mouseUp(const juce::MouseEvent& e);
+
 	//==============================================================================
 
 	/// juce::Points for the JogWheel's playhead
@@ -74,5 +109,20 @@ private:
 	/// Number of rotations of the JogWheel playhead
 	float noRotations = 0;
 
+	/// Flags if the JogWheel is held
+	bool scratching = false;
+
+	/// Smoothed velocity of the JogWheel relative to normal playback
+	double scratchVelocity = 0;
+
+	/// Angle of the mouse around the centre at the last drag event, in radians
+	double lastAngle = 0;
+
+	/// Time of the last drag event in milliseconds
+	double lastDragTime = 0;
+
+	/// Milliseconds without a drag event after which a held JogWheel counts as still
+	static constexpr double stillTime = 50.0;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JogWheel)
 };
@@ -0,0 +1,203 @@
+
+#include "LevelMeter.h"
+#include "SampleMath.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for LevelMeter
+ *
+ * Prepares the meter for a default sample rate so it can be used before prepare is called.
+ *
+ */
+LevelMeter::LevelMeter()
+{
+	prepare(44100, 512);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepare method for LevelMeter
+ *
+ * Sets up the K-weighting filter for the sample rate and allocates the scratch
+ * buffer the weighted copy of a block is filtered in.
+ *
+ */
+void LevelMeter::prepare(double newSampleRate, int maximumBlockSize) {
+	sampleRate = newSampleRate;
+	weightedBuffer.setSize(2, juce::jmax(1, maximumBlockSize));
+	setKWeighting(kWeighting, newSampleRate);
+	kWeighting.reset();
+}
+
+/**
+ * Implementation of setKWeighting method for LevelMeter
+ *
+ * Calculates the two K-weighting stages of ITU-R BS.1770 for the sample rate,
+ * a high shelf of +4 dB around 1.7 kHz followed by a highpass at 38 Hz.
+ *
+ */
+void LevelMeter::setKWeighting(BiquadCascade<2>& filter, double sampleRate) {
+	double K = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 / sampleRate);
+	double Q = 0.7071752369554196;
+	const double Vh = std::pow(10.0, 3.999843853973347 / 20.0);
+	const double Vb = std::pow(Vh, 0.4996667741545416);
+	filter.setCoefficients(0, juce::IIRCoefficients(Vh + Vb * K / Q + K * K, 2.0 * (K * K - Vh), Vh - Vb * K / Q + K * K,
+		1.0 + K / Q + K * K, 2.0 * (K * K - 1.0), 1.0 - K / Q + K * K));
+
+	K = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 / sampleRate);
+	Q = 0.5003270373238773;
+	const double a0 = 1.0 + K / Q + K * K;
+	filter.setCoefficients(1, juce::IIRCoefficients(a0, -2.0 * a0, a0, a0, 2.0 * (K * K - 1.0), 1.0 - K / Q + K * K));
+}
+
+/**
+ * Implementation of process method for LevelMeter
+ *
+ * Measures the block in sections no longer than the scratch buffer and pushes a single
+ * measurement into the FIFO. The measurement is dropped if the message thread has not
+ * drained the FIFO, the audio thread never waits.
+ *
+ */
+void LevelMeter::process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) {
+	if (buffer.getNumChannels() == 0 || numSamples <= 0) {
+		return;
+	}
+
+	BlockMeasurement measurement;
+	measurement.numSamples = numSamples;
+
+	const int sectionSize = weightedBuffer.getNumSamples();
+	for (auto offset = 0; offset < numSamples; offset += sectionSize) {
+		measureSection(buffer, startSample + offset, juce::jmin(sectionSize, numSamples - offset), measurement);
+	}
+
+	int start1, size1, start2, size2;
+	fifo.prepareToWrite(1, start1, size1, start2, size2);
+	if (size1 > 0) {
+		measurements[(size_t)start1] = measurement;
+		fifo.finishedWrite(1);
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of update method for LevelMeter
+ *
+ * Drains the FIFO, using the number of measured samples as the clock for the ballistics:
+ * the peak hold falls at 20 dB per second, the mean square follows the signal with a
+ * 300 ms time constant and the K-weighted sums are gathered into 100 ms segments,
+ * the last 30 of which make up the short-term loudness window.
+ *
+ */
+void LevelMeter::update() {
+	const double rate = sampleRate.load();
+	const int segmentLength = (int)(rate / 10);
+
+	const int numReady = fifo.getNumReady();
+	if (numReady == 0) {
+		return;
+	}
+
+	int start1, size1, start2, size2;
+	fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+	auto readMeasurement = [&](const BlockMeasurement& measurement) {
+		const double seconds = measurement.numSamples / rate;
+
+		const float blockPeakDb = juce::Decibels::gainToDecibels(measurement.peak, minusInfinityDb);
+		peakDecibels = juce::jmax(blockPeakDb, peakDecibels - (float)(20.0 * seconds));
+
+		const float blockMeanSquare = measurement.sumOfSquares / (2.0f * measurement.numSamples);
+		meanSquare += (blockMeanSquare - meanSquare) * (float)(1.0 - std::exp(-seconds / 0.3));
+
+		currentSegmentSum += measurement.weightedSumOfSquares;
+		currentSegmentLength += measurement.numSamples;
+		if (currentSegmentLength >= segmentLength) {
+			segmentSums[(size_t)nextSegment] = currentSegmentSum;
+			segmentLengths[(size_t)nextSegment] = currentSegmentLength;
+			nextSegment = (nextSegment + 1) % numLoudnessSegments;
+			currentSegmentSum = 0;
+			currentSegmentLength = 0;
+		}
+	};
+
+	for (auto i = 0; i < size1; ++i) {
+		readMeasurement(measurements[(size_t)(start1 + i)]);
+	}
+	for (auto i = 0; i < size2; ++i) {
+		readMeasurement(measurements[(size_t)(start2 + i)]);
+	}
+	fifo.finishedRead(size1 + size2);
+
+	double windowSum = 0;
+	juce::int64 windowLength = 0;
+	for (auto i = 0; i < numLoudnessSegments; ++i) {
+		windowSum += segmentSums[(size_t)i];
+		windowLength += segmentLengths[(size_t)i];
+	}
+	shortTermLoudness = (windowLength > 0 && windowSum > 0)
+		? juce::jmax(minusInfinityDb, (float)(-0.691 + 10.0 * std::log10(windowSum / (double)windowLength)))
+		: minusInfinityDb;
+}
+
+/**
+ * Implementation of getPeakDecibels method for LevelMeter
+ *
+ * Returns the peakDecibels data member
+ *
+ */
+float LevelMeter::getPeakDecibels() const {
+	return peakDecibels;
+}
+
+/**
+ * Implementation of getRMSDecibels method for LevelMeter
+ *
+ * Converts the meanSquare data member to decibels
+ *
+ */
+float LevelMeter::getRMSDecibels() const {
+	return juce::Decibels::gainToDecibels(std::sqrt(meanSquare), minusInfinityDb);
+}
+
+/**
+ * Implementation of getShortTermLoudness method for LevelMeter
+ *
+ * Returns the shortTermLoudness data member
+ *
+ */
+float LevelMeter::getShortTermLoudness() const {
+	return shortTermLoudness;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of measureSection method for LevelMeter
+ *
+ * Finds the peak with juce::FloatVectorOperations, sums the squares of the raw samples
+ * and of a K-weighted copy in the scratch buffer. A mono buffer is measured as both channels.
+ *
+ */
+void LevelMeter::measureSection(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, BlockMeasurement& measurement) {
+	const float* channels[2] = { buffer.getReadPointer(0, startSample),
+		buffer.getReadPointer(juce::jmin(1, buffer.getNumChannels() - 1), startSample) };
+
+	for (auto ch = 0; ch < 2; ++ch) {
+		const auto range = juce::FloatVectorOperations::findMinAndMax(channels[ch], numSamples);
+		measurement.peak = juce::jmax(measurement.peak, -range.getStart(), range.getEnd());
+		measurement.sumOfSquares += SampleMath::sumOfSquares(channels[ch], numSamples);
+		weightedBuffer.copyFrom(ch, 0, channels[ch], numSamples);
+	}
+
+	kWeighting.process(weightedBuffer.getWritePointer(0), weightedBuffer.getWritePointer(1), numSamples);
+
+	for (auto ch = 0; ch < 2; ++ch) {
+		measurement.weightedSumOfSquares += SampleMath::sumOfSquares(weightedBuffer.getReadPointer(ch), numSamples);
+	}
+}
+
+//==============================================================================
@@ -0,0 +1,166 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "BiquadCascade.h"
+
+//==============================================================================
+
+/**
+ * Definition of a LevelMeter
+ *
+ * Measures peak, RMS and short-term loudness (EBU R128, 3 second window) of a stereo signal.
+ * The audio thread only accumulates the raw per block peak, sum of squares and K-weighted
+ * sum of squares and pushes them into a lock-free FIFO. The message thread drains the FIFO,
+ * applies the meter ballistics and converts the results to decibels.
+ *
+ */
+class LevelMeter {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for LevelMeter, initializes member variables.
+	*/
+	LevelMeter();
+
+	//==============================================================================
+
+	/**
+		* Sets up the K-weighting filter and scratch buffer. Called before audio processing starts.
+		*
+		* @param Number of samples per second
+		* @param Largest number of samples expected in a block
+	*/
+	void prepare(double sampleRate, int maximumBlockSize);
+
+	/**
+		* Sets the two stages of a cascade to the K-weighting filter of ITU-R BS.1770
+		*
+		* @param Cascade to set
+		* @param Number of samples per second
+	*/
+	static void setKWeighting(BiquadCascade<2>& filter, double sampleRate);
+
+	/**
+		* Measures a block and pushes the measurement to the message thread. Called from the audio thread.
+		*
+		* @param juce::AudioBuffer holding the block
+		* @param First sample of the block in the buffer
+		* @param Number of samples in the block
+	*/
+	void process(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+	//==============================================================================
+
+	/**
+		* Drains the measurements pushed by the audio thread and updates the meter readings.
+		* Called from the message thread.
+	*/
+	void update();
+
+	/**
+		* @return Peak level with a falling hold, in decibels
+	*/
+	float getPeakDecibels() const;
+
+	/**
+		* @return RMS level with a 300 ms integration time, in decibels
+	*/
+	float getRMSDecibels() const;
+
+	/**
+		* @return Short-term loudness over the last 3 seconds, in LUFS
+	*/
+	float getShortTermLoudness() const;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/// Raw measurement of a single block, summed over both channels
+	struct BlockMeasurement {
+		/// Largest absolute sample value
+		float peak = 0;
+
+		/// Sum of squared samples
+		float sumOfSquares = 0;
+
+		/// Sum of squared K-weighted samples
+		float weightedSumOfSquares = 0;
+
+		/// Number of samples per channel
+		int numSamples = 0;
+	};
+
+	//==============================================================================
+
+	/**
+		* Measures a section of a block no longer than the scratch buffer
+		*
+		* @param juce::AudioBuffer holding the block
+		* @param First sample of the section in the buffer
+		* @param Number of samples in the section
+		* @param BlockMeasurement to add the section to
+	*/
+	void measureSection(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples, BlockMeasurement& measurement);
+
+	//==============================================================================
+
+	/// Number of block measurements the FIFO can hold
+	static constexpr int fifoSize = 512;
+
+	/// Number of 100 ms segments in the short-term loudness window
+	static constexpr int numLoudnessSegments = 30;
+
+	/// Lowest level reported, in decibels
+	static constexpr float minusInfinityDb = -100.0f;
+
+	//==============================================================================
+
+	/// Two stage K-weighting filter used for loudness
+	BiquadCascade<2> kWeighting;
+
+	/// Scratch buffer holding the K-weighted copy of a block
+	juce::AudioBuffer<float> weightedBuffer;
+
+	/// Index management of the measurements FIFO
+	juce::AbstractFifo fifo{ fifoSize };
+
+	/// Block measurements handed from the audio thread to the message thread
+	std::array<BlockMeasurement, fifoSize> measurements;
+
+	/// Number of samples per second of the measured signal
+	std::atomic<double> sampleRate{ 44100 };
+
+	/// Peak level with a falling hold, in decibels
+	float peakDecibels = minusInfinityDb;
+
+	/// Mean square with meter ballistics applied
+	float meanSquare = 0;
+
+	/// Sums of K-weighted squares of the completed 100 ms segments
+	std::array<float, numLoudnessSegments> segmentSums{};
+
+	/// Number of samples of the completed 100 ms segments
+	std::array<int, numLoudnessSegments> segmentLengths{};
+
+	/// Index of the oldest segment in segmentSums
+	int nextSegment = 0;
+
+	/// Sum of K-weighted squares of the segment being filled
+	float currentSegmentSum = 0;
+
+	/// Number of samples of the segment being filled
+	int currentSegmentLength = 0;
+
+	/// Short-term loudness in LUFS
+	float shortTermLoudness = minusInfinityDb;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
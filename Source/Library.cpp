@@ -9,7 +9,8 @@
  * Data members are initialized and initial configurations are applied to components here.
  * File reading occurs from a fixed path defined in the header file.
  * The retrieved value tree from reading off the xml file is used to populate
- * the elements of the trackFolders data structure.
+ * the elements of the trackFolders data structure. Tracks the analyser did not
+ * finish before the application last closed are queued again by startAnalysis.
  *
  */
 Library::Library(juce::AudioFormatManager& _formatManager) : formatManager(_formatManager), playlist(_formatManager)
@@ -34,6 +35,10 @@ Library::Library(juce::AudioFormatManager& _formatManager) : formatManager(_form
 				for (auto j = 0; j < newValueTree.getChild(i).getNumChildren(); ++j) {
 					auto song = newValueTree.getChild(i).getChild(j);
 					track refSong{ song.getProperty("title"), song.getProperty("length") , song.getProperty("url") , song.getProperty("identity") };
+					refSong.bpm = song.getProperty("bpm", 0.0);
+					refSong.firstBeat = song.getProperty("firstBeat", 0.0);
+					refSong.loudness = song.getProperty("loudness", 0.0);
+					refSong.truePeak = song.getProperty("truePeak", 0.0);
 					folder.second.push_back(refSong);
 				}
 				trackFolders.push_back(folder);
@@ -75,6 +80,10 @@ Library::~Library()
 			song.setProperty("length", trackFolders[i].second[j].lengthInSeconds, nullptr);
 			song.setProperty("url", trackFolders[i].second[j].url.toString(false), nullptr);
 			song.setProperty("identity", trackFolders[i].second[j].identity, nullptr);
+			song.setProperty("bpm", trackFolders[i].second[j].bpm, nullptr);
+			song.setProperty("firstBeat", trackFolders[i].second[j].firstBeat, nullptr);
+			song.setProperty("loudness", trackFolders[i].second[j].loudness, nullptr);
+			song.setProperty("truePeak", trackFolders[i].second[j].truePeak, nullptr);
 			folder.addChild(song, j, nullptr);
 		}
 		main.addChild(folder, i, nullptr);
@@ -151,6 +160,16 @@ void Library::deleteItem() {
 	}
 };
 
+/**
+ * Implementation of setAnalysisThrottled method for Library
+ *
+ * Passes the flag to the analyser
+ *
+ */
+void Library::setAnalysisThrottled(bool shouldThrottle) {
+	analyser.setThrottled(shouldThrottle);
+};
+
 //==============================================================================
 
 /**
@@ -248,6 +267,7 @@ bool Library::isInterestedInFileDrag(const juce::StringArray& files) {
  * is communicated to the playlist instance using the trackFolders data.
  * Adds tracks into the currently selected folder if items are dropped on the playlist component.
  * Adds folder of tracks into the library if items are dropped on the library component.
+ * The new tracks are then queued for analysis.
  *
  */
 void Library::filesDropped(const juce::StringArray& files, int x, int y) {
@@ -308,7 +328,62 @@ void Library::filesDropped(const juce::StringArray& files, int x, int y) {
 	}
 	directoryComponent.updateContent();
 	directoryComponent.selectRow(selectedFolderIndex, true);
+	analyseNewTracks();
 };
 
-//==============================================================================
+/**
+ * Implementation of startAnalysis method for Library
+ *
+ * Queues the tracks left unanalysed by earlier sessions
+ *
+ */
+void Library::startAnalysis() {
+	analyseNewTracks();
+};
+
+/**
+ * Implementation of analyseNewTracks method for Library
+ *
+ * The analyser skips files it already has queued, so a file in several folders is
+ * analysed once. The callback holds a SafePointer so it does nothing once the
+ * Library is deleted. Tracks analysed for tempo before loudness was measured
+ * are queued again for their loudness.
+ *
+ */
+void Library::analyseNewTracks() {
+	juce::Component::SafePointer<Library> safeThis(this);
+	for (auto& folder : trackFolders) {
+		for (auto& song : folder.second) {
+			if ((song.bpm == 0 || song.loudness == 0) && song.url.isLocalFile()) {
+				const juce::String path = song.url.getLocalFile().getFullPathName();
+				analyser.analyse(song.url.getLocalFile(), [safeThis, path](const TrackAnalyser::Result& result) {
+					if (safeThis != nullptr) {
+						safeThis->storeAnalysis(path, result);
+					}
+				});
+			}
+		}
+	}
+};
+
+/**
+ * Implementation of storeAnalysis method for Library
+ *
+ * Tracks are matched by the path of their file, as the same file can be in several folders.
+ *
+ */
+void Library::storeAnalysis(const juce::String& path, const TrackAnalyser::Result& result) {
+	for (auto& folder : trackFolders) {
+		for (auto& song : folder.second) {
+			if (song.url.isLocalFile() && song.url.getLocalFile().getFullPathName() == path) {
+				song.bpm = result.bpm;
+				song.firstBeat = result.firstBeat;
+				song.loudness = result.loudness;
+				song.truePeak = result.truePeak;
+			}
+		}
+	}
+	playlist.repaint();
+};
 
+//==============================================================================
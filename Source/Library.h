@@ -4,6 +4,7 @@
 #include <JuceHeader.h>
 #include "CustomLookAndFeel.h"
 #include "PlaylistComponent.h"
+#include "TrackAnalyser.h"
 
 //==============================================================================
 
@@ -53,6 +54,19 @@ public:
 	*/
 	void deleteItem();
 
+	/**
+		* Pauses the background analysis while set, for example while the audio callback is busy
+		*
+		* @param True to pause
+	*/
+	void setAnalysisThrottled(bool shouldThrottle);
+
+	/**
+		* Queues every track that has not been analysed yet. Called once the formats have been
+		* registered with the juce::AudioFormatManager, as the analyser opens files through it.
+	*/
+	void startAnalysis();
+
 	//==============================================================================
 
 private:
@@ -130,6 +144,21 @@ private:
 
 	//==============================================================================
 
+	/**
+		* Queues every local track that has not been analysed with the analyser
+	*/
+	void analyseNewTracks();
+
+	/**
+		* Stores the analysis of a file in every track playing it and repaints the playlist
+		*
+		* @param Full path of the analysed file
+		* @param Tempo, beatgrid and loudness of the file
+	*/
+	void storeAnalysis(const juce::String& path, const TrackAnalyser::Result& result);
+
+	//==============================================================================
+
 
 	/// Instance of CustomLookAndFeel class. 
 	CustomLookAndFeel customLookAndFeel;
@@ -143,6 +172,9 @@ private:
 	/// Reader source for the audio url
 	std::unique_ptr<juce::AudioFormatReader> audioReader;
 
+	/// Works out the tempo, beatgrid and loudness of new tracks in the background
+	TrackAnalyser analyser{ formatManager };
+
 	/// Reflects the trackFolders' elements
 	juce::TableListBox directoryComponent;
 
@@ -0,0 +1,82 @@
+
+#include "LoadMeter.h"
+#include "LoadPanel.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for LoadMeter
+ *
+ * Stores the references and shows a pointing hand, as the meter opens the panel.
+ *
+ */
+LoadMeter::LoadMeter(CallbackMonitor& _monitor, DeckEngine& _deckEngine)
+	: monitor(_monitor), deckEngine(_deckEngine)
+{
+	setMouseCursor(juce::MouseCursor::PointingHandCursor);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of update method for LoadMeter
+ *
+ * Starts a flash of about a second at the 50 ms timer rate when the xrun count grows.
+ *
+ */
+void LoadMeter::update() {
+	const juce::int64 xruns = monitor.getXRunCount();
+	if (xruns > previousXRuns) {
+		xrunFlash = 20;
+	}
+	else if (xrunFlash > 0) {
+		--xrunFlash;
+	}
+	previousXRuns = xruns;
+	repaint();
+}
+
+/**
+ * Implementation of paint method for LoadMeter
+ *
+ * Draws the load as a bar coloured the same way as the master level meter, the
+ * peak as a white line once it passes 80%, and the load and xrun count as text.
+ *
+ */
+void LoadMeter::paint(juce::Graphics& g) {
+	auto meterArea = getLocalBounds().reduced(0, 3);
+	g.setColour(xrunFlash > 0 ? juce::Colour::fromRGBA(120, 20, 20, 255) : juce::Colour::fromRGBA(50, 50, 50, 255));
+	g.fillRect(meterArea);
+
+	const float load = juce::jlimit(0.0f, 100.0f, monitor.getLoad());
+	float loadWidth = juce::jmap(load, 0.0f, 100.0f, 0.0f, (float)meterArea.getWidth());
+	float redStrength = juce::jmap(load, 0.0f, 100.0f, 0.0f, 255.0f);
+	g.setColour(juce::Colour((juce::uint8)redStrength, (juce::uint8)(255 - redStrength), (juce::uint8)0).withAlpha(0.6f));
+	g.fillRect(juce::Rectangle<float>((float)meterArea.getX(), (float)meterArea.getY(), loadWidth, (float)meterArea.getHeight()));
+
+	const float peak = monitor.getPeakLoad();
+	if (peak > 80.0f) {
+		float peakX = meterArea.getX() + juce::jmap(juce::jmin(peak, 100.0f), 0.0f, 100.0f, 0.0f, (float)meterArea.getWidth() - 2);
+		g.setColour(juce::Colours::white);
+		g.fillRect(juce::Rectangle<float>(peakX, (float)meterArea.getY(), 2.0f, (float)meterArea.getHeight()));
+	}
+
+	const juce::int64 xruns = monitor.getXRunCount();
+	g.setColour(juce::Colours::white);
+	g.setFont(11.0f);
+	g.drawText("DSP " + juce::String(juce::roundToInt(monitor.getLoad())) + "%  " + juce::String(xruns) + (xruns == 1 ? " xrun" : " xruns"),
+		meterArea.reduced(3, 0), juce::Justification::centredLeft);
+}
+
+/**
+ * Implementation of mouseUp method for LoadMeter
+ *
+ * The call out box owns the panel and deletes it when dismissed.
+ *
+ */
+void LoadMeter::mouseUp(const juce::MouseEvent& e) {
+	juce::ignoreUnused(e);
+	juce::CallOutBox::launchAsynchronously(std::make_unique<LoadPanel>(monitor, deckEngine), getScreenBounds(), nullptr);
+}
+
+//==============================================================================
@@ -0,0 +1,71 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CallbackMonitor.h"
+#include "DeckEngine.h"
+
+//==============================================================================
+
+/**
+ * Definition of a LoadMeter Component
+ *
+ * Compact meter of the DSP load measured by a CallbackMonitor, shown as a bar that
+ * turns from green to red with the load and the xrun count next to it. The meter
+ * flashes red for a while after an xrun, and marks callbacks above 80% load with a
+ * line at the peak. Clicking it opens a LoadPanel with the detailed figures.
+ *
+ */
+class LoadMeter : public juce::Component
+{
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for LoadMeter, initializes member variables.
+		*
+		* @param CallbackMonitor measuring the audio callback
+		* @param DeckEngine whose decks are broken down in the LoadPanel
+	*/
+	LoadMeter(CallbackMonitor& _monitor, DeckEngine& _deckEngine);
+
+	//==============================================================================
+
+	/**
+		* Reads the latest figures from the monitor and repaints. Called from the message thread after CallbackMonitor::update.
+	*/
+	void update();
+
+	/**
+		* Paints the LoadMeter Component.
+		*
+		* @param juce::Graphics object for the component to draw itself on
+	*/
+	void paint(juce::Graphics& g) override;
+
+	/**
+		* Opens the LoadPanel in a call out box
+		*
+		* @param juce::MouseEvent reference
+	*/
+	void mouseUp(const juce::MouseEvent& e) override;
+
+	//==============================================================================
+
+private:
+
+	/// Monitor the figures come from
+	CallbackMonitor& monitor;
+
+	/// Engine handed to the LoadPanel
+	DeckEngine& deckEngine;
+
+	/// Xrun count at the previous update
+	juce::int64 previousXRuns = 0;
+
+	/// Updates left to keep flashing for the last xrun
+	int xrunFlash = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadMeter)
+};
@@ -0,0 +1,175 @@
+
+#include "LoadPanel.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for LoadPanel
+ *
+ * Sizes the panel to fit a row per deck and starts refreshing at 10 Hz.
+ *
+ */
+LoadPanel::LoadPanel(CallbackMonitor& _monitor, DeckEngine& _deckEngine)
+	: monitor(_monitor), deckEngine(_deckEngine)
+{
+	addAndMakeVisible(resetButton);
+	resetButton.setColour(juce::TextButton::ColourIds::buttonColourId, juce::Colour::fromRGBA(25, 25, 25, 255));
+	resetButton.onClick = [this] {
+		monitor.reset();
+		repaint();
+	};
+
+	setSize(320, rowHeight * (deckEngine.getNumDecks() * 2 + 12) + 88);
+	startTimer(100);
+}
+
+/**
+ * Implementation of a destructor for LoadPanel
+ *
+ */
+LoadPanel::~LoadPanel()
+{
+	stopTimer();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of paint method for LoadPanel
+ *
+ * Deck bars show each deck's smoothed render time against the block duration. The
+ * decks render in parallel, so they can add up to more than the engine row, which is
+ * the time the whole engine took. Below them each streamed deck lists its read-ahead
+ * buffer length, how much of it is decoded and its underruns since the file was
+ * loaded. The histogram is drawn on a square root scale so the rare slow callbacks
+ * stay visible next to the common ones.
+ *
+ */
+void LoadPanel::paint(juce::Graphics& g) {
+	g.fillAll(juce::Colour::fromRGBA(25, 25, 25, 255));
+	g.setColour(juce::Colours::white);
+	g.setFont(12.0f);
+
+	auto area = getLocalBounds().reduced(8);
+	area.removeFromTop(rowHeight + 4);
+
+	const double blockDuration = monitor.getBlockDuration();
+	g.drawText(juce::String(monitor.getSampleRate(), 0) + " Hz, " + juce::String(monitor.getBlockSize()) + " samples, "
+		+ juce::String(blockDuration, 2) + " ms per block", area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+	g.drawText("Load " + juce::String(monitor.getLoad(), 1) + "%, peak " + juce::String(monitor.getPeakLoad(), 0) + "%, p50 "
+		+ juce::String(monitor.getLoadPercentile(0.5), 0) + "%, p99 " + juce::String(monitor.getLoadPercentile(0.99), 0) + "%",
+		area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+	g.drawText("Jitter p50 " + juce::String(monitor.getJitterPercentile(0.5), 1) + " ms, p99 "
+		+ juce::String(monitor.getJitterPercentile(0.99), 1) + " ms", area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+	const int deviceXRuns = monitor.getDeviceXRunCount();
+	g.drawText("Overruns " + juce::String(monitor.getOverrunCount()) + ", late callbacks " + juce::String(monitor.getLateCallbackCount())
+		+ ", device xruns " + (deviceXRuns < 0 ? juce::String("n/a") : juce::String(deviceXRuns))
+		+ ", late decks " + juce::String(deckEngine.getLateRenderCount()),
+		area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+	area.removeFromTop(8);
+	for (auto i = 0; i < deckEngine.getNumDecks(); ++i) {
+		const double renderTime = deckEngine.getDeck(i)->getRenderTime();
+		drawBarRow(g, area.removeFromTop(rowHeight), "Deck " + juce::String(i + 1), blockDuration > 0 ? (float)(renderTime / blockDuration) : 0.0f,
+			juce::String(renderTime, 2) + " ms");
+	}
+	const double callbackTime = deckEngine.getCallbackTime();
+	drawBarRow(g, area.removeFromTop(rowHeight), "Engine", blockDuration > 0 ? (float)(callbackTime / blockDuration) : 0.0f,
+		juce::String(callbackTime, 2) + " ms");
+
+	area.removeFromTop(8);
+	g.setColour(juce::Colours::white);
+	for (auto i = 0; i < deckEngine.getNumDecks(); ++i) {
+		auto* deck = deckEngine.getDeck(i);
+		const double readAheadLength = deck->getReadAheadLength();
+		juce::String readAhead;
+		if (!deck->isLoaded()) {
+			readAhead = "no track loaded";
+		}
+		else if (deck->isRamResident()) {
+			readAhead = "plays from memory";
+		}
+		else if (readAheadLength > 0) {
+			readAhead = "read-ahead " + juce::String(readAheadLength, 1) + " s, " + juce::String(juce::roundToInt(deck->getReadAheadFillLevel() * 100.0f))
+				+ "% decoded, " + juce::String(deck->getUnderrunCount()) + " underruns";
+		}
+		else {
+			readAhead = deck->isMemoryMapped() ? "memory mapped, paged in ahead" : "reads on the audio thread";
+		}
+		g.drawText("Deck " + juce::String(i + 1) + " " + readAhead, area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+	}
+
+	area.removeFromTop(8);
+	g.setColour(juce::Colours::white);
+	g.drawText("Load histogram, 0 to 200%", area.removeFromTop(rowHeight), juce::Justification::centredLeft);
+
+	auto histogramArea = area.toFloat();
+	g.setColour(juce::Colour::fromRGBA(50, 50, 50, 255));
+	g.fillRect(histogramArea);
+
+	const auto& histogram = monitor.getLoadHistogram();
+	juce::uint64 highest = 0;
+	for (auto count : histogram) {
+		highest = juce::jmax(highest, count);
+	}
+	if (highest > 0) {
+		const float binWidth = histogramArea.getWidth() / (float)CallbackMonitor::numLoadBins;
+		for (auto i = 0; i < CallbackMonitor::numLoadBins; ++i) {
+			if (histogram[(size_t)i] == 0) {
+				continue;
+			}
+			const float height = histogramArea.getHeight() * std::sqrt((float)histogram[(size_t)i] / (float)highest);
+			g.setColour(i < 80 ? juce::Colours::limegreen : (i < 100 ? juce::Colours::orange : juce::Colours::red));
+			g.fillRect(histogramArea.getX() + i * binWidth, histogramArea.getBottom() - height, juce::jmax(1.0f, binWidth), height);
+		}
+	}
+
+	const float deadlineX = histogramArea.getX() + histogramArea.getWidth() * 100.0f / (float)CallbackMonitor::numLoadBins;
+	g.setColour(juce::Colours::white);
+	g.drawVerticalLine((int)deadlineX, histogramArea.getY(), histogramArea.getBottom());
+}
+
+/**
+ * Implementation of resized method for LoadPanel
+ *
+ * The reset button sits in the top right corner.
+ *
+ */
+void LoadPanel::resized() {
+	resetButton.setBounds(getWidth() - 68, 8, 60, rowHeight + 2);
+}
+
+/**
+ * Implementation of timerCallback method for LoadPanel
+ *
+ * The monitor is updated by the MainComponent timer, so only a repaint is needed.
+ *
+ */
+void LoadPanel::timerCallback() {
+	repaint();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of drawBarRow method for LoadPanel
+ *
+ * Bars are coloured like the load meter, green to red as they fill.
+ *
+ */
+void LoadPanel::drawBarRow(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& label, float fraction, const juce::String& value) {
+	g.setColour(juce::Colours::white);
+	g.drawText(label, area.removeFromLeft(60), juce::Justification::centredLeft);
+	g.drawText(value + " " + juce::String(juce::roundToInt(fraction * 100.0f)) + "%", area.removeFromRight(100), juce::Justification::centredRight);
+
+	auto barArea = area.reduced(0, 3).toFloat();
+	g.setColour(juce::Colour::fromRGBA(50, 50, 50, 255));
+	g.fillRect(barArea);
+
+	const float clamped = juce::jlimit(0.0f, 1.0f, fraction);
+	g.setColour(juce::Colour((juce::uint8)(clamped * 255), (juce::uint8)(255 - clamped * 255), (juce::uint8)0));
+	g.fillRect(barArea.withWidth(barArea.getWidth() * clamped));
+}
+
+//==============================================================================
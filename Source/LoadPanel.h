@@ -0,0 +1,87 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CallbackMonitor.h"
+#include "DeckEngine.h"
+
+//==============================================================================
+
+/**
+ * Definition of a LoadPanel Component
+ *
+ * Detailed view of the audio callback shown by the LoadMeter. Lists the device
+ * settings, the load and jitter percentiles and the xrun counts, breaks the callback
+ * time down per deck, shows how full each deck's read-ahead buffer is with its underruns,
+ * and draws the load histogram since the last reset. Refreshes itself while open.
+ *
+ */
+class LoadPanel : public juce::Component, public juce::Timer
+{
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for LoadPanel, initializes member variables.
+		*
+		* @param CallbackMonitor measuring the audio callback
+		* @param DeckEngine whose decks are broken down
+	*/
+	LoadPanel(CallbackMonitor& _monitor, DeckEngine& _deckEngine);
+
+	/**
+		* Class Destructor for LoadPanel
+	*/
+	~LoadPanel() override;
+
+	//==============================================================================
+
+	/**
+		* Paints the LoadPanel Component.
+		*
+		* @param juce::Graphics object for the component to draw itself on
+	*/
+	void paint(juce::Graphics& g) override;
+
+	/**
+		* Set bounds of member components
+	*/
+	void resized() override;
+
+	/**
+		* Repaints with the latest figures
+	*/
+	void timerCallback() override;
+
+	//==============================================================================
+
+private:
+
+	/**
+		* Draws a label with a bar filled to a fraction and a value next to it
+		*
+		* @param juce::Graphics object to draw on
+		* @param Area of the row
+		* @param Label drawn left of the bar
+		* @param Fraction of the bar to fill, clamped to 0 to 1
+		* @param Text drawn right of the bar
+	*/
+	void drawBarRow(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& label, float fraction, const juce::String& value);
+
+	//==============================================================================
+
+	/// Monitor the figures come from
+	CallbackMonitor& monitor;
+
+	/// Engine whose decks are broken down
+	DeckEngine& deckEngine;
+
+	/// Clears the monitor's histograms and counts
+	juce::TextButton resetButton{ "Reset" };
+
+	/// Height of a row of text
+	static constexpr int rowHeight = 16;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadPanel)
+};
@@ -0,0 +1,521 @@
+
+#include "LoopAudioSource.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for LoopAudioSource
+ *
+ * Works out the crossfade and tail lengths in samples of the file. At most thirty
+ * seconds are decoded ahead after a marked loop start.
+ *
+ */
+LoopAudioSource::LoopAudioSource(juce::PositionableAudioSource* _source, juce::AudioFormatReader* loopReader, juce::TimeSliceThread& thread, double crossfadeSeconds, double tailSeconds)
+	: source(_source), reader(loopReader), backgroundThread(thread),
+	crossfadeLength(juce::jmax(1, (int)(crossfadeSeconds * loopReader->sampleRate))),
+	tailLength(juce::jmax(0, (int)(tailSeconds * loopReader->sampleRate))),
+	maxPartLength((int)(30 * loopReader->sampleRate))
+{
+	jassert(source != nullptr);
+}
+
+/**
+ * Implementation of a destructor for LoopAudioSource
+ *
+ * Detaches from the decode thread before the loop and reader are freed.
+ *
+ */
+LoopAudioSource::~LoopAudioSource()
+{
+	backgroundThread.removeTimeSliceClient(this);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setLoopStart method for LoopAudioSource
+ *
+ * Hands the start to the decode thread, which drops whatever it decoded ahead before.
+ *
+ */
+void LoopAudioSource::setLoopStart(juce::int64 start) {
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		pendingPartStart = juce::jlimit((juce::int64)0, source->getTotalLength(), start);
+	}
+	backgroundThread.moveToFrontOfQueue(this);
+}
+
+/**
+ * Implementation of setLoop method for LoopAudioSource
+ *
+ * Limits the loop to the file and queues it for decoding. The current loop, if any,
+ * keeps playing until the new one is ready.
+ *
+ */
+void LoopAudioSource::setLoop(juce::int64 start, juce::int64 end, bool roll) {
+	start = juce::jmax((juce::int64)0, start);
+	end = juce::jmin(source->getTotalLength(), end);
+	if (end - start < 2) {
+		return;
+	}
+
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		pendingStart = start;
+		pendingEnd = end;
+		pendingRoll = roll;
+		pending = true;
+		++generation;
+	}
+	loopActive = true;
+	backgroundThread.moveToFrontOfQueue(this);
+}
+
+/**
+ * Implementation of exitLoop method for LoopAudioSource
+ *
+ * Drops a loop still waiting to be decoded and stops the current one wrapping around.
+ * The audio thread then plays a loop out to its end and tail, moving the wrapped source
+ * past the tail, or crossfades a roll back to the slipped position.
+ *
+ */
+void LoopAudioSource::exitLoop() {
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		pending = false;
+		++generation;
+		enabled = false;
+		wrapPending = false;
+		exitSeek = inLoop && !slipping;
+	}
+	loopActive = false;
+}
+
+/**
+ * Implementation of isLoopActive method for LoopAudioSource
+ *
+ * Returns the loopActive data member.
+ *
+ */
+bool LoopAudioSource::isLoopActive() const {
+	return loopActive;
+}
+
+/**
+ * Implementation of isLoopReady method for LoopAudioSource
+ *
+ * Returns if a decoded loop is enabled.
+ *
+ */
+bool LoopAudioSource::isLoopReady() const {
+	const juce::SpinLock::ScopedLockType sl(loopLock);
+	return loop != nullptr && enabled;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for LoopAudioSource
+ *
+ * Prepares the wrapped source, allocates the scratch buffers a loop roll streams the
+ * wrapped source into and a jump back into a loop fades out of, and attaches to the
+ * decode thread.
+ *
+ */
+void LoopAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	source->prepareToPlay(samplesPerBlockExpected, sampleRate);
+	scratch.setSize(2, juce::jmax(4096, samplesPerBlockExpected * 2));
+	jumpScratch.setSize(2, crossfadeLength);
+	if (!isPrepared) {
+		backgroundThread.addTimeSliceClient(this);
+		isPrepared = true;
+	}
+}
+
+/**
+ * Implementation of releaseResources method for LoopAudioSource
+ *
+ * Detaches from the decode thread and releases the wrapped source.
+ *
+ */
+void LoopAudioSource::releaseResources() {
+	if (isPrepared) {
+		backgroundThread.removeTimeSliceClient(this);
+		isPrepared = false;
+	}
+	source->releaseResources();
+}
+
+/**
+ * Implementation of getNextAudioBlock method for LoopAudioSource
+ *
+ * Renders the block in chunks no longer than the scratch buffer, as the resampler and
+ * time stretcher above can ask for more than the expected block size.
+ *
+ */
+void LoopAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	const int chunkSize = juce::jmax(1, scratch.getNumSamples());
+	for (auto offset = 0; offset < bufferToFill.numSamples; offset += chunkSize) {
+		renderChunk(*bufferToFill.buffer, bufferToFill.startSample + offset, juce::jmin(chunkSize, bufferToFill.numSamples - offset));
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setNextReadPosition method for LoopAudioSource
+ *
+ * A position inside an enabled loop is played from the loop buffer. The wrapped source
+ * is left where it is, unless the loop is a roll, where it moves along with the playhead
+ * as that moves the slipped position too. Any other position leaves the loop and seeks
+ * the wrapped source; the loop stays set and is entered again when playback reaches it.
+ *
+ */
+void LoopAudioSource::setNextReadPosition(juce::int64 newPosition) {
+	bool moveSource = true;
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		wrapPending = false;
+		exitSeek = false;
+		if (loop != nullptr && enabled && newPosition >= loop->start && newPosition < loop->end) {
+			moveSource = loop->roll;
+			slipping = loop->roll;
+			inLoop = true;
+			loopPlayPos = newPosition;
+		}
+		else {
+			inLoop = false;
+			slipping = false;
+		}
+		publishedPlayPos = inLoop ? loopPlayPos : -1;
+	}
+
+	if (moveSource) {
+		source->setNextReadPosition(newPosition);
+	}
+}
+
+/**
+ * Implementation of getNextReadPosition method for LoopAudioSource
+ *
+ * Returns the position in the loop, or the position of the wrapped source.
+ *
+ */
+juce::int64 LoopAudioSource::getNextReadPosition() const {
+	const auto pos = publishedPlayPos.load();
+	return pos >= 0 ? pos : source->getNextReadPosition();
+}
+
+/**
+ * Implementation of getTotalLength method for LoopAudioSource
+ *
+ * Returns the length of the wrapped source.
+ *
+ */
+juce::int64 LoopAudioSource::getTotalLength() const {
+	return source->getTotalLength();
+}
+
+/**
+ * Implementation of isLooping method for LoopAudioSource
+ *
+ * Returns the looping state of the wrapped source.
+ *
+ */
+bool LoopAudioSource::isLooping() const {
+	return source->isLooping();
+}
+
+/**
+ * Implementation of setLooping method for LoopAudioSource
+ *
+ * Sets the looping state of the wrapped source.
+ *
+ */
+void LoopAudioSource::setLooping(bool shouldLoop) {
+	source->setLooping(shouldLoop);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of renderChunk method for LoopAudioSource
+ *
+ * Under the lock, a newly decoded loop is resolved first: a playhead already past its
+ * start jumps into it, wrapped around if it is past the end as well, and a playhead
+ * left outside it goes back to the wrapped source. A jump that wraps around crossfades
+ * out of the audio that would have followed, taken from the loop buffer if it holds it
+ * and from the wrapped source otherwise. Playback from the wrapped source that reaches
+ * the start of an enabled loop reads up to the sample before it and takes the rest of
+ * the chunk from the loop buffer, leaving the wrapped source there. Once a loop is
+ * exited it plays out to the end of its tail, the wrapped source having been moved
+ * there when the exit was seen, while a roll crossfades into the samples the wrapped
+ * source kept streaming. What the wrapped source has to read and where it has to move
+ * is carried out after the lock is released, in chunk order.
+ *
+ */
+void LoopAudioSource::renderChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) {
+	const juce::int64 sourcePosition = source->getNextReadPosition();
+	SourcePlan plan;
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		if (loop != nullptr && wrapPending) {
+			wrapPending = false;
+			const juce::int64 position = inLoop ? loopPlayPos : sourcePosition;
+			if (enabled && position >= loop->start) {
+				if (position >= loop->end) {
+					plan.jumpFade = juce::jmin(crossfadeLength, numSamples);
+					if (loop->covers(position, plan.jumpFade)) {
+						for (auto chan = 0; chan < jumpScratch.getNumChannels(); ++chan) {
+							jumpScratch.copyFrom(chan, 0, loop->buffer, juce::jmin(chan, loop->buffer.getNumChannels() - 1), loop->indexOf(position), plan.jumpFade);
+						}
+					}
+					else if (!inLoop) {
+						plan.jumpFromSource = true;
+					}
+					else {
+						plan.jumpFade = 0;
+					}
+				}
+				loopPlayPos = position < loop->end ? position : loop->start + (position - loop->start) % (loop->end - loop->start);
+				if (loop->roll && inLoop && !slipping) {
+					plan.seekPosition = position;
+				}
+				slipping = loop->roll;
+				inLoop = true;
+				exitSeek = false;
+			}
+			else if (inLoop) {
+				if (!slipping) {
+					plan.seekPosition = position;
+				}
+				inLoop = false;
+				slipping = false;
+				exitSeek = false;
+			}
+		}
+
+		if (exitSeek) {
+			exitSeek = false;
+			if (inLoop && !slipping) {
+				plan.seekPosition = loop->end + loop->tailLength;
+			}
+		}
+
+		if (!inLoop) {
+			if (loop != nullptr && enabled && sourcePosition < loop->start && sourcePosition + numSamples > loop->start) {
+				plan.before = (int)(loop->start - sourcePosition);
+				slipping = loop->roll;
+				inLoop = true;
+				loopPlayPos = loop->start;
+			}
+			else {
+				plan.before = numSamples;
+			}
+		}
+
+		if (inLoop) {
+			const int count = numSamples - plan.before;
+			const int copied = copyFromLoop(buffer, startSample + plan.before, count, enabled || slipping);
+			if (slipping) {
+				plan.slip = count;
+				if (!enabled) {
+					plan.releaseRoll = true;
+					inLoop = false;
+					slipping = false;
+				}
+			}
+			else if (copied < count) {
+				plan.after = count - copied;
+				inLoop = false;
+			}
+		}
+		publishedPlayPos = inLoop ? loopPlayPos : -1;
+	}
+
+	if (plan.jumpFromSource && plan.slip == 0) {
+		source->getNextAudioBlock(juce::AudioSourceChannelInfo(&jumpScratch, 0, plan.jumpFade));
+	}
+	if (plan.before > 0) {
+		source->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, startSample, plan.before));
+	}
+	if (plan.seekPosition >= 0) {
+		source->setNextReadPosition(plan.seekPosition);
+	}
+	if (plan.after > 0) {
+		source->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, startSample + numSamples - plan.after, plan.after));
+	}
+	if (plan.slip > 0) {
+		source->getNextAudioBlock(juce::AudioSourceChannelInfo(&scratch, 0, plan.slip));
+		if (plan.releaseRoll) {
+			const int offset = startSample + numSamples - plan.slip;
+			const int fade = juce::jmin(crossfadeLength, plan.slip);
+			for (auto chan = 0; chan < buffer.getNumChannels(); ++chan) {
+				const int scratchChan = juce::jmin(chan, scratch.getNumChannels() - 1);
+				buffer.applyGainRamp(chan, offset, fade, 1.0f, 0.0f);
+				buffer.addFromWithRamp(chan, offset, scratch.getReadPointer(scratchChan), fade, 0.0f, 1.0f);
+				buffer.copyFrom(chan, offset + fade, scratch, scratchChan, fade, plan.slip - fade);
+			}
+		}
+	}
+	if (plan.jumpFade > 0) {
+		const juce::AudioBuffer<float>& fadeOut = plan.jumpFromSource && plan.slip > 0 ? scratch : jumpScratch;
+		for (auto chan = 0; chan < buffer.getNumChannels(); ++chan) {
+			buffer.applyGainRamp(chan, startSample, plan.jumpFade, 0.0f, 1.0f);
+			buffer.addFromWithRamp(chan, startSample, fadeOut.getReadPointer(juce::jmin(chan, fadeOut.getNumChannels() - 1)), plan.jumpFade, 1.0f, 0.0f);
+		}
+	}
+}
+
+/**
+ * Implementation of copyFromLoop method for LoopAudioSource
+ *
+ * Copies the loop buffer a run at a time up to the end of the loop, or of the tail when
+ * not wrapping, duplicating a mono loop to every channel. When wrapping, the part of a run in the last fadeLength samples
+ * of the loop is faded out while the same stretch leading up to the start is faded in,
+ * so the sample after the end follows on from the one before the start. Everywhere
+ * else the copy is a plain block copy.
+ *
+ */
+int LoopAudioSource::copyFromLoop(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, bool wrap) {
+	const juce::int64 length = loop->end - loop->start;
+	const juce::int64 seamStart = loop->end - loop->fadeLength;
+	const juce::int64 stop = wrap ? loop->end : loop->end + loop->tailLength;
+	int copied = 0;
+	while (copied < numSamples) {
+		if (loopPlayPos >= stop) {
+			if (!wrap) {
+				break;
+			}
+			loopPlayPos = loop->start;
+		}
+
+		const int count = (int)juce::jmin((juce::int64)(numSamples - copied), stop - loopPlayPos);
+		const int destStart = startSample + copied;
+		for (auto chan = 0; chan < buffer.getNumChannels(); ++chan) {
+			buffer.copyFrom(chan, destStart, loop->buffer, juce::jmin(chan, loop->buffer.getNumChannels() - 1), loop->indexOf(loopPlayPos), count);
+		}
+
+		const juce::int64 fadeFrom = juce::jmax(loopPlayPos, seamStart);
+		const juce::int64 fadeTo = loopPlayPos + count;
+		if (wrap && loop->fadeLength > 0 && fadeFrom < fadeTo) {
+			const int fadeOffset = destStart + (int)(fadeFrom - loopPlayPos);
+			const int fadeSamples = (int)(fadeTo - fadeFrom);
+			const float startGain = (float)(fadeFrom - seamStart) / loop->fadeLength;
+			const float endGain = (float)(fadeTo - seamStart) / loop->fadeLength;
+			for (auto chan = 0; chan < buffer.getNumChannels(); ++chan) {
+				const int loopChan = juce::jmin(chan, loop->buffer.getNumChannels() - 1);
+				buffer.applyGainRamp(chan, fadeOffset, fadeSamples, 1.0f - startGain, 1.0f - endGain);
+				buffer.addFromWithRamp(chan, fadeOffset, loop->buffer.getReadPointer(loopChan, loop->indexOf(fadeFrom - length)), fadeSamples, startGain, endGain);
+			}
+		}
+
+		loopPlayPos += count;
+		copied += count;
+	}
+	return copied;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of useTimeSlice method for LoopAudioSource
+ *
+ * Picks up a newly marked loop start, dropping the audio decoded from the last one, and
+ * takes the queued loop if there is one. The loop is decoded outside the lock into a
+ * buffer of its own and swapped in only if it was not changed while it was decoding;
+ * the buffer it replaces is freed on this thread, after the lock is released. With no
+ * loop queued, the next part of the file after a marked loop start is decoded.
+ *
+ */
+int LoopAudioSource::useTimeSlice() {
+	std::unique_ptr<LoopBuffer> newLoop;
+	int decodeGeneration = 0;
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		if (pendingPartStart >= 0) {
+			partStart = juce::jmax((juce::int64)0, pendingPartStart - crossfadeLength);
+			partLength = 0;
+			pendingPartStart = -1;
+		}
+		if (pending) {
+			newLoop.reset(new LoopBuffer());
+			newLoop->start = pendingStart;
+			newLoop->end = pendingEnd;
+			newLoop->roll = pendingRoll;
+			decodeGeneration = generation;
+		}
+	}
+
+	if (newLoop == nullptr) {
+		return decodeNextPart() ? 1 : 100;
+	}
+
+	decodeLoop(*newLoop);
+	{
+		const juce::SpinLock::ScopedLockType sl(loopLock);
+		if (generation == decodeGeneration) {
+			std::swap(loop, newLoop);
+			pending = false;
+			enabled = true;
+			wrapPending = true;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Implementation of decodeLoop method for LoopAudioSource
+ *
+ * Adds the crossfade before the start, limited to half the loop and to the start of the
+ * file, and for a loop that is not a roll the tail after the end, limited to the end of
+ * the file. Whatever part of that range was decoded ahead from a marked loop start is
+ * copied, and only the rest is read from the file.
+ *
+ */
+void LoopAudioSource::decodeLoop(LoopBuffer& newLoop) {
+	newLoop.fadeLength = (int)juce::jmin((juce::int64)crossfadeLength, newLoop.start, (newLoop.end - newLoop.start) / 2);
+	newLoop.tailLength = newLoop.roll ? 0 : (int)juce::jlimit((juce::int64)0, (juce::int64)tailLength, reader->lengthInSamples - newLoop.end);
+	const juce::int64 from = newLoop.start - newLoop.fadeLength;
+	const int length = (int)(newLoop.end - newLoop.start) + newLoop.fadeLength + newLoop.tailLength;
+	newLoop.buffer.setSize(2, length);
+
+	int copied = 0;
+	if (partStart >= 0 && from >= partStart && from < partStart + partLength) {
+		copied = (int)juce::jmin((juce::int64)length, partStart + partLength - from);
+		for (auto chan = 0; chan < 2; ++chan) {
+			newLoop.buffer.copyFrom(chan, 0, part, chan, (int)(from - partStart), copied);
+		}
+	}
+	if (copied < length) {
+		reader->read(&newLoop.buffer, copied, length - copied, from + copied, true, true);
+	}
+}
+
+/**
+ * Implementation of decodeNextPart method for LoopAudioSource
+ *
+ * Decodes the next chunk of up to 16384 samples, growing the buffer by doubling so it
+ * is copied only a few times, and gives up if the file cannot be read there.
+ *
+ */
+bool LoopAudioSource::decodeNextPart() {
+	if (partStart < 0 || partLength >= maxPartLength || partStart + partLength >= reader->lengthInSamples) {
+		return false;
+	}
+
+	const int count = (int)juce::jmin((juce::int64)juce::jmin(16384, maxPartLength - partLength), reader->lengthInSamples - (partStart + partLength));
+	if (partLength + count > part.getNumSamples()) {
+		part.setSize(2, juce::jmin(maxPartLength, juce::jmax(partLength + count, part.getNumSamples() * 2)), true, false, true);
+	}
+	if (!reader->read(&part, partLength, count, partStart + partLength, true, true)) {
+		partStart = -1;
+		partLength = 0;
+		return false;
+	}
+	partLength += count;
+	return true;
+}
+
+//==============================================================================
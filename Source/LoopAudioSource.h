@@ -0,0 +1,337 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+
+/**
+ * Definition of a LoopAudioSource
+ *
+ * A PositionableAudioSource that loops a section of the wrapped source from memory.
+ * A loop is decoded on a background juce::TimeSliceThread with a reader of its own,
+ * together with a few milliseconds before its start and half a second after its end.
+ * Decoding starts as soon as the loop's start is marked, so a manual loop is usually
+ * ready the moment its end is set. Once decoded, playback entering the loop is served
+ * from the loop buffer and wraps around to the start at the exact sample of the end,
+ * crossfading the last few milliseconds into the audio leading up to the start so the
+ * seam does not click. A loop decoded after the playhead already passed its end jumps
+ * back with a crossfade too. The wrapped source is left where it was while the loop
+ * plays; once the loop is exited the audio after its end is served from the buffer
+ * while the wrapped source is moved past it, so a read-ahead has half a second to
+ * catch up. A loop roll instead keeps pulling the wrapped source in the
+ * background while the loop plays, so releasing the roll crossfades back to where the
+ * track would have been without a seek.
+ *
+ */
+class LoopAudioSource : public juce::PositionableAudioSource,
+	private juce::TimeSliceClient
+{
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for LoopAudioSource.
+		*
+		* @param PositionableAudioSource playing the file, not owned
+		* @param Reader of the same file used only to decode the loops, owned
+		* @param juce::TimeSliceThread that decodes the loops
+		* @param Length of the crossfade at the seam in seconds
+		* @param Length of the audio after a loop decoded with it in seconds
+	*/
+	LoopAudioSource(juce::PositionableAudioSource* source, juce::AudioFormatReader* loopReader, juce::TimeSliceThread& thread, double crossfadeSeconds = 0.005, double tailSeconds = 0.5);
+
+	/**
+		* Class destructor for LoopAudioSource, detaches from the decode thread.
+	*/
+	~LoopAudioSource() override;
+
+	//==============================================================================
+
+	/**
+		* Starts decoding the file from the start of a loop whose end is not known yet, so
+		* a loop set from there is ready sooner. Only called from the message thread.
+		*
+		* @param First sample of the loop
+	*/
+	void setLoopStart(juce::int64 start);
+
+	/**
+		* Queues a loop for decoding, replacing the current one once it is ready. Only called from the message thread.
+		*
+		* @param First sample of the loop
+		* @param Sample after the last sample of the loop
+		* @param True for a loop roll, which returns to the slipped position when it is exited
+	*/
+	void setLoop(juce::int64 start, juce::int64 end, bool roll = false);
+
+	/**
+		* Stops looping. A loop plays out to its end, a loop roll returns to the slipped position. Only called from the message thread.
+	*/
+	void exitLoop();
+
+	/**
+		* @return If a loop is set and has not been exited
+	*/
+	bool isLoopActive() const;
+
+	/**
+		* @return If the loop is decoded and wraps around
+	*/
+	bool isLoopReady() const;
+
+	//==============================================================================
+
+	/**
+		* Prepares the wrapped source, allocates the roll scratch buffer and attaches to the decode thread
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Detaches from the decode thread and releases the wrapped source
+	*/
+	void releaseResources() override;
+
+	/**
+		* Renders the block from the loop buffer while in the loop or its tail, otherwise from the wrapped source
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Plays from the loop buffer if the position lies in the loop, otherwise seeks the wrapped source
+		*
+		* @param Position in samples
+	*/
+	void setNextReadPosition(juce::int64 newPosition) override;
+
+	/**
+		* @return Next playback position in samples
+	*/
+	juce::int64 getNextReadPosition() const override;
+
+	/**
+		* @return Total length of the wrapped source in samples
+	*/
+	juce::int64 getTotalLength() const override;
+
+	/**
+		* @return If the wrapped source is looping
+	*/
+	bool isLooping() const override;
+
+	/**
+		* Sets the looping state of the wrapped source
+		*
+		* @param True to loop the wrapped source
+	*/
+	void setLooping(bool shouldLoop) override;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/// Decoded PCM of a loop and the audio around it
+	struct LoopBuffer {
+		/// Decoded samples from start - fadeLength to end + tailLength
+		juce::AudioBuffer<float> buffer;
+
+		/// First sample of the loop
+		juce::int64 start = 0;
+
+		/// Sample after the last sample of the loop
+		juce::int64 end = 0;
+
+		/// Number of samples crossfaded at the seam
+		int fadeLength = 0;
+
+		/// Number of samples after the end, played once the loop is exited
+		int tailLength = 0;
+
+		/// Flags a loop roll
+		bool roll = false;
+
+		/**
+			* @param Position in the loop or in the fade before it
+			* @return Index of the position in buffer
+		*/
+		int indexOf(juce::int64 position) const {
+			return (int)(position - (start - fadeLength));
+		}
+
+		/**
+			* @param Position in the file
+			* @param Number of samples from the position
+			* @return If the buffer holds every sample of the range
+		*/
+		bool covers(juce::int64 position, int numSamples) const {
+			return position >= start - fadeLength && position + numSamples <= end + tailLength;
+		}
+	};
+
+	/// What a chunk reads from the wrapped source, worked out under the lock and carried out after it
+	struct SourcePlan {
+		/// Samples read from the wrapped source into the start of the chunk, before the loop takes over
+		int before = 0;
+
+		/// Position the wrapped source is moved to after the samples before, -1 for none
+		juce::int64 seekPosition = -1;
+
+		/// Samples read from the wrapped source into the end of the chunk, after the loop played out
+		int after = 0;
+
+		/// Samples read from the wrapped source into the scratch buffer to keep the slipped position moving
+		int slip = 0;
+
+		/// Flags that the chunk crossfades from the loop into the slipped samples
+		bool releaseRoll = false;
+
+		/// Samples at the start of the chunk crossfaded from where playback was into a loop it jumped back into
+		int jumpFade = 0;
+
+		/// Flags that the audio crossfaded out of is read from the wrapped source rather than the loop buffer
+		bool jumpFromSource = false;
+	};
+
+	//==============================================================================
+
+	/**
+		* Renders part of a block no longer than the scratch buffer
+		*
+		* @param juce::AudioBuffer to fill
+		* @param First sample of the part
+		* @param Number of samples in the part
+	*/
+	void renderChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+
+	/**
+		* Copies from the loop buffer at loopPlayPos, wrapping around and crossfading at the seam
+		* if the loop wraps. Only called from the audio thread with the lock held.
+		*
+		* @param juce::AudioBuffer to fill
+		* @param First sample to fill
+		* @param Number of samples to fill
+		* @param True to wrap around at the end, false to play on into the tail and stop at its end
+		* @return Number of samples copied, less than asked for if the end was reached without wrapping
+	*/
+	int copyFromLoop(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, bool wrap);
+
+	/**
+		* Called by the decode thread to decode a queued loop, or the next part of the file after a marked loop start
+		*
+		* @return Number of milliseconds before the decode thread should call again
+	*/
+	int useTimeSlice() override;
+
+	/**
+		* Decodes a loop, copying what was already decoded from its start. Only called from the decode thread.
+		*
+		* @param Loop with its start, end and roll set, filled in
+	*/
+	void decodeLoop(LoopBuffer& newLoop);
+
+	/**
+		* Decodes the next part of the file after a marked loop start. Only called from the decode thread.
+		*
+		* @return False once there is nothing left to decode
+	*/
+	bool decodeNextPart();
+
+	//==============================================================================
+
+	/// Wrapped source playing the file
+	juce::PositionableAudioSource* source;
+
+	/// Reader decoding the loops
+	std::unique_ptr<juce::AudioFormatReader> reader;
+
+	/// Background thread that decodes the loops
+	juce::TimeSliceThread& backgroundThread;
+
+	/// Longest crossfade at the seam in samples
+	int crossfadeLength;
+
+	/// Longest tail after a loop in samples
+	int tailLength;
+
+	/// Most samples decoded ahead after a marked loop start
+	int maxPartLength;
+
+	/// Decoded loop, swapped by the decode thread and only read by the audio thread
+	std::unique_ptr<LoopBuffer> loop;
+
+	/// Guards the loop state, only held for state updates and block copies
+	mutable juce::SpinLock loopLock;
+
+	/// First sample of the loop waiting to be decoded
+	juce::int64 pendingStart = 0;
+
+	/// Sample after the last of the loop waiting to be decoded
+	juce::int64 pendingEnd = 0;
+
+	/// Flags a loop roll waiting to be decoded
+	bool pendingRoll = false;
+
+	/// Flags that a loop is waiting to be decoded
+	bool pending = false;
+
+	/// Marked loop start the decode thread has not picked up yet, -1 for none
+	juce::int64 pendingPartStart = -1;
+
+	/// Audio decoded from a marked loop start, only used by the decode thread
+	juce::AudioBuffer<float> part;
+
+	/// First sample of part, -1 when nothing is decoded ahead
+	juce::int64 partStart = -1;
+
+	/// Number of samples decoded into part
+	int partLength = 0;
+
+	/// Incremented whenever the loop changes, so a decode of an old loop is dropped
+	int generation = 0;
+
+	/// Flags if the loop wraps around, cleared when it is exited
+	bool enabled = false;
+
+	/// Flags if playback is served from the loop buffer
+	bool inLoop = false;
+
+	/// Flags a newly decoded loop, which the playhead jumps into if it is already past its start
+	bool wrapPending = false;
+
+	/// Flags that the wrapped source keeps streaming behind a loop roll, following the slipped position
+	bool slipping = false;
+
+	/// Flags that a loop was exited and the wrapped source has to move past its tail
+	bool exitSeek = false;
+
+	/// Next playback position while in the loop
+	juce::int64 loopPlayPos = 0;
+
+	/// Next playback position while in the loop, -1 while playing from the wrapped source
+	std::atomic<juce::int64> publishedPlayPos{ -1 };
+
+	/// Flags a loop set and not exited, for the message thread
+	std::atomic<bool> loopActive{ false };
+
+	/// Receives the wrapped source's samples during a loop roll
+	juce::AudioBuffer<float> scratch;
+
+	/// Holds the audio a jump back into a loop crossfades out of
+	juce::AudioBuffer<float> jumpScratch;
+
+	/// Flags if the source is prepared and attached to the decode thread
+	bool isPrepared = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoopAudioSource)
+};
@@ -8,6 +8,10 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "OfflineRenderer.h"
+#include "AudioBenchmark.h"
+#include "RealtimeSafetyChecker.h"
+#include <iostream>
 
 //==============================================================================
 class OtoDecksApplication : public juce::JUCEApplication
@@ -25,14 +29,96 @@ public:
 	{
 		// This method is where you should put your application's initialisation code..
 
+		const auto args = juce::StringArray::fromTokens(commandLine, true);
+		realtimeCheck = args.contains("--rt-check");
+
+		const int renderArg = args.indexOf("--render");
+		if (renderArg >= 0) {
+			const juce::String output = args[renderArg + 2].startsWith("--") ? juce::String() : args[renderArg + 2].unquoted();
+			setApplicationReturnValue(checkRealtimeSafety(renderScript(args[renderArg + 1].unquoted(), output)));
+			quit();
+			return;
+		}
+
+		const int benchmarkArg = args.indexOf("--benchmark");
+		if (benchmarkArg >= 0) {
+			juce::Array<juce::File> files;
+			for (auto i = benchmarkArg + 1; i < args.size(); ++i) {
+				if (!args[i].startsWith("--")) {
+					files.add(juce::File::getCurrentWorkingDirectory().getChildFile(args[i].unquoted()));
+				}
+			}
+			setApplicationReturnValue(AudioBenchmark(files, args.contains("--quick")).run());
+			quit();
+			return;
+		}
+
 		mainWindow.reset(new MainWindow(getApplicationName()));
 	}
 
+	/*
+		Renders a mix script without opening a window or an audio device:
+		OtoDecks --render script.json [output.wav|output.flac]
+
+		The audio path is benchmarked the same way with:
+		OtoDecks --benchmark [--quick] [audio files...]
+	*/
+	int renderScript(const juce::String& scriptPath, const juce::String& outputPath)
+	{
+		const juce::File cwd = juce::File::getCurrentWorkingDirectory();
+		OfflineRenderer renderer;
+		auto result = renderer.loadScript(cwd.getChildFile(scriptPath));
+		if (result.failed()) {
+			std::cerr << "render: " << result.getErrorMessage() << std::endl;
+			return 1;
+		}
+
+		const juce::File output = outputPath.isEmpty() ? renderer.getOutputFile() : cwd.getChildFile(outputPath);
+		OfflineRenderer::Report report;
+		result = renderer.render(output, report);
+		if (result.failed()) {
+			std::cerr << "render: " << result.getErrorMessage() << std::endl;
+			return 1;
+		}
+
+		std::cout << "rendered " << report.renderedSeconds << " s to " << output.getFullPathName()
+			<< " in " << report.totalWallSeconds << " s (engine " << report.renderWallSeconds
+			<< " s, loading " << report.loadWallSeconds << " s), " << report.getRealtimeFactor() << "x realtime" << std::endl;
+		return 0;
+	}
+
+	/*
+		With --rt-check, fails the run if the RealtimeSafetyChecker saw the audio callback
+		allocate, free or wait on a lock, printing where it happened:
+		OtoDecks --render script.json --rt-check
+	*/
+	int checkRealtimeSafety(int exitCode)
+	{
+		if (!realtimeCheck) {
+			return exitCode;
+		}
+		if (!RealtimeSafetyChecker::isAvailable()) {
+			std::cerr << "rt-check: real-time checks are not compiled in, build with OTODECKS_RT_CHECKS=1" << std::endl;
+			return 1;
+		}
+		if (RealtimeSafetyChecker::getViolationCount() > 0) {
+			std::cerr << "rt-check: " << RealtimeSafetyChecker::getReport() << std::endl;
+			return 1;
+		}
+		std::cout << "rt-check: no real-time violations" << std::endl;
+		return exitCode;
+	}
+
 	void shutdown() override
 	{
 		// Add your application's shutdown code here..
 
+		const bool ranWindow = mainWindow != nullptr;
 		mainWindow = nullptr; // (deletes our window)
+
+		if (ranWindow && realtimeCheck) {
+			setApplicationReturnValue(checkRealtimeSafety(0));
+		}
 	}
 
 	//==============================================================================
@@ -99,6 +185,9 @@ public:
 
 private:
 	std::unique_ptr<MainWindow> mainWindow;
+
+	/// Flags if --rt-check was passed
+	bool realtimeCheck = false;
 };
 
 //==============================================================================
@@ -13,7 +13,14 @@
  */
 MainComponent::MainComponent()
 {
-	setSize(800, 600);
+	const juce::Colour themes[] = { juce::Colours::aqua, juce::Colours::hotpink, juce::Colours::limegreen, juce::Colours::orange };
+	for (auto i = 0; i < deckEngine.getNumDecks(); ++i) {
+		const juce::Colour theme = themes[i % 4];
+		zoomedDisplays.add(new ZoomedWaveform(formatManager, thumbCache, theme));
+		deckGUIs.add(new DeckGUI(deckEngine.getDeck(i), formatManager, thumbCache, zoomedDisplays.getLast(), library, theme, i % 2 == 1));
+	}
+
+	setSize(800, 600 + 300 * ((deckEngine.getNumDecks() + 1) / 2 - 1));
 
 	// Some platforms require permissions to open input channels so request that here
 	if (juce::RuntimePermissions::isRequired(juce::RuntimePermissions::recordAudio)
@@ -29,24 +36,30 @@ MainComponent::MainComponent()
 	}
 
 
-	addAndMakeVisible(deckGUI1);
-	addAndMakeVisible(deckGUI2);
+	for (auto* deckGUI : deckGUIs) {
+		addAndMakeVisible(deckGUI);
+	}
 	addAndMakeVisible(library);
-	addAndMakeVisible(zoomedDisplay1);
-	addAndMakeVisible(zoomedDisplay2);
+	for (auto* zoomedDisplay : zoomedDisplays) {
+		addAndMakeVisible(zoomedDisplay);
+	}
 	addAndMakeVisible(crossFader);
+	addAndMakeVisible(loadMeter);
 
 	crossFader.setRange(-1, 1);
 	crossFader.setValue(0);
 	crossFader.addListener(this);
 
 	formatManager.registerBasicFormats();
+	library.startAnalysis();
 
 	getLookAndFeel().setColour(juce::ResizableWindow::backgroundColourId, juce::Colour::fromRGBA(25, 25, 25, 255));
 
 	crossFader.setLookAndFeel(&customLookAndFeel);
 	library.setLookAndFeel(&customLookAndFeel);
 	library.addKeyListener(this);
+
+	startTimer(50);
 }
 
 /**
@@ -56,6 +69,7 @@ MainComponent::MainComponent()
  */
 MainComponent::~MainComponent()
 {
+	stopTimer();
 	shutdownAudio();
 }
 
@@ -64,42 +78,44 @@ MainComponent::~MainComponent()
 /**
  * Implementation of prepareToPlay method for MainComponent
  *
- * Calls prepareToPlay methods on all AudioSource data members and adds audio sources
- * in the MainComponentLevel to the MixerAudioSource
+ * Calls prepareToPlay on the DeckEngine data member, which prepares every deck,
+ * and prepares the master level meter and the callback monitor
  *
  */
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
 {
-	mixerSource.addInputSource(&player1, false);
-	mixerSource.addInputSource(&player2, false);
-
-	player1.prepareToPlay(samplesPerBlockExpected, sampleRate);
-	player2.prepareToPlay(samplesPerBlockExpected, sampleRate);
+	deckEngine.prepareToPlay(samplesPerBlockExpected, sampleRate);
+	masterMeter.prepare(sampleRate, samplesPerBlockExpected);
+	callbackMonitor.prepare(sampleRate);
 }
 
 /**
  * Implementation of getNextAudioBlock method for MainComponent
  *
- * Calls getNextAudioBlock methods on the MixerAudioSource data member.
+ * Calls getNextAudioBlock methods on the DeckEngine data member
+ * and hands the mixed block to the master level meter. The whole callback
+ * is a real-time section for the RealtimeSafetyChecker, and is timed by the
+ * callback monitor.
  *
  */
 void MainComponent::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
 {
-	mixerSource.getNextAudioBlock(bufferToFill);
+	const auto startTicks = callbackMonitor.callbackStarted();
+	const RealtimeSafetyChecker::ScopedRealtimeSection realtimeSection;
+	deckEngine.getNextAudioBlock(bufferToFill);
+	masterMeter.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+	callbackMonitor.callbackFinished(startTicks, bufferToFill.numSamples);
 }
 
 /**
  * Implementation of releaseResources method for MainComponent
  *
- * Calls releaseResources methods on all AudioSource data members.
+ * Calls releaseResources on the DeckEngine data member.
  *
  */
 void MainComponent::releaseResources()
 {
-	mixerSource.removeAllInputs();
-	mixerSource.releaseResources();
-	player1.releaseResources();
-	player2.releaseResources();
+	deckEngine.releaseResources();
 }
 
 //==============================================================================
@@ -107,7 +123,8 @@ void MainComponent::releaseResources()
 /**
  * Implementation of paint method for MainComponent
  *
- * Sets global background
+ * Sets global background and draws the master level meter: the RMS level as a bar,
+ * the peak hold as a line and the short-term loudness as text.
  */
 void MainComponent::paint(juce::Graphics& g)
 {
@@ -115,6 +132,24 @@ void MainComponent::paint(juce::Graphics& g)
 	g.setFont(20.0f);
 	g.setColour(juce::Colour::fromRGBA(25, 25, 25, 255));
 	g.fillRect(crossFader.getLocalBounds());
+
+	auto meterArea = masterMeterBounds.reduced(0, 3);
+	auto textArea = meterArea.removeFromRight(60);
+	g.setColour(juce::Colour::fromRGBA(50, 50, 50, 255));
+	g.fillRect(meterArea);
+
+	float rmsWidth = juce::jmap(juce::jlimit(-60.0f, 0.0f, masterMeter.getRMSDecibels()), -60.0f, 0.0f, 0.0f, (float)meterArea.getWidth());
+	float redStrength = juce::jmap(rmsWidth, 0.0f, (float)meterArea.getWidth(), 0.0f, 255.0f);
+	g.setColour(juce::Colour((juce::uint8)redStrength, (juce::uint8)(255 - redStrength), (juce::uint8)0));
+	g.fillRect(juce::Rectangle<float>((float)meterArea.getX(), (float)meterArea.getY(), rmsWidth, (float)meterArea.getHeight()));
+
+	float peakX = meterArea.getX() + juce::jmap(juce::jlimit(-60.0f, 0.0f, masterMeter.getPeakDecibels()), -60.0f, 0.0f, 0.0f, (float)meterArea.getWidth() - 2);
+	g.setColour(juce::Colours::white);
+	g.fillRect(juce::Rectangle<float>(peakX, (float)meterArea.getY(), 2.0f, (float)meterArea.getHeight()));
+
+	float loudness = masterMeter.getShortTermLoudness();
+	g.setFont(11.0f);
+	g.drawText(loudness > -70.0f ? juce::String(loudness, 1) + " LUFS" : "-inf LUFS", textArea, juce::Justification::centredRight);
 }
 
 /**
@@ -128,12 +163,21 @@ void MainComponent::resized()
 	DBG("MainComponent::resized");
 	double rowH = getHeight() / 8;
 
-	zoomedDisplay1.setBounds(0, 0, getWidth(), 75 + getHeight() / 32);
-	zoomedDisplay2.setBounds(0, 75 + getHeight() / 32, getWidth(), 75 + getHeight() / 32);
-	deckGUI1.setBounds(0, 150 + getHeight() / 16, getWidth() / 2, 300);
-	deckGUI2.setBounds(getWidth() / 2, 150 + getHeight() / 16, getWidth() / 2, 300);
-	crossFader.setBounds(getWidth() / 2 - 80, 412.5 + getHeight() / 16, 160, 37.5);
-	library.setBounds(0, 450 + getHeight() / 16, getWidth(), getHeight() - 450 - getHeight() / 16);
+	double zoomedHeight = (150 + getHeight() / 16) / (double)zoomedDisplays.size();
+	for (auto i = 0; i < zoomedDisplays.size(); ++i) {
+		zoomedDisplays[i]->setBounds(0, i * zoomedHeight, getWidth(), zoomedHeight);
+	}
+
+	double decksTop = 150 + getHeight() / 16;
+	for (auto i = 0; i < deckGUIs.size(); ++i) {
+		deckGUIs[i]->setBounds((i % 2) * getWidth() / 2, decksTop + (i / 2) * 300, getWidth() / 2, 300);
+	}
+
+	double mixerTop = decksTop + ((deckGUIs.size() + 1) / 2) * 300;
+	crossFader.setBounds(getWidth() / 2 - 80, mixerTop - 37.5, 160, 37.5);
+	masterMeterBounds.setBounds(getWidth() / 2 - 80, mixerTop, 160, 16);
+	loadMeter.setBounds(getWidth() / 2 + 90, mixerTop, 110, 16);
+	library.setBounds(0, mixerTop + 16, getWidth(), getHeight() - mixerTop - 16);
 
 }
 
@@ -143,25 +187,37 @@ void MainComponent::resized()
  * Implementation of sliderValueChanged method for MainComponent
  *
  * juce::Slider cross fader is compared to the triggered juce::Slider pointer.
- * If the cross fader called this function, calls a setGain method in the
- * DJAudioPlayer instances. The gain set is inversely proportional to the distance
- * of the knob from the deck.
+ * If the cross fader called this function, moves the cross fader of the DeckEngine,
+ * which fades the decks on the side the knob moves away from.
  *
  */
 void MainComponent::sliderValueChanged(juce::Slider* slider) {
 	if (slider == &crossFader) {
-		double val;
-		if (slider->getValue() > 0) {
-			val = 1 - slider->getValue();
-			player1.setGain(val, false);
-			player2.setGain(1, false);
-		}
-		else if (slider->getValue() < 0) {
-			val = 1 + slider->getValue();
-			player2.setGain(val, false);
-			player1.setGain(1, false);
-		}
+		deckEngine.setCrossfader(slider->getValue());
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of timerCallback method for MainComponent
+ *
+ * Drains the measurements of the master level meter and repaints only the meter area.
+ * Hands the xrun count of the audio device, where it reports one, to the callback
+ * monitor before draining it for the load meter. The library's background analysis
+ * pauses while callbacks peak above 70% load.
+ *
+ */
+void MainComponent::timerCallback() {
+	masterMeter.update();
+	repaint(masterMeterBounds);
+
+	if (auto* device = deviceManager.getCurrentAudioDevice()) {
+		callbackMonitor.setDeviceXRunCount(device->getXRunCount());
 	}
+	callbackMonitor.update();
+	loadMeter.update();
+	library.setAnalysisThrottled(callbackMonitor.getPeakLoad() > 70.0f);
 }
 
 //==============================================================================
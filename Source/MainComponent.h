@@ -2,8 +2,13 @@
 
 #include <JuceHeader.h>
 #include "DJAudioPlayer.h"
+#include "DeckEngine.h"
+#include "RealtimeSafetyChecker.h"
+#include "CallbackMonitor.h"
+#include "LoadMeter.h"
 #include "DeckGUI.h"
 #include "Library.h"
+#include "WaveformDiskCache.h"
 #include "CustomLookAndFeel.h"
 
 //==============================================================================
@@ -11,7 +16,7 @@
 	This component lives inside our window, and this is where you should put all
 	your controls and content.
 */
-class MainComponent : public juce::AudioAppComponent, public juce::Slider::Listener, public juce::KeyListener
+class MainComponent : public juce::AudioAppComponent, public juce::Slider::Listener, public juce::KeyListener, public juce::Timer
 {
 public:
 	//==============================================================================
@@ -80,44 +85,54 @@ public:
 
 	//==============================================================================
 
+	/**
+		* Updates the master level meter and the load meter and repaints them
+	*/
+	void timerCallback() override;
+
+	//==============================================================================
+
 private:
 	//==============================================================================
 
 	/// Instance of CustomLookAndFeel class.
 	CustomLookAndFeel customLookAndFeel;
 
+	/// Instance of AudioFormatManager class, declared before everything that reads files through it.
+	juce::AudioFormatManager formatManager;
+
 	/// Instance of Library class.
 	Library library{ formatManager };
 
-	/// Instance of AudioFormatManager class.
-	juce::AudioFormatManager formatManager;
+	/// Waveform cache kept in memory and in the user's application data folder on disk, shared by every waveform.
+	WaveformDiskCache thumbCache{ juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory).getChildFile("OtoDecks/Waveforms") };
 
-	/// Instance of AudioThumbnailCache class.
-	juce::AudioThumbnailCache thumbCache{ 100 };
+	/// Number of DJ Decks, laid out in rows of two
+	static constexpr int numDecks = 4;
 
-	/// Instance of DJAudioPlayer class for the left DJ Deck.
-	DJAudioPlayer player1{ formatManager };
+	/// Instance of DeckEngine class owning and mixing the DJAudioPlayer of every DJ Deck.
+	DeckEngine deckEngine{ formatManager, numDecks };
 
-	/// Instance of DJAudioPlayer class for the right DJ Deck.
-	DJAudioPlayer player2{ formatManager };
+	/// ZoomedWaveform of every DJ Deck's audio track.
+	juce::OwnedArray<ZoomedWaveform> zoomedDisplays;
 
-	/// Instance of MixerAudioSource class for managing both DJAudioPlayer instances.
-	juce::MixerAudioSource mixerSource;
+	/// DeckGUI of every DJ Deck, left decks at even indices.
+	juce::OwnedArray<DeckGUI> deckGUIs;
 
-	/// Instance of ZoomedWaveform class for the left DJ Deck's audio track.
-	ZoomedWaveform zoomedDisplay1{ formatManager, thumbCache, juce::Colours::aqua };
+	/// Instance of juce::Slider for cross fading functionality.
+	juce::Slider crossFader{ juce::Slider::SliderStyle::LinearHorizontal , juce::Slider::TextEntryBoxPosition::NoTextBox };
 
-	/// Instance of ZoomedWaveform class for the right DJ Deck's audio track.
-	ZoomedWaveform zoomedDisplay2{ formatManager, thumbCache,juce::Colours::hotpink };
+	/// Instance of LevelMeter measuring the master output.
+	LevelMeter masterMeter;
 
-	/// Instance of DeckGUI class for the left DJ Deck.
-	DeckGUI deckGUI1{ &player1, formatManager, thumbCache,&zoomedDisplay1 , library,juce::Colours::aqua };
+	/// Area below the cross fader the master level meter is drawn in.
+	juce::Rectangle<int> masterMeterBounds;
 
-	/// Instance of DeckGUI class for the right DJ Deck.
-	DeckGUI deckGUI2{ &player2, formatManager, thumbCache,&zoomedDisplay2 , library,juce::Colours::hotpink };
+	/// Instance of CallbackMonitor timing the audio callback.
+	CallbackMonitor callbackMonitor;
 
-	/// Instance of juce::Slider for cross fading functionality.
-	juce::Slider crossFader{ juce::Slider::SliderStyle::LinearHorizontal , juce::Slider::TextEntryBoxPosition::NoTextBox };
+	/// Instance of LoadMeter showing the DSP load next to the master level meter.
+	LoadMeter loadMeter{ callbackMonitor, deckEngine };
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
 };
@@ -0,0 +1,254 @@
+
+#include "MappedAudioSource.h"
+
+#if ! JUCE_WINDOWS
+#include <unistd.h>
+#endif
+
+//==============================================================================
+
+namespace {
+	/**
+	 * @return Size of a virtual memory page in bytes
+	 */
+	juce::int64 getPageSize() {
+#if JUCE_WINDOWS
+		return 4096;
+#else
+		return (juce::int64)sysconf(_SC_PAGESIZE);
+#endif
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of createFor method for MappedAudioSource
+ *
+ * Finds the format from the file extension and asks it for a memory mapped reader,
+ * which only the WAV and AIFF formats provide for uncompressed data. The whole file
+ * is mapped up front so no remapping is needed while playing.
+ *
+ */
+std::unique_ptr<MappedAudioSource> MappedAudioSource::createFor(const juce::URL& audioURL, juce::AudioFormatManager& formatManager, juce::TimeSliceThread& thread, double prefetchSeconds) {
+	if (!audioURL.isLocalFile()) {
+		return nullptr;
+	}
+
+	const juce::File file = audioURL.getLocalFile();
+	auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+	if (format == nullptr) {
+		return nullptr;
+	}
+
+	std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(file));
+	if (reader == nullptr || !reader->mapEntireFile() || reader->getMappedSection().isEmpty()) {
+		return nullptr;
+	}
+
+	return std::unique_ptr<MappedAudioSource>(new MappedAudioSource(reader.release(), thread, prefetchSeconds));
+}
+
+/**
+ * Implementation of a constructor for MappedAudioSource
+ *
+ * Hands the reader to the reader source and works out how many samples fit in a page
+ * from the size of an uncompressed frame.
+ *
+ */
+MappedAudioSource::MappedAudioSource(juce::MemoryMappedAudioFormatReader* _reader, juce::TimeSliceThread& thread, double prefetchSeconds)
+	: reader(_reader), readerSource(_reader, true), backgroundThread(thread),
+	samplesToPrefetch(juce::jmax((juce::int64)4096, (juce::int64)(juce::jmax(0.5, prefetchSeconds) * _reader->sampleRate)))
+{
+	const int bytesPerFrame = (int)reader->numChannels * reader->bitsPerSample / 8;
+	samplesPerPage = juce::jmax((juce::int64)1, getPageSize() / juce::jmax(1, bytesPerFrame));
+}
+
+/**
+ * Implementation of a destructor for MappedAudioSource
+ *
+ * Detaches from the prefetch thread before the reader is freed.
+ *
+ */
+MappedAudioSource::~MappedAudioSource()
+{
+	backgroundThread.removeTimeSliceClient(this);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for MappedAudioSource
+ *
+ * Prepares the reader source, prefetches the start of the file, which marks any
+ * seek made so far as ready, and attaches to the prefetch thread.
+ *
+ */
+void MappedAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	readerSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+	const int generation = seekGeneration.load(std::memory_order_acquire);
+	prefetch(getNextReadPosition(), (juce::int64)samplesPerBlockExpected * 4);
+	readyGeneration = generation;
+	backgroundThread.addTimeSliceClient(this);
+}
+
+/**
+ * Implementation of releaseResources method for MappedAudioSource
+ *
+ * Detaches from the prefetch thread and releases the reader source.
+ *
+ */
+void MappedAudioSource::releaseResources() {
+	backgroundThread.removeTimeSliceClient(this);
+	readerSource.releaseResources();
+}
+
+/**
+ * Implementation of getNextAudioBlock method for MappedAudioSource
+ *
+ * Moves the reader source to a new seek first, which only sets its position. Until the
+ * prefetch thread has touched the first pages of that seek the block is silent and the
+ * position is held, otherwise it is read through the reader source, straight out of the
+ * mapping. The position of the reader source is published after either, so no other
+ * thread reads the reader source itself.
+ *
+ */
+void MappedAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	const int generation = seekGeneration.load(std::memory_order_acquire);
+	if (generation != appliedGeneration.load(std::memory_order_relaxed)) {
+		readerSource.setNextReadPosition(seekTarget.load());
+		playPosition.store(readerSource.getNextReadPosition(), std::memory_order_relaxed);
+		appliedGeneration.store(generation, std::memory_order_release);
+	}
+	if (readyGeneration.load(std::memory_order_acquire) != generation) {
+		bufferToFill.clearActiveBufferRegion();
+		return;
+	}
+	readerSource.getNextAudioBlock(bufferToFill);
+	playPosition.store(readerSource.getNextReadPosition(), std::memory_order_relaxed);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setNextReadPosition method for MappedAudioSource
+ *
+ * Stores the position, then takes a new seek generation for the audio thread to move the
+ * reader source on and the prefetch thread to touch its first pages. Neither is woken, as
+ * that would take the lock of the prefetch thread's queue; they notice the new generation
+ * on their next block and time slice.
+ *
+ */
+void MappedAudioSource::setNextReadPosition(juce::int64 newPosition) {
+	seekTarget.store(newPosition);
+	seekGeneration.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * Implementation of getNextReadPosition method for MappedAudioSource
+ *
+ * Returns the position of a seek the audio thread has not applied yet,
+ * otherwise the position it published.
+ *
+ */
+juce::int64 MappedAudioSource::getNextReadPosition() const {
+	if (seekGeneration.load(std::memory_order_acquire) != appliedGeneration.load(std::memory_order_acquire)) {
+		return seekTarget.load();
+	}
+	return playPosition.load(std::memory_order_relaxed);
+}
+
+/**
+ * Implementation of getTotalLength method for MappedAudioSource
+ *
+ * Returns the length of the reader source.
+ *
+ */
+juce::int64 MappedAudioSource::getTotalLength() const {
+	return readerSource.getTotalLength();
+}
+
+/**
+ * Implementation of isLooping method for MappedAudioSource
+ *
+ * Returns the looping state of the reader source.
+ *
+ */
+bool MappedAudioSource::isLooping() const {
+	return readerSource.isLooping();
+}
+
+/**
+ * Implementation of setLooping method for MappedAudioSource
+ *
+ * Sets the looping state of the reader source.
+ *
+ */
+void MappedAudioSource::setLooping(bool shouldLoop) {
+	readerSource.setLooping(shouldLoop);
+}
+
+/**
+ * Implementation of getSampleRate method for MappedAudioSource
+ *
+ * Returns the sample rate of the mapped reader.
+ *
+ */
+double MappedAudioSource::getSampleRate() const {
+	return reader->sampleRate;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of useTimeSlice method for MappedAudioSource
+ *
+ * A new seek has the first 50 ms at its position touched and is then marked ready for
+ * the audio thread. Pages up to the prefetch distance ahead of the position the audio
+ * thread published are then touched a second at a time.
+ *
+ */
+int MappedAudioSource::useTimeSlice() {
+	const int generation = seekGeneration.load(std::memory_order_acquire);
+	if (generation != readyGeneration.load(std::memory_order_relaxed)) {
+		const auto target = seekTarget.load();
+		const auto numSamples = (juce::int64)(reader->sampleRate / 20);
+		prefetch(target, numSamples);
+		readyGeneration.store(generation, std::memory_order_release);
+		prefetchedEnd = target + numSamples;
+		return 1;
+	}
+
+	const auto position = playPosition.load(std::memory_order_relaxed);
+	if (prefetchedEnd < position || prefetchedEnd > position + samplesToPrefetch) {
+		prefetchedEnd = position;
+	}
+
+	const auto target = juce::jmin(getTotalLength(), position + samplesToPrefetch);
+	if (prefetchedEnd >= target) {
+		return idleInterval;
+	}
+
+	const auto numSamples = juce::jmin(target - prefetchedEnd, (juce::int64)reader->sampleRate);
+	prefetch(prefetchedEnd, numSamples);
+	prefetchedEnd += numSamples;
+	return 1;
+}
+
+/**
+ * Implementation of prefetch method for MappedAudioSource
+ *
+ * Limits the range to the mapped section and touches one sample per page through the
+ * reader, which faults the page in on this thread rather than the audio thread.
+ *
+ */
+void MappedAudioSource::prefetch(juce::int64 startSample, juce::int64 numSamples) {
+	const auto mapped = reader->getMappedSection();
+	const auto start = juce::jlimit(mapped.getStart(), mapped.getEnd(), startSample);
+	const auto end = juce::jlimit(start, mapped.getEnd(), startSample + numSamples);
+	for (auto sample = start; sample < end; sample += samplesPerPage) {
+		reader->touchSample(sample);
+	}
+}
+
+//==============================================================================
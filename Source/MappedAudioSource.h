@@ -0,0 +1,174 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+
+/**
+ * Definition of a MappedAudioSource
+ *
+ * A PositionableAudioSource that plays an uncompressed WAV or AIFF file through a
+ * juce::MemoryMappedAudioFormatReader mapped over the whole file, so reads on the audio
+ * thread are served straight from the page cache. A background juce::TimeSliceThread
+ * keeps the pages ahead of the playhead resident by touching a sample in each through
+ * the reader, following the playhead through a position the audio thread publishes.
+ * A seek only stores the new position, so it can be made from the audio thread, and
+ * playback waits in silence at the new position until the prefetch thread has touched
+ * its first pages, so the audio thread never faults them in itself.
+ *
+ */
+class MappedAudioSource : public juce::PositionableAudioSource,
+	private juce::TimeSliceClient
+{
+public:
+
+	//==============================================================================
+
+	/**
+		* Creates a memory mapped source if the file supports it
+		*
+		* @param juce::URL of the audio file, only local files are mapped
+		* @param juce::AudioFormatManager used to find the audio format
+		* @param juce::TimeSliceThread that prefetches pages ahead of the playhead
+		* @param Number of seconds to keep resident ahead of the playhead
+		* @return Mapped source, or nullptr if the file is not a mappable WAV or AIFF file
+	*/
+	static std::unique_ptr<MappedAudioSource> createFor(const juce::URL& audioURL, juce::AudioFormatManager& formatManager, juce::TimeSliceThread& thread, double prefetchSeconds);
+
+	/**
+		* Class destructor for MappedAudioSource, detaches from the prefetch thread.
+	*/
+	~MappedAudioSource() override;
+
+	//==============================================================================
+
+	/**
+		* Prepares the reader source and attaches to the prefetch thread
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Detaches from the prefetch thread and releases the reader source
+	*/
+	void releaseResources() override;
+
+	/**
+		* Reads the next block from the mapped file
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Sets the next playback position for the prefetch thread and the audio thread to pick up, without blocking
+		*
+		* @param Position in samples
+	*/
+	void setNextReadPosition(juce::int64 newPosition) override;
+
+	/**
+		* @return Next playback position in samples
+	*/
+	juce::int64 getNextReadPosition() const override;
+
+	/**
+		* @return Length of the file in samples
+	*/
+	juce::int64 getTotalLength() const override;
+
+	/**
+		* @return If the file is looping
+	*/
+	bool isLooping() const override;
+
+	/**
+		* Sets the looping state of the file
+		*
+		* @param True to loop the file
+	*/
+	void setLooping(bool shouldLoop) override;
+
+	//==============================================================================
+
+	/**
+		* @return Number of samples per second of the file
+	*/
+	double getSampleRate() const;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for MappedAudioSource, only used by createFor.
+		*
+		* @param Reader mapped over the whole file, owned by this source
+		* @param juce::TimeSliceThread that prefetches pages ahead of the playhead
+		* @param Number of seconds to keep resident ahead of the playhead
+	*/
+	MappedAudioSource(juce::MemoryMappedAudioFormatReader* reader, juce::TimeSliceThread& thread, double prefetchSeconds);
+
+	/**
+		* Called by the prefetch thread to touch pages ahead of the playhead
+		*
+		* @return Number of milliseconds before the prefetch thread should call again
+	*/
+	int useTimeSlice() override;
+
+	/**
+		* Touches a sample in every page of a range, within the mapped section, so the pages are resident
+		*
+		* @param First sample of the range
+		* @param Number of samples in the range
+	*/
+	void prefetch(juce::int64 startSample, juce::int64 numSamples);
+
+	//==============================================================================
+
+	/// Reader mapped over the whole file, owned by readerSource
+	juce::MemoryMappedAudioFormatReader* reader;
+
+	/// Reader source reading blocks from the mapped reader
+	juce::AudioFormatReaderSource readerSource;
+
+	/// Background thread that prefetches pages
+	juce::TimeSliceThread& backgroundThread;
+
+	/// Number of samples kept resident ahead of the playhead
+	juce::int64 samplesToPrefetch;
+
+	/// Number of samples in a memory page
+	juce::int64 samplesPerPage = 1;
+
+	/// Position of the last seek
+	std::atomic<juce::int64> seekTarget{ 0 };
+
+	/// Incremented by every seek, after seekTarget is stored
+	std::atomic<int> seekGeneration{ 0 };
+
+	/// Last seek the audio thread moved the reader source to
+	std::atomic<int> appliedGeneration{ 0 };
+
+	/// Last seek whose first pages the prefetch thread has touched
+	std::atomic<int> readyGeneration{ 0 };
+
+	/// Position of the reader source, published by the audio thread after every block and seek it applies
+	std::atomic<juce::int64> playPosition{ 0 };
+
+	/// Milliseconds the prefetch thread sleeps when there is nothing to prefetch, which bounds how long a seek waits to be noticed
+	static constexpr int idleInterval = 2;
+
+	/// End of the range already prefetched by the prefetch thread
+	juce::int64 prefetchedEnd = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedAudioSource)
+};
@@ -0,0 +1,324 @@
+
+#include "OfflineRenderer.h"
+
+//==============================================================================
+
+/**
+ * Implementation of getRealtimeFactor method for OfflineRenderer::Report
+ *
+ * Divides the rendered seconds by the wall seconds spent rendering
+ *
+ */
+double OfflineRenderer::Report::getRealtimeFactor() const {
+	return renderWallSeconds > 0 ? renderedSeconds / renderWallSeconds : 0.0;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for OfflineRenderer
+ *
+ * Registers the basic formats, which include WAV and FLAC for the output.
+ *
+ */
+OfflineRenderer::OfflineRenderer()
+{
+	formatManager.registerBasicFormats();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of loadScript method for OfflineRenderer
+ *
+ * Reads the settings, then turns every event into an Event at its sample, failing on
+ * unknown actions and decks. Events are sorted stably so events at the same time keep
+ * the order of the script. The decks are created here, set to decode tracks into memory
+ * before playing and to read without a read-ahead thread when they cannot, so a render
+ * that runs faster than real time never waits on background reading.
+ *
+ */
+juce::Result OfflineRenderer::loadScript(const juce::File& scriptFile) {
+	const juce::var script = juce::JSON::parse(scriptFile);
+	if (!script.isObject()) {
+		return juce::Result::fail("could not parse " + scriptFile.getFullPathName());
+	}
+
+	scriptFolder = scriptFile.getParentDirectory();
+	sampleRate = script.getProperty("sampleRate", 44100);
+	blockSize = script.getProperty("blockSize", 512);
+	bitDepth = script.getProperty("bitDepth", 24);
+	const int numDecks = script.getProperty("decks", 2);
+	const double length = script.getProperty("length", 0.0);
+	outputFile = scriptFolder.getChildFile(script.getProperty("output", "mix.wav").toString());
+
+	if (sampleRate <= 0 || blockSize <= 0 || numDecks <= 0) {
+		return juce::Result::fail("sampleRate, blockSize and decks must be positive");
+	}
+	if (length <= 0) {
+		return juce::Result::fail("length must be set to the number of seconds to render");
+	}
+	lengthInSamples = (juce::int64)(length * sampleRate);
+
+	events.clear();
+	if (auto* list = script.getProperty("events", juce::var()).getArray()) {
+		for (const auto& item : *list) {
+			Event event;
+			event.sample = (juce::int64)((double)item.getProperty("time", 0.0) * sampleRate);
+			event.deck = item.getProperty("deck", 0);
+			event.action = item.getProperty("action", "").toString();
+			event.value = item.getProperty("value", juce::var());
+			event.index = item.getProperty("index", 0);
+			event.duration = (juce::int64)((double)item.getProperty("duration", 0.0) * sampleRate);
+
+			if (!juce::StringArray({ "load", "play", "stop", "position", "setCue", "cue", "keylock", "quality", "side" }).contains(event.action)
+				&& !isNumericAction(event.action)) {
+				return juce::Result::fail("unknown action \"" + event.action + "\"");
+			}
+			if (!juce::isPositiveAndBelow(event.deck, numDecks)) {
+				return juce::Result::fail("deck " + juce::String(event.deck) + " does not exist");
+			}
+			events.push_back(event);
+		}
+	}
+	std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.sample < b.sample; });
+
+	deckEngine.reset(new DeckEngine(formatManager, numDecks));
+	values.assign((size_t)numDecks, {});
+	cuePositions.assign((size_t)numDecks, {});
+	crossfaderPosition = 0;
+	for (auto i = 0; i < numDecks; ++i) {
+		auto* deck = deckEngine->getDeck(i);
+		deck->setLoadMode(DJAudioPlayer::ramResident);
+		deck->setReadAheadTime(0);
+		applyValue(i, "gain", 1);
+		applyValue(i, "speed", 1);
+		applyValue(i, "filter", 0);
+		applyValue(i, "low", 1);
+		applyValue(i, "mid", 1);
+		applyValue(i, "high", 1);
+	}
+	return juce::Result::ok();
+}
+
+/**
+ * Implementation of getOutputFile method for OfflineRenderer
+ *
+ * Returns the outputFile data member
+ *
+ */
+juce::File OfflineRenderer::getOutputFile() const {
+	return outputFile;
+}
+
+/**
+ * Implementation of render method for OfflineRenderer
+ *
+ * Prepares the engine with the block size of the script and works through the render
+ * a block at a time. Events due at the current sample are applied first, and a block
+ * stops short at the next event so every event lands on its sample. Transport events
+ * inside the block are queued on the deck for their sample instead, so they do not
+ * split the block, as long as no other event comes before them. Ramps are advanced
+ * once per block, as the decks apply parameters once per block anyway. Only the time
+ * spent in the engine counts towards the realtime factor, and only the engine runs in
+ * a real-time section, as it would in the audio callback.
+ *
+ */
+juce::Result OfflineRenderer::render(const juce::File& file, Report& report) {
+	if (deckEngine == nullptr) {
+		return juce::Result::fail("no script loaded");
+	}
+	report = Report();
+	const auto startTicks = juce::Time::getHighResolutionTicks();
+
+	auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+	if (format == nullptr) {
+		return juce::Result::fail("no audio format for " + file.getFileName());
+	}
+	file.deleteFile();
+	std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+	if (stream == nullptr) {
+		return juce::Result::fail("could not open " + file.getFullPathName());
+	}
+	std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, 2, bitDepth, {}, 0));
+	if (writer == nullptr) {
+		return juce::Result::fail(format->getFormatName() + " cannot write " + juce::String(bitDepth) + " bit audio at " + juce::String(sampleRate) + " Hz");
+	}
+	stream.release();
+
+	juce::AudioBuffer<float> buffer(2, blockSize);
+	deckEngine->prepareToPlay(blockSize, sampleRate);
+	ramps.clear();
+
+	auto result = juce::Result::ok();
+	size_t nextEvent = 0;
+	juce::int64 position = 0;
+	while (position < lengthInSamples && result.wasOk()) {
+		while (nextEvent < events.size() && events[nextEvent].sample <= position && result.wasOk()) {
+			result = applyEvent(events[nextEvent++], report);
+		}
+
+		for (auto ramp = ramps.begin(); ramp != ramps.end();) {
+			const double progress = juce::jlimit(0.0, 1.0, (double)(position - ramp->start) / (double)(ramp->end - ramp->start));
+			applyValue(ramp->deck, ramp->action, ramp->from + (ramp->to - ramp->from) * progress);
+			ramp = progress >= 1.0 ? ramps.erase(ramp) : ramp + 1;
+		}
+
+		juce::int64 blockEnd = juce::jmin(position + blockSize, lengthInSamples);
+		while (nextEvent < events.size() && events[nextEvent].sample < blockEnd && isTransportAction(events[nextEvent].action) && result.wasOk()) {
+			result = applyEvent(events[nextEvent++], report);
+		}
+		if (nextEvent < events.size()) {
+			blockEnd = juce::jmin(blockEnd, events[nextEvent].sample);
+		}
+		const int numSamples = (int)(blockEnd - position);
+
+		const auto blockTicks = juce::Time::getHighResolutionTicks();
+		juce::AudioSourceChannelInfo info(&buffer, 0, numSamples);
+		{
+			const RealtimeSafetyChecker::ScopedRealtimeSection realtimeSection;
+			deckEngine->getNextAudioBlock(info);
+		}
+		report.renderWallSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockTicks);
+
+		if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples)) {
+			result = juce::Result::fail("could not write " + file.getFullPathName());
+		}
+		position = blockEnd;
+	}
+
+	deckEngine->releaseResources();
+	writer.reset();
+	report.renderedSeconds = position / sampleRate;
+	report.totalWallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+	return result;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of applyEvent method for OfflineRenderer
+ *
+ * Loads are timed separately so decoding does not count towards the realtime factor.
+ * Transport actions are queued on the deck for the sample of the event, which the
+ * deck clock matches as every deck renders every block from the start of the render.
+ * Numeric actions with a duration become ramps starting from the current value.
+ *
+ */
+juce::Result OfflineRenderer::applyEvent(const Event& event, Report& report) {
+	auto* deck = deckEngine->getDeck(event.deck);
+
+	if (event.action == "load") {
+		const juce::File track = scriptFolder.getChildFile(event.value.toString());
+		const auto loadTicks = juce::Time::getHighResolutionTicks();
+		deck->loadURL(juce::URL{ track });
+		report.loadWallSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - loadTicks);
+		cuePositions[(size_t)event.deck].clear();
+		if (!deck->isLoaded()) {
+			return juce::Result::fail("could not load " + track.getFullPathName());
+		}
+	}
+	else if (event.action == "play") {
+		deck->start(event.sample);
+	}
+	else if (event.action == "stop") {
+		deck->stop(event.sample);
+	}
+	else if (event.action == "position") {
+		deck->setPosition(event.value, event.sample);
+	}
+	else if (event.action == "setCue") {
+		cuePositions[(size_t)event.deck][event.index] = event.value;
+		deck->setCuePoint(event.index, event.value);
+	}
+	else if (event.action == "cue") {
+		auto& cues = cuePositions[(size_t)event.deck];
+		if (cues.find(event.index) == cues.end()) {
+			return juce::Result::fail("cue " + juce::String(event.index) + " of deck " + juce::String(event.deck) + " is not set");
+		}
+		deck->setPositionRelative(cues[event.index], event.sample);
+	}
+	else if (event.action == "keylock") {
+		deck->setKeylock(event.value);
+	}
+	else if (event.action == "quality") {
+		const juce::String name = event.value.toString();
+		deck->setResamplerQuality(name == "draft" ? PolyphaseResamplingAudioSource::draft
+			: (name == "mastering" ? PolyphaseResamplingAudioSource::mastering : PolyphaseResamplingAudioSource::normal));
+	}
+	else if (event.action == "side") {
+		const juce::String name = event.value.toString();
+		deckEngine->setCrossfaderSide(event.deck, name == "left" ? DeckEngine::left : (name == "right" ? DeckEngine::right : DeckEngine::thru));
+	}
+	else if (event.duration > 0) {
+		Ramp ramp;
+		ramp.deck = event.deck;
+		ramp.action = event.action;
+		ramp.from = event.action == "crossfader" ? crossfaderPosition : values[(size_t)event.deck][event.action];
+		ramp.to = event.value;
+		ramp.start = event.sample;
+		ramp.end = event.sample + event.duration;
+		ramps.push_back(ramp);
+	}
+	else {
+		applyValue(event.deck, event.action, event.value);
+	}
+	return juce::Result::ok();
+}
+
+/**
+ * Implementation of applyValue method for OfflineRenderer
+ *
+ * Stores the value and hands it to the setter the deck GUI uses for the same control.
+ *
+ */
+void OfflineRenderer::applyValue(int deckIndex, const juce::String& action, double value) {
+	if (action == "crossfader") {
+		crossfaderPosition = value;
+		deckEngine->setCrossfader(value);
+		return;
+	}
+
+	values[(size_t)deckIndex][action] = value;
+	auto* deck = deckEngine->getDeck(deckIndex);
+	if (action == "gain") {
+		deck->setGain(value);
+	}
+	else if (action == "speed") {
+		deck->setSpeed(value);
+	}
+	else if (action == "filter") {
+		deck->setFilter(value);
+	}
+	else if (action == "low") {
+		deck->setLBFilter(value);
+	}
+	else if (action == "mid") {
+		deck->setMBFilter(value);
+	}
+	else if (action == "high") {
+		deck->setHBFilter(value);
+	}
+}
+
+/**
+ * Implementation of isNumericAction method for OfflineRenderer
+ *
+ * Returns true for the actions handled by applyValue
+ *
+ */
+bool OfflineRenderer::isNumericAction(const juce::String& action) {
+	return juce::StringArray({ "gain", "speed", "filter", "low", "mid", "high", "crossfader" }).contains(action);
+}
+
+/**
+ * Implementation of isTransportAction method for OfflineRenderer
+ *
+ * Returns true for the actions queued on the deck as transport commands
+ *
+ */
+bool OfflineRenderer::isTransportAction(const juce::String& action) {
+	return juce::StringArray({ "play", "stop", "position", "cue" }).contains(action);
+}
+
+//==============================================================================
@@ -0,0 +1,208 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+#include "DeckEngine.h"
+#include "RealtimeSafetyChecker.h"
+
+//==============================================================================
+
+/**
+ * Definition of an OfflineRenderer
+ *
+ * Renders a scripted mix to a WAV or FLAC file without an audio device. The script is
+ * a JSON object naming the sample rate, block size, number of decks, length in seconds,
+ * output file and a list of timed events:
+ *
+ *	{ "sampleRate": 44100, "blockSize": 512, "decks": 2, "length": 90, "output": "mix.wav",
+ *	  "events": [ { "time": 0, "deck": 0, "action": "load", "value": "a.mp3" },
+ *	              { "time": 0, "deck": 0, "action": "play" },
+ *	              { "time": 30, "action": "crossfader", "value": 1, "duration": 8 } ] }
+ *
+ * Actions are load, play, stop, position (seconds), setCue and cue (with an index),
+ * gain, speed, keylock, quality, filter, low, mid, high, side and crossfader. Numeric
+ * actions with a duration ramp from the current value. The decks are driven through a
+ * DeckEngine exactly as MainComponent drives them, as fast as the CPU allows, so the
+ * report doubles as a throughput benchmark.
+ *
+ */
+class OfflineRenderer {
+public:
+
+	/// Timing of a finished render
+	struct Report {
+		/// Seconds of audio rendered
+		double renderedSeconds = 0;
+
+		/// Wall seconds spent in the DeckEngine
+		double renderWallSeconds = 0;
+
+		/// Wall seconds spent loading tracks
+		double loadWallSeconds = 0;
+
+		/// Wall seconds of the whole render, including loading and writing
+		double totalWallSeconds = 0;
+
+		/**
+			* @return Seconds of audio rendered per wall second spent in the DeckEngine
+		*/
+		double getRealtimeFactor() const;
+	};
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for OfflineRenderer, registers the basic audio formats.
+	*/
+	OfflineRenderer();
+
+	//==============================================================================
+
+	/**
+		* Parses a script and creates the decks it asks for. Relative paths in the script are
+		* resolved against the folder of the script.
+		*
+		* @param JSON script file
+		* @return juce::Result describing the first problem found in the script
+	*/
+	juce::Result loadScript(const juce::File& scriptFile);
+
+	/**
+		* @return Output file named by the loaded script
+	*/
+	juce::File getOutputFile() const;
+
+	/**
+		* Renders the loaded script.
+		*
+		* @param File to write, its extension picks the format
+		* @param Report filled in with the timing of the render
+		* @return juce::Result describing why the render failed
+	*/
+	juce::Result render(const juce::File& outputFile, Report& report);
+
+	//==============================================================================
+
+private:
+
+	/// A scripted change at a point in time
+	struct Event {
+		/// Sample the event applies at
+		juce::int64 sample = 0;
+
+		/// Deck the event applies to, ignored by the crossfader
+		int deck = 0;
+
+		/// Name of the action
+		juce::String action;
+
+		/// Argument of the action
+		juce::var value;
+
+		/// Cue index for setCue and cue
+		int index = 0;
+
+		/// Samples a numeric action ramps over, 0 to apply at once
+		juce::int64 duration = 0;
+	};
+
+	/// A numeric action moving linearly between two values
+	struct Ramp {
+		/// Deck the ramp applies to
+		int deck = 0;
+
+		/// Name of the action
+		juce::String action;
+
+		/// Value at the start sample
+		double from = 0;
+
+		/// Value at the end sample
+		double to = 0;
+
+		/// First sample of the ramp
+		juce::int64 start = 0;
+
+		/// Sample the ramp reaches its end value
+		juce::int64 end = 0;
+	};
+
+	//==============================================================================
+
+	/**
+		* Applies an event to the decks
+		*
+		* @param Event to apply
+		* @param Report whose load time grows with every load
+		* @return juce::Result describing why the event failed
+	*/
+	juce::Result applyEvent(const Event& event, Report& report);
+
+	/**
+		* Sets a numeric action of a deck and remembers it as the start of later ramps
+		*
+		* @param Index of the deck
+		* @param Name of the action
+		* @param New value
+	*/
+	void applyValue(int deck, const juce::String& action, double value);
+
+	/**
+		* @param Name of an action
+		* @return True if the action takes a number and can be ramped
+	*/
+	static bool isNumericAction(const juce::String& action);
+
+	/**
+		* @param Name of an action
+		* @return True if the action starts, stops or moves a deck and is queued for its sample
+	*/
+	static bool isTransportAction(const juce::String& action);
+
+	//==============================================================================
+
+	/// Formats used to read tracks and write the output
+	juce::AudioFormatManager formatManager;
+
+	/// Decks and mixer driven by the script
+	std::unique_ptr<DeckEngine> deckEngine;
+
+	/// Events of the script sorted by time
+	std::vector<Event> events;
+
+	/// Ramps still moving
+	std::vector<Ramp> ramps;
+
+	/// Last value of every numeric action of each deck
+	std::vector<std::map<juce::String, double>> values;
+
+	/// Last cross fader position
+	double crossfaderPosition = 0;
+
+	/// Relative position of the cues set on each deck
+	std::vector<std::map<int, double>> cuePositions;
+
+	/// Folder relative paths in the script are resolved against
+	juce::File scriptFolder;
+
+	/// Output file named by the script
+	juce::File outputFile;
+
+	/// Sample rate of the render
+	double sampleRate = 44100;
+
+	/// Samples rendered per block
+	int blockSize = 512;
+
+	/// Number of samples to render
+	juce::int64 lengthInSamples = 0;
+
+	/// Bit depth of the output
+	int bitDepth = 24;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineRenderer)
+};
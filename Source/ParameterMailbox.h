@@ -0,0 +1,70 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+/**
+ * Definition of a ParameterMailbox class template
+ *
+ * A lock-free triple buffer that hands a snapshot of parameters from a single writer
+ * thread to a single reader thread. The writer fills its own slot and swaps it with the
+ * shared middle slot; the reader swaps its slot with the middle slot only when a newer
+ * snapshot has been published. Neither side ever waits on the other and the reader
+ * always receives a complete snapshot, never a mix of two.
+ *
+ */
+template <typename ParameterType>
+class ParameterMailbox {
+public:
+
+	//==============================================================================
+
+	/**
+		* Publishes a new snapshot. Only called from the writer thread.
+		*
+		* @param Snapshot to hand over to the reader
+	*/
+	void publish(const ParameterType& parameters) {
+		slots[writeIndex] = parameters;
+		writeIndex = middle.exchange(writeIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+	}
+
+	/**
+		* Fetches the latest snapshot if one was published since the last fetch.
+		* Only called from the reader thread.
+		*
+		* @param Snapshot to overwrite with the latest published parameters
+		* @return True if a new snapshot was fetched
+	*/
+	bool fetch(ParameterType& parameters) {
+		if ((middle.load(std::memory_order_relaxed) & newDataFlag) == 0) {
+			return false;
+		}
+		readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+		parameters = slots[readIndex];
+		return true;
+	}
+
+	//==============================================================================
+
+private:
+
+	/// Mask of the slot index held in middle
+	static constexpr int indexMask = 3;
+
+	/// Flag set in middle when the middle slot holds an unread snapshot
+	static constexpr int newDataFlag = 4;
+
+	/// Snapshot slots shared between writer, middle and reader
+	ParameterType slots[3];
+
+	/// Slot owned by the writer thread
+	int writeIndex = 0;
+
+	/// Slot owned by the reader thread
+	int readIndex = 1;
+
+	/// Slot in the middle of the handover, with newDataFlag when unread
+	std::atomic<int> middle{ 2 };
+};
@@ -13,6 +13,8 @@ PlaylistComponent::PlaylistComponent(juce::AudioFormatManager& _formatManager) :
 {
 	tableComponent.getHeader().addColumn("Track Title", 1, 300);
 	tableComponent.getHeader().addColumn("Length", 2, 150);
+	tableComponent.getHeader().addColumn("BPM", 3, 80);
+	tableComponent.getHeader().addColumn("LUFS", 4, 80);
 	tableComponent.setModel(this);
 	tableComponent.setColour(juce::TableListBox::ColourIds::backgroundColourId, juce::Colour::fromRGBA(25, 25, 25, 255));
 	addAndMakeVisible(tableComponent);
@@ -141,7 +143,8 @@ void PlaylistComponent::paintRowBackground(juce::Graphics& g, int rowNumber, int
 /**
  * Implementation of paintCell method for PlaylistComponent
  *
- * Draw the text of the track names and song length on the rows using displayTrackTitles data structure
+ * Draw the text of the track names, song length, tempo and loudness on the rows using displayTrackTitles data structure.
+ * Tracks still being analysed show an ellipsis, and tracks without a tempo or silent tracks a dash.
  *
  */
 void PlaylistComponent::paintCell(juce::Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) {
@@ -155,6 +158,14 @@ void PlaylistComponent::paintCell(juce::Graphics& g, int rowNumber, int columnId
 			std::string time = track::getLengthString(displayTrackTitles.at(rowNumber)->lengthInSeconds);
 			g.drawText(time, 2, 0, width - 4, height, juce::Justification::centredLeft, true);
 		}
+		else if (tableComponent.getHeader().getColumnName(columnId) == "BPM") {
+			const double bpm = displayTrackTitles.at(rowNumber)->bpm;
+			g.drawText(bpm > 0 ? juce::String(bpm, 2) : (bpm == 0 ? "..." : "-"), 2, 0, width - 4, height, juce::Justification::centredLeft, true);
+		}
+		else if (tableComponent.getHeader().getColumnName(columnId) == "LUFS") {
+			const double loudness = displayTrackTitles.at(rowNumber)->loudness;
+			g.drawText(loudness == 0 ? "..." : (loudness > TrackAnalyser::minLevel ? juce::String(loudness, 1) : "-"), 2, 0, width - 4, height, juce::Justification::centredLeft, true);
+		}
 	}
 };
 
@@ -4,6 +4,7 @@
 
 #include <JuceHeader.h>
 #include "Track.h"
+#include "TrackAnalyser.h"
 //==============================================================================
 
 /**
@@ -0,0 +1,284 @@
+
+#include "PolyphaseResamplingAudioSource.h"
+#include "SampleMath.h"
+
+//==============================================================================
+
+namespace {
+	/**
+	 * @return Zeroth order modified Bessel function of the first kind, used by the Kaiser window
+	 */
+	double besselI0(double x) {
+		double sum = 1.0, term = 1.0;
+		for (auto k = 1; k < 50 && term > sum * 1.0e-12; ++k) {
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for PolyphaseResamplingAudioSource::FilterBank
+ *
+ * Computes a Kaiser windowed sinc table for every tier and cutoff. Each tier has its own
+ * passband edge and window shape: draft keeps 80% of the band with a short soft window,
+ * mastering keeps 95% with a long steep one. Every row is normalised to unity gain so
+ * the level does not ripple with the fractional position.
+ *
+ */
+PolyphaseResamplingAudioSource::FilterBank::FilterBank()
+{
+	const double passbands[numQualities] = { 0.80, 0.90, 0.95 };
+	const double betas[numQualities] = { 4.0, 7.0, 9.0 };
+
+	for (auto q = 0; q < numQualities; ++q) {
+		const int taps = getNumTaps((Quality)q);
+		const int phases = getNumPhases((Quality)q);
+		const int half = taps / 2;
+		const double windowNormalisation = 1.0 / besselI0(betas[q]);
+
+		for (auto c = 0; c < numCutoffs; ++c) {
+			const double cutoff = passbands[q] / (1.0 + c / 16.0);
+			auto& table = tables[q][c];
+			table.resize((size_t)((phases + 1) * taps));
+
+			for (auto p = 0; p <= phases; ++p) {
+				const double fraction = (double)p / phases;
+				float* row = table.data() + p * taps;
+				double sum = 0;
+
+				for (auto k = 0; k < taps; ++k) {
+					const double t = (k - (half - 1)) - fraction;
+					const double x = juce::MathConstants<double>::pi * cutoff * t;
+					const double sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+					const double edge = t / half;
+					const double window = std::abs(edge) >= 1.0 ? 0.0 : besselI0(betas[q] * std::sqrt(1.0 - edge * edge)) * windowNormalisation;
+					const double value = cutoff * sinc * window;
+					row[k] = (float)value;
+					sum += value;
+				}
+
+				for (auto k = 0; k < taps; ++k) {
+					row[k] = (float)(row[k] / sum);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Implementation of getTable method for PolyphaseResamplingAudioSource::FilterBank
+ *
+ * Ratios up to 1 use the full passband. Faster ratios round up to the next sixteenth,
+ * whose table has its cutoff lowered by that ratio, up to twice the speed.
+ *
+ */
+const float* PolyphaseResamplingAudioSource::FilterBank::getTable(Quality quality, double ratio) const {
+	const int cutoffIndex = juce::jlimit(0, numCutoffs - 1, (int)std::ceil((ratio - 1.0) * 16.0 - 1.0e-9));
+	return tables[quality][cutoffIndex].data();
+}
+
+/**
+ * Implementation of getNumTaps method for PolyphaseResamplingAudioSource::FilterBank
+ *
+ * Returns the filter length of the tier
+ *
+ */
+int PolyphaseResamplingAudioSource::FilterBank::getNumTaps(Quality quality) {
+	return quality == draft ? 8 : (quality == normal ? 32 : maxNumTaps);
+}
+
+/**
+ * Implementation of getNumPhases method for PolyphaseResamplingAudioSource::FilterBank
+ *
+ * Returns the number of phases of the tier
+ *
+ */
+int PolyphaseResamplingAudioSource::FilterBank::getNumPhases(Quality quality) {
+	return quality == draft ? 64 : (quality == normal ? 256 : 512);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for PolyphaseResamplingAudioSource
+ *
+ * Saves the input source and channel count, buffers are allocated in prepareToPlay.
+ *
+ */
+PolyphaseResamplingAudioSource::PolyphaseResamplingAudioSource(juce::AudioSource* _input, bool deleteInputWhenDeleted, int _numChannels)
+	: input(_input, deleteInputWhenDeleted), numChannels(juce::jmax(1, _numChannels))
+{
+	jassert(_input != nullptr);
+	kernel.allocate((size_t)FilterBank::maxNumTaps, true);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setResamplingRatio method for PolyphaseResamplingAudioSource
+ *
+ * Sets the ratio data member, limited to the range the history is allocated for
+ *
+ */
+void PolyphaseResamplingAudioSource::setResamplingRatio(double samplesInPerOutputSample) {
+	jassert(samplesInPerOutputSample > 0);
+	ratio = juce::jlimit(0.05, 4.0, samplesInPerOutputSample);
+}
+
+/**
+ * Implementation of getResamplingRatio method for PolyphaseResamplingAudioSource
+ *
+ * Returns the ratio data member
+ *
+ */
+double PolyphaseResamplingAudioSource::getResamplingRatio() const {
+	return ratio;
+}
+
+/**
+ * Implementation of setQuality method for PolyphaseResamplingAudioSource
+ *
+ * Sets the quality data member. The history always keeps enough samples for the
+ * longest filter, so the tier can change between blocks without a flush.
+ *
+ */
+void PolyphaseResamplingAudioSource::setQuality(Quality newQuality) {
+	quality = juce::jlimit(0, numQualities - 1, (int)newQuality);
+}
+
+/**
+ * Implementation of getQuality method for PolyphaseResamplingAudioSource
+ *
+ * Returns the quality data member
+ *
+ */
+PolyphaseResamplingAudioSource::Quality PolyphaseResamplingAudioSource::getQuality() const {
+	return (Quality)quality.load();
+}
+
+/**
+ * Implementation of flushBuffers method for PolyphaseResamplingAudioSource
+ *
+ * Fills the history before the read position with silence
+ *
+ */
+void PolyphaseResamplingAudioSource::flushBuffers() {
+	history.clear();
+	numBuffered = FilterBank::maxNumTaps / 2;
+	position = numBuffered;
+}
+
+/**
+ * Implementation of requestReset method for PolyphaseResamplingAudioSource
+ *
+ * Flags the history to be flushed at the start of the next block
+ *
+ */
+void PolyphaseResamplingAudioSource::requestReset() {
+	resetPending = true;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for PolyphaseResamplingAudioSource
+ *
+ * Sizes the history for a block at the fastest ratio plus the filter on either side,
+ * and prepares the input for blocks of that size.
+ *
+ */
+void PolyphaseResamplingAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	maxBlockSize = juce::jmax(512, samplesPerBlockExpected);
+	const int maxInputBlock = (int)std::ceil(maxBlockSize * 4.0) + 2;
+	history.setSize(numChannels, maxInputBlock + FilterBank::maxNumTaps + 2);
+	input->prepareToPlay(maxInputBlock, sampleRate);
+	resetPending = false;
+	flushBuffers();
+}
+
+/**
+ * Implementation of releaseResources method for PolyphaseResamplingAudioSource
+ *
+ * Calls releaseResources on the input source and frees the history
+ *
+ */
+void PolyphaseResamplingAudioSource::releaseResources() {
+	input->releaseResources();
+	history.setSize(numChannels, 0);
+}
+
+/**
+ * Implementation of getNextAudioBlock method for PolyphaseResamplingAudioSource
+ *
+ * Flushes the history first if a reset was requested. Works through the block in sections no longer than the prepared size. For each section
+ * the input up to the last read position plus half the longest filter is pulled into the
+ * history. Every output sample interpolates its kernel between the two nearest phases and
+ * convolves it with the history around the integer read position. Consumed input is then
+ * dropped, keeping half the longest filter before the read position.
+ *
+ */
+void PolyphaseResamplingAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	if (history.getNumSamples() == 0) {
+		bufferToFill.clearActiveBufferRegion();
+		return;
+	}
+	if (resetPending.exchange(false)) {
+		flushBuffers();
+	}
+
+	const double localRatio = ratio.load();
+	const auto localQuality = (Quality)quality.load();
+	const int taps = FilterBank::getNumTaps(localQuality);
+	const int phases = FilterBank::getNumPhases(localQuality);
+	const int half = taps / 2;
+	const int maxHalf = FilterBank::maxNumTaps / 2;
+	const float* table = filterBank->getTable(localQuality, localRatio);
+
+	int done = 0;
+	while (done < bufferToFill.numSamples) {
+		const int numSamples = juce::jmin(maxBlockSize, bufferToFill.numSamples - done);
+
+		const int needed = (int)std::floor(position + numSamples * localRatio) + maxHalf + 1;
+		if (needed > numBuffered) {
+			juce::AudioSourceChannelInfo info(&history, numBuffered, needed - numBuffered);
+			input->getNextAudioBlock(info);
+			numBuffered = needed;
+		}
+
+		for (auto i = 0; i < numSamples; ++i) {
+			const int integerPosition = (int)position;
+			const double phase = (position - integerPosition) * phases;
+			const int phaseIndex = juce::jmin(phases - 1, (int)phase);
+			const float phaseFraction = (float)(phase - phaseIndex);
+			const float* row = table + phaseIndex * taps;
+			const float* nextRow = row + taps;
+			for (auto k = 0; k < taps; ++k) {
+				kernel[k] = row[k] + phaseFraction * (nextRow[k] - row[k]);
+			}
+
+			const int first = integerPosition - (half - 1);
+			for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+				const float* source = history.getReadPointer(juce::jmin(chan, numChannels - 1), first);
+				bufferToFill.buffer->getWritePointer(chan)[bufferToFill.startSample + done + i] = SampleMath::dotProduct(source, kernel.get(), taps);
+			}
+			position += localRatio;
+		}
+		done += numSamples;
+
+		const int consumed = (int)position - maxHalf;
+		if (consumed > 0) {
+			for (auto chan = 0; chan < numChannels; ++chan) {
+				auto* data = history.getWritePointer(chan);
+				std::memmove(data, data + consumed, (size_t)(numBuffered - consumed) * sizeof(float));
+			}
+			numBuffered -= consumed;
+			position -= consumed;
+		}
+	}
+}
+
+//==============================================================================
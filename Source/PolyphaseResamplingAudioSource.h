@@ -0,0 +1,190 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+//==============================================================================
+
+/**
+ * Definition of a PolyphaseResamplingAudioSource
+ *
+ * A drop-in replacement for juce::ResamplingAudioSource that interpolates with a
+ * Kaiser windowed sinc filter. The filter is stored as polyphase coefficient tables
+ * that are computed once and shared by every instance; the kernel for a fractional
+ * position is interpolated between its two nearest phases and convolved with the input.
+ * When the ratio reads the input faster than real time, a table with a lower cutoff
+ * is picked so the speed-up does not alias. Quality tiers trade filter length for CPU.
+ *
+ */
+class PolyphaseResamplingAudioSource : public juce::AudioSource {
+public:
+
+	/// Filter length and precision of the resampler
+	enum Quality {
+		/// 8 taps, cheapest, for preview and scrubbing
+		draft,
+		/// 32 taps, the default for playback
+		normal,
+		/// 64 taps, for recording and offline rendering
+		mastering,
+		numQualities
+	};
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for PolyphaseResamplingAudioSource, initializes member variables.
+		*
+		* @param AudioSource to resample
+		* @param True if the input should be deleted with this source
+		* @param Number of channels to resample
+	*/
+	PolyphaseResamplingAudioSource(juce::AudioSource* input, bool deleteInputWhenDeleted, int numChannels = 2);
+
+	//==============================================================================
+
+	/**
+		* Sets the resampling ratio, applied from the next block
+		*
+		* @param Number of input samples read per output sample, between 0.05 and 4
+	*/
+	void setResamplingRatio(double samplesInPerOutputSample);
+
+	/**
+		* @return Number of input samples read per output sample
+	*/
+	double getResamplingRatio() const;
+
+	/**
+		* Sets the quality tier, applied from the next block
+		*
+		* @param draft, normal or mastering
+	*/
+	void setQuality(Quality newQuality);
+
+	/**
+		* @return Current quality tier
+	*/
+	Quality getQuality() const;
+
+	/**
+		* Clears the buffered input. Only called from the audio thread or while it is stopped.
+	*/
+	void flushBuffers();
+
+	/**
+		* Asks the audio thread to flush the buffered input before the next block,
+		* used after the input has been repositioned. Safe to call from any thread.
+	*/
+	void requestReset();
+
+	//==============================================================================
+
+	/**
+		* Allocates the input history for the largest block and ratio
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Releases the input source and frees the input history
+	*/
+	void releaseResources() override;
+
+	/**
+		* Resamples the next block from the input
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+	 * Polyphase coefficient tables for every quality tier and cutoff, computed once
+	 * and shared between instances through juce::SharedResourcePointer.
+	 */
+	class FilterBank {
+	public:
+
+		/**
+			* Class Constructor for FilterBank, computes every table.
+		*/
+		FilterBank();
+
+		/**
+			* @param Quality tier
+			* @param Resampling ratio
+			* @return Table of numPhases + 1 rows of numTaps coefficients, with a cutoff low enough for the ratio
+		*/
+		const float* getTable(Quality quality, double ratio) const;
+
+		/**
+			* @param Quality tier
+			* @return Number of taps of the tier's filter
+		*/
+		static int getNumTaps(Quality quality);
+
+		/**
+			* @param Quality tier
+			* @return Number of phases in the tier's table
+		*/
+		static int getNumPhases(Quality quality);
+
+		/// Number of cutoffs per tier, from no speed-up to twice the speed in sixteenths
+		static constexpr int numCutoffs = 17;
+
+		/// Largest number of taps of any tier
+		static constexpr int maxNumTaps = 64;
+
+	private:
+
+		/// Tables indexed by tier, then cutoff
+		std::vector<float> tables[numQualities][numCutoffs];
+	};
+
+	//==============================================================================
+
+	/// Shared coefficient tables
+	juce::SharedResourcePointer<FilterBank> filterBank;
+
+	/// Input source being resampled
+	juce::OptionalScopedPointer<juce::AudioSource> input;
+
+	/// Number of channels resampled
+	int numChannels;
+
+	/// Number of input samples read per output sample
+	std::atomic<double> ratio{ 1.0 };
+
+	/// Current quality tier
+	std::atomic<int> quality{ normal };
+
+	/// Set by requestReset, cleared by the audio thread
+	std::atomic<bool> resetPending{ false };
+
+	/// Input history, keeping half the longest filter of samples before the read position
+	juce::AudioBuffer<float> history;
+
+	/// Number of valid samples in history
+	int numBuffered = 0;
+
+	/// Fractional read position in history
+	double position = 0;
+
+	/// Largest block resampled in one pass, longer blocks are split
+	int maxBlockSize = 0;
+
+	/// Kernel interpolated for the current fractional position
+	juce::HeapBlock<float> kernel;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseResamplingAudioSource)
+};
@@ -0,0 +1,368 @@
+
+#include "ReadAheadAudioSource.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for ReadAheadAudioSource
+ *
+ * Initializes the wrapped source, decode thread and buffer dimensions.
+ * The circular buffer itself is only allocated in prepareToPlay.
+ *
+ */
+ReadAheadAudioSource::ReadAheadAudioSource(juce::PositionableAudioSource* _source, juce::TimeSliceThread& thread, int _numberOfSamplesToBuffer, int _numberOfChannels)
+	: source(_source), backgroundThread(thread), numberOfSamplesToBuffer(juce::jmax(1024, _numberOfSamplesToBuffer)), numberOfChannels(_numberOfChannels)
+{
+	jassert(source != nullptr);
+}
+
+/**
+ * Implementation of a destructor for ReadAheadAudioSource
+ *
+ * Calls releaseResources so the decode thread no longer touches this instance.
+ *
+ */
+ReadAheadAudioSource::~ReadAheadAudioSource()
+{
+	releaseResources();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for ReadAheadAudioSource
+ *
+ * Detaches from the decode thread while the wrapped source is prepared and the
+ * circular buffer is allocated, then reattaches and waits for a quarter of a second
+ * of audio to be decoded so playback can start without an underrun.
+ *
+ */
+void ReadAheadAudioSource::prepareToPlay(int samplesPerBlockExpected, double newSampleRate) {
+	const int bufferSizeNeeded = juce::jmax(samplesPerBlockExpected * 2, numberOfSamplesToBuffer);
+
+	if (isPrepared && newSampleRate == sampleRate && bufferSizeNeeded == buffer.getNumSamples()) {
+		return;
+	}
+
+	backgroundThread.removeTimeSliceClient(this);
+
+	isPrepared = true;
+	sampleRate = newSampleRate;
+	source->prepareToPlay(samplesPerBlockExpected, newSampleRate);
+	buffer.setSize(numberOfChannels, bufferSizeNeeded);
+	buffer.clear();
+
+	{
+		const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+		bufferValidStart = 0;
+		bufferValidEnd = 0;
+	}
+
+	backgroundThread.addTimeSliceClient(this);
+
+	const juce::int64 prefillSamples = juce::jmin((int)newSampleRate / 4, buffer.getNumSamples() / 2);
+	for (auto attempt = 0; attempt < 100; ++attempt) {
+		{
+			const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+			if (bufferValidEnd - bufferValidStart >= prefillSamples) {
+				break;
+			}
+		}
+		backgroundThread.moveToFrontOfQueue(this);
+		juce::Thread::sleep(5);
+	}
+}
+
+/**
+ * Implementation of releaseResources method for ReadAheadAudioSource
+ *
+ * Detaches from the decode thread, frees the circular buffer and releases the wrapped source.
+ *
+ */
+void ReadAheadAudioSource::releaseResources() {
+	isPrepared = false;
+	backgroundThread.removeTimeSliceClient(this);
+	buffer.setSize(numberOfChannels, 0);
+	source->releaseResources();
+}
+
+/**
+ * Implementation of getNextAudioBlock method for ReadAheadAudioSource
+ *
+ * Copies the decoded part of the requested range out of the circular buffer,
+ * handling the wrap around at the end of the buffer. Any part that is not decoded
+ * yet is cleared and the block is counted as an underrun if it lies within the source.
+ * After a seek the block stays silent, without moving the playhead or counting an
+ * underrun, until the first sample at the new position is decoded. The playhead is
+ * only moved on if no seek came in from another thread meanwhile.
+ *
+ */
+void ReadAheadAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	auto start = nextPlayPos.load();
+	bool underrun = false;
+
+	{
+		const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+
+		const int validStart = (int)(juce::jlimit(bufferValidStart, bufferValidEnd, start) - start);
+		const int validEnd = (int)(juce::jlimit(bufferValidStart, bufferValidEnd, start + bufferToFill.numSamples) - start);
+
+		if (seekPending.load()) {
+			if (validStart != 0 || validEnd == 0 || buffer.getNumSamples() == 0) {
+				bufferToFill.clearActiveBufferRegion();
+				return;
+			}
+			seekPending = false;
+		}
+
+		if (validStart == validEnd || buffer.getNumSamples() == 0) {
+			bufferToFill.clearActiveBufferRegion();
+			underrun = true;
+		}
+		else {
+			if (validStart > 0) {
+				bufferToFill.buffer->clear(bufferToFill.startSample, validStart);
+			}
+			if (validEnd < bufferToFill.numSamples) {
+				bufferToFill.buffer->clear(bufferToFill.startSample + validEnd, bufferToFill.numSamples - validEnd);
+			}
+			underrun = validStart > 0 || validEnd < bufferToFill.numSamples;
+
+			const int bufferSize = buffer.getNumSamples();
+			const int startBufferIndex = (int)((validStart + start) % bufferSize);
+			const int endBufferIndex = (int)((validEnd + start) % bufferSize);
+
+			for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+				if (chan >= buffer.getNumChannels()) {
+					bufferToFill.buffer->clear(chan, bufferToFill.startSample, bufferToFill.numSamples);
+				}
+				else if (startBufferIndex < endBufferIndex) {
+					bufferToFill.buffer->copyFrom(chan, bufferToFill.startSample + validStart, buffer, chan, startBufferIndex, validEnd - validStart);
+				}
+				else {
+					const int initialSize = bufferSize - startBufferIndex;
+					bufferToFill.buffer->copyFrom(chan, bufferToFill.startSample + validStart, buffer, chan, startBufferIndex, initialSize);
+					bufferToFill.buffer->copyFrom(chan, bufferToFill.startSample + validStart + initialSize, buffer, chan, 0, (validEnd - validStart) - initialSize);
+				}
+			}
+		}
+	}
+
+	if (underrun && (start < source->getTotalLength() || source->isLooping())) {
+		++underrunCount;
+	}
+
+	nextPlayPos.compare_exchange_strong(start, start + bufferToFill.numSamples);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setNextReadPosition method for ReadAheadAudioSource
+ *
+ * Stores the new playhead and flags the seek. Waking the decode thread would take the
+ * lock of its queue, so it notices the new position within its idle interval instead.
+ *
+ */
+void ReadAheadAudioSource::setNextReadPosition(juce::int64 newPosition) {
+	nextPlayPos = newPosition;
+	seekPending = true;
+}
+
+/**
+ * Implementation of getNextReadPosition method for ReadAheadAudioSource
+ *
+ * Returns the playhead, wrapped to the source length when the source is looping.
+ *
+ */
+juce::int64 ReadAheadAudioSource::getNextReadPosition() const {
+	const auto pos = nextPlayPos.load();
+	const auto length = source->getTotalLength();
+	return (source->isLooping() && length > 0) ? pos % length : pos;
+}
+
+/**
+ * Implementation of getTotalLength method for ReadAheadAudioSource
+ *
+ * Returns the length of the wrapped source.
+ *
+ */
+juce::int64 ReadAheadAudioSource::getTotalLength() const {
+	return source->getTotalLength();
+}
+
+/**
+ * Implementation of isLooping method for ReadAheadAudioSource
+ *
+ * Returns the looping state of the wrapped source.
+ *
+ */
+bool ReadAheadAudioSource::isLooping() const {
+	return source->isLooping();
+}
+
+/**
+ * Implementation of setLooping method for ReadAheadAudioSource
+ *
+ * Sets the looping state of the wrapped source.
+ * The decode thread discards the buffer when it notices the change.
+ *
+ */
+void ReadAheadAudioSource::setLooping(bool shouldLoop) {
+	source->setLooping(shouldLoop);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getBufferFillLevel method for ReadAheadAudioSource
+ *
+ * Returns the decoded samples ahead of the playhead relative to the buffer size.
+ *
+ */
+float ReadAheadAudioSource::getBufferFillLevel() const {
+	const auto pos = nextPlayPos.load();
+	const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+	if (buffer.getNumSamples() == 0 || pos < bufferValidStart || pos >= bufferValidEnd) {
+		return 0.0f;
+	}
+	return juce::jlimit(0.0f, 1.0f, (float)(bufferValidEnd - pos) / (float)buffer.getNumSamples());
+}
+
+/**
+ * Implementation of getBufferLength method for ReadAheadAudioSource
+ *
+ * Returns the numberOfSamplesToBuffer data member.
+ *
+ */
+int ReadAheadAudioSource::getBufferLength() const {
+	return numberOfSamplesToBuffer;
+}
+
+/**
+ * Implementation of getUnderrunCount method for ReadAheadAudioSource
+ *
+ * Returns the underrunCount data member
+ *
+ */
+int ReadAheadAudioSource::getUnderrunCount() const {
+	return underrunCount.load();
+}
+
+/**
+ * Implementation of isSeekPending method for ReadAheadAudioSource
+ *
+ * Returns the seekPending data member
+ *
+ */
+bool ReadAheadAudioSource::isSeekPending() const {
+	return seekPending.load();
+}
+
+/**
+ * Implementation of resetUnderrunCount method for ReadAheadAudioSource
+ *
+ * Sets the underrunCount data member back to 0
+ *
+ */
+void ReadAheadAudioSource::resetUnderrunCount() {
+	underrunCount = 0;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of useTimeSlice method for ReadAheadAudioSource
+ *
+ * Decodes the next chunk, asking to be called again straight away while there is
+ * work left and otherwise sleeping for the idle interval.
+ *
+ */
+int ReadAheadAudioSource::useTimeSlice() {
+	return readNextBufferChunk() ? 1 : idleInterval;
+}
+
+/**
+ * Implementation of readNextBufferChunk method for ReadAheadAudioSource
+ *
+ * Works out which range should be decoded next from the playhead and the currently
+ * valid range. A playhead outside the valid range restarts the buffer from the playhead,
+ * otherwise the valid range is extended in chunks. The range lock is only held while
+ * the indices are updated, never while the wrapped source is decoding.
+ *
+ */
+bool ReadAheadAudioSource::readNextBufferChunk() {
+	const int maxChunkSize = 2048;
+	juce::int64 newBVS, newBVE, sectionToReadStart, sectionToReadEnd;
+
+	{
+		const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+
+		if (wasSourceLooping != isLooping()) {
+			wasSourceLooping = isLooping();
+			bufferValidStart = 0;
+			bufferValidEnd = 0;
+		}
+
+		newBVS = juce::jmax((juce::int64)0, nextPlayPos.load());
+		newBVE = newBVS + buffer.getNumSamples() - 4;
+		sectionToReadStart = 0;
+		sectionToReadEnd = 0;
+
+		if (newBVS < bufferValidStart || newBVS >= bufferValidEnd) {
+			newBVE = juce::jmin(newBVE, newBVS + maxChunkSize);
+			sectionToReadStart = newBVS;
+			sectionToReadEnd = newBVE;
+			bufferValidStart = 0;
+			bufferValidEnd = 0;
+		}
+		else if (std::abs(newBVS - bufferValidStart) > 512 || std::abs(newBVE - bufferValidEnd) > 512) {
+			newBVE = juce::jmin(newBVE, bufferValidEnd + maxChunkSize);
+			sectionToReadStart = bufferValidEnd;
+			sectionToReadEnd = newBVE;
+			bufferValidStart = newBVS;
+			bufferValidEnd = juce::jmin(bufferValidEnd, newBVE);
+		}
+	}
+
+	if (sectionToReadStart == sectionToReadEnd) {
+		return false;
+	}
+
+	const int bufferSize = buffer.getNumSamples();
+	const int bufferIndexStart = (int)(sectionToReadStart % bufferSize);
+	const int bufferIndexEnd = (int)(sectionToReadEnd % bufferSize);
+
+	if (bufferIndexStart < bufferIndexEnd) {
+		readBufferSection(sectionToReadStart, (int)(sectionToReadEnd - sectionToReadStart), bufferIndexStart);
+	}
+	else {
+		const int initialSize = bufferSize - bufferIndexStart;
+		readBufferSection(sectionToReadStart, initialSize, bufferIndexStart);
+		readBufferSection(sectionToReadStart + initialSize, (int)(sectionToReadEnd - sectionToReadStart) - initialSize, 0);
+	}
+
+	{
+		const juce::SpinLock::ScopedLockType sl(bufferRangeLock);
+		bufferValidStart = newBVS;
+		bufferValidEnd = newBVE;
+	}
+
+	return true;
+}
+
+/**
+ * Implementation of readBufferSection method for ReadAheadAudioSource
+ *
+ * Seeks the wrapped source if needed and decodes the section into the circular buffer.
+ *
+ */
+void ReadAheadAudioSource::readBufferSection(juce::int64 start, int length, int bufferOffset) {
+	if (source->getNextReadPosition() != start) {
+		source->setNextReadPosition(start);
+	}
+	juce::AudioSourceChannelInfo info(&buffer, bufferOffset, length);
+	source->getNextAudioBlock(info);
+}
+
+//==============================================================================
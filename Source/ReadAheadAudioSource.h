@@ -0,0 +1,200 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+
+/**
+ * Definition of a ReadAheadAudioSource
+ *
+ * A PositionableAudioSource that decodes its wrapped source ahead of the playhead
+ * on a background juce::TimeSliceThread and keeps the decoded PCM in a circular buffer.
+ * The audio thread only copies already decoded samples out of the buffer, so slow disks
+ * or expensive compressed frames never stall getNextAudioBlock. Blocks that are not yet
+ * decoded are rendered as silence and counted as underruns. A seek only stores the new
+ * position for the decode thread to pick up, so it can be made from the audio thread, and
+ * playback waits in silence at the new position until its first samples are decoded.
+ *
+ */
+class ReadAheadAudioSource : public juce::PositionableAudioSource,
+	private juce::TimeSliceClient
+{
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for ReadAheadAudioSource, initializes member variables.
+		*
+		* @param PositionableAudioSource to decode ahead of the playhead, not owned
+		* @param juce::TimeSliceThread that performs the decoding
+		* @param Number of samples to keep decoded ahead of the playhead
+		* @param Number of channels to buffer
+	*/
+	ReadAheadAudioSource(juce::PositionableAudioSource* source, juce::TimeSliceThread& thread, int numberOfSamplesToBuffer, int numberOfChannels = 2);
+
+	/**
+		* Class destructor for ReadAheadAudioSource, detaches from the decode thread.
+	*/
+	~ReadAheadAudioSource() override;
+
+	//==============================================================================
+
+	/**
+		* Allocates the read-ahead buffer and waits for an initial part of it to be filled
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Detaches from the decode thread and frees the read-ahead buffer
+	*/
+	void releaseResources() override;
+
+	/**
+		* Copies already decoded samples into the buffer, silence is written for any part that is not decoded yet
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+	/**
+		* Sets the next playback position for the decode thread to pick up, without blocking
+		*
+		* @param Position in samples
+	*/
+	void setNextReadPosition(juce::int64 newPosition) override;
+
+	/**
+		* @return Next playback position in samples
+	*/
+	juce::int64 getNextReadPosition() const override;
+
+	/**
+		* @return Total length of the wrapped source in samples
+	*/
+	juce::int64 getTotalLength() const override;
+
+	/**
+		* @return If the wrapped source is looping
+	*/
+	bool isLooping() const override;
+
+	/**
+		* Sets the looping state of the wrapped source
+		*
+		* @param True to loop the wrapped source
+	*/
+	void setLooping(bool shouldLoop) override;
+
+	//==============================================================================
+
+	/**
+		* @return Portion of the read-ahead buffer ahead of the playhead that is decoded, between 0 and 1
+	*/
+	float getBufferFillLevel() const;
+
+	/**
+		* @return Number of samples decoded ahead of the playhead when the read-ahead buffer is full
+	*/
+	int getBufferLength() const;
+
+	/**
+		* @return Number of blocks that could not be fully served from the read-ahead buffer
+	*/
+	int getUnderrunCount() const;
+
+	/**
+		* @return If nothing has been played from the position of the last seek yet
+	*/
+	bool isSeekPending() const;
+
+	/**
+		* Resets the underrun counter
+	*/
+	void resetUnderrunCount();
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Called by the decode thread to decode the next chunk
+		*
+		* @return Number of milliseconds before the decode thread should call again
+	*/
+	int useTimeSlice() override;
+
+	/**
+		* Decodes the next chunk of the wrapped source into the circular buffer
+		*
+		* @return True if a chunk was decoded
+	*/
+	bool readNextBufferChunk();
+
+	/**
+		* Decodes a section of the wrapped source into the circular buffer
+		*
+		* @param Start position of the section in samples
+		* @param Number of samples to decode
+		* @param Index in the circular buffer to write to
+	*/
+	void readBufferSection(juce::int64 start, int length, int bufferOffset);
+
+	//==============================================================================
+
+	/// Wrapped source that is decoded on the background thread
+	juce::PositionableAudioSource* source;
+
+	/// Background thread that performs the decoding
+	juce::TimeSliceThread& backgroundThread;
+
+	/// Number of samples held by the circular buffer
+	int numberOfSamplesToBuffer;
+
+	/// Number of channels held by the circular buffer
+	int numberOfChannels;
+
+	/// Circular buffer of decoded samples, indexed by position modulo its size
+	juce::AudioBuffer<float> buffer;
+
+	/// Guards the valid range of the circular buffer, only held for index updates and block copies
+	juce::SpinLock bufferRangeLock;
+
+	/// Start position of the decoded range in the circular buffer
+	juce::int64 bufferValidStart = 0;
+
+	/// End position of the decoded range in the circular buffer
+	juce::int64 bufferValidEnd = 0;
+
+	/// Next playback position in samples
+	std::atomic<juce::int64> nextPlayPos{ 0 };
+
+	/// Looping state seen by the decode thread on its last chunk
+	bool wasSourceLooping = false;
+
+	/// Flags if the source is prepared and attached to the decode thread
+	bool isPrepared = false;
+
+	/// Number of samples per second the source is prepared with
+	double sampleRate = 0;
+
+	/// Number of blocks that could not be fully served from the buffer
+	std::atomic<int> underrunCount{ 0 };
+
+	/// Flags a seek whose first samples are not decoded yet, playback holds its position meanwhile
+	std::atomic<bool> seekPending{ false };
+
+	/// Milliseconds the decode thread sleeps when there is nothing to decode, which bounds how long a seek waits to be noticed
+	static constexpr int idleInterval = 2;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReadAheadAudioSource)
+};
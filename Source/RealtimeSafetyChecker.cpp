@@ -0,0 +1,319 @@
+
+#include "RealtimeSafetyChecker.h"
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <atomic>
+
+#if (OTODECKS_RT_CHECKS || OTODECKS_COUNT_ALLOCATIONS) && JUCE_LINUX
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+#endif
+
+//==============================================================================
+
+#if OTODECKS_RT_CHECKS
+
+/// Number of real-time sections the current thread is inside
+static thread_local int sectionDepth = 0;
+
+/// Flags if the current thread is recording a violation, so calls made while recording are ignored
+static thread_local bool recording = false;
+
+/// Most frames kept in a stack sample
+static constexpr int maxFrames = 24;
+
+/// Most places violations are recorded for, later places are only counted
+static constexpr int maxSites = 64;
+
+/// A place violations were recorded at
+struct ViolationSite {
+	/// Kind of call
+	RealtimeSafetyChecker::ViolationType type;
+
+	/// Largest allocation seen here
+	size_t bytes;
+
+	/// Stack sample taken at the first violation
+	void* frames[maxFrames];
+
+	/// Number of frames in the sample
+	int numFrames;
+
+	/// Number of violations recorded here
+	juce::int64 count;
+};
+
+/// Guards the sites, only taken while recording a violation or reading them
+static juce::SpinLock siteLock;
+
+/// Places violations were recorded at
+static ViolationSite sites[maxSites];
+
+/// Number of sites in use
+static int numSites = 0;
+
+/// Number of violations since the last reset
+static std::atomic<juce::int64> violationCount{ 0 };
+
+#if JUCE_LINUX
+/// Takes the first stack sample at startup, as backtrace loads its unwinder on first use
+static const int backtraceReady = [] { void* frame; return backtrace(&frame, 1); }();
+#endif
+
+#endif
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for RealtimeSafetyChecker::ScopedRealtimeSection
+ *
+ * Enters a section on the calling thread if active
+ *
+ */
+RealtimeSafetyChecker::ScopedRealtimeSection::ScopedRealtimeSection(bool _active)
+	: active(_active)
+{
+#if OTODECKS_RT_CHECKS
+	if (active) {
+		++sectionDepth;
+	}
+#endif
+}
+
+/**
+ * Implementation of a destructor for RealtimeSafetyChecker::ScopedRealtimeSection
+ *
+ * Leaves the section entered by the constructor
+ *
+ */
+RealtimeSafetyChecker::ScopedRealtimeSection::~ScopedRealtimeSection()
+{
+#if OTODECKS_RT_CHECKS
+	if (active) {
+		--sectionDepth;
+	}
+#endif
+}
+
+//==============================================================================
+
+/**
+ * Implementation of isAvailable method for RealtimeSafetyChecker
+ *
+ * Returns the value of OTODECKS_RT_CHECKS
+ *
+ */
+bool RealtimeSafetyChecker::isAvailable() {
+	return OTODECKS_RT_CHECKS != 0;
+}
+
+/**
+ * Implementation of isInRealtimeSection method for RealtimeSafetyChecker
+ *
+ * Returns true if the section depth of the calling thread is above zero
+ *
+ */
+bool RealtimeSafetyChecker::isInRealtimeSection() {
+#if OTODECKS_RT_CHECKS
+	return sectionDepth > 0;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Implementation of getViolationCount method for RealtimeSafetyChecker
+ *
+ * Returns the violationCount counter
+ *
+ */
+juce::int64 RealtimeSafetyChecker::getViolationCount() {
+#if OTODECKS_RT_CHECKS
+	return violationCount;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Implementation of getReport method for RealtimeSafetyChecker
+ *
+ * Copies the sites out of the lock first so symbolising, which allocates, happens
+ * without holding it. The first frames belong to the checker and the replaced
+ * function and are skipped.
+ *
+ */
+juce::String RealtimeSafetyChecker::getReport() {
+#if OTODECKS_RT_CHECKS
+	const juce::int64 total = violationCount;
+	if (total == 0) {
+		return {};
+	}
+
+	std::unique_ptr<ViolationSite[]> copies(new ViolationSite[maxSites]);
+	int numCopies = 0;
+	{
+		const juce::SpinLock::ScopedLockType sl(siteLock);
+		numCopies = numSites;
+		std::copy(sites, sites + numSites, copies.get());
+	}
+
+	const char* names[] = { "allocation", "deallocation", "lock wait" };
+	juce::String report;
+	report << juce::String(total) << " real-time violations at " << juce::String(numCopies) << " places\n";
+	for (auto i = 0; i < numCopies; ++i) {
+		const auto& site = copies[i];
+		report << "  " << juce::String(site.count) << " x " << names[site.type];
+		if (site.bytes > 0) {
+			report << " of up to " << juce::String((juce::int64)site.bytes) << " bytes";
+		}
+		report << "\n";
+#if JUCE_LINUX
+		if (char** symbols = backtrace_symbols(site.frames, site.numFrames)) {
+			for (auto frame = 2; frame < site.numFrames; ++frame) {
+				report << "      " << symbols[frame] << "\n";
+			}
+			free(symbols);
+		}
+#endif
+	}
+	return report;
+#else
+	return {};
+#endif
+}
+
+/**
+ * Implementation of reset method for RealtimeSafetyChecker
+ *
+ * Drops every site and zeroes the count
+ *
+ */
+void RealtimeSafetyChecker::reset() {
+#if OTODECKS_RT_CHECKS
+	const juce::SpinLock::ScopedLockType sl(siteLock);
+	numSites = 0;
+	violationCount = 0;
+#endif
+}
+
+/**
+ * Implementation of check method for RealtimeSafetyChecker
+ *
+ * Returns straight away outside a section. Inside one, takes a stack sample into a
+ * local array and adds it to the site with the same type and stack, or to a new site.
+ * Nothing here allocates or locks a mutex, and calls made while recording are ignored.
+ *
+ */
+void RealtimeSafetyChecker::check(ViolationType type, size_t bytes) {
+#if OTODECKS_RT_CHECKS
+	if (sectionDepth == 0 || recording) {
+		return;
+	}
+	recording = true;
+	++violationCount;
+
+	void* frames[maxFrames];
+	int numFrames = 0;
+#if JUCE_LINUX
+	numFrames = backtrace(frames, maxFrames);
+#endif
+
+	{
+		const juce::SpinLock::ScopedLockType sl(siteLock);
+		int index = 0;
+		for (; index < numSites; ++index) {
+			const auto& site = sites[index];
+			if (site.type == type && site.numFrames == numFrames && std::equal(frames, frames + numFrames, site.frames)) {
+				break;
+			}
+		}
+		if (index == numSites && numSites < maxSites) {
+			auto& site = sites[numSites++];
+			site.type = type;
+			site.bytes = 0;
+			site.numFrames = numFrames;
+			site.count = 0;
+			std::copy(frames, frames + numFrames, site.frames);
+		}
+		if (index < numSites) {
+			sites[index].count++;
+			sites[index].bytes = juce::jmax(sites[index].bytes, bytes);
+		}
+	}
+
+	recording = false;
+#else
+	juce::ignoreUnused(type, bytes);
+#endif
+}
+
+//==============================================================================
+
+#if (OTODECKS_RT_CHECKS || OTODECKS_COUNT_ALLOCATIONS) && JUCE_LINUX
+
+/*
+	Replacements of the glibc allocation functions, which count every allocation of the
+	process for the AllocationCounter and check it, and of pthread_mutex_lock, only
+	built with the checks. The allocation functions forward to the glibc
+	implementations directly, so they work before static initialisation. The real
+	pthread_mutex_lock is looked up once.
+*/
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+	AllocationCounter::allocationMade();
+	RealtimeSafetyChecker::check(RealtimeSafetyChecker::allocation, size);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+	AllocationCounter::allocationMade();
+	RealtimeSafetyChecker::check(RealtimeSafetyChecker::allocation, count * size);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+	AllocationCounter::allocationMade();
+	RealtimeSafetyChecker::check(RealtimeSafetyChecker::allocation, size);
+	return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+	if (ptr != nullptr) {
+		RealtimeSafetyChecker::check(RealtimeSafetyChecker::deallocation, 0);
+	}
+	__libc_free(ptr);
+}
+
+#if OTODECKS_RT_CHECKS
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+	using LockFunction = int (*)(pthread_mutex_t*);
+	static std::atomic<LockFunction> realLock{ nullptr };
+	auto lock = realLock.load(std::memory_order_relaxed);
+	if (lock == nullptr) {
+		lock = (LockFunction)dlsym(RTLD_NEXT, "pthread_mutex_lock");
+		realLock.store(lock, std::memory_order_relaxed);
+	}
+
+	if (RealtimeSafetyChecker::isInRealtimeSection()) {
+		if (pthread_mutex_trylock(mutex) == 0) {
+			return 0;
+		}
+		RealtimeSafetyChecker::check(RealtimeSafetyChecker::lockWait, 0);
+	}
+	return lock(mutex);
+}
+#endif
+
+}
+
+#endif
+
+//==============================================================================
@@ -0,0 +1,110 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/// Compiles the real-time safety checks in, off unless the build sets it
+#ifndef OTODECKS_RT_CHECKS
+ #define OTODECKS_RT_CHECKS 0
+#endif
+
+//==============================================================================
+
+/**
+ * Definition of a RealtimeSafetyChecker
+ *
+ * Debug tool that catches heap calls and lock waits made by the audio callback. Code
+ * that must be real-time safe is marked with a ScopedRealtimeSection. While a thread is
+ * inside one, every malloc, free and contended mutex lock on that thread is recorded as
+ * a violation along with a sample of the stack, so it can be traced to its caller.
+ * Violations from the same place are counted together.
+ *
+ * On Linux the C allocation functions and pthread_mutex_lock are replaced, catching
+ * reader I/O buffers, juce::HeapBlock and juce::CriticalSection as well as operator new.
+ * A lock counts as a wait when it cannot be taken straight away. Other platforms only
+ * see operator new and delete, without stack samples. Everything compiles away unless
+ * OTODECKS_RT_CHECKS is set.
+ *
+ */
+class RealtimeSafetyChecker {
+public:
+
+	/// Kind of call made inside a real-time section
+	enum ViolationType {
+		/// malloc, calloc, realloc or operator new
+		allocation,
+		/// free or operator delete
+		deallocation,
+		/// Lock of a mutex held by another thread
+		lockWait,
+		/// Number of types
+		numViolationTypes
+	};
+
+	//==============================================================================
+
+	/**
+	 * Marks the calling thread as real-time for its lifetime. Can be nested.
+	 */
+	class ScopedRealtimeSection {
+	public:
+
+		/**
+			* Class Constructor for ScopedRealtimeSection, marks the calling thread.
+			*
+			* @param False to mark nothing, so a section can follow the state of another thread
+		*/
+		explicit ScopedRealtimeSection(bool active = true);
+
+		/**
+			* Class destructor for ScopedRealtimeSection, unmarks the calling thread.
+		*/
+		~ScopedRealtimeSection();
+
+	private:
+
+		/// Flags if the constructor marked the thread
+		bool active;
+
+		JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+	};
+
+	//==============================================================================
+
+	/**
+		* @return True if the checks are compiled in
+	*/
+	static bool isAvailable();
+
+	/**
+		* @return True if the calling thread is inside a real-time section
+	*/
+	static bool isInRealtimeSection();
+
+	/**
+		* @return Number of violations recorded since the last reset
+	*/
+	static juce::int64 getViolationCount();
+
+	/**
+		* Describes every place a violation was recorded, with its count and symbolised stack.
+		* Allocates, so it is not called from a real-time section.
+		*
+		* @return Report, empty if nothing was recorded
+	*/
+	static juce::String getReport();
+
+	/**
+		* Forgets every recorded violation
+	*/
+	static void reset();
+
+	/**
+		* Records a violation if the calling thread is inside a real-time section. Called by the
+		* replaced allocation and lock functions.
+		*
+		* @param Kind of call
+		* @param Bytes requested by an allocation, 0 otherwise
+	*/
+	static void check(ViolationType type, size_t bytes);
+};
@@ -0,0 +1,278 @@
+
+#include "RealtimeWorkerPool.h"
+
+#if JUCE_MAC || JUCE_IOS
+#include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <semaphore.h>
+#include <cerrno>
+#endif
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for RealtimeWorkerPool
+ *
+ * Creates and starts every worker, so no thread is created on the audio thread. Workers
+ * run at real-time priority like the audio thread they help, so the scheduler does not
+ * leave a task waiting behind ordinary threads; where the process may not create
+ * real-time threads they fall back to the highest normal priority.
+ *
+ */
+RealtimeWorkerPool::RealtimeWorkerPool(int numWorkers)
+{
+	for (auto i = 0; i < numWorkers; ++i) {
+		workers.add(new Worker(*this));
+	}
+	for (auto* worker : workers) {
+		if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions{})) {
+			worker->startThread(juce::Thread::Priority::highest);
+		}
+	}
+}
+
+/**
+ * Implementation of a destructor for RealtimeWorkerPool
+ *
+ * Asks every worker to exit and wakes it, then waits for it to stop.
+ *
+ */
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+	for (auto* worker : workers) {
+		worker->signalThreadShouldExit();
+		worker->wakeUp.post();
+	}
+	for (auto* worker : workers) {
+		worker->stopThread(2000);
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getNumWorkers method for RealtimeWorkerPool
+ *
+ * Returns the size of the workers array
+ *
+ */
+int RealtimeWorkerPool::getNumWorkers() const {
+	return workers.size();
+}
+
+/**
+ * Implementation of run method for RealtimeWorkerPool
+ *
+ * Closes the claim state first, so a worker still looking at the previous batch cannot
+ * claim anything while the new batch is stored. The batch is then published by resetting
+ * the claim state to the new batch number with no task claimed. Only workers that
+ * announced they are sleeping are posted; a worker checks the batch number again after
+ * announcing it, so either it sees the new batch or it is posted, and a post it did not
+ * need only costs it one extra look at the batch number. The calling thread then claims
+ * every task no worker has taken yet and spins until the tasks claimed by workers have
+ * finished too, giving up once the deadline passes.
+ *
+ */
+bool RealtimeWorkerPool::run(Task task, void* context, int numTasks, juce::int64 deadlineTicks) {
+	if (numTasks <= 0) {
+		return true;
+	}
+	if (workers.isEmpty() || numTasks == 1) {
+		for (auto i = 0; i < numTasks; ++i) {
+			task(context, i);
+		}
+		return true;
+	}
+
+	const juce::uint32 batch = batchNumber.load() + 1;
+	claimState = ((juce::uint64)batch << 32) | 0xffffffff;
+
+	currentTask = task;
+	currentContext = context;
+	currentRealtime = RealtimeSafetyChecker::isInRealtimeSection();
+	currentNumTasks = numTasks;
+	completionState = (juce::uint64)batch << 32;
+
+	claimState = (juce::uint64)batch << 32;
+	batchNumber = batch;
+
+	for (auto* worker : workers) {
+		if (worker->sleeping.exchange(false)) {
+			worker->wakeUp.post();
+		}
+	}
+
+	runTasks(batch);
+	while ((int)(completionState.load() & 0xffffffff) < numTasks) {
+		if (deadlineTicks != 0 && juce::Time::getHighResolutionTicks() >= deadlineTicks) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Implementation of runTasks method for RealtimeWorkerPool
+ *
+ * Claims the next task index with a compare and swap that also checks the batch number,
+ * so a worker that wakes up late can never claim a task of a batch it did not see. The
+ * task, context and task count are read before the claim: run only replaces them after
+ * closing the claim state, so a claim that succeeds was made with those of its own batch.
+ * Tasks run in a real-time section if run was called from one.
+ *
+ */
+void RealtimeWorkerPool::runTasks(juce::uint32 batch) {
+	const RealtimeSafetyChecker::ScopedRealtimeSection realtimeSection(currentRealtime.load());
+	for (;;) {
+		auto state = claimState.load();
+		if ((juce::uint32)(state >> 32) != batch) {
+			return;
+		}
+		const juce::uint32 index = (juce::uint32)(state & 0xffffffff);
+		const Task task = currentTask.load();
+		void* context = currentContext.load();
+		if (index >= (juce::uint32)currentNumTasks.load()) {
+			return;
+		}
+		if (claimState.compare_exchange_weak(state, state + 1)) {
+			task(context, (int)index);
+			completeTask(batch);
+		}
+	}
+}
+
+/**
+ * Implementation of completeTask method for RealtimeWorkerPool
+ *
+ * Increments the finished count with a compare and swap that fails for good once run
+ * has moved the completion state on to a later batch.
+ *
+ */
+void RealtimeWorkerPool::completeTask(juce::uint32 batch) {
+	auto state = completionState.load();
+	while ((juce::uint32)(state >> 32) == batch && !completionState.compare_exchange_weak(state, state + 1)) {
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for RealtimeWorkerPool::WakeSemaphore
+ *
+ * Creates a dispatch semaphore on macOS, a Win32 semaphore on Windows and a POSIX
+ * semaphore elsewhere.
+ *
+ */
+RealtimeWorkerPool::WakeSemaphore::WakeSemaphore()
+{
+#if JUCE_MAC || JUCE_IOS
+	handle = (void*)dispatch_semaphore_create(0);
+#elif JUCE_WINDOWS
+	handle = (void*)CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr);
+#else
+	auto* semaphore = new sem_t;
+	sem_init(semaphore, 0, 0);
+	handle = semaphore;
+#endif
+}
+
+/**
+ * Implementation of a destructor for RealtimeWorkerPool::WakeSemaphore
+ *
+ * Destroys the semaphore
+ *
+ */
+RealtimeWorkerPool::WakeSemaphore::~WakeSemaphore()
+{
+#if JUCE_MAC || JUCE_IOS
+	dispatch_release((dispatch_semaphore_t)handle);
+#elif JUCE_WINDOWS
+	CloseHandle((HANDLE)handle);
+#else
+	sem_destroy((sem_t*)handle);
+	delete (sem_t*)handle;
+#endif
+}
+
+/**
+ * Implementation of post method for RealtimeWorkerPool::WakeSemaphore
+ *
+ * Only enters the kernel if a thread is waiting, and never takes a user space lock
+ *
+ */
+void RealtimeWorkerPool::WakeSemaphore::post() {
+#if JUCE_MAC || JUCE_IOS
+	dispatch_semaphore_signal((dispatch_semaphore_t)handle);
+#elif JUCE_WINDOWS
+	ReleaseSemaphore((HANDLE)handle, 1, nullptr);
+#else
+	sem_post((sem_t*)handle);
+#endif
+}
+
+/**
+ * Implementation of wait method for RealtimeWorkerPool::WakeSemaphore
+ *
+ * Waits without a timeout, retrying a POSIX wait interrupted by a signal
+ *
+ */
+void RealtimeWorkerPool::WakeSemaphore::wait() {
+#if JUCE_MAC || JUCE_IOS
+	dispatch_semaphore_wait((dispatch_semaphore_t)handle, DISPATCH_TIME_FOREVER);
+#elif JUCE_WINDOWS
+	WaitForSingleObject((HANDLE)handle, INFINITE);
+#else
+	while (sem_wait((sem_t*)handle) != 0 && errno == EINTR) {
+	}
+#endif
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for RealtimeWorkerPool::Worker
+ *
+ * Names the thread and saves the pool.
+ *
+ */
+RealtimeWorkerPool::Worker::Worker(RealtimeWorkerPool& _pool)
+	: juce::Thread("RealtimeWorkerPool worker"), pool(_pool)
+{
+}
+
+/**
+ * Implementation of run method for RealtimeWorkerPool::Worker
+ *
+ * Polls the batch number for a while after each batch, as the next one usually follows
+ * within a callback. If none arrives it announces it is sleeping, checks once more and
+ * waits to be posted. A new batch is worked on until no task is left to claim.
+ *
+ */
+void RealtimeWorkerPool::Worker::run() {
+	juce::uint32 seen = pool.batchNumber.load();
+
+	while (!threadShouldExit()) {
+		for (auto spins = 0; spins < spinCount && pool.batchNumber.load() == seen; ++spins) {
+		}
+
+		if (pool.batchNumber.load() == seen) {
+			sleeping = true;
+			if (pool.batchNumber.load() == seen && !threadShouldExit()) {
+				wakeUp.wait();
+			}
+			sleeping = false;
+			continue;
+		}
+
+		seen = pool.batchNumber.load();
+		juce::ScopedNoDenormals noDenormals;
+		pool.runTasks(seen);
+	}
+}
+
+//==============================================================================
@@ -0,0 +1,184 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "RealtimeSafetyChecker.h"
+
+//==============================================================================
+
+/**
+ * Definition of a RealtimeWorkerPool
+ *
+ * A fixed set of real-time priority worker threads, started up front, that help the
+ * audio thread run a batch of independent tasks. run publishes the batch, the calling
+ * thread works on it alongside the workers and returns once every task has finished,
+ * or once its deadline passes with only tasks already taken by workers left. Tasks are
+ * plain function pointers with a context, so publishing a batch never allocates or locks.
+ * Idle workers spin briefly for the next batch, which usually arrives within one
+ * audio callback, then sleep on a semaphore whose post does not take a lock.
+ *
+ */
+class RealtimeWorkerPool {
+public:
+
+	/// Task run by the pool, called with the context passed to run and the index of the task
+	using Task = void (*)(void* context, int index);
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for RealtimeWorkerPool, starts the worker threads at real-time priority,
+		* or at the highest normal priority where that is not allowed.
+		*
+		* @param Number of worker threads besides the calling thread, 0 runs every task on the calling thread
+	*/
+	RealtimeWorkerPool(int numWorkers);
+
+	/**
+		* Class destructor for RealtimeWorkerPool, stops the worker threads.
+	*/
+	~RealtimeWorkerPool();
+
+	//==============================================================================
+
+	/**
+		* @return Number of worker threads besides the calling thread
+	*/
+	int getNumWorkers() const;
+
+	/**
+		* Runs a batch of tasks on the calling thread and the workers, returning once all have finished
+		* or the deadline has passed. The calling thread runs every task no worker has taken, so on a
+		* missed deadline only tasks taken by workers are left running, and they finish on their own.
+		* Only called from one thread at a time.
+		*
+		* @param Task to run
+		* @param Context passed to every call of the task
+		* @param Number of calls, with indices from 0 to numTasks - 1
+		* @param juce::Time::getHighResolutionTicks value to stop waiting at, 0 to wait for every task
+		* @return True if every task has finished
+	*/
+	bool run(Task task, void* context, int numTasks, juce::int64 deadlineTicks = 0);
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+	 * A counting semaphore on the platform's own primitive, posted from the audio thread
+	 * without taking a lock, unlike a juce::WaitableEvent
+	 */
+	class WakeSemaphore {
+	public:
+
+		/**
+			* Class Constructor for WakeSemaphore, creates the semaphore with a count of 0.
+		*/
+		WakeSemaphore();
+
+		/**
+			* Class destructor for WakeSemaphore, destroys the semaphore.
+		*/
+		~WakeSemaphore();
+
+		/**
+			* Increments the count, waking a waiting thread
+		*/
+		void post();
+
+		/**
+			* Waits until the count is above 0, then decrements it
+		*/
+		void wait();
+
+	private:
+
+		/// Platform semaphore
+		void* handle = nullptr;
+
+		JUCE_DECLARE_NON_COPYABLE(WakeSemaphore)
+	};
+
+	//==============================================================================
+
+	/**
+	 * A thread that claims tasks of each batch until none are left
+	 */
+	class Worker : public juce::Thread {
+	public:
+
+		/**
+			* Class Constructor for Worker, initializes member variables.
+			*
+			* @param Pool the worker takes tasks from
+		*/
+		Worker(RealtimeWorkerPool& pool);
+
+		/**
+			* Spins, then sleeps, until a new batch is published, then works on it
+		*/
+		void run() override;
+
+		/// Posted by the pool when a batch is published while the worker sleeps, or on shutdown
+		WakeSemaphore wakeUp;
+
+		/// Flags if the worker is about to sleep or sleeping
+		std::atomic<bool> sleeping{ false };
+
+	private:
+
+		/// Pool the worker takes tasks from
+		RealtimeWorkerPool& pool;
+	};
+
+	//==============================================================================
+
+	/**
+		* Claims and runs tasks of a batch until none are left
+		*
+		* @param Batch the caller saw published, claims fail once another batch replaces it
+	*/
+	void runTasks(juce::uint32 batch);
+
+	/**
+		* Counts a finished task, unless its batch has been replaced since
+		*
+		* @param Batch the task belongs to
+	*/
+	void completeTask(juce::uint32 batch);
+
+	//==============================================================================
+
+	/// Number of polls an idle worker spins for before it sleeps
+	static constexpr int spinCount = 4000;
+
+	/// Worker threads
+	juce::OwnedArray<Worker> workers;
+
+	/// Task of the current batch, read before a task is claimed so a claim never pairs it with another batch
+	std::atomic<Task> currentTask{ nullptr };
+
+	/// Context of the current batch, read before a task is claimed
+	std::atomic<void*> currentContext{ nullptr };
+
+	/// Flags if the current batch was run from a real-time section, so the workers run it in one too
+	std::atomic<bool> currentRealtime{ false };
+
+	/// Number of tasks in the current batch
+	std::atomic<int> currentNumTasks{ 0 };
+
+	/// Number of the current batch, incremented by run
+	std::atomic<juce::uint32> batchNumber{ 0 };
+
+	/// Batch number in the upper 32 bits and next unclaimed task index in the lower 32 bits
+	std::atomic<juce::uint64> claimState{ 0 };
+
+	/// Batch number in the upper 32 bits and number of its finished tasks in the lower 32 bits,
+	/// so a task of an abandoned batch finishing late is not counted for the next one
+	std::atomic<juce::uint64> completionState{ 0 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeWorkerPool)
+};
@@ -0,0 +1,49 @@
+
+#include "SampleMath.h"
+
+//==============================================================================
+
+/**
+ * Implementation of dotProduct method for SampleMath
+ *
+ * Multiplies into eight lane accumulators, pairs them up once the runs are consumed and
+ * adds the tail to the total.
+ *
+ */
+float SampleMath::dotProduct(const float* a, const float* b, int numSamples) {
+	float sums[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	int i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		for (auto lane = 0; lane < 8; ++lane) {
+			sums[lane] += a[i + lane] * b[i + lane];
+		}
+	}
+	float sum = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+	for (; i < numSamples; ++i) {
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+/**
+ * Implementation of sumOfSquares method for SampleMath
+ *
+ * Squares into eight lane accumulators the same way as dotProduct, reading each sample once.
+ *
+ */
+float SampleMath::sumOfSquares(const float* samples, int numSamples) {
+	float sums[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	int i = 0;
+	for (; i + 8 <= numSamples; i += 8) {
+		for (auto lane = 0; lane < 8; ++lane) {
+			sums[lane] += samples[i + lane] * samples[i + lane];
+		}
+	}
+	float sum = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+	for (; i < numSamples; ++i) {
+		sum += samples[i] * samples[i];
+	}
+	return sum;
+}
+
+//==============================================================================
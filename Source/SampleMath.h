@@ -0,0 +1,40 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+
+/**
+ * Definition of SampleMath
+ *
+ * Reductions over runs of samples shared across the audio code, which
+ * juce::FloatVectorOperations does not provide. Each keeps eight independent partial
+ * sums, so the compiler can keep them in vector registers, and adds the tail a sample
+ * at a time.
+ *
+ */
+class SampleMath {
+public:
+
+	//==============================================================================
+
+	/**
+		* Dot product of two runs of samples
+		*
+		* @param First run
+		* @param Second run
+		* @param Number of samples
+		* @return Sum of the products
+	*/
+	static float dotProduct(const float* a, const float* b, int numSamples);
+
+	/**
+		* Sum of the squares of a run of samples
+		*
+		* @param Samples to sum
+		* @param Number of samples
+		* @return Sum of the squared samples
+	*/
+	static float sumOfSquares(const float* samples, int numSamples);
+};
@@ -0,0 +1,256 @@
+
+#include "ScratchAudioSource.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for ScratchAudioSource
+ *
+ * Rounds the ring buffer up to a power of two so a file position maps to its slot with
+ * a mask, and allocates both copies of it.
+ *
+ */
+ScratchAudioSource::ScratchAudioSource(juce::AudioFormatReader* scratchReader, juce::TimeSliceThread& thread, double cacheSeconds)
+	: reader(scratchReader), backgroundThread(thread),
+	ringSize(juce::nextPowerOfTwo(juce::jmax(4 * decodeChunk, (int)(cacheSeconds * scratchReader->sampleRate))))
+{
+	for (auto& window : windows) {
+		window.ring.setSize(2, ringSize);
+	}
+	decodeBuffer.setSize(2, decodeChunk);
+}
+
+/**
+ * Implementation of a destructor for ScratchAudioSource
+ *
+ * Detaches from the decode thread before the ring buffer and reader are freed.
+ *
+ */
+ScratchAudioSource::~ScratchAudioSource()
+{
+	backgroundThread.removeTimeSliceClient(this);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setPlayhead method for ScratchAudioSource
+ *
+ * Stores the position the ring buffer is filled around.
+ *
+ */
+void ScratchAudioSource::setPlayhead(juce::int64 newPosition) {
+	centre.store(newPosition, std::memory_order_relaxed);
+}
+
+/**
+ * Implementation of begin method for ScratchAudioSource
+ *
+ * Places the scratch at the playhead, moving at the velocity the record had.
+ *
+ */
+void ScratchAudioSource::begin(double newPosition, double newVelocity) {
+	position = newPosition;
+	velocity = newVelocity;
+	targetVelocity = newVelocity;
+	centre.store((juce::int64)newPosition, std::memory_order_relaxed);
+}
+
+/**
+ * Implementation of setVelocity method for ScratchAudioSource
+ *
+ * Sets the targetVelocity data member.
+ *
+ */
+void ScratchAudioSource::setVelocity(double newVelocity) {
+	targetVelocity = newVelocity;
+}
+
+/**
+ * Implementation of getPosition method for ScratchAudioSource
+ *
+ * Returns the position data member.
+ *
+ */
+double ScratchAudioSource::getPosition() const {
+	return position;
+}
+
+/**
+ * Implementation of getFileSampleRate method for ScratchAudioSource
+ *
+ * Returns the sample rate of the reader.
+ *
+ */
+double ScratchAudioSource::getFileSampleRate() const {
+	return reader->sampleRate;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for ScratchAudioSource
+ *
+ * Works out the step at normal playback and a velocity smoothing of about 10 ms
+ * for the output sample rate, and attaches to the decode thread.
+ *
+ */
+void ScratchAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	step = reader->sampleRate / sampleRate;
+	smoothing = 1.0 - std::exp(-1.0 / (0.01 * sampleRate));
+	if (!isPrepared) {
+		backgroundThread.addTimeSliceClient(this);
+		isPrepared = true;
+	}
+}
+
+/**
+ * Implementation of releaseResources method for ScratchAudioSource
+ *
+ * Detaches from the decode thread.
+ *
+ */
+void ScratchAudioSource::releaseResources() {
+	if (isPrepared) {
+		backgroundThread.removeTimeSliceClient(this);
+		isPrepared = false;
+	}
+}
+
+/**
+ * Implementation of getNextAudioBlock method for ScratchAudioSource
+ *
+ * For every output sample the velocity moves a step towards its target, and the four
+ * ring samples around the position are combined with a Catmull-Rom spline. Positions
+ * outside the cached range play silence. The gain follows the speed below a tenth of
+ * normal playback, so the sound dies away as the record stops instead of holding a
+ * level. The position stays within the file and is handed back as the ring's centre.
+ * The front window is picked and flagged busy in one atomic operation, so the decode
+ * thread cannot swap it away before the flag is cleared at the end of the block.
+ *
+ */
+void ScratchAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	auto* buffer = bufferToFill.buffer;
+	const int numChannels = buffer->getNumChannels();
+	const int mask = ringSize - 1;
+	const double lastPosition = (double)juce::jmax((juce::int64)0, reader->lengthInSamples - 1);
+	double pos = position;
+
+	const Window& window = windows[windowState.fetch_or(busyBit, std::memory_order_acquire) & frontBit];
+	const float* ringData[2] = { window.ring.getReadPointer(0), window.ring.getReadPointer(1) };
+	for (auto i = 0; i < bufferToFill.numSamples; ++i) {
+		velocity += (targetVelocity - velocity) * smoothing;
+
+		const juce::int64 index = (juce::int64)std::floor(pos);
+		float out[2] = { 0, 0 };
+		if (index - 1 >= window.start && index + 2 < window.end) {
+			const float t = (float)(pos - (double)index);
+			const float gain = (float)juce::jmin(1.0, std::abs(velocity) * 10.0);
+			for (auto ch = 0; ch < 2; ++ch) {
+				const float y0 = ringData[ch][(index - 1) & mask];
+				const float y1 = ringData[ch][index & mask];
+				const float y2 = ringData[ch][(index + 1) & mask];
+				const float y3 = ringData[ch][(index + 2) & mask];
+				const float a = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+				const float b = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+				const float c = 0.5f * (y2 - y0);
+				out[ch] = gain * (((a * t + b) * t + c) * t + y1);
+			}
+		}
+		for (auto ch = 0; ch < numChannels; ++ch) {
+			buffer->setSample(ch, bufferToFill.startSample + i, out[juce::jmin(ch, 1)]);
+		}
+
+		pos = juce::jlimit(0.0, lastPosition, pos + velocity * step);
+	}
+
+	windowState.fetch_and(~busyBit, std::memory_order_release);
+
+	position = pos;
+	centre.store((juce::int64)pos, std::memory_order_relaxed);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of useTimeSlice method for ScratchAudioSource
+ *
+ * Keeps half the ring on each side of the centre. A centre outside the cached range
+ * empties it there. The next chunk is decoded ahead of the centre until a couple of
+ * chunks are ready, then behind it, then the rest of each side, dropping the far end of
+ * the other side if the ring is full. The chunk goes into the back window, which is then
+ * swapped to the front as soon as the audio thread is not reading, at most a block
+ * later, and finally into the window that became the back one so both stay the same.
+ *
+ */
+int ScratchAudioSource::useTimeSlice() {
+	const juce::int64 length = reader->lengthInSamples;
+	const juce::int64 c = juce::jlimit((juce::int64)0, length, centre.load(std::memory_order_relaxed));
+	const juce::int64 wantStart = juce::jmax((juce::int64)0, c - ringSize / 2);
+	const juce::int64 wantEnd = juce::jmin(length, c + ringSize / 2);
+
+	if (c < cacheStart || c > cacheEnd) {
+		cacheStart = cacheEnd = c;
+	}
+
+	const juce::int64 minimumReady = 2 * decodeChunk;
+	bool forward;
+	if (cacheEnd < wantEnd && cacheEnd - c < minimumReady) {
+		forward = true;
+	}
+	else if (cacheStart > wantStart && c - cacheStart < minimumReady) {
+		forward = false;
+	}
+	else if (cacheEnd < wantEnd) {
+		forward = true;
+	}
+	else if (cacheStart > wantStart) {
+		forward = false;
+	}
+	else {
+		return 20;
+	}
+
+	const int numSamples = (int)(forward ? juce::jmin((juce::int64)decodeChunk, wantEnd - cacheEnd) : juce::jmin((juce::int64)decodeChunk, cacheStart - wantStart));
+	const juce::int64 from = forward ? cacheEnd : cacheStart - numSamples;
+	reader->read(&decodeBuffer, 0, numSamples, from, true, true);
+
+	if (forward) {
+		cacheEnd = from + numSamples;
+		cacheStart = juce::jmax(cacheStart, cacheEnd - ringSize);
+	}
+	else {
+		cacheStart = from;
+		cacheEnd = juce::jmin(cacheEnd, cacheStart + ringSize);
+	}
+
+	const int front = windowState.load(std::memory_order_relaxed) & frontBit;
+	writeChunk(windows[1 - front], from, numSamples);
+	int expected = front;
+	while (!windowState.compare_exchange_weak(expected, 1 - front, std::memory_order_acq_rel)) {
+		expected = front;
+		juce::Thread::yield();
+	}
+	writeChunk(windows[front], from, numSamples);
+	return 1;
+}
+
+/**
+ * Implementation of writeChunk method for ScratchAudioSource
+ *
+ * Copies the decoded chunk into the window's ring, wrapping around its end, and gives
+ * the window the current cached range.
+ *
+ */
+void ScratchAudioSource::writeChunk(Window& window, juce::int64 from, int numSamples) {
+	const int slot = (int)(from & (ringSize - 1));
+	const int firstPart = juce::jmin(numSamples, ringSize - slot);
+	for (auto ch = 0; ch < 2; ++ch) {
+		window.ring.copyFrom(ch, slot, decodeBuffer, ch, 0, firstPart);
+		window.ring.copyFrom(ch, 0, decodeBuffer, ch, firstPart, numSamples - firstPart);
+	}
+	window.start = cacheStart;
+	window.end = cacheEnd;
+}
+
+//==============================================================================
@@ -0,0 +1,196 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+
+/**
+ * Definition of a ScratchAudioSource
+ *
+ * An AudioSource that plays a file at any rate, backwards included, the way a record
+ * moves under the hand. A ring buffer of decoded audio is kept on both sides of the
+ * playhead by a background juce::TimeSliceThread with a reader of its own, filled
+ * ahead first and then behind, so a scratch can start at once and run either way.
+ * The ring is double buffered: the audio thread reads the front copy, flagging it busy
+ * for the length of a block, while the background thread writes each chunk into the
+ * back copy, swaps the two with a compare and swap once the audio thread is not
+ * reading and then writes the same chunk into the new back copy, so neither ever waits
+ * for the other.
+ * While scratching, each output sample is read between samples of the ring with
+ * cubic interpolation, stepping by the velocity, which follows its target smoothly.
+ * The output fades out as the velocity drops to zero, like a stopped record.
+ *
+ */
+class ScratchAudioSource : public juce::AudioSource,
+	private juce::TimeSliceClient
+{
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for ScratchAudioSource, allocates the ring buffer.
+		*
+		* @param Reader of the file used only to fill the ring buffer, owned
+		* @param juce::TimeSliceThread that fills the ring buffer
+		* @param Seconds of audio kept in the ring buffer, half of it on each side of the playhead
+	*/
+	ScratchAudioSource(juce::AudioFormatReader* scratchReader, juce::TimeSliceThread& thread, double cacheSeconds = 12.0);
+
+	/**
+		* Class destructor for ScratchAudioSource, detaches from the decode thread.
+	*/
+	~ScratchAudioSource() override;
+
+	//==============================================================================
+
+	/**
+		* Moves the centre of the ring buffer along with normal playback. Only called from the audio thread while not scratching.
+		*
+		* @param Playhead in samples of the file
+	*/
+	void setPlayhead(juce::int64 position);
+
+	/**
+		* Starts a scratch. Only called from the audio thread.
+		*
+		* @param Playhead in samples of the file
+		* @param Velocity the record was moving at, 1 for normal playback
+	*/
+	void begin(double position, double velocity);
+
+	/**
+		* Sets the velocity the scratch moves towards. Only called from the audio thread.
+		*
+		* @param Velocity relative to normal playback, negative to play backwards
+	*/
+	void setVelocity(double velocity);
+
+	/**
+		* @return Scratch position in samples of the file
+	*/
+	double getPosition() const;
+
+	/**
+		* @return Number of samples per second of the file
+	*/
+	double getFileSampleRate() const;
+
+	//==============================================================================
+
+	/**
+		* Stores the output sample rate and attaches to the decode thread
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Detaches from the decode thread
+	*/
+	void releaseResources() override;
+
+	/**
+		* Renders the block from the ring buffer at the scratch velocity
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Called by the decode thread to decode the next chunk around the playhead
+		*
+		* @return Number of milliseconds before the decode thread should call again
+	*/
+	int useTimeSlice() override;
+
+	//==============================================================================
+
+	/// A copy of the ring buffer and the range of the file it holds
+	struct Window {
+		/// Decoded samples, indexed by file position modulo the ring size
+		juce::AudioBuffer<float> ring;
+
+		/// First file position held in the ring
+		juce::int64 start = 0;
+
+		/// File position after the last one held in the ring
+		juce::int64 end = 0;
+	};
+
+	/**
+		* Copies a decoded chunk into a window and sets its range. Only called from the decode thread.
+		*
+		* @param Window to write, not read by the audio thread
+		* @param File position of the chunk
+		* @param Number of samples in the chunk
+	*/
+	void writeChunk(Window& window, juce::int64 from, int numSamples);
+
+	//==============================================================================
+
+	/// Number of samples decoded at a time
+	static constexpr int decodeChunk = 8192;
+
+	/// Bit of windowState holding the index of the window the audio thread reads
+	static constexpr int frontBit = 1;
+
+	/// Bit of windowState set while the audio thread reads the front window
+	static constexpr int busyBit = 2;
+
+	/// Reader filling the ring buffer
+	std::unique_ptr<juce::AudioFormatReader> reader;
+
+	/// Background thread that fills the ring buffer
+	juce::TimeSliceThread& backgroundThread;
+
+	/// Front and back copies of the ring buffer
+	Window windows[2];
+
+	/// Index of the front window and the busy flag of the audio thread
+	std::atomic<int> windowState{ 0 };
+
+	/// Number of samples in the ring buffer, a power of two
+	int ringSize;
+
+	/// Chunk decoded by the background thread before it is copied into the ring
+	juce::AudioBuffer<float> decodeBuffer;
+
+	/// First file position held in both windows, only used by the decode thread
+	juce::int64 cacheStart = 0;
+
+	/// File position after the last one held in both windows, only used by the decode thread
+	juce::int64 cacheEnd = 0;
+
+	/// Position the ring buffer is kept around, written by the audio thread
+	std::atomic<juce::int64> centre{ 0 };
+
+	/// Scratch position in samples of the file
+	std::atomic<double> position{ 0 };
+
+	/// Current velocity relative to normal playback
+	double velocity = 0;
+
+	/// Velocity the current one moves towards
+	double targetVelocity = 0;
+
+	/// Portion of the way to the target velocity covered each output sample
+	double smoothing = 1;
+
+	/// File samples per output sample at normal playback
+	double step = 1;
+
+	/// Flags if the source is prepared and attached to the decode thread
+	bool isPrepared = false;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScratchAudioSource)
+};
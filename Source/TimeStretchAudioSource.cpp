@@ -0,0 +1,300 @@
+
+#include "TimeStretchAudioSource.h"
+#include "SampleMath.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for TimeStretchAudioSource
+ *
+ * Saves the input source, buffers are allocated in prepareToPlay.
+ *
+ */
+TimeStretchAudioSource::TimeStretchAudioSource(juce::AudioSource* _input, bool deleteInputWhenDeleted)
+	: input(_input, deleteInputWhenDeleted)
+{
+	jassert(_input != nullptr);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of setEnabled method for TimeStretchAudioSource
+ *
+ * Sets the enabled data member, resetting the buffers when it changes
+ * so no stale frames are played when the stretcher is switched back on.
+ *
+ */
+void TimeStretchAudioSource::setEnabled(bool shouldBeEnabled) {
+	if (enabled != shouldBeEnabled) {
+		enabled = shouldBeEnabled;
+		reset();
+	}
+}
+
+/**
+ * Implementation of isEnabled method for TimeStretchAudioSource
+ *
+ * Returns the enabled data member
+ *
+ */
+bool TimeStretchAudioSource::isEnabled() const {
+	return enabled;
+}
+
+/**
+ * Implementation of setTempo method for TimeStretchAudioSource
+ *
+ * Sets the tempo data member, applied from the next frame
+ *
+ */
+void TimeStretchAudioSource::setTempo(double newTempo) {
+	tempo = juce::jlimit(0.25, 4.0, newTempo);
+}
+
+/**
+ * Implementation of requestReset method for TimeStretchAudioSource
+ *
+ * Sets the resetPending flag for the audio thread
+ *
+ */
+void TimeStretchAudioSource::requestReset() {
+	resetPending = true;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of prepareToPlay method for TimeStretchAudioSource
+ *
+ * Works out frame, hop and search lengths for the sample rate, rounded so the hop
+ * divides evenly into the coarse search, builds the Hann window and allocates every
+ * buffer used on the audio thread.
+ *
+ */
+void TimeStretchAudioSource::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
+	input->prepareToPlay(samplesPerBlockExpected, sampleRate);
+
+	frameLength = juce::jmax(16 * coarseFactor, ((int)(sampleRate * 0.04) / (2 * coarseFactor)) * 2 * coarseFactor);
+	synthesisHop = frameLength / 2;
+	searchRange = juce::jmax(coarseFactor, ((int)(sampleRate * 0.01) / coarseFactor) * coarseFactor);
+
+	window.allocate((size_t)frameLength, false);
+	for (auto i = 0; i < frameLength; ++i) {
+		window[i] = 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * (float)i / (float)frameLength));
+	}
+
+	const int searchWindow = frameLength + 2 * searchRange;
+	inputBuffer.setSize(2, 3 * searchWindow + 2 * samplesPerBlockExpected);
+	overlapBuffer.setSize(2, frameLength);
+	outputBuffer.setSize(2, synthesisHop);
+
+	coarseCandidates.allocate((size_t)((2 * searchRange + synthesisHop) / coarseFactor + 1), false);
+	coarseTarget.allocate((size_t)(synthesisHop / coarseFactor + 1), false);
+	fineCandidates.allocate((size_t)(2 * coarseFactor + synthesisHop), false);
+	fineTarget.allocate((size_t)synthesisHop, false);
+
+	reset();
+}
+
+/**
+ * Implementation of releaseResources method for TimeStretchAudioSource
+ *
+ * Calls releaseResources on the input source
+ *
+ */
+void TimeStretchAudioSource::releaseResources() {
+	input->releaseResources();
+}
+
+/**
+ * Implementation of getNextAudioBlock method for TimeStretchAudioSource
+ *
+ * Passes the input straight through when disabled. Otherwise copies finished output,
+ * synthesising a new hop whenever the previous one has been used up.
+ *
+ */
+void TimeStretchAudioSource::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) {
+	if (resetPending.exchange(false)) {
+		reset();
+	}
+
+	if (!enabled || frameLength == 0) {
+		input->getNextAudioBlock(bufferToFill);
+		return;
+	}
+
+	int done = 0;
+	while (done < bufferToFill.numSamples) {
+		if (outputReady == 0) {
+			processHop();
+		}
+		const int numSamples = juce::jmin(outputReady, bufferToFill.numSamples - done);
+		for (auto chan = 0; chan < bufferToFill.buffer->getNumChannels(); ++chan) {
+			bufferToFill.buffer->copyFrom(chan, bufferToFill.startSample + done, outputBuffer, juce::jmin(chan, 1), outputReadPosition, numSamples);
+		}
+		done += numSamples;
+		outputReadPosition += numSamples;
+		outputReady -= numSamples;
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of reset method for TimeStretchAudioSource
+ *
+ * Drops the buffered input and output. The next input sample read becomes absolute position 0.
+ *
+ */
+void TimeStretchAudioSource::reset() {
+	inputStart = 0;
+	inputEnd = 0;
+	analysisPosition = 0;
+	previousFramePosition = 0;
+	hasPreviousFrame = false;
+	overlapBuffer.clear();
+	outputReadPosition = 0;
+	outputReady = 0;
+}
+
+/**
+ * Implementation of processHop method for TimeStretchAudioSource
+ *
+ * Makes sure the search region and the continuation of the previous frame are buffered,
+ * picks the frame start, adds the windowed frame to the overlap buffer and moves the
+ * first hop of the overlap buffer, which no later frame touches, to the output.
+ *
+ */
+void TimeStretchAudioSource::processHop() {
+	const auto nominalPosition = (juce::int64)std::llround(analysisPosition);
+	pullInput(juce::jmax(nominalPosition + searchRange + frameLength, previousFramePosition + frameLength));
+
+	const auto framePosition = nominalPosition + (hasPreviousFrame ? findBestOffset(nominalPosition) : 0);
+	const int frameIndex = (int)(framePosition - inputStart);
+
+	for (auto chan = 0; chan < 2; ++chan) {
+		juce::FloatVectorOperations::addWithMultiply(overlapBuffer.getWritePointer(chan), inputBuffer.getReadPointer(chan, frameIndex), window.get(), frameLength);
+		outputBuffer.copyFrom(chan, 0, overlapBuffer, chan, 0, synthesisHop);
+		overlapBuffer.copyFrom(chan, 0, overlapBuffer, chan, synthesisHop, frameLength - synthesisHop);
+		overlapBuffer.clear(chan, frameLength - synthesisHop, synthesisHop);
+	}
+
+	outputReadPosition = 0;
+	outputReady = synthesisHop;
+	previousFramePosition = framePosition;
+	hasPreviousFrame = true;
+	analysisPosition += tempo * synthesisHop;
+}
+
+/**
+ * Implementation of pullInput method for TimeStretchAudioSource
+ *
+ * Discards input that no future frame or search can reach by moving the rest to the
+ * start of the buffer, then reads the input in blocks until the position is buffered.
+ *
+ */
+void TimeStretchAudioSource::pullInput(juce::int64 endPosition) {
+	const int pullSize = 512;
+	while (inputEnd < endPosition) {
+		if (inputEnd - inputStart + pullSize > inputBuffer.getNumSamples()) {
+			auto keepFrom = (juce::int64)std::floor(analysisPosition) - searchRange;
+			if (hasPreviousFrame) {
+				keepFrom = juce::jmin(keepFrom, previousFramePosition + synthesisHop);
+			}
+			keepFrom = juce::jlimit(inputStart, inputEnd, keepFrom);
+			const int shift = (int)(keepFrom - inputStart);
+			const int remaining = (int)(inputEnd - keepFrom);
+			for (auto chan = 0; chan < 2; ++chan) {
+				auto* data = inputBuffer.getWritePointer(chan);
+				std::memmove(data, data + shift, (size_t)remaining * sizeof(float));
+			}
+			inputStart = keepFrom;
+		}
+
+		const int numSamples = juce::jmin(pullSize, inputBuffer.getNumSamples() - (int)(inputEnd - inputStart));
+		jassert(numSamples > 0);
+		juce::AudioSourceChannelInfo info(&inputBuffer, (int)(inputEnd - inputStart), numSamples);
+		input->getNextAudioBlock(info);
+		inputEnd += numSamples;
+	}
+}
+
+/**
+ * Implementation of findBestOffset method for TimeStretchAudioSource
+ *
+ * The target is the input that naturally followed the previous frame over the length
+ * the new frame overlaps it. A coarse search compares every fourth offset on a mono
+ * signal decimated by four, then the offsets around the best coarse match are compared
+ * at full rate. Matches are scored by correlation over the candidate's energy so loud
+ * candidates are not favoured.
+ *
+ */
+int TimeStretchAudioSource::findBestOffset(juce::int64 nominalPosition) {
+	const float* left = inputBuffer.getReadPointer(0);
+	const float* right = inputBuffer.getReadPointer(1);
+	const auto targetIndex = (int)(previousFramePosition + synthesisHop - inputStart);
+	const int overlapLength = frameLength - synthesisHop;
+	const int lowest = juce::jmax(-searchRange, (int)(inputStart - nominalPosition));
+	const int highest = searchRange;
+	const auto regionIndex = (int)(nominalPosition - inputStart) + lowest;
+
+	const int numCoarseTarget = overlapLength / coarseFactor;
+	const int numCoarseCandidates = (highest - lowest + overlapLength) / coarseFactor;
+	for (auto i = 0; i < numCoarseTarget; ++i) {
+		float sum = 0;
+		for (auto k = 0; k < coarseFactor; ++k) {
+			const int index = targetIndex + i * coarseFactor + k;
+			sum += left[index] + right[index];
+		}
+		coarseTarget[i] = sum;
+	}
+	for (auto i = 0; i < numCoarseCandidates; ++i) {
+		float sum = 0;
+		for (auto k = 0; k < coarseFactor; ++k) {
+			const int index = regionIndex + i * coarseFactor + k;
+			sum += left[index] + right[index];
+		}
+		coarseCandidates[i] = sum;
+	}
+
+	float energy = SampleMath::dotProduct(coarseCandidates.get(), coarseCandidates.get(), numCoarseTarget);
+	float bestScore = -std::numeric_limits<float>::max();
+	int bestOffset = lowest;
+	for (auto c = 0; c + numCoarseTarget <= numCoarseCandidates; ++c) {
+		if (c > 0) {
+			const float leaving = coarseCandidates[c - 1];
+			const float entering = coarseCandidates[c + numCoarseTarget - 1];
+			energy = juce::jmax(0.0f, energy - leaving * leaving + entering * entering);
+		}
+		const float score = SampleMath::dotProduct(coarseCandidates.get() + c, coarseTarget.get(), numCoarseTarget) / std::sqrt(energy + 1.0e-9f);
+		if (score > bestScore) {
+			bestScore = score;
+			bestOffset = lowest + c * coarseFactor;
+		}
+	}
+
+	const int fineLowest = juce::jmax(lowest, bestOffset - (coarseFactor - 1));
+	const int fineHighest = juce::jmin(highest, bestOffset + (coarseFactor - 1));
+	const auto fineIndex = (int)(nominalPosition - inputStart) + fineLowest;
+	for (auto i = 0; i < overlapLength; ++i) {
+		fineTarget[i] = left[targetIndex + i] + right[targetIndex + i];
+	}
+	for (auto i = 0; i < fineHighest - fineLowest + overlapLength; ++i) {
+		fineCandidates[i] = left[fineIndex + i] + right[fineIndex + i];
+	}
+
+	bestScore = -std::numeric_limits<float>::max();
+	for (auto offset = fineLowest; offset <= fineHighest; ++offset) {
+		const float* candidate = fineCandidates.get() + (offset - fineLowest);
+		const float score = SampleMath::dotProduct(candidate, fineTarget.get(), overlapLength) / std::sqrt(SampleMath::dotProduct(candidate, candidate, overlapLength) + 1.0e-9f);
+		if (score > bestScore) {
+			bestScore = score;
+			bestOffset = offset;
+		}
+	}
+
+	return bestOffset;
+}
+
+//==============================================================================
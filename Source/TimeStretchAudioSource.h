@@ -0,0 +1,186 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+
+/**
+ * Definition of a TimeStretchAudioSource
+ *
+ * An AudioSource that changes the tempo of its input without changing its pitch,
+ * using waveform similarity overlap-add (WSOLA). Output is built from Hann windowed
+ * frames of about 40 ms overlapping by half. Each frame is read from the input at the
+ * tempo scaled position, shifted by up to 10 ms to the offset that best continues the
+ * previous frame, found with a coarse search on a decimated signal refined at full rate.
+ * All buffers are allocated in prepareToPlay. When disabled the input passes straight through.
+ *
+ */
+class TimeStretchAudioSource : public juce::AudioSource {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for TimeStretchAudioSource, initializes member variables.
+		*
+		* @param AudioSource to stretch
+		* @param True if the input should be deleted with this source
+	*/
+	TimeStretchAudioSource(juce::AudioSource* input, bool deleteInputWhenDeleted);
+
+	//==============================================================================
+
+	/**
+		* Enables or bypasses the stretcher, clearing its buffers when the state changes.
+		* Only called from the audio thread.
+		*
+		* @param True to stretch, false to pass the input through
+	*/
+	void setEnabled(bool shouldBeEnabled);
+
+	/**
+		* @return If the stretcher is enabled
+	*/
+	bool isEnabled() const;
+
+	/**
+		* Sets the tempo, 1 plays at the original speed. Only called from the audio thread.
+		*
+		* @param Ratio of output tempo to input tempo
+	*/
+	void setTempo(double newTempo);
+
+	/**
+		* Asks the audio thread to clear the buffered input before the next block,
+		* used after the input has been repositioned. Safe to call from any thread.
+	*/
+	void requestReset();
+
+	//==============================================================================
+
+	/**
+		* Allocates the frame, search and overlap buffers for the sample rate
+		*
+		* @param Expected samples in a block
+		* @param Number of samples per second
+	*/
+	void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override;
+
+	/**
+		* Releases the input source
+	*/
+	void releaseResources() override;
+
+	/**
+		* Fills the block from the overlap-add output, synthesising new frames as needed
+		*
+		* @param juce::AudioSourceChannelInfo&: Buffer to be filled by audio source
+	*/
+	void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override;
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Clears all buffered input and output and restarts the frame positions
+	*/
+	void reset();
+
+	/**
+		* Synthesises the next hop of output: picks the frame offset, then windows and overlap-adds the frame
+	*/
+	void processHop();
+
+	/**
+		* Pulls blocks from the input until the buffered input reaches a position
+		*
+		* @param Absolute input position that has to be buffered
+	*/
+	void pullInput(juce::int64 endPosition);
+
+	/**
+		* Finds the offset from the nominal frame position that best continues the previous frame
+		*
+		* @param Absolute nominal start of the frame
+		* @return Offset in samples
+	*/
+	int findBestOffset(juce::int64 nominalPosition);
+
+	//==============================================================================
+
+	/// Input source being stretched
+	juce::OptionalScopedPointer<juce::AudioSource> input;
+
+	/// Flags if the stretcher is enabled
+	bool enabled = false;
+
+	/// Ratio of output tempo to input tempo
+	double tempo = 1.0;
+
+	/// Set by requestReset, cleared by the audio thread
+	std::atomic<bool> resetPending{ false };
+
+	/// Frame length in samples
+	int frameLength = 0;
+
+	/// Synthesis hop in samples, half the frame length
+	int synthesisHop = 0;
+
+	/// Largest offset searched either side of the nominal frame position
+	int searchRange = 0;
+
+	/// Decimation factor of the coarse search
+	static constexpr int coarseFactor = 4;
+
+	/// Periodic Hann window of frameLength samples
+	juce::HeapBlock<float> window;
+
+	/// Stereo input buffer, sample 0 is at absolute position inputStart
+	juce::AudioBuffer<float> inputBuffer;
+
+	/// Absolute position of the first sample in inputBuffer
+	juce::int64 inputStart = 0;
+
+	/// Absolute position one past the last buffered input sample
+	juce::int64 inputEnd = 0;
+
+	/// Absolute nominal position of the next frame, advanced by tempo times the synthesis hop
+	double analysisPosition = 0;
+
+	/// Absolute start of the previous frame
+	juce::int64 previousFramePosition = 0;
+
+	/// Flags if a previous frame exists to continue from
+	bool hasPreviousFrame = false;
+
+	/// Overlap-add accumulator of frameLength samples
+	juce::AudioBuffer<float> overlapBuffer;
+
+	/// Finished output of one hop
+	juce::AudioBuffer<float> outputBuffer;
+
+	/// Read position in outputBuffer
+	int outputReadPosition = 0;
+
+	/// Number of samples left to read in outputBuffer
+	int outputReady = 0;
+
+	/// Decimated mono copy of the search region
+	juce::HeapBlock<float> coarseCandidates;
+
+	/// Decimated mono copy of the continuation of the previous frame
+	juce::HeapBlock<float> coarseTarget;
+
+	/// Mono copy of the search region at full rate
+	juce::HeapBlock<float> fineCandidates;
+
+	/// Mono copy of the continuation of the previous frame at full rate
+	juce::HeapBlock<float> fineTarget;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimeStretchAudioSource)
+};
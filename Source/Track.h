@@ -7,6 +7,7 @@
  *
  * A track object that is representative of a custom audio file,
  * containing a title string, song length double, url of audio file,
+ * the tempo, beatgrid and loudness found by the TrackAnalyser,
  * as well as a double to string conversion function of song lengths.
  *
  */
@@ -26,6 +27,18 @@ struct track {
 	/// Identity hash of track
 	juce::String identity;
 
+	/// Tempo in beats per minute, 0 until analysed and -1 if no tempo was found
+	double bpm = 0;
+
+	/// Time of the first beat of the beatgrid in seconds
+	double firstBeat = 0;
+
+	/// Integrated loudness in LUFS, 0 until analysed
+	double loudness = 0;
+
+	/// Highest level between samples in dBTP
+	double truePeak = 0;
+
 	//==============================================================================
 
 	/**
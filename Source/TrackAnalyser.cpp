@@ -0,0 +1,391 @@
+
+#include "TrackAnalyser.h"
+#include "SampleMath.h"
+#include <cmath>
+#include <cstring>
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for TrackAnalyser
+ *
+ * Uses up to two workers, leaving a core free for the audio thread, at a low priority.
+ *
+ */
+TrackAnalyser::TrackAnalyser(juce::AudioFormatManager& _formatManager)
+	: formatManager(_formatManager), threadPool(juce::jlimit(1, 2, juce::SystemStats::getNumCpus() - 1))
+{
+	threadPool.setThreadPriorities(2);
+}
+
+/**
+ * Implementation of a destructor for TrackAnalyser
+ *
+ * Wakes any throttled worker with the stopping flag and waits for the jobs to return.
+ *
+ */
+TrackAnalyser::~TrackAnalyser()
+{
+	stopping = true;
+	threadPool.removeAllJobs(true, 10000);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of analyse method for TrackAnalyser
+ *
+ * Adds a job that opens the file and analyses it. Between chunks the job gives up if
+ * the analyser is stopping, waits while it is throttled, and sleeps for half the time
+ * the chunk took. The result is posted back to the message thread, where it is dropped
+ * if the analyser was deleted in the meantime. A file that cannot be opened has no
+ * result: it is only taken off the queue, so it is tried again next time.
+ *
+ */
+void TrackAnalyser::analyse(const juce::File& file, Callback onFinished) {
+	const juce::String path = file.getFullPathName();
+	if (pendingFiles.contains(path)) {
+		return;
+	}
+	pendingFiles.add(path);
+	juce::WeakReference<TrackAnalyser> weakThis(this);
+
+	threadPool.addJob([this, weakThis, file, path, onFinished] {
+		Result result;
+		std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+		if (reader != nullptr) {
+			auto chunkTicks = juce::Time::getHighResolutionTicks();
+			auto keepGoing = [this, &chunkTicks] {
+				const double chunkMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - chunkTicks) * 1000.0;
+				juce::Thread::sleep(juce::jmax(1, juce::roundToInt(chunkMs * 0.5)));
+				while (throttled && !stopping) {
+					juce::Thread::sleep(50);
+				}
+				chunkTicks = juce::Time::getHighResolutionTicks();
+				return !stopping;
+			};
+			if (!analyseReader(*reader, result, keepGoing)) {
+				return;
+			}
+		}
+		const bool opened = reader != nullptr;
+
+		juce::MessageManager::callAsync([weakThis, path, result, opened, onFinished] {
+			if (weakThis == nullptr) {
+				return;
+			}
+			weakThis->pendingFiles.removeString(path);
+			if (opened && onFinished != nullptr) {
+				onFinished(result);
+			}
+		});
+	});
+}
+
+/**
+ * Implementation of setThrottled method for TrackAnalyser
+ *
+ * Sets the throttled flag read by the workers
+ *
+ */
+void TrackAnalyser::setThrottled(bool shouldThrottle) {
+	throttled = shouldThrottle;
+}
+
+/**
+ * Implementation of getNumPending method for TrackAnalyser
+ *
+ * Returns the size of pendingFiles
+ *
+ */
+int TrackAnalyser::getNumPending() const {
+	return pendingFiles.size();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of analyseReader method for TrackAnalyser
+ *
+ * Decodes the file a chunk at a time, each chunk read in behind the last samples of the
+ * previous one so the true peak interpolator has its history. Before the chunk is mixed
+ * down, a K-weighted copy is summed in squares over 100 ms segments for the loudness,
+ * a mono file counted on both channels as it plays on both sides of a deck, and each
+ * channel is searched for its true peak. The chunk is then mixed to mono. A one-pole
+ * low pass at 150 Hz gives the low end, where kick drums carry the beat. Both signals
+ * are summed in squares over hops of about 1/172 s, carried across chunk boundaries.
+ * The onset envelope is the rise in log energy from one hop to the next, added over
+ * both bands, with its local average over half a second taken off so only the peaks remain.
+ *
+ */
+bool TrackAnalyser::analyseReader(juce::AudioFormatReader& reader, Result& result, std::function<bool()> keepGoing) {
+	result = Result();
+	if (reader.sampleRate <= 0 || reader.lengthInSamples <= 0) {
+		return true;
+	}
+
+	const int hopSize = juce::jmax(1, juce::roundToInt(reader.sampleRate / envelopeRate));
+	const int numChannels = juce::jlimit(1, 2, (int)reader.numChannels);
+	const float lowCoefficient = 1.0f - (float)std::exp(-2.0 * juce::MathConstants<double>::pi * 150.0 / reader.sampleRate);
+
+	const int history = truePeakTaps - 1;
+	const int segmentLength = juce::jmax(1, juce::roundToInt(reader.sampleRate / 10.0));
+
+	juce::AudioBuffer<float> chunk(numChannels, history + chunkSize);
+	chunk.clear();
+	juce::AudioBuffer<float> weighted(numChannels, chunkSize);
+	juce::HeapBlock<float> low(chunkSize);
+	juce::HeapBlock<float> interpolated(chunkSize);
+	std::vector<float> fullEnergies, lowEnergies;
+	fullEnergies.reserve((size_t)(reader.lengthInSamples / hopSize + 1));
+	lowEnergies.reserve((size_t)(reader.lengthInSamples / hopSize + 1));
+	std::vector<double> segmentSums;
+	segmentSums.reserve((size_t)(reader.lengthInSamples / segmentLength + 1));
+
+	BiquadCascade<2> kWeighting;
+	LevelMeter::setKWeighting(kWeighting, reader.sampleRate);
+
+	float lowState = 0;
+	float hopFull = 0, hopLow = 0;
+	int hopFill = 0;
+	double segmentSum = 0;
+	int segmentFill = 0;
+	float peak = 0;
+	for (juce::int64 position = 0; position < reader.lengthInSamples; position += chunkSize) {
+		if (keepGoing != nullptr && !keepGoing()) {
+			return false;
+		}
+		const int numSamples = (int)juce::jmin((juce::int64)chunkSize, reader.lengthInSamples - position);
+		reader.read(&chunk, history, numSamples, position, true, numChannels > 1);
+
+		for (auto ch = 0; ch < numChannels; ++ch) {
+			peak = juce::jmax(peak, findInterSamplePeak(chunk.getReadPointer(ch, history), numSamples, interpolated));
+			weighted.copyFrom(ch, 0, chunk, ch, history, numSamples);
+			std::memmove(chunk.getWritePointer(ch), chunk.getReadPointer(ch, numSamples), sizeof(float) * (size_t)history);
+		}
+		kWeighting.process(weighted.getWritePointer(0), numChannels > 1 ? weighted.getWritePointer(1) : nullptr, numSamples);
+
+		for (auto i = 0; i < numSamples;) {
+			const int count = juce::jmin(segmentLength - segmentFill, numSamples - i);
+			for (auto ch = 0; ch < numChannels; ++ch) {
+				segmentSum += SampleMath::sumOfSquares(weighted.getReadPointer(ch, i), count);
+			}
+			segmentFill += count;
+			i += count;
+			if (segmentFill == segmentLength) {
+				segmentSums.push_back(numChannels > 1 ? segmentSum : 2.0 * segmentSum);
+				segmentSum = 0;
+				segmentFill = 0;
+			}
+		}
+
+		float* mono = chunk.getWritePointer(0, history);
+		if (numChannels > 1) {
+			juce::FloatVectorOperations::add(mono, chunk.getReadPointer(1, history), numSamples);
+			juce::FloatVectorOperations::multiply(mono, 0.5f, numSamples);
+		}
+		for (auto i = 0; i < numSamples; ++i) {
+			lowState += lowCoefficient * (mono[i] - lowState);
+			low[i] = lowState;
+		}
+
+		for (auto i = 0; i < numSamples;) {
+			const int count = juce::jmin(hopSize - hopFill, numSamples - i);
+			hopFull += SampleMath::sumOfSquares(mono + i, count);
+			hopLow += SampleMath::sumOfSquares(low + i, count);
+			hopFill += count;
+			i += count;
+			if (hopFill == hopSize) {
+				fullEnergies.push_back(hopFull / hopSize);
+				lowEnergies.push_back(hopLow / hopSize);
+				hopFull = hopLow = 0;
+				hopFill = 0;
+			}
+		}
+	}
+
+	const size_t numHops = fullEnergies.size();
+	std::vector<float> envelope(numHops, 0.0f);
+	for (size_t i = 1; i < numHops; ++i) {
+		const float fullRise = std::log1p(1000.0f * fullEnergies[i]) - std::log1p(1000.0f * fullEnergies[i - 1]);
+		const float lowRise = std::log1p(1000.0f * lowEnergies[i]) - std::log1p(1000.0f * lowEnergies[i - 1]);
+		envelope[i] = juce::jmax(0.0f, fullRise) + juce::jmax(0.0f, lowRise);
+	}
+
+	const double rate = reader.sampleRate / hopSize;
+	const int halfWindow = juce::roundToInt(rate * 0.25);
+	std::vector<double> runningSum(numHops + 1, 0.0);
+	for (size_t i = 0; i < numHops; ++i) {
+		runningSum[i + 1] = runningSum[i] + envelope[i];
+	}
+	for (size_t i = 0; i < numHops; ++i) {
+		const size_t start = (size_t)juce::jmax(0, (int)i - halfWindow);
+		const size_t end = juce::jmin(numHops, i + (size_t)halfWindow + 1);
+		const float average = (float)((runningSum[end] - runningSum[start]) / (double)(end - start));
+		envelope[i] = juce::jmax(0.0f, envelope[i] - average);
+	}
+
+	result = estimateTempo(envelope, rate);
+	result.loudness = integrateLoudness(segmentSums, segmentLength);
+	result.truePeak = juce::Decibels::gainToDecibels((double)peak, minLevel);
+	return true;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of estimateTempo method for TrackAnalyser
+ *
+ * Autocorrelates the envelope up to four beats of the slowest tempo. Every tempo from
+ * minBpm to maxBpm in 0.01 BPM steps scores the autocorrelation at one to four beats,
+ * read between lags by linear interpolation, so the longer lags pin the tempo down
+ * more finely than a single beat could. Scores are weighted by a log-normal curve an
+ * octave wide around 120 BPM, which favours the usual reading when half or double
+ * the tempo fits as well. The grid is then fitted to the whole track, trying every
+ * offset within a beat for tempos up to half a BPM either side, and the tempo and
+ * offset whose beats add up to the most onset energy win. Over a whole track a small
+ * tempo error drifts the later beats off their onsets, which makes this the finer fit.
+ *
+ */
+TrackAnalyser::Result TrackAnalyser::estimateTempo(const std::vector<float>& envelope, double rate) {
+	Result result;
+	const int numHops = (int)envelope.size();
+	const int maxLag = (int)std::ceil(4.0 * rate * 60.0 / minBpm) + 1;
+	if (numHops < 2 * maxLag) {
+		return result;
+	}
+
+	std::vector<float> autocorrelation((size_t)maxLag + 1, 0.0f);
+	for (auto lag = 1; lag <= maxLag; ++lag) {
+		autocorrelation[(size_t)lag] = SampleMath::dotProduct(envelope.data(), envelope.data() + lag, numHops - lag) / (float)(numHops - lag);
+	}
+	const auto readLag = [&autocorrelation](double lag) {
+		const int index = (int)lag;
+		const float fraction = (float)(lag - index);
+		return autocorrelation[(size_t)index] + fraction * (autocorrelation[(size_t)index + 1] - autocorrelation[(size_t)index]);
+	};
+
+	double bestScore = 0;
+	for (auto step = 0; step <= juce::roundToInt((maxBpm - minBpm) * 100.0); ++step) {
+		const double bpm = minBpm + step * 0.01;
+		const double beatLag = rate * 60.0 / bpm;
+		double score = 0;
+		for (auto beats = 1; beats <= 4; ++beats) {
+			score += readLag(beats * beatLag);
+		}
+		const double octaves = std::log2(bpm / 120.0);
+		score *= std::exp(-0.5 * octaves * octaves);
+		if (score > bestScore) {
+			bestScore = score;
+			result.bpm = bpm;
+		}
+	}
+	if (result.bpm <= 0) {
+		return result;
+	}
+
+	const double coarseBpm = result.bpm;
+	double bestGridScore = -1;
+	for (auto step = -50; step <= 50; ++step) {
+		const double bpm = coarseBpm + step * 0.01;
+		const double beatLag = rate * 60.0 / bpm;
+		for (auto phase = 0; phase < (int)beatLag; ++phase) {
+			double score = 0;
+			for (double hop = phase; hop < numHops; hop += beatLag) {
+				score += envelope[(size_t)juce::jmin(numHops - 1, juce::roundToInt(hop))];
+			}
+			if (score > bestGridScore) {
+				bestGridScore = score;
+				result.bpm = bpm;
+				result.firstBeat = phase / rate;
+			}
+		}
+	}
+	return result;
+}
+
+/**
+ * Implementation of integrateLoudness method for TrackAnalyser
+ *
+ * Gates 400 ms blocks overlapping by 75 %, four consecutive segments each, as EBU R128
+ * does. Blocks below the absolute gate of -70 LUFS are dropped, then blocks more than
+ * 10 LU below the loudness of the rest. The integrated loudness is that of the mean
+ * energy of the blocks left. A track shorter than a block is measured as a single block.
+ *
+ */
+double TrackAnalyser::integrateLoudness(const std::vector<double>& segmentSums, int segmentLength) {
+	const auto toLoudness = [](double meanSquare) {
+		return meanSquare > 0 ? -0.691 + 10.0 * std::log10(meanSquare) : minLevel;
+	};
+
+	std::vector<double> blocks;
+	const size_t blockSegments = juce::jmin((size_t)4, segmentSums.size());
+	if (blockSegments == 0) {
+		return minLevel;
+	}
+	for (size_t i = 0; i + blockSegments <= segmentSums.size(); ++i) {
+		double sum = 0;
+		for (size_t j = 0; j < blockSegments; ++j) {
+			sum += segmentSums[i + j];
+		}
+		const double meanSquare = sum / ((double)blockSegments * segmentLength);
+		if (toLoudness(meanSquare) > minLevel) {
+			blocks.push_back(meanSquare);
+		}
+	}
+	if (blocks.empty()) {
+		return minLevel;
+	}
+
+	double sum = 0;
+	for (auto block : blocks) {
+		sum += block;
+	}
+	const double relativeGate = toLoudness(sum / (double)blocks.size()) - 10.0;
+
+	double gatedSum = 0;
+	int numGated = 0;
+	for (auto block : blocks) {
+		if (toLoudness(block) > relativeGate) {
+			gatedSum += block;
+			++numGated;
+		}
+	}
+	return numGated > 0 ? juce::jmax(minLevel, toLoudness(gatedSum / numGated)) : minLevel;
+}
+
+/**
+ * Implementation of findInterSamplePeak method for TrackAnalyser
+ *
+ * Upsamples by four with the 48 tap interpolator of ITU-R BS.1770, a phase at a time.
+ * Each phase is built in the scratch space as a sum of delayed copies of the samples
+ * scaled by one tap, so every pass is a vector multiply-add, and its peak is read off
+ * with juce::FloatVectorOperations. The samples themselves count as well.
+ *
+ */
+float TrackAnalyser::findInterSamplePeak(const float* samples, int numSamples, float* scratch) {
+	static constexpr float phases[4][truePeakTaps] = {
+		{ 0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f, -0.0594482421875f, 0.1373291015625f,
+			0.9721679687500f, -0.1022949218750f, 0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f },
+		{ -0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f, -0.1665039062500f, 0.4650878906250f,
+			0.7797851562500f, -0.2003173828125f, 0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f },
+		{ -0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f, -0.2003173828125f, 0.7797851562500f,
+			0.4650878906250f, -0.1665039062500f, 0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f },
+		{ -0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f, -0.1022949218750f, 0.9721679687500f,
+			0.1373291015625f, -0.0594482421875f, 0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f }
+	};
+
+	auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+	float peak = juce::jmax(-range.getStart(), range.getEnd());
+	for (auto& taps : phases) {
+		juce::FloatVectorOperations::clear(scratch, numSamples);
+		for (auto tap = 0; tap < truePeakTaps; ++tap) {
+			juce::FloatVectorOperations::addWithMultiply(scratch, samples - tap, taps[tap], numSamples);
+		}
+		range = juce::FloatVectorOperations::findMinAndMax(scratch, numSamples);
+		peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+	}
+	return peak;
+}
+
+//==============================================================================
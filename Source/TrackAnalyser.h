@@ -0,0 +1,164 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "LevelMeter.h"
+
+//==============================================================================
+
+/**
+ * Definition of a TrackAnalyser
+ *
+ * Works out the tempo, beatgrid and loudness of library tracks in the background. Each track is
+ * decoded a chunk at a time on a low priority worker pool and reduced to an onset
+ * envelope, the rise in log energy of the full signal and of its low end every 1/172 s.
+ * The tempo is the one whose beat and its multiples line up best with the envelope's
+ * autocorrelation, weighted towards 120 BPM, and the grid starts at the phase whose
+ * beats land on the most onsets. Loudness is integrated over gated 400 ms blocks of the
+ * K-weighted signal and the true peak found on a four times upsampled copy, both as
+ * ITU-R BS.1770 measures them. Workers pause while throttled and sleep between chunks,
+ * so the analysis never competes with playback for the CPU or the disk.
+ *
+ */
+class TrackAnalyser {
+public:
+
+	/// Lowest loudness and true peak reported, the absolute gate of EBU R128
+	static constexpr double minLevel = -70.0;
+
+	/// Tempo, beatgrid and loudness of a track
+	struct Result {
+		/// Beats per minute, -1 if no tempo was found
+		double bpm = -1;
+
+		/// Time of the first beat of the grid in seconds
+		double firstBeat = 0;
+
+		/// Integrated loudness in LUFS, minLevel for silence
+		double loudness = minLevel;
+
+		/// Highest level between samples in dBTP, minLevel for silence
+		double truePeak = minLevel;
+	};
+
+	/// Called on the message thread with the result of an analysis
+	using Callback = std::function<void(const Result&)>;
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for TrackAnalyser, starts the low priority workers.
+		*
+		* @param juce::AudioFormatManager used to create the readers
+	*/
+	TrackAnalyser(juce::AudioFormatManager& _formatManager);
+
+	/**
+		* Class destructor for TrackAnalyser, stops the workers and drops pending analyses.
+	*/
+	~TrackAnalyser();
+
+	//==============================================================================
+
+	/**
+		* Queues a file for analysis, unless it is already queued. Only called from the message thread.
+		*
+		* @param Audio file to analyse
+		* @param Called on the message thread once the file is analysed, not called if it cannot be opened or the analyser is deleted first
+	*/
+	void analyse(const juce::File& file, Callback onFinished);
+
+	/**
+		* Pauses the workers between chunks while set, for example while the audio callback is busy
+		*
+		* @param True to pause
+	*/
+	void setThrottled(bool shouldThrottle);
+
+	/**
+		* @return Number of files queued or being analysed
+	*/
+	int getNumPending() const;
+
+	//==============================================================================
+
+	/**
+		* Analyses a whole file on the calling thread
+		*
+		* @param Reader of the file
+		* @param Receives the tempo, beatgrid and loudness
+		* @param Called between chunks, returns false to cancel
+		* @return False if the analysis was cancelled
+	*/
+	static bool analyseReader(juce::AudioFormatReader& reader, Result& result, std::function<bool()> keepGoing);
+
+	//==============================================================================
+
+private:
+
+	/**
+		* Works out the tempo and grid from an onset envelope
+		*
+		* @param Onset envelope
+		* @param Envelope values per second
+		* @return Tempo and beatgrid, with a bpm of -1 if the envelope is too short
+	*/
+	static Result estimateTempo(const std::vector<float>& envelope, double envelopeRate);
+
+	/**
+		* Works out the integrated loudness from the K-weighted energy of consecutive 100 ms segments
+		*
+		* @param Sum of the K-weighted squares of every channel in each segment
+		* @param Number of samples in a segment
+		* @return Integrated loudness in LUFS, minLevel if every block is below the absolute gate
+	*/
+	static double integrateLoudness(const std::vector<double>& segmentSums, int segmentLength);
+
+	/**
+		* Finds the highest level between samples by upsampling them four times
+		*
+		* @param Samples to search, preceded by truePeakTaps - 1 samples of history
+		* @param Number of samples to search
+		* @param Scratch space for numSamples interpolated samples
+		* @return Highest magnitude of the samples and the interpolated samples
+	*/
+	static float findInterSamplePeak(const float* samples, int numSamples, float* scratch);
+
+	//==============================================================================
+
+	/// Target number of envelope values per second
+	static constexpr double envelopeRate = 172.0;
+
+	/// Slowest tempo reported
+	static constexpr double minBpm = 70.0;
+
+	/// Fastest tempo reported
+	static constexpr double maxBpm = 180.0;
+
+	/// Number of samples decoded at a time
+	static constexpr int chunkSize = 65536;
+
+	/// Number of taps of each phase of the true peak interpolator
+	static constexpr int truePeakTaps = 12;
+
+	/// Reference assigned to the AudioFormatManager passed into the constructor
+	juce::AudioFormatManager& formatManager;
+
+	/// Low priority workers running the analyses
+	juce::ThreadPool threadPool;
+
+	/// Full paths of the files queued or being analysed, only used on the message thread
+	juce::StringArray pendingFiles;
+
+	/// Flags the workers to pause between chunks
+	std::atomic<bool> throttled{ false };
+
+	/// Flags the workers to give up, set by the destructor
+	std::atomic<bool> stopping{ false };
+
+	JUCE_DECLARE_WEAK_REFERENCEABLE(TrackAnalyser)
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackAnalyser)
+};
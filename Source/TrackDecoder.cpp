@@ -0,0 +1,254 @@
+
+#include "TrackDecoder.h"
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for DecodedTrack
+ *
+ * Takes ownership of the pooled buffer and saves the sample rate.
+ *
+ */
+DecodedTrack::DecodedTrack(std::unique_ptr<juce::AudioBuffer<float>> _buffer, double _sampleRate)
+	: buffer(std::move(_buffer)), sampleRate(_sampleRate)
+{
+}
+
+/**
+ * Implementation of a destructor for DecodedTrack
+ *
+ * Hands the buffer back to the TrackDecoder pool.
+ *
+ */
+DecodedTrack::~DecodedTrack()
+{
+	decoder->releaseBuffer(std::move(buffer));
+}
+
+/**
+ * Implementation of getBuffer method for DecodedTrack
+ *
+ * Returns the buffer data member
+ *
+ */
+const juce::AudioBuffer<float>& DecodedTrack::getBuffer() const {
+	return *buffer;
+}
+
+/**
+ * Implementation of getBufferForDecoding method for DecodedTrack
+ *
+ * Returns the buffer data member for the decode jobs to write to
+ *
+ */
+juce::AudioBuffer<float>& DecodedTrack::getBufferForDecoding() {
+	return *buffer;
+}
+
+/**
+ * Implementation of getSampleRate method for DecodedTrack
+ *
+ * Returns the sampleRate data member
+ *
+ */
+double DecodedTrack::getSampleRate() const {
+	return sampleRate;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for TrackDecoder
+ *
+ * Leaves one core free for the audio and message threads.
+ *
+ */
+TrackDecoder::TrackDecoder()
+	: threadPool(juce::jmax(1, juce::SystemStats::getNumCpus() - 1))
+{
+}
+
+/**
+ * Implementation of a destructor for TrackDecoder
+ *
+ * Waits for any running decode job before the pool is freed.
+ *
+ */
+TrackDecoder::~TrackDecoder()
+{
+	threadPool.removeAllJobs(true, 10000);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of decode method for TrackDecoder
+ *
+ * Opens the file once to find its length and reserve a pooled buffer, then adds a
+ * job per chunk to the worker pool. Every job opens its own reader so chunks decode
+ * independently, and reads straight into its part of the buffer. The calling thread
+ * waits for the last job to finish; a chunk that cannot be opened or read releases the
+ * whole track, so the caller falls back to streaming rather than playing a gap. While
+ * waiting it reports progress every 50 ms, and once the callback asks to cancel the
+ * chunks that have not started are skipped.
+ *
+ */
+DecodedTrack::Ptr TrackDecoder::decode(const juce::URL& audioURL, juce::AudioFormatManager& formatManager, std::function<bool(double)> progressCallback) {
+	std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(audioURL.createInputStream(false)));
+	if (reader == nullptr || reader->lengthInSamples <= 0 || reader->lengthInSamples > std::numeric_limits<int>::max()) {
+		return nullptr;
+	}
+
+	const int numChannels = juce::jlimit(1, 2, (int)reader->numChannels);
+	const int numSamples = (int)reader->lengthInSamples;
+	auto buffer = acquireBuffer(numChannels, numSamples);
+	if (buffer == nullptr) {
+		DBG("TrackDecoder::decode: " << audioURL.getFileName() << " does not fit the memory budget");
+		return nullptr;
+	}
+
+	DecodedTrack::Ptr decoded = new DecodedTrack(std::move(buffer), reader->sampleRate);
+	reader.reset();
+
+	const int chunkSize = juce::jmax(65536, (int)(decoded->getSampleRate() * chunkSeconds));
+	const int numChunks = (numSamples + chunkSize - 1) / chunkSize;
+	std::atomic<int> chunksRemaining{ numChunks };
+	std::atomic<bool> failed{ false };
+	juce::WaitableEvent finished;
+
+	for (auto chunk = 0; chunk < numChunks; ++chunk) {
+		const int start = chunk * chunkSize;
+		const int length = juce::jmin(chunkSize, numSamples - start);
+
+		threadPool.addJob([&, start, length] {
+			std::unique_ptr<juce::AudioFormatReader> chunkReader(failed ? nullptr : formatManager.createReaderFor(audioURL.createInputStream(false)));
+			if (chunkReader == nullptr || !chunkReader->read(&decoded->getBufferForDecoding(), start, length, start, true, true)) {
+				failed = true;
+			}
+			if (--chunksRemaining == 0) {
+				finished.signal();
+			}
+		});
+	}
+
+	while (!finished.wait(50)) {
+		if (progressCallback != nullptr && !progressCallback(1.0 - (double)chunksRemaining / numChunks)) {
+			failed = true;
+		}
+	}
+	if (failed) {
+		return nullptr;
+	}
+	return decoded;
+}
+
+/**
+ * Implementation of setMemoryBudget method for TrackDecoder
+ *
+ * Sets the memoryBudget data member. Pooled buffers are freed if they no longer fit,
+ * borrowed buffers are kept until they are released.
+ *
+ */
+void TrackDecoder::setMemoryBudget(juce::int64 bytes) {
+	const juce::ScopedLock sl(poolLock);
+	memoryBudget = juce::jmax((juce::int64)0, bytes);
+	while (memoryInUse > memoryBudget && !freeBuffers.isEmpty()) {
+		auto* freeBuffer = freeBuffers.getLast();
+		memoryInUse -= bufferCapacities[freeBuffer] * (juce::int64)sizeof(float);
+		bufferCapacities.erase(freeBuffer);
+		freeBuffers.removeLast();
+	}
+}
+
+/**
+ * Implementation of getMemoryBudget method for TrackDecoder
+ *
+ * Returns the memoryBudget data member
+ *
+ */
+juce::int64 TrackDecoder::getMemoryBudget() const {
+	const juce::ScopedLock sl(poolLock);
+	return memoryBudget;
+}
+
+/**
+ * Implementation of getMemoryInUse method for TrackDecoder
+ *
+ * Returns the memoryInUse data member
+ *
+ */
+juce::int64 TrackDecoder::getMemoryInUse() const {
+	const juce::ScopedLock sl(poolLock);
+	return memoryInUse;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of acquireBuffer method for TrackDecoder
+ *
+ * Reuses the smallest pooled buffer that is large enough, resized without reallocating.
+ * Otherwise pooled buffers are freed, largest first, until a new buffer fits the budget.
+ *
+ */
+std::unique_ptr<juce::AudioBuffer<float>> TrackDecoder::acquireBuffer(int numChannels, int numSamples) {
+	const juce::ScopedLock sl(poolLock);
+	const juce::int64 floatsNeeded = (juce::int64)numChannels * numSamples;
+
+	int bestIndex = -1;
+	for (auto i = 0; i < freeBuffers.size(); ++i) {
+		const auto capacity = bufferCapacities[freeBuffers[i]];
+		if (capacity >= floatsNeeded && (bestIndex < 0 || capacity < bufferCapacities[freeBuffers[bestIndex]])) {
+			bestIndex = i;
+		}
+	}
+
+	if (bestIndex >= 0) {
+		std::unique_ptr<juce::AudioBuffer<float>> reused(freeBuffers.removeAndReturn(bestIndex));
+		reused->setSize(numChannels, numSamples, false, false, true);
+		return reused;
+	}
+
+	while (memoryInUse + floatsNeeded * (juce::int64)sizeof(float) > memoryBudget && !freeBuffers.isEmpty()) {
+		int largest = 0;
+		for (auto i = 1; i < freeBuffers.size(); ++i) {
+			if (bufferCapacities[freeBuffers[i]] > bufferCapacities[freeBuffers[largest]]) {
+				largest = i;
+			}
+		}
+		memoryInUse -= bufferCapacities[freeBuffers[largest]] * (juce::int64)sizeof(float);
+		bufferCapacities.erase(freeBuffers[largest]);
+		freeBuffers.remove(largest);
+	}
+
+	if (memoryInUse + floatsNeeded * (juce::int64)sizeof(float) > memoryBudget) {
+		return nullptr;
+	}
+
+	std::unique_ptr<juce::AudioBuffer<float>> allocated(new juce::AudioBuffer<float>(numChannels, numSamples));
+	bufferCapacities[allocated.get()] = floatsNeeded;
+	memoryInUse += floatsNeeded * (juce::int64)sizeof(float);
+	return allocated;
+}
+
+/**
+ * Implementation of releaseBuffer method for TrackDecoder
+ *
+ * Keeps the buffer for reuse while it fits the budget, otherwise frees it.
+ *
+ */
+void TrackDecoder::releaseBuffer(std::unique_ptr<juce::AudioBuffer<float>> buffer) {
+	if (buffer == nullptr) {
+		return;
+	}
+
+	const juce::ScopedLock sl(poolLock);
+	if (memoryInUse > memoryBudget) {
+		memoryInUse -= bufferCapacities[buffer.get()] * (juce::int64)sizeof(float);
+		bufferCapacities.erase(buffer.get());
+		return;
+	}
+	freeBuffers.add(buffer.release());
+}
+
+//==============================================================================
@@ -0,0 +1,181 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <map>
+
+class TrackDecoder;
+
+//==============================================================================
+
+/**
+ * Definition of a DecodedTrack
+ *
+ * A fully decoded track held in memory. The sample buffer is borrowed from the
+ * TrackDecoder's pool and handed back when the last reference is released.
+ *
+ */
+class DecodedTrack : public juce::ReferenceCountedObject {
+public:
+
+	/// Reference counted pointer to a DecodedTrack
+	using Ptr = juce::ReferenceCountedObjectPtr<DecodedTrack>;
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for DecodedTrack, takes over a pooled buffer.
+		*
+		* @param Buffer from the TrackDecoder pool holding the track
+		* @param Number of samples per second of the track
+	*/
+	DecodedTrack(std::unique_ptr<juce::AudioBuffer<float>> buffer, double sampleRate);
+
+	/**
+		* Class destructor for DecodedTrack, returns the buffer to the pool.
+	*/
+	~DecodedTrack() override;
+
+	//==============================================================================
+
+	/**
+		* @return Buffer holding the decoded samples
+	*/
+	const juce::AudioBuffer<float>& getBuffer() const;
+
+	/**
+		* @return Writable buffer, only used while the track is being decoded
+	*/
+	juce::AudioBuffer<float>& getBufferForDecoding();
+
+	/**
+		* @return Number of samples per second of the track
+	*/
+	double getSampleRate() const;
+
+	//==============================================================================
+
+private:
+
+	/// Keeps the decoder and its pool alive for as long as the buffer is borrowed
+	juce::SharedResourcePointer<TrackDecoder> decoder;
+
+	/// Decoded samples, borrowed from the pool
+	std::unique_ptr<juce::AudioBuffer<float>> buffer;
+
+	/// Number of samples per second of the track
+	double sampleRate;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedTrack)
+};
+
+//==============================================================================
+
+/**
+ * Definition of a TrackDecoder
+ *
+ * Decodes whole tracks into memory for RAM-resident decks. The track is split into
+ * chunks that are decoded in parallel on a worker pool, each job with its own reader.
+ * Sample buffers come from a pool that keeps released buffers for reuse and never
+ * lets the allocated memory grow past a budget; decoding fails instead so the caller
+ * can fall back to streaming. A single instance is shared by every deck through
+ * juce::SharedResourcePointer.
+ *
+ */
+class TrackDecoder {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for TrackDecoder, starts a worker per spare CPU core.
+	*/
+	TrackDecoder();
+
+	/**
+		* Class destructor for TrackDecoder, stops the workers and frees the pool.
+	*/
+	~TrackDecoder();
+
+	//==============================================================================
+
+	/**
+		* Decodes a whole track into memory, blocking until every chunk is decoded, which
+		* takes seconds for a long track. Called from the player's loader thread; the only
+		* callers on the message thread are the headless render and benchmark runs, which
+		* have no UI to stall. Must not be called from a job on the decoder's own pool.
+		*
+		* @param juce::URL of the audio file
+		* @param juce::AudioFormatManager used to create the readers
+		* @param Called on the calling thread with the decoded portion between 0 and 1, returns false to cancel
+		* @return Decoded track, or nullptr if the file cannot be read, does not fit the memory budget or was cancelled
+	*/
+	DecodedTrack::Ptr decode(const juce::URL& audioURL, juce::AudioFormatManager& formatManager, std::function<bool(double)> progressCallback = nullptr);
+
+	/**
+		* Sets the largest amount of memory that decoded tracks and pooled buffers may use
+		*
+		* @param Memory budget in bytes
+	*/
+	void setMemoryBudget(juce::int64 bytes);
+
+	/**
+		* @return Memory budget in bytes
+	*/
+	juce::int64 getMemoryBudget() const;
+
+	/**
+		* @return Memory held by decoded tracks and pooled buffers in bytes
+	*/
+	juce::int64 getMemoryInUse() const;
+
+	//==============================================================================
+
+private:
+
+	friend class DecodedTrack;
+
+	//==============================================================================
+
+	/**
+		* Takes a buffer from the pool or allocates one within the memory budget
+		*
+		* @param Number of channels
+		* @param Number of samples per channel
+		* @return Buffer of the requested size, or nullptr if it does not fit the memory budget
+	*/
+	std::unique_ptr<juce::AudioBuffer<float>> acquireBuffer(int numChannels, int numSamples);
+
+	/**
+		* Returns a buffer to the pool for reuse
+		*
+		* @param Buffer previously returned by acquireBuffer
+	*/
+	void releaseBuffer(std::unique_ptr<juce::AudioBuffer<float>> buffer);
+
+	//==============================================================================
+
+	/// Length of the chunk decoded by each job, in seconds
+	static constexpr double chunkSeconds = 15.0;
+
+	/// Workers decoding the chunks
+	juce::ThreadPool threadPool;
+
+	/// Guards the pool and the memory accounting
+	juce::CriticalSection poolLock;
+
+	/// Released buffers kept for reuse
+	juce::OwnedArray<juce::AudioBuffer<float>> freeBuffers;
+
+	/// Number of floats each allocated buffer, borrowed or pooled, can hold without reallocating
+	std::map<const juce::AudioBuffer<float>*, juce::int64> bufferCapacities;
+
+	/// Memory budget in bytes
+	juce::int64 memoryBudget = (juce::int64)1024 * 1024 * 1024;
+
+	/// Memory held by decoded tracks and pooled buffers in bytes
+	juce::int64 memoryInUse = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackDecoder)
+};
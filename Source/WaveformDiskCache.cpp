@@ -0,0 +1,189 @@
+
+#include "WaveformDiskCache.h"
+#include <algorithm>
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for WaveformDiskCache
+ *
+ * Initializes the in-memory cache and data members
+ *
+ */
+WaveformDiskCache::WaveformDiskCache(const juce::File& directory, juce::int64 diskBudget, int maxThumbsInMemory)
+	: juce::AudioThumbnailCache(maxThumbsInMemory), cacheDirectory(directory), budget(diskBudget)
+{
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getHashFor method for WaveformDiskCache
+ *
+ * Tracks dropped straight onto a deck have no identity and are keyed by their path instead.
+ *
+ */
+juce::int64 WaveformDiskCache::getHashFor(const track& track) {
+	const juce::File file = track.url.getLocalFile();
+	const juce::String name = track.identity.isNotEmpty() ? track.identity : file.getFullPathName();
+	return (name + "|" + juce::String(file.getSize()) + "|" + juce::String(file.getLastModificationTime().toMilliseconds())).hashCode64();
+}
+
+//==============================================================================
+
+/**
+ * Implementation of loadNewThumb method for WaveformDiskCache
+ *
+ * The waveform is read straight out of the mapped file. A file that does not parse is
+ * deleted so it is saved again, and a loaded one has its modification time moved to now,
+ * which marks it as recently used for eviction.
+ *
+ */
+bool WaveformDiskCache::loadNewThumb(juce::AudioThumbnailBase& thumb, juce::int64 hashCode) {
+	const juce::ScopedLock sl(diskLock);
+	const juce::File file = getFileFor(hashCode, ".thumb");
+	if (!file.existsAsFile()) {
+		return false;
+	}
+
+	bool loaded = false;
+	{
+		juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+		if (mapped.getData() != nullptr) {
+			juce::MemoryInputStream stream(mapped.getData(), mapped.getSize(), false);
+			loaded = thumb.loadFrom(stream);
+		}
+	}
+	if (!loaded) {
+		DBG("WaveformDiskCache::loadNewThumb: dropping unreadable " << file.getFileName());
+		file.deleteFile();
+		return false;
+	}
+	file.setLastModificationTime(juce::Time::getCurrentTime());
+	return true;
+}
+
+/**
+ * Implementation of saveNewlyFinishedThumbnail method for WaveformDiskCache
+ *
+ * Writes to a temporary file that replaces the cached one once it is complete, so a
+ * waveform is never read half written.
+ *
+ */
+void WaveformDiskCache::saveNewlyFinishedThumbnail(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode) {
+	const juce::ScopedLock sl(diskLock);
+	if (cacheDirectory.createDirectory().failed()) {
+		return;
+	}
+
+	juce::TemporaryFile temporary(getFileFor(hashCode, ".thumb"));
+	{
+		juce::FileOutputStream stream(temporary.getFile());
+		if (stream.failedToOpen()) {
+			return;
+		}
+		thumb.saveTo(stream);
+	}
+	if (temporary.overwriteTargetFileWithTemporary()) {
+		evict();
+	}
+}
+
+/**
+ * Implementation of loadPyramid method for WaveformDiskCache
+ *
+ * Loads the same way as a waveform: straight out of the mapped file, deleting a file
+ * that does not parse and marking a loaded one as recently used.
+ *
+ */
+bool WaveformDiskCache::loadPyramid(WaveformPyramid& pyramid, juce::int64 hashCode) {
+	const juce::ScopedLock sl(diskLock);
+	const juce::File file = getFileFor(hashCode, ".pyr");
+	if (!file.existsAsFile()) {
+		return false;
+	}
+
+	bool loaded = false;
+	{
+		juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+		if (mapped.getData() != nullptr) {
+			juce::MemoryInputStream stream(mapped.getData(), mapped.getSize(), false);
+			loaded = pyramid.loadFrom(stream);
+		}
+	}
+	if (!loaded) {
+		DBG("WaveformDiskCache::loadPyramid: dropping unreadable " << file.getFileName());
+		file.deleteFile();
+		return false;
+	}
+	file.setLastModificationTime(juce::Time::getCurrentTime());
+	return true;
+}
+
+/**
+ * Implementation of savePyramid method for WaveformDiskCache
+ *
+ * Writes through a temporary file like a waveform, so a pyramid is never read half written.
+ *
+ */
+void WaveformDiskCache::savePyramid(const WaveformPyramid& pyramid, juce::int64 hashCode) {
+	const juce::ScopedLock sl(diskLock);
+	if (cacheDirectory.createDirectory().failed()) {
+		return;
+	}
+
+	juce::TemporaryFile temporary(getFileFor(hashCode, ".pyr"));
+	{
+		juce::FileOutputStream stream(temporary.getFile());
+		if (stream.failedToOpen()) {
+			return;
+		}
+		pyramid.saveTo(stream);
+	}
+	if (temporary.overwriteTargetFileWithTemporary()) {
+		evict();
+	}
+}
+
+/**
+ * Implementation of evict method for WaveformDiskCache
+ *
+ * Adds up the cached waveforms and pyramids and deletes them from the least recently
+ * used one until the total is back under the budget.
+ *
+ */
+void WaveformDiskCache::evict() {
+	auto files = cacheDirectory.findChildFiles(juce::File::findFiles, false, "*.thumb;*.pyr");
+	juce::int64 total = 0;
+	for (auto& file : files) {
+		total += file.getSize();
+	}
+	if (total <= budget) {
+		return;
+	}
+
+	std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b) {
+		return a.getLastModificationTime() < b.getLastModificationTime();
+	});
+	for (auto& file : files) {
+		if (total <= budget) {
+			break;
+		}
+		const juce::int64 size = file.getSize();
+		if (file.deleteFile()) {
+			total -= size;
+		}
+	}
+}
+
+/**
+ * Implementation of getFileFor method for WaveformDiskCache
+ *
+ * Names the file after the key in hexadecimal
+ *
+ */
+juce::File WaveformDiskCache::getFileFor(juce::int64 hashCode, const juce::String& extension) const {
+	return cacheDirectory.getChildFile(juce::String::toHexString(hashCode) + extension);
+}
+
+//==============================================================================
@@ -0,0 +1,110 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Track.h"
+#include "WaveformPyramid.h"
+
+//==============================================================================
+
+/**
+ * Definition of a WaveformDiskCache
+ *
+ * A juce::AudioThumbnailCache that keeps every finished waveform in a cache directory
+ * as well as in memory, so a track played in an earlier session shows its waveform as
+ * soon as it is loaded instead of being read again. Waveforms are keyed by the track's
+ * identity, file size and modification time, so an edited file is read afresh. The
+ * finest level of each track's WaveformPyramid is kept next to its waveform under the
+ * same key. Cached files are memory mapped to load them, and the least recently used
+ * are deleted once the directory grows past its budget.
+ *
+ */
+class WaveformDiskCache : public juce::AudioThumbnailCache {
+public:
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for WaveformDiskCache.
+		*
+		* @param Directory the waveforms are kept in, created when the first one is saved
+		* @param Largest total size of the cached waveforms in bytes
+		* @param Number of waveforms also kept in memory
+	*/
+	WaveformDiskCache(const juce::File& directory, juce::int64 diskBudget = 256 * 1024 * 1024, int maxThumbsInMemory = 100);
+
+	//==============================================================================
+
+	/**
+		* Returns the key a track's waveform is cached under, to hand to juce::AudioThumbnail::setReader
+		*
+		* @param track object with a local file
+		* @return Hash of the track's identity, or its path without one, with its file size and modification time
+	*/
+	static juce::int64 getHashFor(const track& track);
+
+	/**
+		* Loads a pyramid from the cache directory by memory mapping its file
+		*
+		* @param Pyramid to load into, not built yet
+		* @param Key of the track
+		* @return True if the pyramid was cached and loaded
+	*/
+	bool loadPyramid(WaveformPyramid& pyramid, juce::int64 hashCode);
+
+	/**
+		* Saves a built pyramid to the cache directory and evicts old files over the budget
+		*
+		* @param Pyramid that is ready
+		* @param Key of the track
+	*/
+	void savePyramid(const WaveformPyramid& pyramid, juce::int64 hashCode);
+
+	//==============================================================================
+
+private:
+
+	//==============================================================================
+
+	/**
+		* Loads a waveform from the cache directory by memory mapping its file
+		*
+		* @param Thumbnail to load into
+		* @param Key of the waveform
+		* @return True if the waveform was cached and loaded
+	*/
+	bool loadNewThumb(juce::AudioThumbnailBase& thumb, juce::int64 hashCode) override;
+
+	/**
+		* Saves a finished waveform to the cache directory and evicts old waveforms over the budget
+		*
+		* @param Thumbnail that finished reading its file
+		* @param Key of the waveform
+	*/
+	void saveNewlyFinishedThumbnail(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode) override;
+
+	/**
+		* Deletes the least recently used waveforms and pyramids until the directory fits the budget. Only called with the lock held.
+	*/
+	void evict();
+
+	/**
+		* @param Key of the waveform
+		* @param Extension of the file, .thumb for a waveform or .pyr for a pyramid
+		* @return File the waveform or pyramid is cached in
+	*/
+	juce::File getFileFor(juce::int64 hashCode, const juce::String& extension) const;
+
+	//==============================================================================
+
+	/// Directory the waveforms are kept in
+	juce::File cacheDirectory;
+
+	/// Largest total size of the cached waveforms in bytes
+	juce::int64 budget;
+
+	/// Guards the cache directory between the message thread loading and the thumbnail and pyramid threads saving
+	juce::CriticalSection diskLock;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformDiskCache)
+};
@@ -9,17 +9,19 @@
  * Initializes data members and configure component details
  *
  */
-WaveformDisplay::WaveformDisplay(juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& cacheToUse, juce::Colour _colour) : audioThumb(50, formatManagerToUse, cacheToUse), position(0), theme(_colour)
+WaveformDisplay::WaveformDisplay(juce::AudioFormatManager& formatManagerToUse, juce::AudioThumbnailCache& cacheToUse, juce::Colour _colour) : formatManager(formatManagerToUse), thumbCache(cacheToUse), position(0), theme(_colour)
 {
-	audioThumb.addChangeListener(this);
 }
 
 /**
  * Implementation of a destructor for WaveformDisplay
  *
+ * Lets go of the shared waveform
+ *
  */
 WaveformDisplay::~WaveformDisplay()
 {
+	releaseWaveform();
 }
 
 //==============================================================================
@@ -54,17 +56,27 @@ bool WaveformDisplay::isFileLoaded() {
 	return isLoaded;
 };
 
+/**
+ * Implementation of getLengthInSeconds method for WaveformDisplay
+ *
+ * Returns the length of the shared waveform, or 0 without one
+ *
+ */
+double WaveformDisplay::getLengthInSeconds() {
+	return waveform != nullptr ? waveform->getLengthInSeconds() : 0.0;
+};
+
 //==============================================================================
 
 /**
  * Implementation of loadTrack method for WaveformDisplay
  *
- * Calls loadURL using the track object's url data member
+ * Calls loadWaveform with the track object
  * and stores the loaded song name
  *
  */
 void WaveformDisplay::loadTrack(track track) {
-	loadURL(track.url);
+	loadWaveform(track);
 	if (isLoaded) {
 		songNameLoaded = track.title;
 	}
@@ -108,7 +120,7 @@ void WaveformDisplay::setCuePoints(std::map<juce::TextButton*, std::pair<double,
  * Implementation of paint method for WaveformDisplay
  *
  * Checks if track is loaded onto component.
- * Upon loading, calls the drawChannel method on audioThumb to
+ * Upon loading, calls the drawChannel method on the waveform's thumbnail to
  * draw the waveform.
  * Cue point data containing time stamps are drawn on the component as
  * vertical lines.
@@ -122,7 +134,7 @@ void WaveformDisplay::paint(juce::Graphics& g)
 	g.setColour(theme);
 	if (isLoaded) {
 		g.drawText(songNameLoaded, 5, 5, getWidth() * 3 / 4, 6, juce::Justification::left);
-		audioThumb.drawChannel(g, getLocalBounds(), 0, audioThumb.getTotalLength(), 0, 0.55);
+		waveform->getThumbnail().drawChannel(g, getLocalBounds(), 0, getLengthInSeconds(), 0, 0.55);
 		g.setColour(juce::Colours::lightgreen);
 		g.drawRect(position * getWidth(), 0, 1, getHeight());
 
@@ -232,17 +244,21 @@ void WaveformDisplay::mouseUp(const juce::MouseEvent& e) {
 //==============================================================================
 
 /**
- * Implementation of loadURL method for WaveformDisplay
+ * Implementation of loadWaveform method for WaveformDisplay
  *
- * Calls the setSource method on the audioThumb and
+ * Takes the track's waveform from the WaveformStore, which only reads the file
+ * if no other display holds it yet, listens to it and
  * clears all previous track data on data members.
  *
  */
-void  WaveformDisplay::loadURL(juce::URL audioURL) {
+void  WaveformDisplay::loadWaveform(const track& track) {
 	isLoaded = false;
 	DBG("WaveformDispaly loadURL");
-	audioThumb.clear();
-	if (audioThumb.setSource(new juce::URLInputSource(audioURL))) {
+	releaseWaveform();
+	waveform = waveformStore->getModel(track, formatManager, thumbCache);
+	if (waveform != nullptr) {
+		waveform->getThumbnail().addChangeListener(this);
+		waveform->getPyramid().addChangeListener(this);
 		DBG("Successfully loaded wfd");
 		isLoaded = true;
 		setPositionRelative(0);
@@ -253,6 +269,20 @@ void  WaveformDisplay::loadURL(juce::URL audioURL) {
 	}
 }
 
+/**
+ * Implementation of releaseWaveform method for WaveformDisplay
+ *
+ * Removes the component from the thumbnail's and pyramid's listeners before dropping its reference
+ *
+ */
+void WaveformDisplay::releaseWaveform() {
+	if (waveform != nullptr) {
+		waveform->getThumbnail().removeChangeListener(this);
+		waveform->getPyramid().removeChangeListener(this);
+		waveform = nullptr;
+	}
+}
+
 //==============================================================================
 
 
@@ -3,12 +3,14 @@
 
 #include <JuceHeader.h>
 #include "Track.h"
+#include "WaveformModel.h"
 //==============================================================================
 
 /**
  * Definition of a WaveformDisplay Component
  *
  * A component to display the loaded audio file's waveform.
+ * The waveform comes from a WaveformModel shared with every other display of the track.
  * Playback functionality is included to set the current player position.
  * Communicates with DJAudioPlayer controls via the DeckGUI interface
  *
@@ -97,7 +99,7 @@ private:
 	//============================================================================== 
 
 	/**
-		* Called when change is detected in audioThumb member
+		* Called when change is detected in the waveform's thumbnail or pyramid
 		*
 		* @param juce::ChangeBroadcaster pointer
 	*/
@@ -143,11 +145,16 @@ private:
 	//============================================================================== 
 
 	/**
-		* Loads component with audio URL of file
+		* Loads component with the waveform of a track
 		*
-		* @param juce::URL object
+		* @param track object
 	*/
-	void loadURL(juce::URL audioURL);
+	void loadWaveform(const track& track);
+
+	/**
+		* Stops listening to the current waveform and lets go of it
+	*/
+	void releaseWaveform();
 
 	//============================================================================== 
 
@@ -155,15 +162,29 @@ private:
 	/// Tracks if mouse has entered component
 	bool mouseEntered = false;
 
+	/// Reference assigned to the AudioFormatManager passed into the constructor
+	juce::AudioFormatManager& formatManager;
+
+	/// Reference assigned to the AudioThumbnailCache passed into the constructor
+	juce::AudioThumbnailCache& thumbCache;
+
+	/// Store handing out the waveform of each track, shared by every display
+	juce::SharedResourcePointer<WaveformStore> waveformStore;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformDisplay);
 
 protected:
 
+	/**
+		* @return Length of the loaded track in seconds, 0 when nothing is loaded
+	*/
+	double getLengthInSeconds();
+
 	/// Song name of the loaded audio file
 	juce::String songNameLoaded;
 
-	/// AudioThumbnail to draw waveform
-	juce::AudioThumbnail audioThumb;
+	/// Shared waveform of the loaded track, null when nothing is loaded
+	WaveformModel::Ptr waveform;
 
 	/// Position of the audio song
 	double position = 0;
@@ -0,0 +1,200 @@
+
+#include "WaveformModel.h"
+
+//==============================================================================
+
+namespace {
+	/**
+	 * Loads or builds the pyramid of a local file on the WaveformStore's thread. When the
+	 * thumbnail was not cached the file is read once for both: every chunk the pyramid
+	 * reads is added to the thumbnail as well, and both are saved to the disk cache.
+	 */
+	class WaveformBuildJob : public juce::ThreadPoolJob {
+	public:
+		WaveformBuildJob(WaveformPyramid::Ptr _pyramid, juce::AudioThumbnail* _thumbnail, juce::AudioThumbnailCache& _cache, juce::int64 _hashCode, juce::AudioFormatReader* _reader)
+			: juce::ThreadPoolJob("WaveformBuildJob"), pyramid(_pyramid), thumbnail(_thumbnail), cache(_cache),
+			diskCache(dynamic_cast<WaveformDiskCache*>(&_cache)), hashCode(_hashCode), reader(_reader)
+		{
+		}
+
+		JobStatus runJob() override {
+			if (thumbnail != nullptr || diskCache == nullptr || !diskCache->loadPyramid(*pyramid, hashCode)) {
+				WaveformPyramid::ChunkCallback onChunk;
+				if (thumbnail != nullptr) {
+					onChunk = [this](const juce::AudioBuffer<float>& buffer, juce::int64 position, int numSamples) {
+						thumbnail->addBlock(position, buffer, 0, numSamples);
+					};
+				}
+				pyramid->build(*reader, onChunk);
+				if (!pyramid->isReady()) {
+					return jobHasFinished;
+				}
+				if (thumbnail != nullptr) {
+					cache.storeThumb(*thumbnail, hashCode);
+				}
+				if (diskCache != nullptr) {
+					diskCache->savePyramid(*pyramid, hashCode);
+				}
+			}
+			WaveformPyramid::Ptr ready(pyramid);
+			juce::MessageManager::callAsync([ready] { ready->sendSynchronousChangeMessage(); });
+			return jobHasFinished;
+		}
+
+	private:
+		/// Pyramid to load or build
+		WaveformPyramid::Ptr pyramid;
+
+		/// Thumbnail to feed, nullptr if it was loaded from the cache
+		juce::AudioThumbnail* thumbnail;
+
+		/// Cache the thumbnail is stored in once built
+		juce::AudioThumbnailCache& cache;
+
+		/// Cache as a WaveformDiskCache, which also keeps pyramids, or nullptr
+		WaveformDiskCache* diskCache;
+
+		/// Key of the track in the caches
+		juce::int64 hashCode;
+
+		/// Reader of the file
+		std::unique_ptr<juce::AudioFormatReader> reader;
+	};
+}
+
+//==============================================================================
+
+/**
+ * Implementation of a constructor for WaveformModel
+ *
+ * Uses the same resolution the displays used for their own thumbnails.
+ *
+ */
+WaveformModel::WaveformModel(const juce::String& _key, juce::AudioFormatManager& formatManager, juce::AudioThumbnailCache& cache)
+	: key(_key), thumbnail(50, formatManager, cache)
+{
+}
+
+/**
+ * Implementation of a destructor for WaveformModel
+ *
+ * Cancels the build and waits for its job to stop, which takes at most one chunk, as
+ * the job feeds the thumbnail. Then unregisters the model so the next request builds a
+ * new one.
+ *
+ */
+WaveformModel::~WaveformModel()
+{
+	pyramid->cancel();
+	if (buildJob != nullptr) {
+		store->pyramidPool.removeJob(buildJob.get(), true, -1);
+	}
+	store->removeModel(key);
+}
+
+//==============================================================================
+
+/**
+ * Implementation of buildFromFile method for WaveformModel
+ *
+ * A thumbnail found in the cache is complete at once. Otherwise it is reset to the
+ * channels, rate and length of the file, so displays know the length straight away,
+ * and filled in by the job as the file is read.
+ *
+ */
+bool WaveformModel::buildFromFile(juce::AudioFormatReader* reader, juce::int64 hashCode, juce::AudioThumbnailCache& cache) {
+	std::unique_ptr<juce::AudioFormatReader> fileReader(reader);
+	const bool cached = cache.loadThumb(thumbnail, hashCode);
+	if (!cached) {
+		thumbnail.reset(juce::jlimit(1, 2, (int)fileReader->numChannels), fileReader->sampleRate, fileReader->lengthInSamples);
+	}
+	if (getLengthInSeconds() <= 0) {
+		return false;
+	}
+	buildJob.reset(new WaveformBuildJob(pyramid, cached ? nullptr : &thumbnail, cache, hashCode, fileReader.release()));
+	store->pyramidPool.addJob(buildJob.get(), false);
+	return true;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getThumbnail method for WaveformModel
+ *
+ * Returns the thumbnail data member
+ *
+ */
+juce::AudioThumbnail& WaveformModel::getThumbnail() {
+	return thumbnail;
+}
+
+/**
+ * Implementation of getLengthInSeconds method for WaveformModel
+ *
+ * Returns the total length of the thumbnail data member
+ *
+ */
+double WaveformModel::getLengthInSeconds() const {
+	return thumbnail.getTotalLength();
+}
+
+/**
+ * Implementation of getPyramid method for WaveformModel
+ *
+ * Returns the pyramid data member
+ *
+ */
+WaveformPyramid& WaveformModel::getPyramid() {
+	return *pyramid;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getModel method for WaveformStore
+ *
+ * Returns the registered model of the track if one is still held. Otherwise creates one
+ * and registers it unless the file could not be opened. A local file is built by the
+ * model under the WaveformDiskCache key of the track, so a cached waveform and pyramid
+ * are loaded and new ones are read once and saved; the pyramid's listeners are told on
+ * the message thread once it is ready. Other URLs are streamed into the thumbnail on
+ * the thumbnail cache's thread and have no pyramid.
+ *
+ */
+WaveformModel::Ptr WaveformStore::getModel(const track& track, juce::AudioFormatManager& formatManager, juce::AudioThumbnailCache& cache) {
+	const juce::URL& audioURL = track.url;
+	const juce::String key = audioURL.isLocalFile() ? audioURL.getLocalFile().getFullPathName() : audioURL.toString(false);
+	auto it = models.find(key);
+	if (it != models.end()) {
+		return it->second;
+	}
+
+	WaveformModel::Ptr model = new WaveformModel(key, formatManager, cache);
+	bool opened = false;
+	if (audioURL.isLocalFile()) {
+		if (auto* reader = formatManager.createReaderFor(audioURL.getLocalFile())) {
+			opened = model->buildFromFile(reader, WaveformDiskCache::getHashFor(track), cache);
+		}
+	}
+	else {
+		opened = model->getThumbnail().setSource(new juce::URLInputSource(audioURL));
+	}
+	if (!opened) {
+		DBG("WaveformStore::getModel: failed to open " << audioURL.getFileName());
+		return nullptr;
+	}
+	models[key] = model.get();
+	return model;
+}
+
+/**
+ * Implementation of removeModel method for WaveformStore
+ *
+ * Erases the key from the models data member
+ *
+ */
+void WaveformStore::removeModel(const juce::String& key) {
+	models.erase(key);
+}
+
+//==============================================================================
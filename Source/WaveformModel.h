@@ -0,0 +1,142 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include "WaveformDiskCache.h"
+#include "WaveformPyramid.h"
+
+class WaveformStore;
+
+//==============================================================================
+
+/**
+ * Definition of a WaveformModel
+ *
+ * The waveform of one loaded track, shared by every display showing it. The
+ * juce::AudioThumbnail is built once when the model is created, and displays listen to
+ * it for progress. Local files also get a WaveformPyramid for zoomed drawing. Both are
+ * built by one read of the file on the WaveformStore's thread, unless the disk cache
+ * already holds them. The model unregisters itself from the WaveformStore when the last
+ * display lets go of it.
+ *
+ */
+class WaveformModel : public juce::ReferenceCountedObject {
+public:
+
+	/// Reference counted pointer to a WaveformModel
+	using Ptr = juce::ReferenceCountedObjectPtr<WaveformModel>;
+
+	//==============================================================================
+
+	/**
+		* Class Constructor for WaveformModel, initializes the thumbnail.
+		*
+		* @param Key of the track in the WaveformStore
+		* @param juce::AudioFormatManager reference that manages audio formats
+		* @param AudioThumbnailCache reference that manages a cache of juce::AudioThumbnail objects
+	*/
+	WaveformModel(const juce::String& key, juce::AudioFormatManager& formatManager, juce::AudioThumbnailCache& cache);
+
+	/**
+		* Class destructor for WaveformModel, cancels the build, waits for it to stop and unregisters the model from the WaveformStore.
+	*/
+	~WaveformModel() override;
+
+	/**
+		* Loads the thumbnail of a local file from the cache, or sizes it for the file, and
+		* adds a job to the WaveformStore's thread that loads or builds the pyramid, feeding
+		* the thumbnail from the same read when it was not cached. Only called once.
+		*
+		* @param Reader of the file, owned
+		* @param WaveformDiskCache key of the track
+		* @param AudioThumbnailCache reference that manages a cache of juce::AudioThumbnail objects
+		* @return True if the file has any audio
+	*/
+	bool buildFromFile(juce::AudioFormatReader* reader, juce::int64 hashCode, juce::AudioThumbnailCache& cache);
+
+	//==============================================================================
+
+	/**
+		* @return Thumbnail holding the waveform, a juce::ChangeBroadcaster while it is built
+	*/
+	juce::AudioThumbnail& getThumbnail();
+
+	/**
+		* @return Length of the track in seconds
+	*/
+	double getLengthInSeconds() const;
+
+	/**
+		* @return Levels of detail of the waveform, a juce::ChangeBroadcaster once they are ready
+	*/
+	WaveformPyramid& getPyramid();
+
+	//==============================================================================
+
+private:
+
+	/// Keeps the store alive for as long as the model is registered in it
+	juce::SharedResourcePointer<WaveformStore> store;
+
+	/// Key of the track in the store
+	juce::String key;
+
+	/// AudioThumbnail holding the waveform
+	juce::AudioThumbnail thumbnail;
+
+	/// Levels of detail of the waveform, shared with the job building them
+	WaveformPyramid::Ptr pyramid{ new WaveformPyramid() };
+
+	/// Job reading a local file on the store's thread, removed from it before the thumbnail is freed
+	std::unique_ptr<juce::ThreadPoolJob> buildJob;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformModel)
+};
+
+//==============================================================================
+
+/**
+ * Definition of a WaveformStore
+ *
+ * Hands out the WaveformModel of a track, creating it the first time the track is
+ * asked for and returning the same model for as long as any display holds it, so
+ * a track loaded into a deck is only read once for its waveform display, zoomed
+ * waveform, jog wheel and pyramid. Shared by every deck through a juce::SharedResourcePointer
+ * and only used from the message thread.
+ *
+ */
+class WaveformStore {
+public:
+
+	//==============================================================================
+
+	/**
+		* Returns the model of a track, building its waveform if no display holds it yet.
+		*
+		* @param track object to show
+		* @param juce::AudioFormatManager reference that manages audio formats
+		* @param AudioThumbnailCache reference that manages a cache of juce::AudioThumbnail objects
+		* @return Model of the track, or nullptr if the file could not be opened
+	*/
+	WaveformModel::Ptr getModel(const track& track, juce::AudioFormatManager& formatManager, juce::AudioThumbnailCache& cache);
+
+	//==============================================================================
+
+private:
+
+	friend class WaveformModel;
+
+	/**
+		* Removes a model once its last reference is released
+		*
+		* @param Key of the track
+	*/
+	void removeModel(const juce::String& key);
+
+	/// Models held by at least one display, by the full path of their track
+	std::map<juce::String, WaveformModel*> models;
+
+	/// Single thread reading local files for their waveforms and pyramids, one track at a time
+	juce::ThreadPool pyramidPool{ 1 };
+};
@@ -0,0 +1,260 @@
+
+#include "WaveformPyramid.h"
+
+//==============================================================================
+
+/**
+ * Implementation of build method for WaveformPyramid
+ *
+ * Builds the finest level from the file, then the levels above it.
+ *
+ */
+void WaveformPyramid::build(juce::AudioFormatReader& reader, ChunkCallback onChunk) {
+	sampleRate = reader.sampleRate > 0 ? reader.sampleRate : 44100;
+	if (buildBaseLevel(reader, onChunk)) {
+		buildUpperLevels();
+	}
+}
+
+/**
+ * Implementation of loadFrom method for WaveformPyramid
+ *
+ * Checks the version, the points' span and that the stream holds every point before
+ * reading the three arrays of the finest level straight into place.
+ *
+ */
+bool WaveformPyramid::loadFrom(juce::InputStream& stream) {
+	if (stream.readInt() != formatVersion) {
+		return false;
+	}
+	const double savedSampleRate = stream.readDouble();
+	const int samplesPerPoint = stream.readInt();
+	const juce::int64 numPoints = stream.readInt64();
+	const juce::int64 numBytes = numPoints * (juce::int64)sizeof(float);
+	if (savedSampleRate <= 0 || samplesPerPoint != baseSamplesPerPoint || numPoints <= 0 || stream.getNumBytesRemaining() < 3 * numBytes) {
+		return false;
+	}
+
+	Level level;
+	level.samplesPerPoint = baseSamplesPerPoint;
+	for (auto* points : { &level.minimum, &level.maximum, &level.meanSquare }) {
+		points->resize((size_t)numPoints);
+		if (stream.read(points->data(), (size_t)numBytes) != numBytes) {
+			return false;
+		}
+	}
+	sampleRate = savedSampleRate;
+	levels.push_back(std::move(level));
+	buildUpperLevels();
+	return isReady();
+}
+
+/**
+ * Implementation of saveTo method for WaveformPyramid
+ *
+ * Writes the version, sample rate, points' span and number of points, then the three
+ * arrays of the finest level. The levels above are cheap to rebuild and are not saved.
+ *
+ */
+void WaveformPyramid::saveTo(juce::OutputStream& stream) const {
+	jassert(isReady());
+	const Level& level = levels.front();
+	const size_t numBytes = level.minimum.size() * sizeof(float);
+	stream.writeInt(formatVersion);
+	stream.writeDouble(sampleRate);
+	stream.writeInt(baseSamplesPerPoint);
+	stream.writeInt64((juce::int64)level.minimum.size());
+	stream.write(level.minimum.data(), numBytes);
+	stream.write(level.maximum.data(), numBytes);
+	stream.write(level.meanSquare.data(), numBytes);
+}
+
+/**
+ * Implementation of buildUpperLevels method for WaveformPyramid
+ *
+ * Builds each level from the one below: the lowest and highest of two points, and the
+ * mean of their mean squares. The last point of an odd level is carried up on its own.
+ *
+ */
+void WaveformPyramid::buildUpperLevels() {
+	while (levels.back().minimum.size() > 1) {
+		if (cancelled) {
+			return;
+		}
+		const Level& below = levels.back();
+		const size_t belowSize = below.minimum.size();
+		const size_t size = (belowSize + 1) / 2;
+		Level level;
+		level.samplesPerPoint = below.samplesPerPoint * 2;
+		level.minimum.resize(size);
+		level.maximum.resize(size);
+		level.meanSquare.resize(size);
+		for (size_t i = 0; i < belowSize / 2; ++i) {
+			level.minimum[i] = juce::jmin(below.minimum[2 * i], below.minimum[2 * i + 1]);
+			level.maximum[i] = juce::jmax(below.maximum[2 * i], below.maximum[2 * i + 1]);
+			level.meanSquare[i] = 0.5f * (below.meanSquare[2 * i] + below.meanSquare[2 * i + 1]);
+		}
+		if (belowSize % 2 == 1) {
+			level.minimum[size - 1] = below.minimum[belowSize - 1];
+			level.maximum[size - 1] = below.maximum[belowSize - 1];
+			level.meanSquare[size - 1] = below.meanSquare[belowSize - 1];
+		}
+		levels.push_back(std::move(level));
+	}
+	ready.store(true, std::memory_order_release);
+}
+
+/**
+ * Implementation of buildBaseLevel method for WaveformPyramid
+ *
+ * Reads whole chunks of points into a stereo buffer, mono files being copied to both
+ * channels, and hands each to the chunk callback. A failed read gives up, as the pyramid
+ * would otherwise be drawn with silence where the file could not be read. The peaks of
+ * each point come from a vectorised search of each channel, and the squares of both
+ * channels are summed into a scratch channel with vectorised operations before being
+ * added up per point.
+ *
+ */
+bool WaveformPyramid::buildBaseLevel(juce::AudioFormatReader& reader, const ChunkCallback& onChunk) {
+	const juce::int64 length = reader.lengthInSamples;
+	const size_t numPoints = (size_t)((length + baseSamplesPerPoint - 1) / baseSamplesPerPoint);
+
+	Level level;
+	level.samplesPerPoint = baseSamplesPerPoint;
+	level.minimum.resize(juce::jmax((size_t)1, numPoints));
+	level.maximum.resize(juce::jmax((size_t)1, numPoints));
+	level.meanSquare.resize(juce::jmax((size_t)1, numPoints));
+
+	juce::AudioBuffer<float> buffer(2, chunkSize);
+	juce::AudioBuffer<float> squares(1, chunkSize);
+	size_t point = 0;
+	for (juce::int64 position = 0; position < length; position += chunkSize) {
+		if (cancelled) {
+			return false;
+		}
+		const int numSamples = (int)juce::jmin((juce::int64)chunkSize, length - position);
+		if (!reader.read(&buffer, 0, numSamples, position, true, true)) {
+			DBG("WaveformPyramid::buildBaseLevel: read failed at sample " << position);
+			return false;
+		}
+		if (onChunk != nullptr) {
+			onChunk(buffer, position, numSamples);
+		}
+		const float* left = buffer.getReadPointer(0);
+		const float* right = buffer.getReadPointer(1);
+		float* square = squares.getWritePointer(0);
+		juce::FloatVectorOperations::multiply(square, left, left, numSamples);
+		juce::FloatVectorOperations::addWithMultiply(square, right, right, numSamples);
+
+		for (auto start = 0; start < numSamples; start += baseSamplesPerPoint, ++point) {
+			const int count = juce::jmin(baseSamplesPerPoint, numSamples - start);
+			const auto leftRange = juce::FloatVectorOperations::findMinAndMax(left + start, count);
+			const auto rightRange = juce::FloatVectorOperations::findMinAndMax(right + start, count);
+			float sum = 0;
+			for (auto i = 0; i < count; ++i) {
+				sum += square[start + i];
+			}
+			level.minimum[point] = juce::jmin(leftRange.getStart(), rightRange.getStart());
+			level.maximum[point] = juce::jmax(leftRange.getEnd(), rightRange.getEnd());
+			level.meanSquare[point] = sum / (float)(2 * count);
+		}
+	}
+	levels.push_back(std::move(level));
+	return true;
+}
+
+/**
+ * Implementation of cancel method for WaveformPyramid
+ *
+ * Sets the cancelled data member
+ *
+ */
+void WaveformPyramid::cancel() {
+	cancelled = true;
+}
+
+/**
+ * Implementation of isReady method for WaveformPyramid
+ *
+ * Returns the ready data member
+ *
+ */
+bool WaveformPyramid::isReady() const {
+	return ready.load(std::memory_order_acquire);
+}
+
+/**
+ * Implementation of getSampleRate method for WaveformPyramid
+ *
+ * Returns the sampleRate data member, only meaningful once the pyramid is ready
+ *
+ */
+double WaveformPyramid::getSampleRate() const {
+	return sampleRate;
+}
+
+//==============================================================================
+
+/**
+ * Implementation of draw method for WaveformPyramid
+ *
+ * Each pixel column gathers the points of the chosen level that fall in its time span,
+ * usually one or two, and draws a line from their lowest to their highest sample with
+ * the RMS level over it. Columns before the start or past the end of the track stay empty.
+ *
+ */
+void WaveformPyramid::draw(juce::Graphics& g, juce::Rectangle<int> area, double startTime, double endTime, float verticalZoom, juce::Colour colour) const {
+	const int width = area.getWidth();
+	if (!isReady() || width <= 0 || endTime <= startTime) {
+		return;
+	}
+	const double samplesPerPixel = (endTime - startTime) * sampleRate / width;
+	const Level& level = getLevelFor(samplesPerPixel);
+	const juce::int64 numPoints = (juce::int64)level.minimum.size();
+	const float centre = (float)area.getCentreY();
+	const float halfHeight = area.getHeight() * 0.5f * verticalZoom;
+	const juce::Colour rmsColour = colour.brighter(0.6f);
+
+	for (auto x = 0; x < width; ++x) {
+		const double firstSample = startTime * sampleRate + x * samplesPerPixel;
+		juce::int64 first = (juce::int64)std::floor(firstSample / level.samplesPerPoint);
+		juce::int64 last = (juce::int64)std::floor((firstSample + samplesPerPixel) / level.samplesPerPoint);
+		if (last < 0 || first >= numPoints) {
+			continue;
+		}
+		first = juce::jmax((juce::int64)0, first);
+		last = juce::jlimit(first + 1, numPoints, last);
+
+		float low = level.minimum[(size_t)first];
+		float high = level.maximum[(size_t)first];
+		float meanSquare = 0;
+		for (auto i = first; i < last; ++i) {
+			low = juce::jmin(low, level.minimum[(size_t)i]);
+			high = juce::jmax(high, level.maximum[(size_t)i]);
+			meanSquare += level.meanSquare[(size_t)i];
+		}
+		const float rms = std::sqrt(meanSquare / (float)(last - first));
+
+		g.setColour(colour);
+		g.drawVerticalLine(area.getX() + x, centre - high * halfHeight, centre - low * halfHeight + 1.0f);
+		g.setColour(rmsColour);
+		g.drawVerticalLine(area.getX() + x, centre - rms * halfHeight, centre + rms * halfHeight + 1.0f);
+	}
+}
+
+/**
+ * Implementation of getLevelFor method for WaveformPyramid
+ *
+ * Levels double their points' span from the finest up, so the last one whose span does
+ * not exceed a pixel is the cheapest that keeps every pixel's detail.
+ *
+ */
+const WaveformPyramid::Level& WaveformPyramid::getLevelFor(double samplesPerPixel) const {
+	size_t index = 0;
+	while (index + 1 < levels.size() && levels[index + 1].samplesPerPoint <= samplesPerPixel) {
+		++index;
+	}
+	return levels[index];
+}
+
+//==============================================================================
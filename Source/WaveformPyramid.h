@@ -0,0 +1,154 @@
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+//==============================================================================
+
+/**
+ * Definition of a WaveformPyramid
+ *
+ * Levels of detail of a track's waveform for zoomed drawing. The finest level holds the
+ * minimum, maximum and mean square of every baseSamplesPerPoint samples across both
+ * channels, and each level above halves the one below, up to a single point for the
+ * whole track. Drawing reads the coarsest level that still has a point for every pixel,
+ * so any zoom from a few samples per pixel to the whole track costs about one point per
+ * pixel. Built once on a background thread, either from the file or from the finest
+ * level saved by an earlier session, then only read.
+ *
+ */
+class WaveformPyramid : public juce::ReferenceCountedObject,
+	public juce::ChangeBroadcaster
+{
+public:
+
+	/// Reference counted pointer to a WaveformPyramid
+	using Ptr = juce::ReferenceCountedObjectPtr<WaveformPyramid>;
+
+	/// Number of samples summarised by a point of the finest level
+	static constexpr int baseSamplesPerPoint = 16;
+
+	/// Number of samples read at a time, a multiple of the 50 samples per point of the waveform thumbnails too
+	static constexpr int chunkSize = baseSamplesPerPoint * 4000;
+
+	/// Called with every chunk read while building: the stereo buffer, the position of the chunk in the file and its length
+	using ChunkCallback = std::function<void(const juce::AudioBuffer<float>&, juce::int64, int)>;
+
+	//==============================================================================
+
+	/**
+		* Reads the whole file and builds every level, then marks the pyramid ready.
+		* Only called once, from a background thread.
+		*
+		* @param Reader of the track
+		* @param Called with every chunk read, so another waveform can be built from the same decode, or nullptr
+	*/
+	void build(juce::AudioFormatReader& reader, ChunkCallback onChunk = nullptr);
+
+	/**
+		* Reads the finest level written by saveTo and builds the levels above it, then marks
+		* the pyramid ready. Only called instead of build.
+		*
+		* @param Stream to read from
+		* @return False if the stream does not hold a saved pyramid or the build was cancelled
+	*/
+	bool loadFrom(juce::InputStream& stream);
+
+	/**
+		* Writes the sample rate and the finest level. Only called once the pyramid is ready.
+		*
+		* @param Stream to write to
+	*/
+	void saveTo(juce::OutputStream& stream) const;
+
+	/**
+		* Makes a build in progress give up, called when the track is no longer shown
+	*/
+	void cancel();
+
+	/**
+		* @return If every level is built and can be drawn
+	*/
+	bool isReady() const;
+
+	/**
+		* @return Number of samples per second of the track
+	*/
+	double getSampleRate() const;
+
+	//==============================================================================
+
+	/**
+		* Draws the waveform between two times across an area, peaks in the colour and
+		* the RMS level on top in a brighter shade. Only called once the pyramid is ready.
+		*
+		* @param juce::Graphics object to draw on
+		* @param Area to draw in
+		* @param Time at the left edge in seconds
+		* @param Time at the right edge in seconds
+		* @param Vertical scale of a full scale sample relative to half the height
+		* @param juce::Colour of the peaks
+	*/
+	void draw(juce::Graphics& g, juce::Rectangle<int> area, double startTime, double endTime, float verticalZoom, juce::Colour colour) const;
+
+	//==============================================================================
+
+private:
+
+	/// Points of one level of detail
+	struct Level {
+		/// Number of samples summarised by each point
+		juce::int64 samplesPerPoint = 0;
+
+		/// Lowest sample of each point
+		std::vector<float> minimum;
+
+		/// Highest sample of each point
+		std::vector<float> maximum;
+
+		/// Mean of the squared samples of each point
+		std::vector<float> meanSquare;
+	};
+
+	/**
+		* Builds the finest level from the reader, a chunk at a time
+		*
+		* @param Reader of the track
+		* @param Called with every chunk read, or nullptr
+		* @return False if the build was cancelled or the file could not be read
+	*/
+	bool buildBaseLevel(juce::AudioFormatReader& reader, const ChunkCallback& onChunk);
+
+	/**
+		* Builds every level above the finest one, then marks the pyramid ready unless cancelled
+	*/
+	void buildUpperLevels();
+
+	/**
+		* @param Number of samples a pixel covers
+		* @return Coarsest level with at least one point per pixel, the finest level if none
+	*/
+	const Level& getLevelFor(double samplesPerPixel) const;
+
+	//==============================================================================
+
+	/// Levels from the finest to a single point
+	std::vector<Level> levels;
+
+	/// Number of samples per second of the track
+	double sampleRate = 44100;
+
+	/// Set once every level is built, the levels are not touched by the builder after
+	std::atomic<bool> ready{ false };
+
+	/// Set when the build should give up
+	std::atomic<bool> cancelled{ false };
+
+	/// Written first by saveTo, changed whenever the layout changes
+	static constexpr int formatVersion = 1;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformPyramid)
+};
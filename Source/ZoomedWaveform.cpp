@@ -26,10 +26,12 @@ ZoomedWaveform::~ZoomedWaveform()
 /**
  * Implementation of paint method for ZoomedWaveform
  *
- * Similar to WaveformDisplay, calls the drawChannel method on audioThumb to
+ * Similar to WaveformDisplay, calls the drawChannel method on the waveform's thumbnail to
  * draw the waveform.
  * However, the waveform drawn is zoomed in and instead of a moving playhead,
  * the drawn waveform moves against a fixed playhead in the middle.
+ * Once the track's pyramid is built the waveform is drawn from it at the zoom
+ * set with the mouse wheel, until then from the thumbnail.
  *
  */
 void ZoomedWaveform::paint(juce::Graphics& g)
@@ -38,12 +40,17 @@ void ZoomedWaveform::paint(juce::Graphics& g)
 	g.setColour(juce::Colours::grey);
 
 	if (isLoaded) {
-		double thisPos = position * audioThumb.getTotalLength();
-		double half = audioThumb.getTotalLength() / 80;
+		double thisPos = position * getLengthInSeconds();
+		double half = getHalfWindow();
 		double left = thisPos - half;
 		double right = thisPos + half;
 		g.setColour(theme);
-		audioThumb.drawChannel(g, getLocalBounds(), left, right, 0, .7);
+		if (waveform->getPyramid().isReady()) {
+			waveform->getPyramid().draw(g, getLocalBounds(), left, right, 0.7f, theme);
+		}
+		else {
+			waveform->getThumbnail().drawChannel(g, getLocalBounds(), left, right, 0, .7);
+		}
 		if (left < 0) {
 			double widthRect = juce::jmap(fabs(left), (double)0, half * 2, (double)0, (double)getWidth());
 			g.setColour(juce::Colour::fromRGBA(0, 0, 0, 255));
@@ -51,9 +58,9 @@ void ZoomedWaveform::paint(juce::Graphics& g)
 		}
 
 		for (auto i = 0; i < cueTargets.size(); ++i) {
-			if ((cueTargets[i]->first * audioThumb.getTotalLength()) > left && (cueTargets[i]->first * audioThumb.getTotalLength()) < right) {
+			if ((cueTargets[i]->first * getLengthInSeconds()) > left && (cueTargets[i]->first * getLengthInSeconds()) < right) {
 				g.setColour(juce::Colour::fromHSL(cueTargets[i]->second, 1, 0.5, 1));
-				double widthPos = juce::jmap(cueTargets[i]->first * audioThumb.getTotalLength(), left, right, (double)0, (double)getWidth());
+				double widthPos = juce::jmap(cueTargets[i]->first * getLengthInSeconds(), left, right, (double)0, (double)getWidth());
 				g.drawRect(widthPos, 0, 1, getHeight());
 			}
 		}
@@ -91,16 +98,48 @@ void ZoomedWaveform::mouseDrag(const juce::MouseEvent& e) {
 		sliderIsDragged = true;
 		DBG("MOUSE DRAGGED :: Zoomed");
 		if ((double)prevX > (double)e.x) {
-			setValue(position + 0.1 / audioThumb.getTotalLength());
+			setValue(position + 0.1 / getLengthInSeconds());
 		}
 		else if ((double)prevX < (double)e.x) {
-			setValue(position - 0.1 / audioThumb.getTotalLength());
+			setValue(position - 0.1 / getLengthInSeconds());
 		}
 		prevX = e.x;
 		setPositionRelative(getValue());
 	}
 }
 
+/**
+ * Implementation of mouseWheelMove method for ZoomedWaveform
+ *
+ * Each notch of the wheel zooms by about a third, in when turned up and out when turned down.
+ * The zoom is brought back within the limits getHalfWindow keeps to, so zooming back
+ * out always starts from what is shown.
+ *
+ */
+void ZoomedWaveform::mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) {
+	if (isEnabled() && isLoaded && getLengthInSeconds() > 0) {
+		zoom = juce::jmax(minZoom, zoom * std::pow(2.0, wheel.deltaY * 4.0));
+		zoom = getLengthInSeconds() / (80.0 * getHalfWindow());
+		repaint();
+	}
+}
+
+//==============================================================================
+
+/**
+ * Implementation of getHalfWindow method for ZoomedWaveform
+ *
+ * A fortieth of the track divided by the zoom, at most half the track and at least
+ * minSamplesPerPixel samples per pixel, which is finer than the pyramid's finest level.
+ *
+ */
+double ZoomedWaveform::getHalfWindow() {
+	const double length = getLengthInSeconds();
+	const double sampleRate = waveform != nullptr && waveform->getPyramid().isReady() ? waveform->getPyramid().getSampleRate() : 44100.0;
+	const double shortest = getWidth() * minSamplesPerPixel / sampleRate / 2;
+	return juce::jlimit(juce::jmin(shortest, length / 2), length / 2, length / (80 * zoom));
+}
+
 //==============================================================================
 
 
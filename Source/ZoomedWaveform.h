@@ -11,7 +11,8 @@
  * A component that has similar appearance to WaveformDisplay
  * but a different playback control functionality. Acts as an application level
  * Waveform display with playback functionality. Communicates with DJAudioPlayer
- * via the DeckGUI interface
+ * via the DeckGUI interface. The mouse wheel zooms from a few samples per pixel out
+ * to the whole track, drawn from the track's WaveformPyramid once it is built.
  *
  */
 class ZoomedWaveform : public WaveformDisplay
@@ -68,7 +69,31 @@ private:
 	*/
 	void mouseDrag(const juce::MouseEvent& e);
 
+	/**
+		* Called when the mouse wheel is moved over the component
+		*
+		* @param juce::MouseEvent reference
+		* @param juce::MouseWheelDetails of the wheel movement
+	*/
+	void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override;
+
 	//============================================================================== 
 
+	/**
+		* @return Seconds shown either side of the playhead
+	*/
+	double getHalfWindow();
+
+	//============================================================================== 
+
+	/// Zoom relative to the default window of a fortieth of the track, above 1 to zoom in
+	double zoom = 1;
+
+	/// Lowest zoom, at which the window spans the length of the track
+	static constexpr double minZoom = 1.0 / 40.0;
+
+	/// Fewest samples a pixel covers at the highest zoom
+	static constexpr double minSamplesPerPixel = 4.0;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ZoomedWaveform)
 };